@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2025-11-03     Administrator       the first version
+ * 2026-10-17     RT-Thread           add the adaptive response timeout controls
  */
 #ifndef APPLICATIONS_MACBSP_INC_BSP_RS485_DEV_H_
 #define APPLICATIONS_MACBSP_INC_BSP_RS485_DEV_H_
@@ -26,6 +27,9 @@ extern "C"
 #define RS485_CTRL_SET_TMO          1
 #define RS485_CTRL_BREAK_RECV       2
 #define RS485_CTRL_SEND_THEN_RECV   3
+#define RS485_CTRL_SET_RTO          4   //设置自适应应答超时范围, args: rs485_dev_rto_param_t
+#define RS485_CTRL_GET_RTO          5   //读取从站应答超时统计, args: rs485_rto_stat_t
+#define RS485_CTRL_RESET_RTO        6   //清除所有从站的应答时间和退避
 
 
 /**
@@ -139,6 +143,23 @@ typedef struct {
 
 
 
+/**
+ * @brief RS485 自适应应答超时范围
+ *
+ * 用于 `RS485_CTRL_SET_RTO`，需要开启 RS485_USING_RTO。
+ * 每个从站的应答超时由实测应答时间计算（平滑值 + 4 倍偏差），并限制在此范围内。
+ *
+ * @note 单位：毫秒 (ms)
+ */
+typedef struct {
+    int min_ms;     //最小应答超时, 避免偶尔的慢应答被误判为超时
+    int max_ms;     //最大应答超时, 超时加倍时不超过此值
+} rs485_dev_rto_param_t;
+
+
+
+
+
 /**
  * @brief RS485 “发送后接收”操作参数结构体
  *
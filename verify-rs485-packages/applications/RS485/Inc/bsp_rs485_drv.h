@@ -6,6 +6,11 @@
  * Change Logs:
  * Date           Author       Notes
  * 2025-11-03     Administrator       the first version
+ * 2026-10-17     RT-Thread           wait for the interrupt tx ring buffer
+ * 2026-10-17     RT-Thread           add the notify and the non-blocking send for the gateway
+ * 2026-10-17     RT-Thread           adaptive response timeout per slave
+ * 2026-10-17     RT-Thread           add the modbus tcp gateway option
+ * 2026-10-17     RT-Thread           rto for the gateway
  */
 #ifndef APPLICATIONS_MACBSP_INC_BSP_RS485_DRV_H_
 #define APPLICATIONS_MACBSP_INC_BSP_RS485_DRV_H_
@@ -24,6 +29,15 @@ extern "C"
 #define RS485_USING_DMA_RX          //使用DMA接收
 //#define RS485_USING_INT_TX          //使用中断发送
 #define RS485_USING_DMA_TX          //使用DMA发送
+//#define RS485_USING_USB_BRIDGE      //使用USB虚拟串口桥接
+//#define RS485_USING_GATEWAY         //使用多总线网关, 一个线程服务所有总线
+//#define RS485_USING_RTO             //按从站地址自适应应答超时
+//#define RS485_USING_MBTCP           //Modbus TCP转RTU网关, 需要RS485_USING_GATEWAY和SAL
+
+/* DMA发送和中断发送环形缓冲区由串口通知发送完成 */
+#if defined(RS485_USING_DMA_TX) || (defined(RS485_USING_INT_TX) && defined(RT_SERIAL_USING_TX_RB))
+#define RS485_USING_TX_COMP
+#endif
 
 
 #ifndef RS485_SW_DLY_US
@@ -34,9 +48,54 @@ extern "C"
 #define RS485_BYTE_TMO_MIN          2     //最小字节超时
 #define RS485_BYTE_TMO_MAX          200   //最大字节超时
 
+#ifdef RS485_USING_RTO
+#ifndef RS485_RTO_SLAVE_MAX
+#define RS485_RTO_SLAVE_MAX         16    //每条总线记录的从站数, 满了替换最久未访问的
+#endif
+#ifndef RS485_RTO_MIN_MS
+#define RS485_RTO_MIN_MS            20    //默认最小应答超时
+#endif
+#ifndef RS485_RTO_MAX_MS
+#define RS485_RTO_MAX_MS            1000  //默认最大应答超时
+#endif
+#ifndef RS485_RTO_FAIL_LIMIT
+#define RS485_RTO_FAIL_LIMIT        3     //连续超时次数, 达到后进入退避
+#endif
+#ifndef RS485_RTO_BACKOFF_MS
+#define RS485_RTO_BACKOFF_MS        1000  //首次退避时间, 之后每次超时翻倍
+#endif
+#ifndef RS485_RTO_BACKOFF_SHIFT
+#define RS485_RTO_BACKOFF_SHIFT     5     //退避最多翻倍次数
+#endif
+#endif
+
 // 创建RS458实例(instance)
 typedef struct rs485_inst rs485_inst_t;
 
+#define RS485_NOTIFY_RX             0       //收到数据
+#define RS485_NOTIFY_TX_DONE        1       //rs485_send_start的数据已发出
+
+// 实例事件通知, 在中断中调用
+typedef void (*rs485_notify_t)(rs485_inst_t *hinst, int event, void *arg);
+
+#ifdef RS485_USING_RTO
+/**
+ * @brief 从站应答超时统计, addr由调用者填写
+ */
+typedef struct {
+    int addr;                   //从站地址, 发送帧的第一个字节
+    int srtt_ms;                //平滑应答时间
+    int rttvar_ms;              //应答时间偏差
+    int rto_ms;                 //当前应答超时
+    int fails;                  //连续超时次数
+    int backoff_ms;             //剩余退避时间, 0 - 未退避
+    rt_uint32_t req;            //发出的请求数
+    rt_uint32_t ok;             //收到应答数
+    rt_uint32_t tmo;            //超时数
+    rt_uint32_t skip;           //退避期间拒绝的请求数
+} rs485_rto_stat_t;
+#endif
+
 #ifdef RS485_USING_DEV
 #include <rs485_dev.h>
 #endif
@@ -133,9 +192,102 @@ int rs485_break_recv(rs485_inst_t * hinst);
  * @param   recv_buf    - recv buffer addr
  * @param   recv_size   - maximum length of received datas
  * @retval  >=0 - length of received datas, <0 - error
+ * @note    with RS485_USING_RTO and a receive timeout > 0, the response timeout is
+ *          learned per slave (the first byte of send_buf, 0 - broadcast, not learned),
+ *          -RT_EBUSY is returned without sending while the slave is backed off.
  */
 int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, void *recv_buf, int recv_size);
 
+#ifdef RS485_USING_RTO
+/*
+ * @brief   set the bounds of the adaptive response timeout
+ * @param   hinst       - instance handle
+ * @param   min_ms      - minimum response timeout
+ * @param   max_ms      - maximum response timeout, also the limit of the back-off time
+ * @retval  0 - success, other - error
+ */
+int rs485_set_rto_bounds(rs485_inst_t * hinst, int min_ms, int max_ms);
+
+/*
+ * @brief   get the response timeout statistics of a slave
+ * @param   hinst       - instance handle
+ * @param   stat        - statistics, stat->addr is the slave address
+ * @retval  0 - success, -RT_EEMPTY - the slave is not recorded, other - error
+ */
+int rs485_get_rto_stat(rs485_inst_t * hinst, rs485_rto_stat_t *stat);
+
+/*
+ * @brief   forget the response times and the back-off of all slaves
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_reset_rto(rs485_inst_t * hinst);
+
+/*
+ * @brief   begin a request to a slave, for the users driving the bus by rs485_send_start
+ * @param   hinst       - instance handle
+ * @param   addr        - slave address, not 0
+ * @param   tmo_ms      - configured response timeout, the first value of a new slave
+ * @retval  >0 - response timeout to wait, -RT_EBUSY - the slave is backed off, other - error
+ */
+int rs485_rto_begin(rs485_inst_t * hinst, int addr, int tmo_ms);
+
+/*
+ * @brief   end a request begun by rs485_rto_begin
+ * @param   hinst       - instance handle
+ * @param   addr        - slave address
+ * @param   rtt_ms      - ms from the end of sending to the first byte, <0 - no response
+ * @retval  0 - success, other - error
+ */
+int rs485_rto_end(rs485_inst_t * hinst, int addr, int rtt_ms);
+#endif
+
+/*
+ * @brief   set the event notify of the instance, for event driven users
+ * @param   hinst       - instance handle
+ * @param   notify      - called in the interrupt, RT_NULL - remove
+ * @param   arg         - argument of notify
+ * @retval  0 - success, other - error
+ */
+int rs485_set_notify(rs485_inst_t * hinst, rs485_notify_t notify, void *arg);
+
+/*
+ * @brief   get the timing of the instance, for event driven users
+ * @param   hinst       - instance handle
+ * @param   byte_tmo    - byte interval timeout in ms, may be RT_NULL
+ * @param   tx_tail     - ms the last datas are still sent after RS485_NOTIFY_TX_DONE, may be RT_NULL
+ * @retval  0 - success, other - error
+ */
+int rs485_get_timing(rs485_inst_t * hinst, int *byte_tmo, int *tx_tail);
+
+/*
+ * @brief   switch to send mode and start sending without waiting for the end
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr, must be kept until RS485_NOTIFY_TX_DONE
+ * @param   size        - length of send datas
+ * @retval  >=0 - length of send datas, <0 - error
+ * @note    not locked, for the only user of the instance. RS485_NOTIFY_TX_DONE is
+ *          notified when the datas are sent, then call rs485_send_end.
+ */
+int rs485_send_start(rs485_inst_t * hinst, void *buf, int size);
+
+/*
+ * @brief   switch back to receive mode after rs485_send_start
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_send_end(rs485_inst_t * hinst);
+
+/*
+ * @brief   read the received datas without waiting
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of read datas
+ * @retval  >=0 - length of read datas, <0 - error
+ * @note    not locked, for the only user of the instance
+ */
+int rs485_read(rs485_inst_t * hinst, void *buf, int size);
+
 
 
 #ifdef __cplusplus
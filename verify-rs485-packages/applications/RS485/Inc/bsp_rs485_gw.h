@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ * 2026-10-17     RT-Thread    urgent requests
+ * 2026-10-17     RT-Thread    flush in the gateway thread
+ * 2026-10-17     RT-Thread    learn the response timeout per slave
+ * 2026-10-17     RT-Thread    hold the bus after a send only request
+ */
+#ifndef APPLICATIONS_MACBSP_INC_BSP_RS485_GW_H_
+#define APPLICATIONS_MACBSP_INC_BSP_RS485_GW_H_
+
+#include "bsp_sys.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef RS485_USING_GATEWAY
+
+#ifndef RS485_GW_PORT_MAX
+#define RS485_GW_PORT_MAX           8       //网关最多服务的总线数, 不能大于8
+#endif
+
+#ifndef RS485_GW_THREAD_PRIO
+#define RS485_GW_THREAD_PRIO        11      //网关线程优先级
+#endif
+
+#ifndef RS485_GW_TX_TMO_MS
+#define RS485_GW_TX_TMO_MS          1000    //等待发送完成的最长时间
+#endif
+
+typedef struct rs485_gw_req rs485_gw_req_t;
+
+/**
+ * @brief 网关请求, 由使用者分配, 在done回调之前不能释放或修改
+ */
+struct rs485_gw_req {
+    rs485_gw_req_t *next;                       //网关内部使用
+    int port;                                   //总线号, rs485_gw_add的返回值
+    void *sbuf;                                 //发送数据
+    int slen;                                   //发送长度
+    void *rbuf;                                 //接收缓冲区, RT_NULL - 只发送
+    int rsize;                                  //接收缓冲区大小
+    int ack_tmo_ms;                             //应答超时, 0 - 只发送, RS485_USING_RTO时为新从站的初始值
+    int urgent;                                 //非0 - 排在普通请求之前, 如写请求
+    int hold_ms;                                //只发送时, 发完后总线保持空闲的时间, 如广播后的转换延时
+    int result;                                 //>=0 - 接收长度, <0 - 错误, -RT_ETIMEOUT - 无应答, -RT_EBUSY - 从站退避中
+    void (*done)(rs485_gw_req_t *req);          //完成回调, 在网关线程中调用, 不能阻塞
+    void *user_data;
+};
+
+/*
+ * @brief   add a bus to the gateway, before rs485_gw_start
+ * @param   hinst       - instance handle, must be connected
+ * @retval  >=0 - port number, <0 - error
+ * @note    the instance is owned by the gateway while it runs,
+ *          rs485_send/rs485_recv must not be used on it.
+ */
+int rs485_gw_add(rs485_inst_t * hinst);
+
+/*
+ * @brief   start the gateway thread servicing all the added buses
+ * @retval  0 - success, other - error
+ */
+int rs485_gw_start(void);
+
+/*
+ * @brief   stop the gateway, the pending requests are done with -RT_ERROR
+ * @retval  0 - success, other - error
+ * @note    the buses are removed, add them again before the next start.
+ *          the done callbacks still run in the gateway thread, so not for
+ *          the gateway thread itself.
+ */
+int rs485_gw_stop(void);
+
+/*
+ * @brief   queue a request to its bus
+ * @param   req         - request, kept until its done callback
+ * @retval  0 - success, other - error
+ * @note    may be called from the interrupt and the done callback,
+ *          the requests of one bus are handled in order, the urgent ones first.
+ */
+int rs485_gw_submit(rs485_gw_req_t *req);
+
+/*
+ * @brief   send then receive through the gateway and wait for the result
+ * @param   port        - port number
+ * @param   sbuf        - send buffer
+ * @param   slen        - send length
+ * @param   rbuf        - receive buffer, RT_NULL - send only
+ * @param   rsize       - receive buffer size
+ * @param   ack_tmo_ms  - wait the first byte timeout, 0 - send only
+ * @retval  >=0 - length of receive datas, <0 - error
+ * @note    not for the gateway thread
+ */
+int rs485_gw_transfer(int port, void *sbuf, int slen, void *rbuf, int rsize, int ack_tmo_ms);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APPLICATIONS_MACBSP_INC_BSP_RS485_GW_H_ */
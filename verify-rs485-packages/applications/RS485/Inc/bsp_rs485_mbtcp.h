@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ * 2026-10-17     RT-Thread    broadcast turnaround delay
+ */
+#ifndef APPLICATIONS_MACBSP_INC_BSP_RS485_MBTCP_H_
+#define APPLICATIONS_MACBSP_INC_BSP_RS485_MBTCP_H_
+
+#include "bsp_sys.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(RS485_USING_MBTCP) && defined(RT_USING_SAL)
+
+#ifndef RS485_MBTCP_PORT
+#define RS485_MBTCP_PORT            502     //默认监听端口
+#endif
+
+#ifndef RS485_MBTCP_CLIENT_MAX
+#define RS485_MBTCP_CLIENT_MAX      4       //最多同时连接的客户端, 每个一个线程
+#endif
+
+#ifndef RS485_MBTCP_THREAD_PRIO
+#define RS485_MBTCP_THREAD_PRIO     15      //监听和客户端线程优先级
+#endif
+
+#ifndef RS485_MBTCP_IDLE_S
+#define RS485_MBTCP_IDLE_S          60      //客户端无请求超过此时间断开
+#endif
+
+#ifndef RS485_MBTCP_ACK_TMO_MS
+#define RS485_MBTCP_ACK_TMO_MS      300     //从站应答超时
+#endif
+
+#ifndef RS485_MBTCP_TURNAROUND_MS
+#define RS485_MBTCP_TURNAROUND_MS   100     //广播后的转换延时, 之后总线才发下一个请求
+#endif
+
+#ifndef RS485_MBTCP_CACHE_NUM
+#define RS485_MBTCP_CACHE_NUM       16      //读结果缓存条数, 满了替换最旧的
+#endif
+
+#ifndef RS485_MBTCP_CACHE_TTL_MS
+#define RS485_MBTCP_CACHE_TTL_MS    100     //读结果缓存有效期, 0 - 不缓存
+#endif
+
+/*
+ * @brief   start the modbus tcp to rtu gateway
+ * @param   tcp_port    - listen port, 0 - RS485_MBTCP_PORT
+ * @retval  0 - success, other - error
+ * @note    the requests are sent by the rs485 gateway, start it first.
+ *          a read is answered from the cache within the ttl, or shares an
+ *          in-flight read of the same slave covering its range. writes are
+ *          sent before the queued reads and clear the cache of the slave.
+ */
+int rs485_mbtcp_start(int tcp_port);
+
+/*
+ * @brief   stop the modbus tcp to rtu gateway
+ * @retval  0 - success, other - error
+ */
+int rs485_mbtcp_stop(void);
+
+/*
+ * @brief   route a unit id to a bus
+ * @param   unit        - unit id, 0~247, also the rtu slave address
+ * @param   port        - port number of the rs485 gateway, <0 - not routed
+ * @retval  0 - success, other - error
+ * @note    all the unit ids are routed to port 0 by default
+ */
+int rs485_mbtcp_route(int unit, int port);
+
+/*
+ * @brief   set the ttl of the read cache
+ * @param   ttl_ms      - ttl, 0 - no cache
+ * @retval  0 - success, other - error
+ */
+int rs485_mbtcp_set_ttl(int ttl_ms);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APPLICATIONS_MACBSP_INC_BSP_RS485_MBTCP_H_ */
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+#ifndef APPLICATIONS_MACBSP_INC_BSP_RS485_USB_H_
+#define APPLICATIONS_MACBSP_INC_BSP_RS485_USB_H_
+
+#include "bsp_sys.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#if defined(RS485_USING_USB_BRIDGE) && defined(RT_VCOM_USING_PINGPONG)
+
+#ifndef RS485_USB_POLL_MS
+#define RS485_USB_POLL_MS           5       //桥接线程接收等待时间, 决定主机数据的最大排队延时
+#endif
+
+#ifndef RS485_USB_THREAD_PRIO
+#define RS485_USB_THREAD_PRIO       12      //桥接线程优先级
+#endif
+
+/*
+ * @brief   start bridging the usb virtual com to rs485
+ * @param   hinst       - instance handle, must be connected
+ * @retval  0 - success, other - error
+ * @note    usb OUT packets are sent by dma straight from the endpoint buffer,
+ *          rs485 frames are received straight into the IN packet buffer.
+ *          the host line coding is applied by rs485_config.
+ */
+int rs485_usb_bridge_start(rs485_inst_t * hinst);
+
+/*
+ * @brief   stop the usb virtual com bridge
+ * @retval  0 - success, other - error
+ */
+int rs485_usb_bridge_stop(void);
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* APPLICATIONS_MACBSP_INC_BSP_RS485_USB_H_ */
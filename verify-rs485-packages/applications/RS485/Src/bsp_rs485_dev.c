@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2025-11-03     Administrator       the first version
+ * 2026-10-17     RT-Thread           add the adaptive response timeout controls
  */
 #include "bsp_sys.h"
 #include "bsp_rs485_drv.h"
@@ -144,6 +145,31 @@ static rt_err_t rs485_dev_control(rt_device_t dev, int cmd, void *args)
                                             params->rlen);  // 期望接收长度
             }
             break;
+
+#ifdef RS485_USING_RTO
+        /* ============================================= */
+        /* 5. 自适应应答超时：范围、统计、清除 */
+        /* ============================================= */
+        case RS485_CTRL_SET_RTO:
+            if (args)
+            {
+                rs485_dev_rto_param_t *params = (rs485_dev_rto_param_t *)args;
+                rst = rs485_set_rto_bounds(pdev->hinst, params->min_ms, params->max_ms);
+            }
+            break;
+
+        case RS485_CTRL_GET_RTO:
+            if (args)
+            {
+                // args->addr 为从站地址
+                rst = rs485_get_rto_stat(pdev->hinst, (rs485_rto_stat_t *)args);
+            }
+            break;
+
+        case RS485_CTRL_RESET_RTO:
+            rst = rs485_reset_rto(pdev->hinst);
+            break;
+#endif
         default:
             break;
     }
@@ -6,6 +6,10 @@
  * Change Logs:
  * Date           Author       Notes
  * 2025-11-03     Administrator       the first version
+ * 2026-10-17     RT-Thread           wait for the interrupt tx ring buffer
+ * 2026-10-17     RT-Thread           add the notify and the non-blocking send for the gateway
+ * 2026-10-17     RT-Thread           adaptive response timeout per slave
+ * 2026-10-17     RT-Thread           bound the back-off, skip the broadcasts, rto for the gateway
  */
 #include "bsp_sys.h"
 #include "bsp_rs485_drv.h"
@@ -19,6 +23,23 @@
 #define RS485_EVT_RX_BREAK  (1<<1)  // 用于标记总线"断裂"
 
 
+#ifdef RS485_USING_RTO
+/* 一个从站的应答时间, 按RFC6298计算, srtt放大8倍, rttvar放大4倍 */
+typedef struct {
+    rt_uint8_t used;
+    rt_uint8_t addr;
+    rt_uint16_t fails;      // 连续超时次数
+    rt_int32_t srtt;
+    rt_int32_t rttvar;
+    rt_int32_t rto;         // 应答超时, ms
+    rt_tick_t until;        // 退避结束时刻
+    rt_tick_t last;         // 最近访问时刻, 表满时替换最久未访问的
+    rt_uint32_t req;
+    rt_uint32_t ok;
+    rt_uint32_t tmo;
+    rt_uint32_t skip;
+} rs485_rto_t;
+#endif
 
 struct rs485_inst
 {
@@ -30,18 +51,32 @@ struct rs485_inst
     rt_int16_t pin;         // RE/DE 引脚序号（-1：未使用）
     rt_int32_t timeout;     // 接收超时时间
     rt_int32_t byte_tmo;    // 接收字节的时间区间
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
     rt_int32_t tx_dly_ms;
     struct rt_completion tx_comp;//send completion
+#endif
+    rs485_notify_t notify;  // 事件通知, 在中断中调用
+    void *notify_arg;
+#ifdef RS485_USING_RTO
+    rt_int32_t rto_min;     // 自适应应答超时的范围
+    rt_int32_t rto_max;
+    rs485_rto_t rto[RS485_RTO_SLAVE_MAX];
 #endif
 };
 
 
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
 static rt_err_t rs485_send_comp_hook(rt_device_t dev, void *buffer)
 {
     rs485_inst_t *hinst = (rs485_inst_t *)(dev->user_data);
-    rt_completion_done(&(hinst->tx_comp));
+
+    /* rs485_send_start的使用者不等待完成量 */
+    if (hinst->notify){
+        hinst->notify(hinst, RS485_NOTIFY_TX_DONE, hinst->notify_arg);
+    }
+    else{
+        rt_completion_done(&(hinst->tx_comp));
+    }
     return(RT_EOK);
 }
 #endif
@@ -54,9 +89,131 @@ static rt_err_t rs485_recv_ind_hook(rt_device_t dev, rt_size_t size)
     if (hinst->evt){
         rt_event_send(hinst->evt, RS485_EVT_RX_IND);
     }
+    if (hinst->notify){
+        hinst->notify(hinst, RS485_NOTIFY_RX, hinst->notify_arg);
+    }
     return(RT_EOK);
 }
 
+#ifdef RS485_USING_RTO
+static rt_int32_t rs485_rto_clamp(rs485_inst_t *hinst, rt_int32_t rto)
+{
+    if (rto < hinst->rto_min){
+        rto = hinst->rto_min;
+    }
+    else if (rto > hinst->rto_max){
+        rto = hinst->rto_max;
+    }
+    return(rto);
+}
+
+/* 查找从站, 没有则占用空闲或最久未访问的一项, 初始超时为配置的应答超时 */
+static rs485_rto_t *rs485_rto_find(rs485_inst_t *hinst, rt_uint8_t addr, rt_int32_t init_ms)
+{
+    rs485_rto_t *rto = RT_NULL;
+    rt_tick_t now = rt_tick_get();
+    int i;
+
+    for (i = 0; i < RS485_RTO_SLAVE_MAX; i++)
+    {
+        if (hinst->rto[i].used && hinst->rto[i].addr == addr)
+        {
+            rto = &hinst->rto[i];
+            rto->last = now;
+            return(rto);
+        }
+        if (rto == RT_NULL || !hinst->rto[i].used ||
+            (rto->used && (now - hinst->rto[i].last) > (now - rto->last)))
+        {
+            rto = &hinst->rto[i];
+        }
+    }
+
+    rt_memset(rto, 0, sizeof(rs485_rto_t));
+    rto->used = 1;
+    rto->addr = addr;
+    rto->rto = rs485_rto_clamp(hinst, init_ms);
+    rto->last = now;
+
+    return(rto);
+}
+
+/* 连续超时的从站在退避期间不再发送 */
+static int rs485_rto_backoff(rs485_rto_t *rto)
+{
+    return((rto->fails >= RS485_RTO_FAIL_LIMIT) && ((rt_int32_t)(rto->until - rt_tick_get()) > 0));
+}
+
+/*
+ * @brief   update the response timeout of a slave after a request
+ * @param   hinst       - instance handle
+ * @param   rto         - the slave
+ * @param   rtt         - ms from the end of sending to the first byte, <0 - timeout
+ */
+static void rs485_rto_update(rs485_inst_t *hinst, rs485_rto_t *rto, rt_int32_t rtt)
+{
+    rt_int32_t err, gran, backoff;
+    int shift;
+
+    if (rtt >= 0)
+    {
+        if (rto->ok == 0)
+        {
+            rto->srtt = rtt << 3;
+            rto->rttvar = rtt << 1;
+        }
+        else
+        {
+            err = rtt - (rto->srtt >> 3);
+            rto->srtt += err;
+            if (err < 0){
+                err = -err;
+            }
+            rto->rttvar += err - (rto->rttvar >> 2);
+        }
+
+        /* 偏差不小于一个时钟节拍 */
+        gran = (1000 + RT_TICK_PER_SECOND - 1) / RT_TICK_PER_SECOND;
+        rto->rto = rs485_rto_clamp(hinst, (rto->srtt >> 3) + ((rto->rttvar > gran) ? rto->rttvar : gran));
+        rto->fails = 0;
+        rto->ok++;
+        return;
+    }
+
+    /* 超时加倍, 连续超时后按指数退避, 不超过最大应答超时 */
+    rto->tmo++;
+    rto->fails++;
+    rto->rto = rs485_rto_clamp(hinst, rto->rto * 2);
+    if (rto->fails >= RS485_RTO_FAIL_LIMIT)
+    {
+        shift = rto->fails - RS485_RTO_FAIL_LIMIT;
+        if (shift > RS485_RTO_BACKOFF_SHIFT){
+            shift = RS485_RTO_BACKOFF_SHIFT;
+        }
+        backoff = RS485_RTO_BACKOFF_MS << shift;
+        if (backoff > hinst->rto_max){
+            backoff = hinst->rto_max;
+        }
+        rto->until = rt_tick_get() + rt_tick_from_millisecond(backoff);
+        LOG_D("rs485 slave %d backoff %d ms.", rto->addr, backoff);
+    }
+}
+#endif
+
+/* 串口在数据发完时会通知 */
+static int rs485_tx_notified(rs485_inst_t *hinst)
+{
+#ifdef RS485_USING_TX_COMP
+    rt_uint16_t flag = RT_DEVICE_FLAG_DMA_TX;
+#ifdef RT_SERIAL_USING_TX_RB
+    flag |= RT_DEVICE_FLAG_INT_TX;
+#endif
+    return((hinst->serial->open_flag & flag) != 0);
+#else
+    return(0);
+#endif
+}
+
 
 
 /* rs485_cal_byte_tmo() 就是“波特率→毫秒”的换算表，把 3.5 字符时间换算出来并锁在 [1,20] ms 安全区，给接收状态机当“帧间隔”用 */
@@ -106,9 +263,13 @@ static void rs485_mode_set(rs485_inst_t *hinst, int mode)
                                                                         再 rt_thread_mdelay(hinst->tx_dly_ms)
                                   → 有些收发器 停止位后仍需保持 DE 有效 1-2 ms，靠这个参数补
          */
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
         rt_completion_wait(&(hinst->tx_comp), RS485_TX_COMP_TMO_MAX);
-        rt_thread_mdelay(hinst->tx_dly_ms);//等待末尾数据传输完成
+        /* 中断发送环形缓冲区在TC时通知, DMA完成时末尾数据仍在移位寄存器中 */
+        if (hinst->serial->open_flag & RT_DEVICE_FLAG_DMA_TX)
+        {
+            rt_thread_mdelay(hinst->tx_dly_ms);//等待末尾数据传输完成
+        }
 
        /**
         * b. 若只是 中断/polling 发送 且定义了 RS485_SW_DLY_US：直接阻塞 rt_hw_us_delay()，让最后一个停止位有时间输出
@@ -230,7 +391,7 @@ rs485_inst_t * rs485_create(const char *name, int baudrate, int parity, int pin,
         return(RT_NULL);
     }
 
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
     hinst->tx_dly_ms = ((2 * 11 *1000) / baudrate) + 1;
     rt_completion_init(&(hinst->tx_comp));
 #endif
@@ -241,6 +402,13 @@ rs485_inst_t * rs485_create(const char *name, int baudrate, int parity, int pin,
     hinst->level = (level != 0);
     hinst->timeout = 0;
     hinst->byte_tmo = rs485_cal_byte_tmo(baudrate);
+    hinst->notify = RT_NULL;
+    hinst->notify_arg = RT_NULL;
+#ifdef RS485_USING_RTO
+    hinst->rto_min = RS485_RTO_MIN_MS;
+    hinst->rto_max = RS485_RTO_MAX_MS;
+    rt_memset(hinst->rto, 0, sizeof(hinst->rto));
+#endif
 
     rs485_config(hinst, baudrate, 8, parity, 0);
 
@@ -304,7 +472,7 @@ int rs485_config(rs485_inst_t * hinst, int baudrate, int databits, int parity, i
         return(-RT_ERROR);
     }
 
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
     hinst->tx_dly_ms = ((2 * 11 *1000) / baudrate) + 1;
 #endif
 
@@ -398,7 +566,7 @@ int rs485_connect(rs485_inst_t * hinst)
 
     hinst->serial->user_data = hinst;
     hinst->serial->rx_indicate = rs485_recv_ind_hook;
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
     hinst->serial->tx_complete = rs485_send_comp_hook;
 #endif
     hinst->status = 1;
@@ -432,7 +600,7 @@ int rs485_disconn(rs485_inst_t * hinst)
     if (hinst->serial)
     {
         hinst->serial->rx_indicate = RT_NULL;
-#ifdef RS485_USING_DMA_TX
+#ifdef RS485_USING_TX_COMP
         hinst->serial->tx_complete = RT_NULL;
 #endif
         rt_device_close(hinst->serial);
@@ -591,6 +759,12 @@ int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, voi
 {
     int recv_len = 0;
     rt_uint32_t recved = 0;
+    rt_int32_t ack_tmo;
+#ifdef RS485_USING_RTO
+    rs485_rto_t *rto = RT_NULL;
+    rt_tick_t sent_tick = 0;
+    rt_int32_t rtt = -1;
+#endif
 
     if (hinst == RT_NULL || send_buf == RT_NULL || send_len == 0 || recv_buf == RT_NULL || recv_size == 0)
     {
@@ -610,6 +784,23 @@ int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, voi
         return(-RT_ERROR);
     }
 
+    ack_tmo = hinst->timeout;
+#ifdef RS485_USING_RTO
+    /* 按从站地址使用学习到的应答超时, 广播没有应答 */
+    if (hinst->timeout > 0 && *(rt_uint8_t *)send_buf != 0)
+    {
+        rto = rs485_rto_find(hinst, *(rt_uint8_t *)send_buf, hinst->timeout);
+        if (rs485_rto_backoff(rto))
+        {
+            rto->skip++;
+            rt_mutex_release(hinst->lock);
+            return(-RT_EBUSY);
+        }
+        rto->req++;
+        ack_tmo = rt_tick_from_millisecond(rto->rto);
+    }
+#endif
+
     rs485_mode_set(hinst, 1);//set to send mode
     send_len = rt_device_write(hinst->serial, 0, send_buf, send_len);
     rs485_mode_set(hinst, 0);//set to receive mode
@@ -619,12 +810,21 @@ int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, voi
         LOG_E("rs485 send_then_recv fail. send datas error.");
         return(-RT_ERROR);
     }
+#ifdef RS485_USING_RTO
+    sent_tick = rt_tick_get();
+#endif
 
     while(recv_size)
     {
         int len = rt_device_read(hinst->serial, 0, (char *)recv_buf + recv_len, recv_size);
         if (len)
         {
+#ifdef RS485_USING_RTO
+            if (recv_len == 0)
+            {
+                rtt = (rt_int32_t)(rt_tick_get() - sent_tick);
+            }
+#endif
             recv_len += len;
             recv_size -= len;
             continue;
@@ -641,13 +841,20 @@ int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, voi
         else
         {
             if (rt_event_recv(hinst->evt, RS485_EVT_RX_IND,
-                    (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), hinst->timeout, &recved) != RT_EOK)
+                    (RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR), ack_tmo, &recved) != RT_EOK)
             {
                 break;
             }
         }
     }
 
+#ifdef RS485_USING_RTO
+    if (rto)
+    {
+        rs485_rto_update(hinst, rto, (rtt < 0) ? rtt : rtt * 1000 / RT_TICK_PER_SECOND);
+    }
+#endif
+
     rt_mutex_release(hinst->lock);
 
     return(recv_len);
@@ -660,6 +867,304 @@ int rs485_send_then_recv(rs485_inst_t * hinst, void *send_buf, int send_len, voi
 
 
 
+#ifdef RS485_USING_RTO
+/*
+ * @brief   set the bounds of the adaptive response timeout
+ * @param   hinst       - instance handle
+ * @param   min_ms      - minimum response timeout
+ * @param   max_ms      - maximum response timeout, also the limit of the back-off doubling
+ * @retval  0 - success, other - error
+ */
+int rs485_set_rto_bounds(rs485_inst_t * hinst, int min_ms, int max_ms)
+{
+    int i;
+
+    if (hinst == RT_NULL || min_ms <= 0 || max_ms < min_ms)
+    {
+        LOG_E("rs485 set rto bounds fail. param error.");
+        return(-RT_ERROR);
+    }
+
+    rt_mutex_take(hinst->lock, RT_WAITING_FOREVER);
+
+    hinst->rto_min = min_ms;
+    hinst->rto_max = max_ms;
+    for (i = 0; i < RS485_RTO_SLAVE_MAX; i++)
+    {
+        hinst->rto[i].rto = rs485_rto_clamp(hinst, hinst->rto[i].rto);
+    }
+
+    rt_mutex_release(hinst->lock);
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   get the response timeout statistics of a slave
+ * @param   hinst       - instance handle
+ * @param   stat        - statistics, stat->addr is the slave address
+ * @retval  0 - success, -RT_EEMPTY - the slave is not recorded, other - error
+ */
+int rs485_get_rto_stat(rs485_inst_t * hinst, rs485_rto_stat_t *stat)
+{
+    rs485_rto_t *rto = RT_NULL;
+    rt_int32_t left;
+    int i;
+
+    if (hinst == RT_NULL || stat == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    rt_mutex_take(hinst->lock, RT_WAITING_FOREVER);
+
+    for (i = 0; i < RS485_RTO_SLAVE_MAX; i++)
+    {
+        if (hinst->rto[i].used && hinst->rto[i].addr == stat->addr)
+        {
+            rto = &hinst->rto[i];
+            break;
+        }
+    }
+
+    if (rto == RT_NULL)
+    {
+        rt_mutex_release(hinst->lock);
+        return(-RT_EEMPTY);
+    }
+
+    stat->srtt_ms = rto->srtt >> 3;
+    stat->rttvar_ms = rto->rttvar >> 2;
+    stat->rto_ms = rto->rto;
+    stat->fails = rto->fails;
+    stat->backoff_ms = 0;
+    if (rs485_rto_backoff(rto))
+    {
+        left = (rt_int32_t)(rto->until - rt_tick_get());
+        stat->backoff_ms = left * 1000 / RT_TICK_PER_SECOND;
+    }
+    stat->req = rto->req;
+    stat->ok = rto->ok;
+    stat->tmo = rto->tmo;
+    stat->skip = rto->skip;
+
+    rt_mutex_release(hinst->lock);
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   forget the response times and the back-off of all slaves
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_reset_rto(rs485_inst_t * hinst)
+{
+    if (hinst == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    rt_mutex_take(hinst->lock, RT_WAITING_FOREVER);
+    rt_memset(hinst->rto, 0, sizeof(hinst->rto));
+    rt_mutex_release(hinst->lock);
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   begin a request to a slave, for the users driving the bus by rs485_send_start
+ * @param   hinst       - instance handle
+ * @param   addr        - slave address, not 0
+ * @param   tmo_ms      - configured response timeout, the first value of a new slave
+ * @retval  >0 - response timeout to wait, -RT_EBUSY - the slave is backed off, other - error
+ */
+int rs485_rto_begin(rs485_inst_t * hinst, int addr, int tmo_ms)
+{
+    rs485_rto_t *rto;
+    int rst;
+
+    if (hinst == RT_NULL || addr <= 0 || addr > 0xFF || tmo_ms <= 0)
+    {
+        return(-RT_ERROR);
+    }
+
+    rt_mutex_take(hinst->lock, RT_WAITING_FOREVER);
+
+    rto = rs485_rto_find(hinst, (rt_uint8_t)addr, tmo_ms);
+    if (rs485_rto_backoff(rto))
+    {
+        rto->skip++;
+        rst = -RT_EBUSY;
+    }
+    else
+    {
+        rto->req++;
+        rst = rto->rto;
+    }
+
+    rt_mutex_release(hinst->lock);
+
+    return(rst);
+}
+
+/*
+ * @brief   end a request begun by rs485_rto_begin
+ * @param   hinst       - instance handle
+ * @param   addr        - slave address
+ * @param   rtt_ms      - ms from the end of sending to the first byte, <0 - no response
+ * @retval  0 - success, other - error
+ */
+int rs485_rto_end(rs485_inst_t * hinst, int addr, int rtt_ms)
+{
+    if (hinst == RT_NULL || addr <= 0 || addr > 0xFF)
+    {
+        return(-RT_ERROR);
+    }
+
+    rt_mutex_take(hinst->lock, RT_WAITING_FOREVER);
+    rs485_rto_update(hinst, rs485_rto_find(hinst, (rt_uint8_t)addr, hinst->rto_max), rtt_ms);
+    rt_mutex_release(hinst->lock);
+
+    return(RT_EOK);
+}
+#endif
+
+/*
+ * @brief   set the event notify of the instance, for event driven users
+ * @param   hinst       - instance handle
+ * @param   notify      - called in the interrupt, RT_NULL - remove
+ * @param   arg         - argument of notify
+ * @retval  0 - success, other - error
+ */
+int rs485_set_notify(rs485_inst_t * hinst, rs485_notify_t notify, void *arg)
+{
+    rt_base_t level;
+
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 set notify fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+
+    level = rt_hw_interrupt_disable();
+    hinst->notify = notify;
+    hinst->notify_arg = arg;
+    rt_hw_interrupt_enable(level);
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   get the timing of the instance, for event driven users
+ * @param   hinst       - instance handle
+ * @param   byte_tmo    - byte interval timeout in ms, may be RT_NULL
+ * @param   tx_tail     - ms the last datas are still sent after RS485_NOTIFY_TX_DONE, may be RT_NULL
+ * @retval  0 - success, other - error
+ */
+int rs485_get_timing(rs485_inst_t * hinst, int *byte_tmo, int *tx_tail)
+{
+    if (hinst == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    if (byte_tmo)
+    {
+        *byte_tmo = hinst->byte_tmo;
+    }
+    if (tx_tail)
+    {
+        *tx_tail = 0;
+#ifdef RS485_USING_TX_COMP
+        /* DMA完成时末尾数据仍在移位寄存器中 */
+        if (hinst->serial->open_flag & RT_DEVICE_FLAG_DMA_TX)
+        {
+            *tx_tail = hinst->tx_dly_ms;
+        }
+#endif
+    }
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   switch to send mode and start sending without waiting for the end
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr, must be kept until RS485_NOTIFY_TX_DONE
+ * @param   size        - length of send datas
+ * @retval  >=0 - length of send datas, <0 - error
+ * @note    not locked, for the only user of the instance. RS485_NOTIFY_TX_DONE is
+ *          notified when the datas are sent, then call rs485_send_end.
+ */
+int rs485_send_start(rs485_inst_t * hinst, void *buf, int size)
+{
+    int send_len;
+
+    if (hinst == RT_NULL || buf == RT_NULL || size == 0 || hinst->status == 0)
+    {
+        return(-RT_ERROR);
+    }
+
+    rs485_mode_set(hinst, 1);//set to send mode
+    send_len = rt_device_write(hinst->serial, 0, buf, size);
+
+    /* 轮询或逐字节中断发送时写完即发完 */
+    if (!rs485_tx_notified(hinst) && hinst->notify)
+    {
+        hinst->notify(hinst, RS485_NOTIFY_TX_DONE, hinst->notify_arg);
+    }
+
+    return(send_len);
+}
+
+/*
+ * @brief   switch back to receive mode after rs485_send_start
+ * @param   hinst       - instance handle
+ * @retval  0 - success, other - error
+ */
+int rs485_send_end(rs485_inst_t * hinst)
+{
+    if (hinst == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    if (hinst->pin >= 0)
+    {
+#if (RS485_SW_DLY_US > 0)
+        if (!rs485_tx_notified(hinst))
+        {
+            rt_hw_us_delay(RS485_SW_DLY_US);
+        }
+#endif
+        rt_pin_write(hinst->pin, !hinst->level);
+    }
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   read the received datas without waiting
+ * @param   hinst       - instance handle
+ * @param   buf         - buffer addr
+ * @param   size        - maximum length of read datas
+ * @retval  >=0 - length of read datas, <0 - error
+ * @note    not locked, for the only user of the instance
+ */
+int rs485_read(rs485_inst_t * hinst, void *buf, int size)
+{
+    if (hinst == RT_NULL || buf == RT_NULL || hinst->status == 0)
+    {
+        return(-RT_ERROR);
+    }
+
+    return(rt_device_read(hinst->serial, 0, buf, size));
+}
+
+
+
+
 #ifdef RS485_USING_TEST
 
 #ifndef RS485_TEST_SERIAL
@@ -0,0 +1,737 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ * 2026-10-17     RT-Thread    urgent requests
+ * 2026-10-17     RT-Thread    flush in the gateway thread, join it by a completion
+ * 2026-10-17     RT-Thread    learn the response timeout per slave
+ * 2026-10-17     RT-Thread    hold the bus after a send only request
+ * 2026-10-17     RT-Thread    close the devices the command opened
+ */
+#include "bsp_sys.h"
+#include "bsp_rs485_drv.h"
+
+#ifdef RS485_USING_GATEWAY
+
+#define DBG_TAG "rs485.gw"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#if (RS485_GW_PORT_MAX > 8)
+#error "RS485_GW_PORT_MAX must not be greater than 8"
+#endif
+
+/* 每条总线占两个事件位, 高位为网关命令 */
+#define RS485_GW_EVT_RX(port)       (1UL << (2 * (port)))
+#define RS485_GW_EVT_TX(port)       (1UL << (2 * (port) + 1))
+#define RS485_GW_EVT_REQ            (1UL << 16)
+#define RS485_GW_EVT_STOP           (1UL << 17)
+#define RS485_GW_EVT_ALL            (0xFFFFUL | RS485_GW_EVT_REQ | RS485_GW_EVT_STOP)
+
+/**
+ * @brief 总线状态
+ */
+typedef enum {
+    RS485_GW_IDLE = 0,                          //空闲, 取下一个请求
+    RS485_GW_TX,                                //等待发送完成通知
+    RS485_GW_TAIL,                              //等待末尾数据移出
+    RS485_GW_WAIT,                              //等待应答的第一个字节
+    RS485_GW_RECV,                              //接收中, 字节间超时结束
+    RS485_GW_HOLD,                              //只发送的请求保持总线空闲
+} rs485_gw_state_t;
+
+/**
+ * @brief 一条总线
+ */
+typedef struct {
+    rs485_inst_t *hinst;
+    rs485_gw_state_t state;
+    rt_tick_t deadline;                         //当前状态的超时时刻
+    rs485_gw_req_t *head[2];                    //请求队列, 0 - 紧急, 1 - 普通
+    rs485_gw_req_t *tail[2];
+    rs485_gw_req_t *cur;                        //处理中的请求
+    int rlen;
+    int byte_tmo;
+    int tx_tail;
+    int ack_tmo;                                //应答超时, ms
+#ifdef RS485_USING_RTO
+    int rto;                                    //非0 - 当前请求学习应答超时
+    rt_tick_t sent;                             //发送结束时刻
+    int rtt;                                    //应答时间, ms
+#endif
+    rt_uint32_t req_cnt;
+    rt_uint32_t ok_cnt;
+    rt_uint32_t tmo_cnt;
+    rt_uint32_t err_cnt;
+} rs485_gw_port_t;
+
+/**
+ * @brief 网关服务状态
+ */
+typedef struct {
+    rt_thread_t tid;
+    struct rt_event evt;
+    struct rt_completion exit;                  //网关线程退出
+    int stop;                                   //停止中, submit直接失败
+    int num;
+    rs485_gw_port_t port[RS485_GW_PORT_MAX];
+} rs485_gw_t;
+
+static rs485_gw_t gateway;
+
+/*
+ * @brief   instance notify, runs in the interrupt
+ */
+static void rs485_gw_notify(rs485_inst_t *hinst, int event, void *arg)
+{
+    int port = (int)(rt_ubase_t)arg;
+
+    if (event == RS485_NOTIFY_TX_DONE)
+    {
+        rt_event_send(&gateway.evt, RS485_GW_EVT_TX(port));
+    }
+    else
+    {
+        rt_event_send(&gateway.evt, RS485_GW_EVT_RX(port));
+    }
+}
+
+/*
+ * @brief   take the first request of the queue
+ */
+static rs485_gw_req_t *rs485_gw_pop(rs485_gw_port_t *p)
+{
+    rs485_gw_req_t *req = RT_NULL;
+    rt_base_t level;
+    int q;
+
+    level = rt_hw_interrupt_disable();
+    for (q = 0; q < 2; q++)
+    {
+        req = p->head[q];
+        if (req)
+        {
+            p->head[q] = req->next;
+            if (p->head[q] == RT_NULL)
+            {
+                p->tail[q] = RT_NULL;
+            }
+            req->next = RT_NULL;
+            break;
+        }
+    }
+    rt_hw_interrupt_enable(level);
+
+    return(req);
+}
+
+/*
+ * @brief   done the current request, back to idle
+ */
+static void rs485_gw_finish(rs485_gw_port_t *p, int result)
+{
+    rs485_gw_req_t *req = p->cur;
+
+    if (result >= 0)
+    {
+        p->ok_cnt++;
+    }
+    else if (result == -RT_ETIMEOUT)
+    {
+        p->tmo_cnt++;
+    }
+    else
+    {
+        p->err_cnt++;
+    }
+
+#ifdef RS485_USING_RTO
+    /* 发送失败和停止不算从站超时 */
+    if (p->rto && result != -RT_ERROR)
+    {
+        rs485_rto_end(p->hinst, *(rt_uint8_t *)req->sbuf, (result >= 0) ? p->rtt : -1);
+    }
+    p->rto = 0;
+#endif
+
+    p->cur = RT_NULL;
+    p->state = RS485_GW_IDLE;
+
+    req->result = result;
+    if (req->done)
+    {
+        req->done(req);
+    }
+}
+
+/*
+ * @brief   the datas are sent, release the bus and wait for the reply
+ */
+static void rs485_gw_sent(rs485_gw_port_t *p)
+{
+    rs485_gw_req_t *req = p->cur;
+
+    /* 丢弃发送期间残留的数据 */
+    if (req->rbuf && req->rsize > 0)
+    {
+        while (rs485_read(p->hinst, req->rbuf, req->rsize) > 0);
+    }
+
+    rs485_send_end(p->hinst);
+
+    if (req->rbuf == RT_NULL || req->rsize <= 0 || req->ack_tmo_ms <= 0)
+    {
+        if (req->hold_ms > 0)
+        {
+            p->state = RS485_GW_HOLD;
+            p->deadline = rt_tick_get() + rt_tick_from_millisecond(req->hold_ms);
+            return;
+        }
+        rs485_gw_finish(p, 0);
+        return;
+    }
+
+    p->state = RS485_GW_WAIT;
+    p->deadline = rt_tick_get() + rt_tick_from_millisecond(p->ack_tmo);
+#ifdef RS485_USING_RTO
+    p->sent = rt_tick_get();
+#endif
+}
+
+/*
+ * @brief   run the state machine of one bus
+ * @param   p           - the bus
+ * @param   port        - port number
+ * @param   set         - received events
+ */
+static void rs485_gw_port_run(rs485_gw_port_t *p, int port, rt_uint32_t set)
+{
+    rs485_gw_req_t *req;
+    rt_bool_t expired;
+    int len;
+
+    for (;;)
+    {
+        req = p->cur;
+        expired = (p->state != RS485_GW_IDLE) && ((rt_int32_t)(rt_tick_get() - p->deadline) >= 0);
+
+        switch (p->state)
+        {
+        case RS485_GW_IDLE:
+            req = rs485_gw_pop(p);
+            if (req == RT_NULL)
+            {
+                return;
+            }
+            p->cur = req;
+            p->rlen = 0;
+            p->req_cnt++;
+            p->ack_tmo = req->ack_tmo_ms;
+            rs485_get_timing(p->hinst, &p->byte_tmo, &p->tx_tail);
+
+#ifdef RS485_USING_RTO
+            /* 按从站地址使用学习到的应答超时, 广播没有应答 */
+            if (req->rbuf && req->rsize > 0 && req->ack_tmo_ms > 0 && *(rt_uint8_t *)req->sbuf != 0)
+            {
+                p->ack_tmo = rs485_rto_begin(p->hinst, *(rt_uint8_t *)req->sbuf, req->ack_tmo_ms);
+                if (p->ack_tmo < 0)
+                {
+                    /* 从站退避中, 不发送 */
+                    rs485_gw_finish(p, -RT_EBUSY);
+                    break;
+                }
+                p->rto = 1;
+            }
+#endif
+
+            /* 轮询发送时在rs485_send_start中就会通知完成 */
+            set &= ~RS485_GW_EVT_TX(port);
+            p->state = RS485_GW_TX;
+            p->deadline = rt_tick_get() + rt_tick_from_millisecond(RS485_GW_TX_TMO_MS);
+            if (rs485_send_start(p->hinst, req->sbuf, req->slen) < 0)
+            {
+                rs485_send_end(p->hinst);
+                rs485_gw_finish(p, -RT_ERROR);
+            }
+            break;
+
+        case RS485_GW_TX:
+            if (set & RS485_GW_EVT_TX(port))
+            {
+                set &= ~RS485_GW_EVT_TX(port);
+                if (p->tx_tail > 0)
+                {
+                    p->state = RS485_GW_TAIL;
+                    p->deadline = rt_tick_get() + rt_tick_from_millisecond(p->tx_tail);
+                }
+                else
+                {
+                    rs485_gw_sent(p);
+                }
+            }
+            else if (expired)
+            {
+                LOG_W("rs485 gateway port %d send timeout.", port);
+                rs485_send_end(p->hinst);
+                rs485_gw_finish(p, -RT_ERROR);
+            }
+            else
+            {
+                return;
+            }
+            break;
+
+        case RS485_GW_TAIL:
+            if (!expired)
+            {
+                return;
+            }
+            rs485_gw_sent(p);
+            break;
+
+        case RS485_GW_HOLD:
+            if (!expired)
+            {
+                return;
+            }
+            rs485_gw_finish(p, 0);
+            break;
+
+        case RS485_GW_WAIT:
+        case RS485_GW_RECV:
+            set &= ~RS485_GW_EVT_RX(port);
+            len = rs485_read(p->hinst, (rt_uint8_t *)req->rbuf + p->rlen, req->rsize - p->rlen);
+            if (len > 0)
+            {
+#ifdef RS485_USING_RTO
+                if (p->rlen == 0)
+                {
+                    p->rtt = (rt_int32_t)(rt_tick_get() - p->sent) * 1000 / RT_TICK_PER_SECOND;
+                }
+#endif
+                p->rlen += len;
+                if (p->rlen >= req->rsize)
+                {
+                    rs485_gw_finish(p, p->rlen);
+                    break;
+                }
+                p->state = RS485_GW_RECV;
+                p->deadline = rt_tick_get() + rt_tick_from_millisecond(p->byte_tmo);
+                return;
+            }
+            if (!expired)
+            {
+                return;
+            }
+            rs485_gw_finish(p, (p->state == RS485_GW_RECV) ? p->rlen : -RT_ETIMEOUT);
+            break;
+
+        default:
+            p->state = RS485_GW_IDLE;
+            break;
+        }
+    }
+}
+
+/*
+ * @brief   done all the requests of the bus with the result
+ */
+static void rs485_gw_flush(rs485_gw_port_t *p, int result)
+{
+    if (p->cur)
+    {
+        if (p->state == RS485_GW_TX || p->state == RS485_GW_TAIL)
+        {
+            rs485_send_end(p->hinst);
+        }
+        rs485_gw_finish(p, result);
+    }
+
+    while ((p->cur = rs485_gw_pop(p)) != RT_NULL)
+    {
+        rs485_gw_finish(p, result);
+    }
+}
+
+/*
+ * @brief   gateway thread, sleeps until an event or the nearest deadline
+ */
+static void rs485_gw_thread_entry(void *param)
+{
+    rs485_gw_t *gw = (rs485_gw_t *)param;
+    rs485_gw_port_t *p;
+    rt_uint32_t set;
+    rt_int32_t tmo, left;
+    rt_tick_t now;
+    rt_base_t level;
+    int i;
+
+    for (;;)
+    {
+        now = rt_tick_get();
+        tmo = RT_WAITING_FOREVER;
+        for (i = 0; i < gw->num; i++)
+        {
+            p = &gw->port[i];
+            if (p->state == RS485_GW_IDLE)
+            {
+                continue;
+            }
+            left = (rt_int32_t)(p->deadline - now);
+            if (left < 0)
+            {
+                left = 0;
+            }
+            if (tmo == RT_WAITING_FOREVER || left < tmo)
+            {
+                tmo = left;
+            }
+        }
+
+        set = 0;
+        rt_event_recv(&gw->evt, RS485_GW_EVT_ALL,
+                      RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, tmo, &set);
+        if (set & RS485_GW_EVT_STOP)
+        {
+            break;
+        }
+
+        for (i = 0; i < gw->num; i++)
+        {
+            rs485_gw_port_run(&gw->port[i], i, set);
+        }
+    }
+
+    /* 之后的submit直接失败, 已排队的请求在本线程中完成 */
+    level = rt_hw_interrupt_disable();
+    gw->stop = 1;
+    rt_hw_interrupt_enable(level);
+
+    for (i = 0; i < gw->num; i++)
+    {
+        rs485_set_notify(gw->port[i].hinst, RT_NULL, RT_NULL);
+        rs485_gw_flush(&gw->port[i], -RT_ERROR);
+    }
+
+    rt_completion_done(&gw->exit);
+}
+
+/*
+ * @brief   add a bus to the gateway, before rs485_gw_start
+ * @param   hinst       - instance handle, must be connected
+ * @retval  >=0 - port number, <0 - error
+ */
+int rs485_gw_add(rs485_inst_t * hinst)
+{
+    rs485_gw_t *gw = &gateway;
+    rs485_gw_port_t *p;
+    int i;
+
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 gateway add fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+
+    if (gw->tid != RT_NULL)
+    {
+        LOG_E("rs485 gateway add fail. it is running.");
+        return(-RT_EBUSY);
+    }
+
+    for (i = 0; i < gw->num; i++)
+    {
+        if (gw->port[i].hinst == hinst)
+        {
+            return(i);
+        }
+    }
+
+    if (gw->num >= RS485_GW_PORT_MAX)
+    {
+        LOG_E("rs485 gateway add fail. no more than %d ports.", RS485_GW_PORT_MAX);
+        return(-RT_EFULL);
+    }
+
+    p = &gw->port[gw->num];
+    rt_memset(p, 0, sizeof(rs485_gw_port_t));
+    p->hinst = hinst;
+
+    return(gw->num++);
+}
+
+/*
+ * @brief   start the gateway thread servicing all the added buses
+ * @retval  0 - success, other - error
+ */
+int rs485_gw_start(void)
+{
+    rs485_gw_t *gw = &gateway;
+    int i;
+
+    if (gw->tid != RT_NULL)
+    {
+        LOG_E("rs485 gateway start fail. it is running.");
+        return(-RT_EBUSY);
+    }
+
+    if (gw->num == 0)
+    {
+        LOG_E("rs485 gateway start fail. no port is added.");
+        return(-RT_ERROR);
+    }
+
+    rt_event_init(&gw->evt, "rs485gw", RT_IPC_FLAG_FIFO);
+    rt_completion_init(&gw->exit);
+    gw->stop = 0;
+
+    gw->tid = rt_thread_create("rs485gw", rs485_gw_thread_entry, gw,
+                               1024, RS485_GW_THREAD_PRIO, 10);
+    if (gw->tid == RT_NULL)
+    {
+        rt_event_detach(&gw->evt);
+        LOG_E("rs485 gateway start fail. thread create fail.");
+        return(-RT_ENOMEM);
+    }
+
+    for (i = 0; i < gw->num; i++)
+    {
+        rs485_set_notify(gw->port[i].hinst, rs485_gw_notify, (void *)(rt_ubase_t)i);
+    }
+
+    rt_thread_startup(gw->tid);
+
+    LOG_I("rs485 gateway start success, %d ports.", gw->num);
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   stop the gateway, the pending requests are done with -RT_ERROR
+ * @retval  0 - success, other - error
+ */
+int rs485_gw_stop(void)
+{
+    rs485_gw_t *gw = &gateway;
+
+    if (gw->tid == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    if (gw->tid == rt_thread_self())
+    {
+        LOG_E("rs485 gateway stop fail. called in the gateway thread.");
+        return(-RT_EBUSY);
+    }
+
+    /* 网关线程完成全部请求后退出 */
+    rt_event_send(&gw->evt, RS485_GW_EVT_STOP);
+    rt_completion_wait(&gw->exit, RT_WAITING_FOREVER);
+
+    gw->tid = RT_NULL;
+    gw->num = 0;
+
+    rt_event_detach(&gw->evt);
+
+    LOG_I("rs485 gateway stop success.");
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   queue a request to its bus
+ * @param   req         - request, kept until its done callback
+ * @retval  0 - success, other - error
+ */
+int rs485_gw_submit(rs485_gw_req_t *req)
+{
+    rs485_gw_t *gw = &gateway;
+    rs485_gw_port_t *p;
+    rt_base_t level;
+    int q;
+
+    if (req == RT_NULL || req->sbuf == RT_NULL || req->slen <= 0)
+    {
+        return(-RT_EINVAL);
+    }
+
+    level = rt_hw_interrupt_disable();
+    if (gw->tid == RT_NULL || gw->stop || req->port < 0 || req->port >= gw->num)
+    {
+        rt_hw_interrupt_enable(level);
+        return(-RT_ERROR);
+    }
+
+    p = &gw->port[req->port];
+    q = req->urgent ? 0 : 1;
+    req->next = RT_NULL;
+    if (p->tail[q])
+    {
+        p->tail[q]->next = req;
+    }
+    else
+    {
+        p->head[q] = req;
+    }
+    p->tail[q] = req;
+    rt_hw_interrupt_enable(level);
+
+    rt_event_send(&gw->evt, RS485_GW_EVT_REQ);
+
+    return(RT_EOK);
+}
+
+static void rs485_gw_transfer_done(rs485_gw_req_t *req)
+{
+    rt_sem_release((rt_sem_t)req->user_data);
+}
+
+/*
+ * @brief   send then receive through the gateway and wait for the result
+ * @retval  >=0 - length of receive datas, <0 - error
+ */
+int rs485_gw_transfer(int port, void *sbuf, int slen, void *rbuf, int rsize, int ack_tmo_ms)
+{
+    struct rt_semaphore sem;
+    rs485_gw_req_t req;
+    int rst;
+
+    rt_memset(&req, 0, sizeof(req));
+    req.port = port;
+    req.sbuf = sbuf;
+    req.slen = slen;
+    req.rbuf = rbuf;
+    req.rsize = rsize;
+    req.ack_tmo_ms = ack_tmo_ms;
+    req.done = rs485_gw_transfer_done;
+    req.user_data = &sem;
+
+    rt_sem_init(&sem, "rs485gw", 0, RT_IPC_FLAG_FIFO);
+
+    rst = rs485_gw_submit(&req);
+    if (rst == RT_EOK)
+    {
+        /* 每个请求都会完成, 超时由网关处理 */
+        rt_sem_take(&sem, RT_WAITING_FOREVER);
+        rst = req.result;
+    }
+
+    rt_sem_detach(&sem);
+
+    return(rst);
+}
+
+static rt_device_t gw_dev[RS485_GW_PORT_MAX];   //命令打开的设备, 停止时关闭
+static int gw_dev_num;
+
+/*
+ * @brief   close the devices the command opened, drop the ports it added
+ * @param   num         - ports of the gateway before the command
+ */
+static void rs485_gw_close_dev(int num)
+{
+    rs485_gw_t *gw = &gateway;
+
+    if (gw->tid == RT_NULL && gw->num > num)
+    {
+        gw->num = num;
+    }
+
+    while (gw_dev_num > 0)
+    {
+        rt_device_close(gw_dev[--gw_dev_num]);
+        gw_dev[gw_dev_num] = RT_NULL;
+    }
+}
+
+/**
+ * @brief 网关命令（FinSH shell 命令）
+ *
+ * 使用方式：
+ *   rs485_gw start rs485-1 rs485-2
+ *   rs485_gw stop
+ *   rs485_gw stat
+ */
+static void rs485_gw(int argc, char **argv)
+{
+    rs485_gw_t *gw = &gateway;
+    rs485_gw_port_t *p;
+    rt_device_t dev;
+    int i, num;
+
+    if ((argc >= 3) && (strcmp(argv[1], "start") == 0))
+    {
+        if (gw->tid != RT_NULL)
+        {
+            rt_kprintf("rs485 gateway is running.\n");
+            return;
+        }
+        if (argc - 2 > RS485_GW_PORT_MAX)
+        {
+            rt_kprintf("rs485 gateway serves no more than %d ports.\n", RS485_GW_PORT_MAX);
+            return;
+        }
+        num = gw->num;
+        for (i = 2; i < argc; i++)
+        {
+            dev = rt_device_find(argv[i]);
+            if (dev == RT_NULL)
+            {
+                rt_kprintf("rs485 device %s not found.\n", argv[i]);
+                rs485_gw_close_dev(num);
+                return;
+            }
+            if (rt_device_open(dev, RT_DEVICE_OFLAG_RDWR) != RT_EOK)
+            {
+                rt_kprintf("rs485 device %s open fail.\n", argv[i]);
+                rs485_gw_close_dev(num);
+                return;
+            }
+            gw_dev[gw_dev_num++] = dev;
+            if (rs485_gw_add(((rs485_dev_t *)dev)->hinst) < 0)
+            {
+                rs485_gw_close_dev(num);
+                return;
+            }
+        }
+        if (rs485_gw_start() != RT_EOK)
+        {
+            rs485_gw_close_dev(num);
+        }
+        return;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "stop") == 0))
+    {
+        if (rs485_gw_stop() == RT_EOK)
+        {
+            rs485_gw_close_dev(0);
+        }
+        return;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "stat") == 0))
+    {
+        rt_kprintf("port state    request         ok        timeout   error\n");
+        for (i = 0; i < gw->num; i++)
+        {
+            p = &gw->port[i];
+            rt_kprintf("%-4d %-8d %-15u %-9u %-9u %u\n", i, p->state,
+                       p->req_cnt, p->ok_cnt, p->tmo_cnt, p->err_cnt);
+        }
+        return;
+    }
+
+    rt_kprintf("Usage: \n");
+    rt_kprintf("rs485_gw start [rs485 device]...  - service the buses from one thread.\n");
+    rt_kprintf("rs485_gw stop                     - stop the gateway.\n");
+    rt_kprintf("rs485_gw stat                     - show the counters of the buses.\n");
+}
+MSH_CMD_EXPORT(rs485_gw, multi-port rs485 gateway);
+
+#endif
@@ -0,0 +1,926 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ * 2026-10-17     RT-Thread    a backed-off slave answers as no response
+ * 2026-10-17     RT-Thread    join the listen thread before closing its socket, broadcast turnaround
+ * 2026-10-17     RT-Thread    a broadcast clears the cache of the bus, join the client threads on stop
+ */
+#include "bsp_sys.h"
+#include "bsp_rs485_drv.h"
+
+#if defined(RS485_USING_MBTCP) && defined(RT_USING_SAL)
+
+#ifndef RS485_USING_GATEWAY
+#error "RS485_USING_MBTCP needs RS485_USING_GATEWAY"
+#endif
+
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#define DBG_TAG "rs485.mbtcp"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#define MBTCP_MBAP_SIZE         7       //事务号, 协议号, 长度, 单元号
+#define MBTCP_PDU_MAX           253
+#define MBTCP_ADU_MAX           256     //RTU帧: 地址 + PDU + CRC
+#define MBTCP_UNIT_NUM          248
+
+#define MB_FC_READ_COILS        0x01
+#define MB_FC_READ_DISCRETE     0x02
+#define MB_FC_READ_HOLDING      0x03
+#define MB_FC_READ_INPUT        0x04
+#define MB_FC_WRITE_COIL        0x05
+#define MB_FC_WRITE_REG         0x06
+#define MB_FC_WRITE_COILS       0x0F
+#define MB_FC_WRITE_REGS        0x10
+
+#define MB_EX_ILLEGAL_VALUE     0x03
+#define MB_EX_GW_PATH           0x0A    //网关路径不可用
+#define MB_EX_GW_NO_RESPONSE    0x0B    //目标从站无应答
+
+#define MB_FC_IS_READ(fc)       ((fc) >= MB_FC_READ_COILS && (fc) <= MB_FC_READ_INPUT)
+#define MB_FC_IS_REG(fc)        ((fc) == MB_FC_READ_HOLDING || (fc) == MB_FC_READ_INPUT)
+
+typedef struct mbtcp_txn mbtcp_txn_t;
+
+/**
+ * @brief 一次总线事务, 读事务的结果可被多个客户端共享
+ */
+struct mbtcp_txn {
+    rs485_gw_req_t req;
+    mbtcp_txn_t *next;                  //进行中的读事务
+    rt_uint8_t port;
+    rt_uint8_t unit;
+    rt_uint8_t fc;
+    rt_uint16_t addr;                   //读范围
+    rt_uint16_t qty;
+    rt_uint32_t wgen;                   //提交时的写计数, 之后有写则结果不缓存
+    int refs;                           //持有者数
+    int joined;                         //共享结果的客户端数, 不含发起者
+    struct rt_semaphore done;           //总线完成, 发起者等待
+    struct rt_semaphore join;           //发起者处理完, 共享者等待
+    rt_uint8_t sbuf[MBTCP_ADU_MAX];
+    rt_uint8_t rbuf[MBTCP_ADU_MAX];
+};
+
+/**
+ * @brief 读结果缓存
+ */
+typedef struct {
+    rt_uint8_t used;
+    rt_uint8_t port;
+    rt_uint8_t unit;
+    rt_uint8_t fc;
+    rt_uint16_t addr;
+    rt_uint16_t qty;
+    rt_tick_t tick;                     //读到的时刻
+    rt_uint8_t data[MBTCP_PDU_MAX - 2]; //与RTU应答的数据区相同
+} mbtcp_cache_t;
+
+/**
+ * @brief 一个客户端连接
+ */
+typedef struct {
+    int sock;
+    rt_thread_t tid;
+    struct rt_completion exit;          //线程退出, 空闲的槽位总是已完成
+    rt_uint8_t buf[MBTCP_MBAP_SIZE + MBTCP_PDU_MAX];
+} mbtcp_client_t;
+
+/**
+ * @brief 网关服务状态
+ */
+typedef struct {
+    int sock;
+    rt_thread_t tid;
+    struct rt_completion exit;          //监听线程退出
+    volatile rt_uint8_t running;
+    struct rt_mutex lock;               //保护进行中的事务, 缓存和客户端
+    mbtcp_txn_t *inflight;
+    rt_uint32_t wgen;
+    rt_int32_t ttl;
+    rt_int8_t route[MBTCP_UNIT_NUM];
+    mbtcp_cache_t cache[RS485_MBTCP_CACHE_NUM];
+    mbtcp_client_t client[RS485_MBTCP_CLIENT_MAX];
+    rt_uint32_t served;                 //应答的请求数
+    rt_uint32_t hits;                   //缓存应答数
+    rt_uint32_t joins;                  //共享进行中读事务的请求数
+    rt_uint32_t bus_reads;              //总线读事务数
+    rt_uint32_t bus_writes;             //总线写及其它事务数
+    rt_uint32_t fails;                  //超时或应答错误数
+} mbtcp_server_t;
+
+static mbtcp_server_t mbtcp = { .sock = -1, .ttl = RS485_MBTCP_CACHE_TTL_MS };
+
+static rt_uint16_t mbtcp_crc16(const rt_uint8_t *data, int len)
+{
+    rt_uint16_t crc = 0xFFFF;
+    int i;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+        }
+    }
+
+    return(crc);
+}
+
+/* 读应答的数据字节数 */
+static int mbtcp_read_bytes(rt_uint8_t fc, rt_uint16_t qty)
+{
+    return(MB_FC_IS_REG(fc) ? (qty * 2) : ((qty + 7) / 8));
+}
+
+static int mbtcp_exception(rt_uint8_t fc, rt_uint8_t code, rt_uint8_t *pdu)
+{
+    pdu[0] = fc | 0x80;
+    pdu[1] = code;
+    return(2);
+}
+
+/*
+ * @brief   build the read response from the datas of a covering read
+ * @param   fc          - function code
+ * @param   src_addr    - start address of the datas
+ * @param   src         - datas, as the data field of the rtu response
+ * @param   addr        - start address of the request
+ * @param   qty         - quantity of the request
+ * @param   pdu         - response pdu
+ * @retval  length of the response pdu
+ */
+static int mbtcp_read_slice(rt_uint8_t fc, rt_uint16_t src_addr, const rt_uint8_t *src,
+                            rt_uint16_t addr, rt_uint16_t qty, rt_uint8_t *pdu)
+{
+    int off = addr - src_addr;
+    int n = mbtcp_read_bytes(fc, qty);
+    int i, bit;
+
+    pdu[0] = fc;
+    pdu[1] = n;
+    if (MB_FC_IS_REG(fc))
+    {
+        rt_memmove(&pdu[2], &src[off * 2], n);
+    }
+    else
+    {
+        rt_memset(&pdu[2], 0, n);
+        for (i = 0; i < qty; i++)
+        {
+            bit = off + i;
+            if (src[bit >> 3] & (1 << (bit & 7)))
+            {
+                pdu[2 + (i >> 3)] |= 1 << (i & 7);
+            }
+        }
+    }
+
+    return(n + 2);
+}
+
+/*
+ * @brief   check the rtu response of a transaction
+ * @retval  >0 - length of the response pdu in txn->rbuf[1], <0 - modbus exception code
+ */
+static int mbtcp_txn_check(mbtcp_txn_t *txn)
+{
+    int len = txn->req.result;
+    rt_uint8_t *r = txn->rbuf;
+
+    /* 从站退避中同无应答 */
+    if (len == -RT_ETIMEOUT || len == -RT_EBUSY)
+    {
+        return(-MB_EX_GW_NO_RESPONSE);
+    }
+    if (len < 0)
+    {
+        return(-MB_EX_GW_PATH);
+    }
+
+    /* 地址 + 功能码 + 异常码 + CRC */
+    if (len < 5 || r[0] != txn->unit || (r[1] & 0x7F) != txn->fc ||
+        mbtcp_crc16(r, len - 2) != (r[len - 2] | (r[len - 1] << 8)))
+    {
+        return(-MB_EX_GW_NO_RESPONSE);
+    }
+
+    if (MB_FC_IS_READ(txn->fc) && !(r[1] & 0x80) &&
+        (r[2] != mbtcp_read_bytes(txn->fc, txn->qty) || len != r[2] + 5))
+    {
+        return(-MB_EX_GW_NO_RESPONSE);
+    }
+
+    return(len - 3);
+}
+
+static void mbtcp_txn_done(rs485_gw_req_t *req)
+{
+    rt_sem_release(&((mbtcp_txn_t *)req->user_data)->done);
+}
+
+static mbtcp_txn_t *mbtcp_txn_create(int port, rt_uint8_t unit, const rt_uint8_t *pdu, int len)
+{
+    mbtcp_txn_t *txn;
+    rt_uint16_t crc;
+
+    txn = rt_calloc(1, sizeof(mbtcp_txn_t));
+    if (txn == RT_NULL)
+    {
+        return(RT_NULL);
+    }
+
+    txn->port = port;
+    txn->unit = unit;
+    txn->fc = pdu[0];
+    txn->refs = 1;
+
+    txn->sbuf[0] = unit;
+    rt_memcpy(&txn->sbuf[1], pdu, len);
+    crc = mbtcp_crc16(txn->sbuf, len + 1);
+    txn->sbuf[len + 1] = crc & 0xFF;
+    txn->sbuf[len + 2] = crc >> 8;
+
+    txn->req.port = port;
+    txn->req.sbuf = txn->sbuf;
+    txn->req.slen = len + 3;
+    txn->req.rbuf = txn->rbuf;
+    txn->req.rsize = MBTCP_ADU_MAX;
+    txn->req.ack_tmo_ms = (unit == 0) ? 0 : RS485_MBTCP_ACK_TMO_MS;
+    /* 广播后给从站处理的时间, 之后才发下一个请求 */
+    txn->req.hold_ms = (unit == 0) ? RS485_MBTCP_TURNAROUND_MS : 0;
+    txn->req.done = mbtcp_txn_done;
+    txn->req.user_data = txn;
+
+    rt_sem_init(&txn->done, "mbtcp", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&txn->join, "mbtcp", 0, RT_IPC_FLAG_FIFO);
+
+    return(txn);
+}
+
+static void mbtcp_txn_put(mbtcp_server_t *srv, mbtcp_txn_t *txn)
+{
+    int refs;
+
+    rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+    refs = --txn->refs;
+    rt_mutex_release(&srv->lock);
+
+    if (refs == 0)
+    {
+        rt_sem_detach(&txn->done);
+        rt_sem_detach(&txn->join);
+        rt_free(txn);
+    }
+}
+
+/* 有效期内覆盖请求范围的缓存, 在锁内调用 */
+static mbtcp_cache_t *mbtcp_cache_find(mbtcp_server_t *srv, int port, rt_uint8_t unit,
+                                       rt_uint8_t fc, rt_uint16_t addr, rt_uint16_t qty)
+{
+    mbtcp_cache_t *c;
+    int i;
+
+    if (srv->ttl <= 0)
+    {
+        return(RT_NULL);
+    }
+
+    for (i = 0; i < RS485_MBTCP_CACHE_NUM; i++)
+    {
+        c = &srv->cache[i];
+        if (c->used && c->port == port && c->unit == unit && c->fc == fc &&
+            c->addr <= addr && (rt_uint32_t)c->addr + c->qty >= (rt_uint32_t)addr + qty)
+        {
+            if ((rt_tick_get() - c->tick) < rt_tick_from_millisecond(srv->ttl))
+            {
+                return(c);
+            }
+            c->used = 0;
+        }
+    }
+
+    return(RT_NULL);
+}
+
+/* 保存读结果, 替换相同范围, 空闲或最旧的一项, 在锁内调用 */
+static void mbtcp_cache_store(mbtcp_server_t *srv, mbtcp_txn_t *txn)
+{
+    mbtcp_cache_t *c = RT_NULL, *e;
+    int i;
+
+    if (srv->ttl <= 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < RS485_MBTCP_CACHE_NUM; i++)
+    {
+        e = &srv->cache[i];
+        if (e->used && e->port == txn->port && e->unit == txn->unit &&
+            e->fc == txn->fc && e->addr == txn->addr && e->qty == txn->qty)
+        {
+            c = e;
+            break;
+        }
+        if (c == RT_NULL || !e->used || (c->used && (rt_int32_t)(e->tick - c->tick) < 0))
+        {
+            c = e;
+        }
+    }
+
+    c->used = 1;
+    c->port = txn->port;
+    c->unit = txn->unit;
+    c->fc = txn->fc;
+    c->addr = txn->addr;
+    c->qty = txn->qty;
+    c->tick = rt_tick_get();
+    rt_memcpy(c->data, &txn->rbuf[3], txn->rbuf[2]);
+}
+
+/* 写之后清除从站的缓存, 广播清除整条总线的, 在锁内调用 */
+static void mbtcp_cache_clear(mbtcp_server_t *srv, int port, rt_uint8_t unit)
+{
+    int i;
+
+    srv->wgen++;
+    for (i = 0; i < RS485_MBTCP_CACHE_NUM; i++)
+    {
+        if (srv->cache[i].port == port && (unit == 0 || srv->cache[i].unit == unit))
+        {
+            srv->cache[i].used = 0;
+        }
+    }
+}
+
+/*
+ * @brief   handle a read request, from the cache, an in-flight read or the bus
+ * @retval  length of the response pdu
+ */
+static int mbtcp_handle_read(mbtcp_server_t *srv, int port, rt_uint8_t unit, rt_uint8_t *pdu)
+{
+    rt_uint8_t fc = pdu[0];
+    rt_uint16_t addr = (pdu[1] << 8) | pdu[2];
+    rt_uint16_t qty = (pdu[3] << 8) | pdu[4];
+    mbtcp_cache_t *c;
+    mbtcp_txn_t *txn, **pp;
+    int joined, len, owner = 0;
+
+    if (qty == 0 || qty > (MB_FC_IS_REG(fc) ? 125 : 2000))
+    {
+        return(mbtcp_exception(fc, MB_EX_ILLEGAL_VALUE, pdu));
+    }
+
+    rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+
+    c = mbtcp_cache_find(srv, port, unit, fc, addr, qty);
+    if (c)
+    {
+        len = mbtcp_read_slice(fc, c->addr, c->data, addr, qty, pdu);
+        srv->hits++;
+        rt_mutex_release(&srv->lock);
+        return(len);
+    }
+
+    /* 共享覆盖请求范围的进行中读事务 */
+    for (txn = srv->inflight; txn; txn = txn->next)
+    {
+        if (txn->port == port && txn->unit == unit && txn->fc == fc &&
+            txn->addr <= addr && (rt_uint32_t)txn->addr + txn->qty >= (rt_uint32_t)addr + qty)
+        {
+            txn->refs++;
+            txn->joined++;
+            srv->joins++;
+            break;
+        }
+    }
+
+    if (txn == RT_NULL)
+    {
+        txn = mbtcp_txn_create(port, unit, pdu, 5);
+        if (txn == RT_NULL)
+        {
+            rt_mutex_release(&srv->lock);
+            return(mbtcp_exception(fc, MB_EX_GW_PATH, pdu));
+        }
+        txn->addr = addr;
+        txn->qty = qty;
+        txn->wgen = srv->wgen;
+        /* 应答长度已知, 收齐即完成, 不等字节间超时 */
+        txn->req.rsize = mbtcp_read_bytes(fc, qty) + 5;
+        txn->next = srv->inflight;
+        srv->inflight = txn;
+        srv->bus_reads++;
+        owner = 1;
+    }
+
+    rt_mutex_release(&srv->lock);
+
+    if (owner)
+    {
+        if (rs485_gw_submit(&txn->req) != RT_EOK)
+        {
+            txn->req.result = -RT_ERROR;
+        }
+        else
+        {
+            rt_sem_take(&txn->done, RT_WAITING_FOREVER);
+        }
+
+        rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+        for (pp = &srv->inflight; *pp; pp = &(*pp)->next)
+        {
+            if (*pp == txn)
+            {
+                *pp = txn->next;
+                break;
+            }
+        }
+        len = mbtcp_txn_check(txn);
+        if (len > 0 && !(txn->rbuf[1] & 0x80) && txn->wgen == srv->wgen)
+        {
+            mbtcp_cache_store(srv, txn);
+        }
+        if (len < 0)
+        {
+            srv->fails++;
+        }
+        joined = txn->joined;
+        rt_mutex_release(&srv->lock);
+
+        while (joined--)
+        {
+            rt_sem_release(&txn->join);
+        }
+    }
+    else
+    {
+        rt_sem_take(&txn->join, RT_WAITING_FOREVER);
+        len = mbtcp_txn_check(txn);
+    }
+
+    if (len < 0)
+    {
+        len = mbtcp_exception(fc, -len, pdu);
+    }
+    else if (txn->rbuf[1] & 0x80)
+    {
+        rt_memcpy(pdu, &txn->rbuf[1], len);
+    }
+    else
+    {
+        len = mbtcp_read_slice(fc, txn->addr, &txn->rbuf[3], addr, qty, pdu);
+    }
+
+    mbtcp_txn_put(srv, txn);
+
+    return(len);
+}
+
+/*
+ * @brief   handle a write or other request, sent before the queued reads
+ * @retval  length of the response pdu, 0 - no response
+ */
+static int mbtcp_handle_other(mbtcp_server_t *srv, int port, rt_uint8_t unit, rt_uint8_t *pdu, int len)
+{
+    rt_uint8_t fc = pdu[0];
+    mbtcp_txn_t *txn;
+
+    txn = mbtcp_txn_create(port, unit, pdu, len);
+    if (txn == RT_NULL)
+    {
+        return(mbtcp_exception(fc, MB_EX_GW_PATH, pdu));
+    }
+    txn->req.urgent = 1;
+    if (fc == MB_FC_WRITE_COIL || fc == MB_FC_WRITE_REG ||
+        fc == MB_FC_WRITE_COILS || fc == MB_FC_WRITE_REGS)
+    {
+        txn->req.rsize = 8;
+    }
+
+    /* 其它功能码也可能修改数据 */
+    rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+    mbtcp_cache_clear(srv, port, unit);
+    srv->bus_writes++;
+    rt_mutex_release(&srv->lock);
+
+    if (rs485_gw_submit(&txn->req) != RT_EOK)
+    {
+        txn->req.result = -RT_ERROR;
+    }
+    else
+    {
+        rt_sem_take(&txn->done, RT_WAITING_FOREVER);
+    }
+
+    if (unit == 0)
+    {
+        /* 广播没有应答 */
+        len = 0;
+    }
+    else
+    {
+        len = mbtcp_txn_check(txn);
+        if (len < 0)
+        {
+            srv->fails++;
+            len = mbtcp_exception(fc, -len, pdu);
+        }
+        else
+        {
+            rt_memcpy(pdu, &txn->rbuf[1], len);
+        }
+    }
+
+    mbtcp_txn_put(srv, txn);
+
+    return(len);
+}
+
+static int mbtcp_recv_all(int sock, rt_uint8_t *buf, int len)
+{
+    int n;
+
+    while (len > 0)
+    {
+        n = recv(sock, buf, len, 0);
+        if (n <= 0)
+        {
+            return(-1);
+        }
+        buf += n;
+        len -= n;
+    }
+
+    return(0);
+}
+
+/*
+ * @brief   client thread, one request at a time, the response pdu is built in place
+ */
+static void mbtcp_client_entry(void *param)
+{
+    mbtcp_client_t *cl = (mbtcp_client_t *)param;
+    mbtcp_server_t *srv = &mbtcp;
+    rt_uint8_t *buf = cl->buf;
+    rt_uint8_t unit;
+    int len, port;
+
+    while (srv->running)
+    {
+        if (mbtcp_recv_all(cl->sock, buf, MBTCP_MBAP_SIZE) < 0)
+        {
+            break;
+        }
+
+        /* 协议号必须为0 */
+        len = (buf[4] << 8) | buf[5];
+        if (buf[2] != 0 || buf[3] != 0 || len < 2 || len > MBTCP_PDU_MAX + 1)
+        {
+            break;
+        }
+        if (mbtcp_recv_all(cl->sock, &buf[MBTCP_MBAP_SIZE], len - 1) < 0)
+        {
+            break;
+        }
+
+        len -= 1;
+        unit = buf[6];
+        port = (unit < MBTCP_UNIT_NUM) ? srv->route[unit] : -1;
+
+        if (port < 0)
+        {
+            len = mbtcp_exception(buf[MBTCP_MBAP_SIZE], MB_EX_GW_PATH, &buf[MBTCP_MBAP_SIZE]);
+        }
+        else if (MB_FC_IS_READ(buf[MBTCP_MBAP_SIZE]) && len == 5 && unit != 0)
+        {
+            len = mbtcp_handle_read(srv, port, unit, &buf[MBTCP_MBAP_SIZE]);
+        }
+        else
+        {
+            len = mbtcp_handle_other(srv, port, unit, &buf[MBTCP_MBAP_SIZE], len);
+        }
+
+        if (len > 0)
+        {
+            srv->served++;
+            buf[4] = (len + 1) >> 8;
+            buf[5] = (len + 1) & 0xFF;
+            if (send(cl->sock, buf, MBTCP_MBAP_SIZE + len, 0) < 0)
+            {
+                break;
+            }
+        }
+    }
+
+    rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+    closesocket(cl->sock);
+    cl->sock = -1;
+    cl->tid = RT_NULL;
+    rt_mutex_release(&srv->lock);
+
+    /* 最后通知, 之后不再访问槽位 */
+    rt_completion_done(&cl->exit);
+}
+
+/*
+ * @brief   listen thread, a thread for each client
+ */
+static void mbtcp_server_entry(void *param)
+{
+    mbtcp_server_t *srv = (mbtcp_server_t *)param;
+    mbtcp_client_t *cl;
+    struct sockaddr_in addr;
+    socklen_t addrlen;
+    struct timeval tv;
+    char name[RT_NAME_MAX];
+    int sock, opt, i;
+
+    while (srv->running)
+    {
+        addrlen = sizeof(addr);
+        sock = accept(srv->sock, (struct sockaddr *)&addr, &addrlen);
+        if (sock < 0)
+        {
+            if (srv->running)
+            {
+                rt_thread_mdelay(100);
+            }
+            continue;
+        }
+
+        rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+        cl = RT_NULL;
+        for (i = 0; i < RS485_MBTCP_CLIENT_MAX; i++)
+        {
+            if (srv->client[i].tid == RT_NULL)
+            {
+                cl = &srv->client[i];
+                break;
+            }
+        }
+        if (cl == RT_NULL || !srv->running)
+        {
+            rt_mutex_release(&srv->lock);
+            LOG_W("rs485 mbtcp refuse a client, %d clients connected.", RS485_MBTCP_CLIENT_MAX);
+            closesocket(sock);
+            continue;
+        }
+
+        /* 上一个线程已释放槽位, 等它通知完 */
+        rt_completion_wait(&cl->exit, RT_WAITING_FOREVER);
+
+        tv.tv_sec = RS485_MBTCP_IDLE_S;
+        tv.tv_usec = 0;
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (void *)&tv, sizeof(tv));
+        opt = 1;
+        setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (void *)&opt, sizeof(opt));
+
+        rt_snprintf(name, sizeof(name), "mbtc%d", i);
+        cl->sock = sock;
+        cl->tid = rt_thread_create(name, mbtcp_client_entry, cl,
+                                   2048, RS485_MBTCP_THREAD_PRIO, 10);
+        if (cl->tid == RT_NULL)
+        {
+            cl->sock = -1;
+            rt_completion_done(&cl->exit);
+            rt_mutex_release(&srv->lock);
+            LOG_E("rs485 mbtcp client thread create fail.");
+            closesocket(sock);
+            continue;
+        }
+        rt_thread_startup(cl->tid);
+        rt_mutex_release(&srv->lock);
+    }
+
+    srv->tid = RT_NULL;
+    rt_completion_done(&srv->exit);
+}
+
+/*
+ * @brief   start the modbus tcp to rtu gateway
+ * @param   tcp_port    - listen port, 0 - RS485_MBTCP_PORT
+ * @retval  0 - success, other - error
+ */
+int rs485_mbtcp_start(int tcp_port)
+{
+    mbtcp_server_t *srv = &mbtcp;
+    struct sockaddr_in addr;
+    int opt = 1;
+    int i;
+
+    if (srv->running || srv->tid != RT_NULL)
+    {
+        LOG_E("rs485 mbtcp start fail. it is running.");
+        return(-RT_EBUSY);
+    }
+
+    srv->sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (srv->sock < 0)
+    {
+        LOG_E("rs485 mbtcp start fail. socket create fail.");
+        return(-RT_ERROR);
+    }
+    setsockopt(srv->sock, SOL_SOCKET, SO_REUSEADDR, (void *)&opt, sizeof(opt));
+
+    rt_memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((tcp_port > 0) ? tcp_port : RS485_MBTCP_PORT);
+    addr.sin_addr.s_addr = INADDR_ANY;
+    if (bind(srv->sock, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(srv->sock, RS485_MBTCP_CLIENT_MAX) < 0)
+    {
+        closesocket(srv->sock);
+        srv->sock = -1;
+        LOG_E("rs485 mbtcp start fail. port %d is not available.", ntohs(addr.sin_port));
+        return(-RT_ERROR);
+    }
+
+    rt_mutex_init(&srv->lock, "mbtcp", RT_IPC_FLAG_PRIO);
+    srv->inflight = RT_NULL;
+    rt_memset(srv->cache, 0, sizeof(srv->cache));
+    for (i = 0; i < RS485_MBTCP_CLIENT_MAX; i++)
+    {
+        srv->client[i].sock = -1;
+        srv->client[i].tid = RT_NULL;
+        rt_completion_init(&srv->client[i].exit);
+        rt_completion_done(&srv->client[i].exit);
+    }
+
+    rt_completion_init(&srv->exit);
+    srv->running = 1;
+    srv->tid = rt_thread_create("mbtcp", mbtcp_server_entry, srv,
+                                1024, RS485_MBTCP_THREAD_PRIO, 10);
+    if (srv->tid == RT_NULL)
+    {
+        srv->running = 0;
+        closesocket(srv->sock);
+        srv->sock = -1;
+        rt_mutex_detach(&srv->lock);
+        LOG_E("rs485 mbtcp start fail. thread create fail.");
+        return(-RT_ENOMEM);
+    }
+    rt_thread_startup(srv->tid);
+
+    LOG_I("rs485 mbtcp start success, port %d.", ntohs(addr.sin_port));
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   stop the modbus tcp to rtu gateway
+ * @retval  0 - success, other - error
+ */
+int rs485_mbtcp_stop(void)
+{
+    mbtcp_server_t *srv = &mbtcp;
+    int i;
+
+    if (!srv->running)
+    {
+        return(-RT_ERROR);
+    }
+
+    /* 关闭监听使accept返回, 监听线程退出后才释放套接字 */
+    srv->running = 0;
+    shutdown(srv->sock, SHUT_RDWR);
+    rt_completion_wait(&srv->exit, RT_WAITING_FOREVER);
+    closesocket(srv->sock);
+    srv->sock = -1;
+
+    /* 关闭连接使recv返回, 总线请求总会完成 */
+    rt_mutex_take(&srv->lock, RT_WAITING_FOREVER);
+    for (i = 0; i < RS485_MBTCP_CLIENT_MAX; i++)
+    {
+        if (srv->client[i].tid != RT_NULL)
+        {
+            shutdown(srv->client[i].sock, SHUT_RDWR);
+        }
+    }
+    rt_mutex_release(&srv->lock);
+
+    for (i = 0; i < RS485_MBTCP_CLIENT_MAX; i++)
+    {
+        rt_completion_wait(&srv->client[i].exit, RT_WAITING_FOREVER);
+    }
+
+    rt_mutex_detach(&srv->lock);
+
+    LOG_I("rs485 mbtcp stop success.");
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   route a unit id to a bus
+ * @param   unit        - unit id, 0~247, also the rtu slave address
+ * @param   port        - port number of the rs485 gateway, <0 - not routed
+ * @retval  0 - success, other - error
+ */
+int rs485_mbtcp_route(int unit, int port)
+{
+    if (unit < 0 || unit >= MBTCP_UNIT_NUM || port >= RS485_GW_PORT_MAX)
+    {
+        return(-RT_EINVAL);
+    }
+
+    /* 默认全部为0, 即第一条总线 */
+    mbtcp.route[unit] = (port < 0) ? -1 : port;
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   set the ttl of the read cache
+ * @param   ttl_ms      - ttl, 0 - no cache
+ * @retval  0 - success, other - error
+ */
+int rs485_mbtcp_set_ttl(int ttl_ms)
+{
+    if (ttl_ms < 0)
+    {
+        return(-RT_EINVAL);
+    }
+
+    mbtcp.ttl = ttl_ms;
+
+    return(RT_EOK);
+}
+
+/**
+ * @brief Modbus TCP网关命令（FinSH shell 命令）
+ *
+ * 使用方式：
+ *   rs485_mbtcp start 502
+ *   rs485_mbtcp route 5 1
+ *   rs485_mbtcp ttl 200
+ *   rs485_mbtcp stat
+ *   rs485_mbtcp stop
+ */
+static void rs485_mbtcp(int argc, char **argv)
+{
+    mbtcp_server_t *srv = &mbtcp;
+    rt_uint32_t bus;
+
+    if ((argc >= 2) && (strcmp(argv[1], "start") == 0))
+    {
+        rs485_mbtcp_start((argc >= 3) ? atoi(argv[2]) : 0);
+        return;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "stop") == 0))
+    {
+        rs485_mbtcp_stop();
+        return;
+    }
+
+    if ((argc == 4) && (strcmp(argv[1], "route") == 0))
+    {
+        if (rs485_mbtcp_route(atoi(argv[2]), atoi(argv[3])) != RT_EOK)
+        {
+            rt_kprintf("rs485 mbtcp route param error.\n");
+        }
+        return;
+    }
+
+    if ((argc == 3) && (strcmp(argv[1], "ttl") == 0))
+    {
+        rs485_mbtcp_set_ttl(atoi(argv[2]));
+        return;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "stat") == 0))
+    {
+        bus = srv->bus_reads + srv->bus_writes;
+        rt_kprintf("served    : %u\n", srv->served);
+        rt_kprintf("cache hit : %u\n", srv->hits);
+        rt_kprintf("coalesced : %u\n", srv->joins);
+        rt_kprintf("bus read  : %u\n", srv->bus_reads);
+        rt_kprintf("bus write : %u\n", srv->bus_writes);
+        rt_kprintf("bus fail  : %u\n", srv->fails);
+        if (bus)
+        {
+            rt_kprintf("served/bus: %u.%02u\n", srv->served / bus, (srv->served % bus) * 100 / bus);
+        }
+        return;
+    }
+
+    rt_kprintf("Usage: \n");
+    rt_kprintf("rs485_mbtcp start [port]        - start the modbus tcp to rtu gateway.\n");
+    rt_kprintf("rs485_mbtcp stop                - stop the gateway.\n");
+    rt_kprintf("rs485_mbtcp route [unit] [bus]  - route a unit id to a rs485_gw port, -1 - none.\n");
+    rt_kprintf("rs485_mbtcp ttl [ms]            - set the read cache ttl, 0 - no cache.\n");
+    rt_kprintf("rs485_mbtcp stat                - show the counters.\n");
+}
+MSH_CMD_EXPORT(rs485_mbtcp, modbus tcp to rs485 rtu gateway);
+
+#endif
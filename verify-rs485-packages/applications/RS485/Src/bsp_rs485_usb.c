@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2006-2021, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ * 2026-10-17     RT-Thread    join the thread by a completion, close the device on stop
+ */
+#include "bsp_sys.h"
+#include "bsp_rs485_drv.h"
+
+#if defined(RS485_USING_USB_BRIDGE) && defined(RT_VCOM_USING_PINGPONG)
+
+#include <class/cdc.h>
+
+#define DBG_TAG "rs485.usb"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#define RS485_USB_PKT_SIZE      128     //IN包大小, 与vcom发送包一致
+
+/**
+ * @brief 一个待发送的USB OUT包, 数据仍在端点缓冲区中
+ */
+typedef struct {
+    void *buf;
+    rt_size_t size;
+} rs485_usb_pkt_t;
+
+/**
+ * @brief 桥接服务状态
+ */
+typedef struct {
+    rs485_inst_t *hinst;
+    rt_thread_t tid;
+    volatile rt_uint8_t running;
+    volatile rt_uint8_t coding_pending;         //主机修改了串口参数, 由桥接线程应用
+    struct ucdc_line_coding coding;
+    struct rt_completion exit;                  //桥接线程退出
+    struct rt_mailbox mb;
+    rt_ubase_t mb_pool[2];                      //端点只有两个OUT缓冲区
+    rs485_usb_pkt_t pkt[2];
+    int pkt_idx;
+    rt_uint8_t in_buf[2][RS485_USB_PKT_SIZE];   //一个在总线上发送, 另一个接收RS485数据
+} rs485_usb_bridge_t;
+
+static rs485_usb_bridge_t usb_bridge;
+
+/*
+ * @brief   usb OUT packet callback, runs in the usbd thread
+ */
+static void rs485_usb_out_packet(void *buf, rt_size_t size, void *user_data)
+{
+    rs485_usb_bridge_t *br = (rs485_usb_bridge_t *)user_data;
+    rs485_usb_pkt_t *pkt = &br->pkt[br->pkt_idx];
+
+    br->pkt_idx ^= 1;
+    pkt->buf = buf;
+    pkt->size = size;
+
+    /* 两个缓冲区都被占用时端点不再接收, 邮箱不会满 */
+    rt_mb_send(&br->mb, (rt_ubase_t)pkt);
+
+    /* 打断接收等待, 让桥接线程立刻发送 */
+    rs485_break_recv(br->hinst);
+}
+
+/*
+ * @brief   usb set line coding callback, runs in the usbd thread
+ */
+static void rs485_usb_line_coding(const struct ucdc_line_coding *coding, void *user_data)
+{
+    rs485_usb_bridge_t *br = (rs485_usb_bridge_t *)user_data;
+
+    br->coding = *coding;
+    br->coding_pending = 1;
+    rs485_break_recv(br->hinst);
+}
+
+static const struct vcom_bridge_ops rs485_usb_ops =
+{
+    rs485_usb_out_packet,
+    rs485_usb_line_coding,
+};
+
+/*
+ * @brief   apply the host line coding to rs485
+ */
+static void rs485_usb_apply_coding(rs485_usb_bridge_t *br)
+{
+    struct ucdc_line_coding coding;
+    rt_base_t level;
+    int parity, stopbits;
+
+    level = rt_hw_interrupt_disable();
+    coding = br->coding;
+    br->coding_pending = 0;
+    rt_hw_interrupt_enable(level);
+
+    /* CDC: 0 - none, 1 - odd, 2 - even, 3 - mark, 4 - space, 后两种不支持 */
+    parity = (coding.bParityType <= 2) ? coding.bParityType : 0;
+    /* CDC: 0 - 1 stop bit, 1 - 1.5 stop bits, 2 - 2 stop bits */
+    stopbits = (coding.bCharFormat == 2) ? 1 : 0;
+
+    if (rs485_config(br->hinst, coding.dwDTERate, coding.bDataBits, parity, stopbits) != RT_EOK)
+    {
+        LOG_W("rs485 usb bridge config %d,%d,%d,%d fail.",
+                coding.dwDTERate, coding.bDataBits, parity, stopbits);
+    }
+}
+
+/*
+ * @brief   bridge thread, host data first, then rs485 data
+ */
+static void rs485_usb_thread_entry(void *param)
+{
+    rs485_usb_bridge_t *br = (rs485_usb_bridge_t *)param;
+    rs485_usb_pkt_t *pkt;
+    int cur = 0;
+    int len;
+
+    while (br->running)
+    {
+        if (br->coding_pending)
+        {
+            rs485_usb_apply_coding(br);
+        }
+
+        /* USB -> RS485, DMA直接从端点缓冲区发送 */
+        while (rt_mb_recv(&br->mb, (rt_ubase_t *)&pkt, 0) == RT_EOK)
+        {
+            if (rs485_send(br->hinst, pkt->buf, pkt->size) < 0)
+            {
+                LOG_W("rs485 usb bridge send %d bytes fail.", pkt->size);
+            }
+            rt_usb_vcom_out_release(pkt->buf);
+        }
+
+        /* RS485 -> USB, 直接接收到IN包缓冲区, 上一包仍在总线上发送 */
+        len = rs485_recv(br->hinst, br->in_buf[cur], RS485_USB_PKT_SIZE);
+        if (len > 0)
+        {
+            if (rt_usb_vcom_in_submit(br->in_buf[cur], len) == RT_EOK)
+            {
+                cur ^= 1;
+            }
+        }
+    }
+
+    rt_usb_vcom_in_wait(RT_TICK_PER_SECOND);
+
+    /* 归还未发送的包 */
+    while (rt_mb_recv(&br->mb, (rt_ubase_t *)&pkt, 0) == RT_EOK)
+    {
+        rt_usb_vcom_out_release(pkt->buf);
+    }
+
+    rt_completion_done(&br->exit);
+}
+
+/*
+ * @brief   start bridging the usb virtual com to rs485
+ * @param   hinst       - instance handle, must be connected
+ * @retval  0 - success, other - error
+ */
+int rs485_usb_bridge_start(rs485_inst_t * hinst)
+{
+    rs485_usb_bridge_t *br = &usb_bridge;
+
+    if (hinst == RT_NULL)
+    {
+        LOG_E("rs485 usb bridge start fail. hinst is NULL.");
+        return(-RT_ERROR);
+    }
+
+    if (br->tid != RT_NULL)
+    {
+        LOG_E("rs485 usb bridge start fail. it is running.");
+        return(-RT_EBUSY);
+    }
+
+    br->hinst = hinst;
+    br->pkt_idx = 0;
+    br->coding_pending = 0;
+    rt_mb_init(&br->mb, "rs485usb", br->mb_pool, 2, RT_IPC_FLAG_FIFO);
+    rt_completion_init(&br->exit);
+
+    /* 短接收超时, 保证主机数据和停止请求能及时处理 */
+    rs485_set_recv_tmo(hinst, RS485_USB_POLL_MS);
+
+    br->tid = rt_thread_create("rs485usb", rs485_usb_thread_entry, br,
+                               1024, RS485_USB_THREAD_PRIO, 10);
+    if (br->tid == RT_NULL)
+    {
+        rt_mb_detach(&br->mb);
+        LOG_E("rs485 usb bridge start fail. thread create fail.");
+        return(-RT_ENOMEM);
+    }
+
+    if (rt_usb_vcom_bridge_attach(&rs485_usb_ops, br) != RT_EOK)
+    {
+        rt_thread_delete(br->tid);
+        br->tid = RT_NULL;
+        rt_mb_detach(&br->mb);
+        LOG_E("rs485 usb bridge start fail. vcom is not ready.");
+        return(-RT_ERROR);
+    }
+
+    br->running = 1;
+    rt_thread_startup(br->tid);
+
+    LOG_I("rs485 usb bridge start success.");
+
+    return(RT_EOK);
+}
+
+/*
+ * @brief   stop the usb virtual com bridge
+ * @retval  0 - success, other - error
+ */
+int rs485_usb_bridge_stop(void)
+{
+    rs485_usb_bridge_t *br = &usb_bridge;
+
+    if (br->tid == RT_NULL)
+    {
+        return(-RT_ERROR);
+    }
+
+    /* 先断开回调, 之后不会再有新包 */
+    rt_usb_vcom_bridge_detach();
+
+    br->running = 0;
+    rs485_break_recv(br->hinst);
+    rt_completion_wait(&br->exit, RT_WAITING_FOREVER);
+
+    br->tid = RT_NULL;
+    rt_mb_detach(&br->mb);
+
+    LOG_I("rs485 usb bridge stop success.");
+
+    return(RT_EOK);
+}
+
+/**
+ * @brief USB桥接命令（FinSH shell 命令）
+ *
+ * 使用方式：
+ *   rs485_usb start rs485-1
+ *   rs485_usb stop
+ */
+static void rs485_usb(int argc, char **argv)
+{
+    static rt_device_t bridge_dev = RT_NULL;    //命令打开的设备, 停止时关闭
+
+    if ((argc == 3) && (strcmp(argv[1], "start") == 0))
+    {
+        rt_device_t dev;
+
+        if (bridge_dev != RT_NULL)
+        {
+            rt_kprintf("rs485 usb bridge is running.\n");
+            return;
+        }
+        dev = rt_device_find(argv[2]);
+        if (dev == RT_NULL)
+        {
+            rt_kprintf("rs485 device %s not found.\n", argv[2]);
+            return;
+        }
+        if (rt_device_open(dev, RT_DEVICE_OFLAG_RDWR) != RT_EOK)
+        {
+            rt_kprintf("rs485 device %s open fail.\n", argv[2]);
+            return;
+        }
+        if (rs485_usb_bridge_start(((rs485_dev_t *)dev)->hinst) != RT_EOK)
+        {
+            rt_device_close(dev);
+            return;
+        }
+        bridge_dev = dev;
+        return;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "stop") == 0))
+    {
+        if (rs485_usb_bridge_stop() == RT_EOK && bridge_dev != RT_NULL)
+        {
+            rt_device_close(bridge_dev);
+            bridge_dev = RT_NULL;
+        }
+        return;
+    }
+
+    rt_kprintf("Usage: \n");
+    rt_kprintf("rs485_usb start [rs485 device]   - bridge usb virtual com to rs485.\n");
+    rt_kprintf("rs485_usb stop                   - stop the bridge.\n");
+}
+MSH_CMD_EXPORT(rs485_usb, bridge usb virtual com to rs485);
+
+#endif
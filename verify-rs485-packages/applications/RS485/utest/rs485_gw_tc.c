@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include "rs485_tc.h"
+
+#if defined(RT_USING_UTEST) && defined(RS485_USING_GATEWAY)
+#include "utest.h"
+
+/*
+ * The gateway on the simulated bus, one port per bus. The transfer unit
+ * makes a round trip and a send only request on every port. In the
+ * parallel unit every port keeps GW_TC_INFLIGHT requests queued, the
+ * done callback checks the echo and submits the request again until
+ * GW_TC_ROUNDS requests of the port are done. The timeout unit waits
+ * for a silent slave on one port while another port keeps working. With
+ * RS485_USING_RTO the rto unit checks the timeout learned from the
+ * parallel unit and that a silent slave is backed off. The stop unit
+ * checks that a stop completes the queued requests. The
+ * gateway must not be running. Time it with:
+ *
+ *     utest_bench -n 20 testcases.rs485.gw
+ */
+
+#define GW_TC_LEN               8
+#define GW_TC_ACK_MS            100
+#define GW_TC_INFLIGHT          2
+#define GW_TC_ROUNDS            256
+#define GW_TC_SILENT_ADDR       0x7E
+
+struct gw_tc_req
+{
+    rs485_gw_req_t req;
+    rt_uint8_t sbuf[GW_TC_LEN];
+    rt_uint8_t rbuf[GW_TC_LEN];
+};
+
+static int ports[RS485_TC_PORTS];
+static struct gw_tc_req reqs[RS485_TC_PORTS][GW_TC_INFLIGHT];
+static int rounds[RS485_TC_PORTS];
+static int inflight;
+static int bad;
+static struct rt_semaphore all_done;
+
+static rt_err_t gw_tc_init(void)
+{
+    int i;
+
+    if (rs485_tc_bus_init() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+    rs485_tc_slave(GW_TC_SILENT_ADDR, RS485_TC_SILENT);
+
+    for (i = 0; i < RS485_TC_PORTS; i++)
+    {
+        ports[i] = rs485_gw_add(rs485_tc_inst[i]);
+        if (ports[i] < 0)
+        {
+            LOG_E("the gateway is in use");
+            rs485_tc_bus_deinit();
+            return -RT_ERROR;
+        }
+    }
+
+    if (rs485_gw_start() != RT_EOK)
+    {
+        rs485_tc_bus_deinit();
+        return -RT_ERROR;
+    }
+    rt_sem_init(&all_done, "gw_tc", 0, RT_IPC_FLAG_PRIO);
+
+    return RT_EOK;
+}
+
+static rt_err_t gw_tc_cleanup(void)
+{
+    /* the stop unit may have stopped it */
+    rs485_gw_stop();
+    rs485_tc_bus_deinit();
+    rt_sem_detach(&all_done);
+
+    return RT_EOK;
+}
+
+static void gw_tc_fill(struct gw_tc_req *r, int port, rt_uint8_t addr, int ack_ms)
+{
+    int i;
+
+    rt_memset(r, 0, sizeof(*r));
+    r->sbuf[0] = addr;
+    for (i = 1; i < GW_TC_LEN; i++)
+    {
+        r->sbuf[i] = (rt_uint8_t)(port * 16 + i);
+    }
+    r->req.port = ports[port];
+    r->req.sbuf = r->sbuf;
+    r->req.slen = GW_TC_LEN;
+    r->req.rbuf = r->rbuf;
+    r->req.rsize = GW_TC_LEN;
+    r->req.ack_tmo_ms = ack_ms;
+}
+
+static void gw_transfer(void)
+{
+    rt_uint8_t sbuf[GW_TC_LEN], rbuf[GW_TC_LEN];
+    rt_uint32_t frames;
+    int i, j, err = 0;
+
+    for (i = 0; i < RS485_TC_PORTS; i++)
+    {
+        sbuf[0] = (rt_uint8_t)(i + 1);
+        for (j = 1; j < GW_TC_LEN; j++)
+        {
+            sbuf[j] = (rt_uint8_t)(i * 16 + j);
+        }
+        rt_memset(rbuf, 0, sizeof(rbuf));
+        if (rs485_gw_transfer(ports[i], sbuf, GW_TC_LEN, rbuf, GW_TC_LEN, GW_TC_ACK_MS) != GW_TC_LEN ||
+            rt_memcmp(sbuf, rbuf, GW_TC_LEN) != 0)
+        {
+            err ++;
+        }
+
+        /* a broadcast is only sent */
+        frames = rs485_tc_port[i].frames;
+        sbuf[0] = 0;
+        if (rs485_gw_transfer(ports[i], sbuf, GW_TC_LEN, RT_NULL, 0, 0) != 0 ||
+            rs485_tc_port[i].frames != frames + 1)
+        {
+            err ++;
+        }
+    }
+
+    uassert_int_equal(err, 0);
+}
+
+/* check the echo and submit again, in the gateway thread */
+static void gw_tc_done(rs485_gw_req_t *req)
+{
+    struct gw_tc_req *r = rt_container_of(req, struct gw_tc_req, req);
+    int port = (int)(rt_ubase_t)req->user_data;
+
+    if (req->result != GW_TC_LEN || rt_memcmp(r->sbuf, r->rbuf, GW_TC_LEN) != 0)
+    {
+        bad ++;
+    }
+
+    if (rounds[port] < GW_TC_ROUNDS)
+    {
+        rounds[port] ++;
+        r->sbuf[1] ++;
+        rt_memset(r->rbuf, 0, GW_TC_LEN);
+        if (rs485_gw_submit(req) == RT_EOK)
+        {
+            return;
+        }
+        bad ++;
+    }
+
+    if (-- inflight == 0)
+    {
+        rt_sem_release(&all_done);
+    }
+}
+
+static void gw_parallel(void)
+{
+    struct gw_tc_req *r;
+    rt_tick_t tick;
+    int i, j;
+
+    bad = 0;
+    inflight = RS485_TC_PORTS * GW_TC_INFLIGHT;
+    for (i = 0; i < RS485_TC_PORTS; i++)
+    {
+        rounds[i] = GW_TC_INFLIGHT;
+        for (j = 0; j < GW_TC_INFLIGHT; j++)
+        {
+            r = &reqs[i][j];
+            gw_tc_fill(r, i, (rt_uint8_t)(i + 1), GW_TC_ACK_MS);
+            r->req.done = gw_tc_done;
+            r->req.user_data = (void *)(rt_ubase_t)i;
+        }
+    }
+
+    tick = rt_tick_get();
+    for (i = 0; i < RS485_TC_PORTS; i++)
+    {
+        for (j = 0; j < GW_TC_INFLIGHT; j++)
+        {
+            if (rs485_gw_submit(&reqs[i][j].req) != RT_EOK)
+            {
+                bad ++;
+            }
+        }
+    }
+
+    uassert_int_equal(bad, 0);
+    uassert_int_equal(rt_sem_take(&all_done, 10 * RT_TICK_PER_SECOND), RT_EOK);
+    tick = rt_tick_get() - tick;
+    uassert_int_equal(bad, 0);
+
+    LOG_I("%d ports, %d requests in %d ms", RS485_TC_PORTS, RS485_TC_PORTS * GW_TC_ROUNDS,
+          tick * 1000 / RT_TICK_PER_SECOND);
+}
+
+static void gw_tc_signal(rs485_gw_req_t *req)
+{
+    rt_sem_release(&all_done);
+}
+
+static void gw_timeout(void)
+{
+    struct gw_tc_req *r = &reqs[0][0];
+    rt_uint8_t sbuf[GW_TC_LEN], rbuf[GW_TC_LEN];
+    rt_tick_t tick;
+
+    gw_tc_fill(r, 0, GW_TC_SILENT_ADDR, GW_TC_ACK_MS);
+    r->req.done = gw_tc_signal;
+    r->req.result = 1;
+
+    tick = rt_tick_get();
+    uassert_int_equal(rs485_gw_submit(&r->req), RT_EOK);
+
+    /* the other bus is not held up by the silent slave */
+    rt_memset(sbuf, 0x5A, sizeof(sbuf));
+    sbuf[0] = 1;
+    uassert_int_equal(rs485_gw_transfer(ports[1], sbuf, GW_TC_LEN, rbuf, GW_TC_LEN, GW_TC_ACK_MS), GW_TC_LEN);
+    uassert_int_equal(r->req.result, 1);
+
+    uassert_int_equal(rt_sem_take(&all_done, RT_TICK_PER_SECOND), RT_EOK);
+    tick = rt_tick_get() - tick;
+    uassert_int_equal(r->req.result, -RT_ETIMEOUT);
+    uassert_true(tick >= rt_tick_from_millisecond(GW_TC_ACK_MS));
+}
+
+#ifdef RS485_USING_RTO
+static void gw_rto(void)
+{
+    rs485_inst_t *hinst = rs485_tc_inst[2];
+    rt_uint8_t sbuf[GW_TC_LEN], rbuf[GW_TC_LEN];
+    rs485_rto_stat_t stat;
+    rt_uint32_t frames;
+    int i, err = 0;
+
+    /* learned from the replies of the parallel unit */
+    stat.addr = 3;
+    uassert_int_equal(rs485_get_rto_stat(hinst, &stat), RT_EOK);
+    uassert_true(stat.ok >= GW_TC_ROUNDS);
+    uassert_true(stat.rto_ms < GW_TC_ACK_MS);
+
+    /* a silent slave is backed off after RS485_RTO_FAIL_LIMIT timeouts */
+    rs485_set_rto_bounds(hinst, RS485_RTO_MIN_MS, 2 * GW_TC_ACK_MS);
+    rt_memset(sbuf, 0x5A, sizeof(sbuf));
+    sbuf[0] = GW_TC_SILENT_ADDR;
+    for (i = 0; i < RS485_RTO_FAIL_LIMIT; i++)
+    {
+        if (rs485_gw_transfer(ports[2], sbuf, GW_TC_LEN, rbuf, GW_TC_LEN, GW_TC_ACK_MS) != -RT_ETIMEOUT)
+        {
+            err ++;
+        }
+    }
+    uassert_int_equal(err, 0);
+
+    frames = rs485_tc_port[2].frames;
+    uassert_int_equal(rs485_gw_transfer(ports[2], sbuf, GW_TC_LEN, rbuf, GW_TC_LEN, GW_TC_ACK_MS), -RT_EBUSY);
+    uassert_int_equal(rs485_tc_port[2].frames, frames);
+    stat.addr = GW_TC_SILENT_ADDR;
+    uassert_int_equal(rs485_get_rto_stat(hinst, &stat), RT_EOK);
+    uassert_int_equal(stat.skip, 1);
+    uassert_true(stat.backoff_ms > 0 && stat.backoff_ms <= 2 * GW_TC_ACK_MS);
+}
+#endif
+
+static void gw_stop(void)
+{
+    int i;
+
+    /* one waiting for the silent slave, the others queued behind it */
+    for (i = 0; i < GW_TC_INFLIGHT; i++)
+    {
+        gw_tc_fill(&reqs[0][i], 0, GW_TC_SILENT_ADDR, 1000);
+        reqs[0][i].req.result = 1;
+        uassert_int_equal(rs485_gw_submit(&reqs[0][i].req), RT_EOK);
+    }
+    rt_thread_mdelay(10);
+
+    uassert_int_equal(rs485_gw_stop(), RT_EOK);
+    for (i = 0; i < GW_TC_INFLIGHT; i++)
+    {
+        uassert_int_equal(reqs[0][i].req.result, -RT_ERROR);
+    }
+    uassert_int_equal(rs485_gw_submit(&reqs[0][0].req), -RT_ERROR);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(gw_transfer);
+    UTEST_UNIT_RUN(gw_parallel);
+    UTEST_UNIT_RUN(gw_timeout);
+#ifdef RS485_USING_RTO
+    UTEST_UNIT_RUN(gw_rto);
+#endif
+    UTEST_UNIT_RUN(gw_stop);
+}
+UTEST_TC_EXPORT(testcase, "testcases.rs485.gw", gw_tc_init, gw_tc_cleanup, 30);
+
+#endif /* RT_USING_UTEST && RS485_USING_GATEWAY */
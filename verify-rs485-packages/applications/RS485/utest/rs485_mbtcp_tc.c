@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include "rs485_tc.h"
+
+#if defined(RT_USING_UTEST) && defined(RS485_USING_MBTCP) && defined(RT_USING_SAL)
+#include "utest.h"
+#include <sys/socket.h>
+#include <sys/time.h>
+
+/*
+ * The modbus tcp gateway on port 0 of the simulated bus, with local tcp
+ * clients, the loopback of the stack must be on. The slaves 1 and 2 have
+ * MBTCP_TC_REGS holding registers, read by 0x03 and written by 0x06, a
+ * broadcast write goes to both. The cache unit checks that a repeated
+ * read is answered without the bus and that a write clears the cache of
+ * the slave. The broadcast unit checks that a broadcast write clears the
+ * cache of every slave on the bus. The stop unit checks that a stop
+ * returns with clients connected, that a freed client slot is used again
+ * and that the gateway starts again. The gateway must not be running.
+ * Run it with:
+ *
+ *     utest_run testcases.rs485.mbtcp
+ */
+
+#define MBTCP_TC_TCP_PORT       5020
+#define MBTCP_TC_UNITS          3       /* the broadcast and two slaves */
+#define MBTCP_TC_REGS           8
+#define MBTCP_TC_TTL_MS         1000
+#define MBTCP_TC_RECV_S         2
+
+static int gw_port;
+static rt_uint16_t regs[MBTCP_TC_UNITS][MBTCP_TC_REGS];
+static rt_uint16_t tid;
+
+static rt_uint16_t mbtcp_tc_crc16(const rt_uint8_t *data, int len)
+{
+    rt_uint16_t crc = 0xFFFF;
+    int i;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++)
+        {
+            crc = (crc & 1) ? ((crc >> 1) ^ 0xA001) : (crc >> 1);
+        }
+    }
+
+    return crc;
+}
+
+/* the rtu slaves, a broadcast write goes to every slave */
+static int mbtcp_tc_answer(const rt_uint8_t *frame, int len, rt_uint8_t *reply)
+{
+    rt_uint8_t unit = frame[0];
+    rt_uint16_t addr = (frame[2] << 8) | frame[3];
+    rt_uint16_t val = (frame[4] << 8) | frame[5];
+    rt_uint16_t crc;
+    int i, n;
+
+    if (len != 8 || unit >= MBTCP_TC_UNITS ||
+        mbtcp_tc_crc16(frame, 6) != (frame[6] | (frame[7] << 8)))
+    {
+        return 0;
+    }
+
+    if (frame[1] == 0x03 && unit != 0 && val > 0 && addr + val <= MBTCP_TC_REGS)
+    {
+        reply[0] = unit;
+        reply[1] = 0x03;
+        reply[2] = val * 2;
+        for (i = 0; i < val; i++)
+        {
+            reply[3 + i * 2] = regs[unit][addr + i] >> 8;
+            reply[4 + i * 2] = regs[unit][addr + i] & 0xFF;
+        }
+        n = 3 + val * 2;
+        crc = mbtcp_tc_crc16(reply, n);
+        reply[n] = crc & 0xFF;
+        reply[n + 1] = crc >> 8;
+        return n + 2;
+    }
+
+    if (frame[1] == 0x06 && addr < MBTCP_TC_REGS)
+    {
+        for (i = 1; i < MBTCP_TC_UNITS; i++)
+        {
+            if (unit == 0 || unit == i)
+            {
+                regs[i][addr] = val;
+            }
+        }
+        rt_memcpy(reply, frame, len);
+        return len;
+    }
+
+    return 0;
+}
+
+static rt_err_t mbtcp_tc_init(void)
+{
+    int i;
+
+    if (rs485_tc_bus_init() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+    rt_memset(regs, 0, sizeof(regs));
+    rs485_tc_set_answer(mbtcp_tc_answer);
+
+    gw_port = rs485_gw_add(rs485_tc_inst[0]);
+    if (gw_port < 0 || rs485_gw_start() != RT_EOK)
+    {
+        LOG_E("the gateway is in use");
+        rs485_tc_bus_deinit();
+        return -RT_ERROR;
+    }
+
+    for (i = 0; i < MBTCP_TC_UNITS; i++)
+    {
+        rs485_mbtcp_route(i, gw_port);
+    }
+    rs485_mbtcp_set_ttl(MBTCP_TC_TTL_MS);
+    if (rs485_mbtcp_start(MBTCP_TC_TCP_PORT) != RT_EOK)
+    {
+        rs485_gw_stop();
+        rs485_tc_bus_deinit();
+        return -RT_ERROR;
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t mbtcp_tc_cleanup(void)
+{
+    int i;
+
+    rs485_mbtcp_stop();
+    rs485_mbtcp_set_ttl(RS485_MBTCP_CACHE_TTL_MS);
+    for (i = 0; i < MBTCP_TC_UNITS; i++)
+    {
+        rs485_mbtcp_route(i, 0);
+    }
+    rs485_gw_stop();
+    rs485_tc_bus_deinit();
+
+    return RT_EOK;
+}
+
+static int mbtcp_tc_connect(void)
+{
+    struct sockaddr_in addr;
+    struct timeval tv;
+    int sock;
+
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0)
+    {
+        return -1;
+    }
+
+    tv.tv_sec = MBTCP_TC_RECV_S;
+    tv.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (void *)&tv, sizeof(tv));
+
+    rt_memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(MBTCP_TC_TCP_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        closesocket(sock);
+        return -1;
+    }
+
+    return sock;
+}
+
+static int mbtcp_tc_recv(int sock, rt_uint8_t *buf, int len)
+{
+    int n;
+
+    while (len > 0)
+    {
+        n = recv(sock, buf, len, 0);
+        if (n <= 0)
+        {
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+/*
+ * one request of 5 pdu bytes, rsp - the response pdu, RT_NULL - a broadcast
+ * with no response. returns the length of the response pdu, <0 - error
+ */
+static int mbtcp_tc_request(int sock, rt_uint8_t unit, rt_uint8_t fc, rt_uint16_t addr,
+                            rt_uint16_t val, rt_uint8_t *rsp)
+{
+    rt_uint8_t buf[7 + 253];
+    int len;
+
+    tid ++;
+    buf[0] = tid >> 8;
+    buf[1] = tid & 0xFF;
+    buf[2] = 0;
+    buf[3] = 0;
+    buf[4] = 0;
+    buf[5] = 6;
+    buf[6] = unit;
+    buf[7] = fc;
+    buf[8] = addr >> 8;
+    buf[9] = addr & 0xFF;
+    buf[10] = val >> 8;
+    buf[11] = val & 0xFF;
+    if (send(sock, buf, 12, 0) != 12)
+    {
+        return -1;
+    }
+    if (rsp == RT_NULL)
+    {
+        return 0;
+    }
+
+    if (mbtcp_tc_recv(sock, buf, 7) < 0)
+    {
+        return -1;
+    }
+    len = (buf[4] << 8) | buf[5];
+    if (buf[0] != (tid >> 8) || buf[1] != (tid & 0xFF) || buf[6] != unit || len < 2 || len > 254 ||
+        mbtcp_tc_recv(sock, rsp, len - 1) < 0)
+    {
+        return -1;
+    }
+
+    return len - 1;
+}
+
+/* reads one holding register, returns its value, <0 - error */
+static int mbtcp_tc_read(int sock, rt_uint8_t unit, rt_uint16_t addr)
+{
+    rt_uint8_t pdu[253];
+
+    if (mbtcp_tc_request(sock, unit, 0x03, addr, 1, pdu) != 4 || pdu[0] != 0x03 || pdu[1] != 2)
+    {
+        return -1;
+    }
+
+    return (pdu[2] << 8) | pdu[3];
+}
+
+static int mbtcp_tc_write(int sock, rt_uint8_t unit, rt_uint16_t addr, rt_uint16_t val)
+{
+    rt_uint8_t pdu[253];
+
+    if (unit == 0)
+    {
+        return mbtcp_tc_request(sock, 0, 0x06, addr, val, RT_NULL);
+    }
+
+    if (mbtcp_tc_request(sock, unit, 0x06, addr, val, pdu) != 5 || pdu[0] != 0x06)
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
+static void mbtcp_cache(void)
+{
+    rt_uint32_t frames;
+    int sock;
+
+    regs[1][0] = 0x1234;
+    sock = mbtcp_tc_connect();
+    uassert_true(sock >= 0);
+
+    uassert_int_equal(mbtcp_tc_read(sock, 1, 0), 0x1234);
+
+    /* from the cache */
+    frames = rs485_tc_port[0].frames;
+    uassert_int_equal(mbtcp_tc_read(sock, 1, 0), 0x1234);
+    uassert_int_equal(rs485_tc_port[0].frames, frames);
+
+    /* a write clears the cache of the slave */
+    uassert_int_equal(mbtcp_tc_write(sock, 1, 0, 0x4321), 0);
+    uassert_int_equal(mbtcp_tc_read(sock, 1, 0), 0x4321);
+    uassert_int_equal(rs485_tc_port[0].frames, frames + 2);
+
+    closesocket(sock);
+}
+
+static void mbtcp_broadcast(void)
+{
+    rt_uint32_t frames;
+    int sock;
+
+    regs[1][1] = 0x1111;
+    regs[2][1] = 0x2222;
+    sock = mbtcp_tc_connect();
+    uassert_true(sock >= 0);
+
+    uassert_int_equal(mbtcp_tc_read(sock, 1, 1), 0x1111);
+    uassert_int_equal(mbtcp_tc_read(sock, 2, 1), 0x2222);
+
+    /* the next request of the client is handled after the broadcast */
+    frames = rs485_tc_port[0].frames;
+    uassert_int_equal(mbtcp_tc_write(sock, 0, 1, 0xB0B0), 0);
+    uassert_int_equal(mbtcp_tc_read(sock, 1, 1), 0xB0B0);
+    uassert_int_equal(mbtcp_tc_read(sock, 2, 1), 0xB0B0);
+    uassert_int_equal(rs485_tc_port[0].frames, frames + 3);
+
+    closesocket(sock);
+}
+
+static void mbtcp_stop(void)
+{
+    int sock[RS485_MBTCP_CLIENT_MAX];
+    rt_uint8_t c;
+    rt_tick_t tick;
+    int i, err = 0;
+
+    for (i = 0; i < RS485_MBTCP_CLIENT_MAX; i++)
+    {
+        sock[i] = mbtcp_tc_connect();
+        if (sock[i] < 0 || mbtcp_tc_read(sock[i], 1, 2) < 0)
+        {
+            err ++;
+        }
+    }
+    uassert_int_equal(err, 0);
+
+    /* a slot is used again after its client is gone */
+    closesocket(sock[0]);
+    rt_thread_mdelay(100);
+    sock[0] = mbtcp_tc_connect();
+    uassert_true(sock[0] >= 0);
+    uassert_int_equal(mbtcp_tc_read(sock[0], 2, 2), 0);
+
+    /* the idle clients are closed */
+    tick = rt_tick_get();
+    uassert_int_equal(rs485_mbtcp_stop(), RT_EOK);
+    uassert_true(rt_tick_get() - tick < rt_tick_from_millisecond(MBTCP_TC_RECV_S * 1000 / 2));
+    for (i = 0; i < RS485_MBTCP_CLIENT_MAX; i++)
+    {
+        if (recv(sock[i], &c, 1, 0) != 0)
+        {
+            err ++;
+        }
+        closesocket(sock[i]);
+    }
+    uassert_int_equal(err, 0);
+    uassert_int_equal(rs485_mbtcp_stop(), -RT_ERROR);
+
+    uassert_int_equal(rs485_mbtcp_start(MBTCP_TC_TCP_PORT), RT_EOK);
+    sock[0] = mbtcp_tc_connect();
+    uassert_true(sock[0] >= 0);
+    uassert_int_equal(mbtcp_tc_read(sock[0], 1, 2), 0);
+    closesocket(sock[0]);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(mbtcp_cache);
+    UTEST_UNIT_RUN(mbtcp_broadcast);
+    UTEST_UNIT_RUN(mbtcp_stop);
+}
+UTEST_TC_EXPORT(testcase, "testcases.rs485.mbtcp", mbtcp_tc_init, mbtcp_tc_cleanup, 30);
+
+#endif /* RT_USING_UTEST && RS485_USING_MBTCP && RT_USING_SAL */
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include "rs485_tc.h"
+
+#if defined(RT_USING_UTEST) && defined(RS485_USING_RTO)
+#include "utest.h"
+
+/*
+ * The adaptive response timeout of rs485_send_then_recv on the simulated
+ * bus. The learn unit polls a slow and a fast slave with a long receive
+ * timeout and checks that each one gets a timeout near its own reply
+ * time, and that a broadcast is not learned. The backoff unit polls a
+ * silent slave until it is backed off, checks that it is skipped without
+ * sending and that the back-off never gets longer than the maximum
+ * response timeout. Run it with:
+ *
+ *     utest_run testcases.rs485.rto
+ */
+
+#define RTO_TC_LEN              8
+#define RTO_TC_RECV_TMO         500
+#define RTO_TC_POLLS            16
+#define RTO_TC_SLOW_ADDR        1
+#define RTO_TC_SLOW_MS          30
+#define RTO_TC_FAST_ADDR        2
+#define RTO_TC_SILENT_ADDR      0x7E
+#define RTO_TC_MIN_MS           10
+#define RTO_TC_MAX_MS           200
+/* a learned timeout is about the reply time, give or take the frame tail and a few ticks */
+#define RTO_TC_SLACK_MS         20
+
+static rs485_inst_t *hinst;
+
+static rt_err_t rto_tc_init(void)
+{
+    if (rs485_tc_bus_init() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    hinst = rs485_tc_inst[0];
+    rs485_tc_slave(RTO_TC_SLOW_ADDR, RTO_TC_SLOW_MS);
+    rs485_tc_slave(RTO_TC_SILENT_ADDR, RS485_TC_SILENT);
+    rs485_set_recv_tmo(hinst, RTO_TC_RECV_TMO);
+    rs485_set_rto_bounds(hinst, RTO_TC_MIN_MS, RTO_TC_MAX_MS);
+
+    return RT_EOK;
+}
+
+static rt_err_t rto_tc_cleanup(void)
+{
+    rs485_tc_bus_deinit();
+    hinst = RT_NULL;
+
+    return RT_EOK;
+}
+
+/* one request to the slave, returns the length of the reply */
+static int rto_tc_poll(rt_uint8_t addr)
+{
+    rt_uint8_t sbuf[RTO_TC_LEN], rbuf[RTO_TC_LEN];
+
+    rt_memset(sbuf, 0x33, sizeof(sbuf));
+    sbuf[0] = addr;
+
+    return rs485_send_then_recv(hinst, sbuf, RTO_TC_LEN, rbuf, RTO_TC_LEN);
+}
+
+static void rto_learn(void)
+{
+    rs485_rto_stat_t slow, fast;
+    int i, err = 0;
+
+    for (i = 0; i < RTO_TC_POLLS; i++)
+    {
+        if (rto_tc_poll(RTO_TC_SLOW_ADDR) != RTO_TC_LEN || rto_tc_poll(RTO_TC_FAST_ADDR) != RTO_TC_LEN)
+        {
+            err ++;
+        }
+    }
+    uassert_int_equal(err, 0);
+
+    slow.addr = RTO_TC_SLOW_ADDR;
+    fast.addr = RTO_TC_FAST_ADDR;
+    uassert_int_equal(rs485_get_rto_stat(hinst, &slow), RT_EOK);
+    uassert_int_equal(rs485_get_rto_stat(hinst, &fast), RT_EOK);
+    LOG_I("slow srtt %d rto %d, fast srtt %d rto %d", slow.srtt_ms, slow.rto_ms, fast.srtt_ms, fast.rto_ms);
+
+    uassert_int_equal(slow.ok, RTO_TC_POLLS);
+    uassert_int_equal(slow.tmo, 0);
+    uassert_true(slow.srtt_ms >= RTO_TC_SLOW_MS - RTO_TC_SLACK_MS && slow.srtt_ms <= RTO_TC_SLOW_MS + RTO_TC_SLACK_MS);
+    uassert_true(slow.rto_ms > slow.srtt_ms && slow.rto_ms <= RTO_TC_SLOW_MS + 2 * RTO_TC_SLACK_MS);
+
+    /* the fast slave is not held to the timeout of the slow one */
+    uassert_int_equal(fast.ok, RTO_TC_POLLS);
+    uassert_true(fast.rto_ms >= RTO_TC_MIN_MS && fast.rto_ms < slow.rto_ms);
+
+    /* a broadcast has no reply to learn from */
+    uassert_int_equal(rto_tc_poll(0), 0);
+    fast.addr = 0;
+    uassert_int_equal(rs485_get_rto_stat(hinst, &fast), -RT_EEMPTY);
+}
+
+static void rto_backoff(void)
+{
+    rs485_rto_stat_t stat;
+    rt_uint32_t frames;
+    int i, err = 0;
+
+    stat.addr = RTO_TC_SILENT_ADDR;
+    for (i = 0; i < RS485_RTO_FAIL_LIMIT; i++)
+    {
+        if (rto_tc_poll(RTO_TC_SILENT_ADDR) != 0)
+        {
+            err ++;
+        }
+    }
+    uassert_int_equal(err, 0);
+    uassert_int_equal(rs485_get_rto_stat(hinst, &stat), RT_EOK);
+    uassert_int_equal(stat.tmo, RS485_RTO_FAIL_LIMIT);
+    uassert_int_equal(stat.rto_ms, RTO_TC_MAX_MS);
+    uassert_true(stat.backoff_ms > 0 && stat.backoff_ms <= RTO_TC_MAX_MS);
+
+    /* skipped without a frame on the bus */
+    frames = rs485_tc_port[0].frames;
+    uassert_int_equal(rto_tc_poll(RTO_TC_SILENT_ADDR), -RT_EBUSY);
+    uassert_int_equal(rs485_tc_port[0].frames, frames);
+
+    /* every further timeout doubles the back-off, up to the maximum response timeout */
+    for (i = 0; i < RS485_RTO_BACKOFF_SHIFT + 2; i++)
+    {
+        rt_thread_mdelay(RTO_TC_MAX_MS + RTO_TC_MIN_MS);
+        frames = rs485_tc_port[0].frames;
+        if (rto_tc_poll(RTO_TC_SILENT_ADDR) != 0 || rs485_tc_port[0].frames != frames + 1 ||
+            rs485_get_rto_stat(hinst, &stat) != RT_EOK || stat.backoff_ms <= 0 ||
+            stat.backoff_ms > RTO_TC_MAX_MS)
+        {
+            err ++;
+        }
+    }
+    uassert_int_equal(err, 0);
+    uassert_int_equal(stat.skip, 1);
+
+    /* the other slaves are still polled */
+    uassert_int_equal(rto_tc_poll(RTO_TC_FAST_ADDR), RTO_TC_LEN);
+
+    /* a reset forgets the back-off */
+    uassert_int_equal(rs485_reset_rto(hinst), RT_EOK);
+    uassert_int_equal(rs485_get_rto_stat(hinst, &stat), -RT_EEMPTY);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(rto_learn);
+    UTEST_UNIT_RUN(rto_backoff);
+}
+UTEST_TC_EXPORT(testcase, "testcases.rs485.rto", rto_tc_init, rto_tc_cleanup, 30);
+
+#endif /* RT_USING_UTEST && RS485_USING_RTO */
@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include "rs485_tc.h"
+
+#ifdef RT_USING_UTEST
+
+#define RS485_TC_IDLE           0
+#define RS485_TC_WIRE           1       /* the frame is being sent */
+#define RS485_TC_REPLY          2       /* the slave is about to answer */
+/* the last bytes are still sent when the dma is done */
+#define RS485_TC_TAIL_MS        ((2 * 11 * 1000) / RS485_TC_BAUDRATE + 1)
+
+struct rs485_tc_port rs485_tc_port[RS485_TC_PORTS];
+rs485_inst_t *rs485_tc_inst[RS485_TC_PORTS];
+
+/* the reply time of every slave address in ms */
+static int slave_ms[256];
+static rs485_tc_answer_t slave_answer;
+
+static rt_err_t rs485_tc_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    struct rs485_tc_port *port = (struct rs485_tc_port *)dev;
+
+    port->phase = RS485_TC_IDLE;
+    port->rx_len = 0;
+    /* the dma tx of a uart, the end of a frame is notified */
+    dev->open_flag = oflag & (RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_INT_RX | RT_DEVICE_FLAG_DMA_RX |
+                              RT_DEVICE_FLAG_INT_TX | RT_DEVICE_FLAG_DMA_TX);
+
+    return RT_EOK;
+}
+
+static rt_err_t rs485_tc_close(rt_device_t dev)
+{
+    struct rs485_tc_port *port = (struct rs485_tc_port *)dev;
+
+    rt_timer_stop(&port->timer);
+    port->phase = RS485_TC_IDLE;
+
+    return RT_EOK;
+}
+
+static rt_ssize_t rs485_tc_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    struct rs485_tc_port *port = (struct rs485_tc_port *)dev;
+    rt_base_t level;
+    int len;
+
+    level = rt_hw_interrupt_disable();
+    len = (port->rx_len < (int)size) ? port->rx_len : (int)size;
+    rt_memcpy(buffer, port->rx, len);
+    port->rx_len -= len;
+    rt_memmove(port->rx, port->rx + len, port->rx_len);
+    rt_hw_interrupt_enable(level);
+
+    return len;
+}
+
+/* the slave of the frame answers its reply time after the last byte, the others never */
+static void rs485_tc_reply(struct rs485_tc_port *port)
+{
+    rt_tick_t tick;
+    int ms;
+
+    if (slave_answer != RT_NULL)
+    {
+        port->reply_len = slave_answer(port->frame, port->frame_len, port->reply);
+    }
+    else
+    {
+        rt_memcpy(port->reply, port->frame, port->frame_len);
+        port->reply_len = port->frame_len;
+    }
+
+    ms = (port->frame[0] == 0) ? RS485_TC_SILENT : slave_ms[port->frame[0]];
+    if (ms < 0 || port->reply_len <= 0)
+    {
+        port->phase = RS485_TC_IDLE;
+        return;
+    }
+
+    tick = rt_tick_from_millisecond(RS485_TC_TAIL_MS + ms) + 1;
+    port->phase = RS485_TC_REPLY;
+    rt_timer_control(&port->timer, RT_TIMER_CTRL_SET_TIME, &tick);
+    rt_timer_start(&port->timer);
+}
+
+static rt_ssize_t rs485_tc_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    struct rs485_tc_port *port = (struct rs485_tc_port *)dev;
+    rt_tick_t tick = 1;
+
+    if (size > RS485_TC_FRAME_MAX)
+    {
+        size = RS485_TC_FRAME_MAX;
+    }
+
+    rt_timer_stop(&port->timer);
+    rt_memcpy(port->frame, buffer, size);
+    port->frame_len = size;
+    port->frames ++;
+
+    if (dev->open_flag & RT_DEVICE_FLAG_DMA_TX)
+    {
+        port->phase = RS485_TC_WIRE;
+        rt_timer_control(&port->timer, RT_TIMER_CTRL_SET_TIME, &tick);
+        rt_timer_start(&port->timer);
+    }
+    else
+    {
+        rs485_tc_reply(port);
+    }
+
+    return size;
+}
+
+static void rs485_tc_timeout(void *param)
+{
+    struct rs485_tc_port *port = (struct rs485_tc_port *)param;
+    rt_device_t dev = &port->parent;
+
+    if (port->phase == RS485_TC_WIRE)
+    {
+        if (dev->tx_complete)
+        {
+            dev->tx_complete(dev, port->frame);
+        }
+        rs485_tc_reply(port);
+        return;
+    }
+
+    if (port->phase == RS485_TC_REPLY)
+    {
+        port->phase = RS485_TC_IDLE;
+        rt_memcpy(port->rx, port->reply, port->reply_len);
+        port->rx_len = port->reply_len;
+        if (dev->rx_indicate)
+        {
+            dev->rx_indicate(dev, port->rx_len);
+        }
+    }
+}
+
+#ifdef RT_USING_DEVICE_OPS
+static const struct rt_device_ops rs485_tc_ops =
+{
+    RT_NULL,
+    rs485_tc_open,
+    rs485_tc_close,
+    rs485_tc_read,
+    rs485_tc_write,
+    RT_NULL
+};
+#endif
+
+/* the reply time of a slave, RS485_TC_SILENT - no reply */
+void rs485_tc_slave(int addr, int reply_ms)
+{
+    slave_ms[addr & 0xFF] = reply_ms;
+}
+
+/* the replies are built by answer, RT_NULL - an echo of the frame */
+void rs485_tc_set_answer(rs485_tc_answer_t answer)
+{
+    slave_answer = answer;
+}
+
+rt_err_t rs485_tc_bus_init(void)
+{
+    struct rs485_tc_port *port;
+    char name[RT_NAME_MAX];
+    int i;
+
+    slave_answer = RT_NULL;
+    for (i = 0; i < 256; i++)
+    {
+        slave_ms[i] = RS485_TC_REPLY_MS;
+    }
+
+    for (i = 0; i < RS485_TC_PORTS; i++)
+    {
+        port = &rs485_tc_port[i];
+        rt_memset(port, 0, sizeof(*port));
+        rt_snprintf(name, sizeof(name), "rs485tc%d", i);
+
+        port->parent.type = RT_Device_Class_Char;
+#ifdef RT_USING_DEVICE_OPS
+        port->parent.ops = &rs485_tc_ops;
+#else
+        port->parent.open = rs485_tc_open;
+        port->parent.close = rs485_tc_close;
+        port->parent.read = rs485_tc_read;
+        port->parent.write = rs485_tc_write;
+#endif
+        rt_timer_init(&port->timer, name, rs485_tc_timeout, port, 1, RT_TIMER_FLAG_ONE_SHOT);
+        if (rt_device_register(&port->parent, name, RT_DEVICE_FLAG_RDWR) != RT_EOK)
+        {
+            rt_timer_detach(&port->timer);
+            goto _error;
+        }
+
+        /* no direction pin, the transceiver is always right */
+        rs485_tc_inst[i] = rs485_create(name, RS485_TC_BAUDRATE, 0, -1, 1);
+        if (rs485_tc_inst[i] == RT_NULL || rs485_connect(rs485_tc_inst[i]) != RT_EOK)
+        {
+            i ++;
+            goto _error;
+        }
+    }
+
+    return RT_EOK;
+
+_error:
+    while (i-- > 0)
+    {
+        if (rs485_tc_inst[i] != RT_NULL)
+        {
+            rs485_destory(rs485_tc_inst[i]);
+            rs485_tc_inst[i] = RT_NULL;
+        }
+        rt_device_unregister(&rs485_tc_port[i].parent);
+        rt_timer_detach(&rs485_tc_port[i].timer);
+    }
+
+    return -RT_ERROR;
+}
+
+void rs485_tc_bus_deinit(void)
+{
+    int i;
+
+    for (i = 0; i < RS485_TC_PORTS; i++)
+    {
+        /* closes the port */
+        rs485_destory(rs485_tc_inst[i]);
+        rs485_tc_inst[i] = RT_NULL;
+        rt_device_unregister(&rs485_tc_port[i].parent);
+        rt_timer_detach(&rs485_tc_port[i].timer);
+    }
+}
+
+#endif /* RT_USING_UTEST */
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#ifndef __RS485_TC_H__
+#define __RS485_TC_H__
+
+#include "bsp_sys.h"
+
+/*
+ * A simulated bus for the rs485 testcases. Every port is a char device
+ * with no uart behind it and an rs485 instance connected on it. A frame
+ * written to a port is on the wire for one tick, then the slave of the
+ * first byte of the frame echoes it its reply time after the last byte.
+ * Broadcasts and silent slaves get no reply. A testcase can set an answer
+ * function to build the replies instead, it sees every frame, broadcasts
+ * too. The timers of the ports run in the timer context, like the
+ * interrupts of a real uart.
+ */
+
+#define RS485_TC_PORTS          4
+#define RS485_TC_FRAME_MAX      64
+#define RS485_TC_BAUDRATE       115200
+#ifndef RS485_TC_REPLY_MS
+#define RS485_TC_REPLY_MS       5       /* the reply time of a slave by default */
+#endif
+#define RS485_TC_SILENT         (-1)
+
+struct rs485_tc_port
+{
+    struct rt_device parent;
+    struct rt_timer timer;
+    int phase;                  /* on the wire or waiting for the reply */
+    rt_uint8_t frame[RS485_TC_FRAME_MAX];
+    int frame_len;
+    rt_uint8_t reply[RS485_TC_FRAME_MAX];
+    int reply_len;
+    rt_uint8_t rx[RS485_TC_FRAME_MAX];
+    int rx_len;
+    rt_uint32_t frames;         /* frames written so far */
+};
+
+/* builds the reply to a frame, in the timer context, returns its length, 0 - no reply */
+typedef int (*rs485_tc_answer_t)(const rt_uint8_t *frame, int len, rt_uint8_t *reply);
+
+extern struct rs485_tc_port rs485_tc_port[RS485_TC_PORTS];
+extern rs485_inst_t *rs485_tc_inst[RS485_TC_PORTS];
+
+rt_err_t rs485_tc_bus_init(void);
+void rs485_tc_bus_deinit(void);
+void rs485_tc_slave(int addr, int reply_ms);
+void rs485_tc_set_answer(rs485_tc_answer_t answer);
+
+#endif /* __RS485_TC_H__ */
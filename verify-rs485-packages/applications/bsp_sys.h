@@ -31,6 +31,9 @@
 /* macBSP文件 */
 #include "bsp_rs485_drv.h"
 #include "bsp_rs485_dev.h"
+#include "bsp_rs485_usb.h"
+#include "bsp_rs485_gw.h"
+#include "bsp_rs485_mbtcp.h"
 
 
 
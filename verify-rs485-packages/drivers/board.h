@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2025-11-08     RealThread   first version
+ * 2026-10-17     RT-Thread    add the uart fast isr options
  */
 
 #ifndef __BOARD_H__
@@ -65,6 +66,11 @@ extern "C"
  * STEP 4, according to serial port number to define serial port tx/rx DMA function in the board.h file
  *                 such as     #define BSP_UART1_RX_USING_DMA
  *
+ * STEP 5, optionally handle the uart interrupt on the registers instead of the HAL flag macros,
+ *         and count the DWT cycles of it, "uart_stat" shows them
+ *                 such as     #define BSP_UART_USING_FAST_ISR
+ *                             #define BSP_UART_USING_ISR_STAT
+ *
  */
 
 #define BSP_USING_UART5
@@ -77,6 +83,9 @@ extern "C"
 #define BSP_UART3_RX_USING_DMA
 #define BSP_UART3_TX_USING_DMA
 
+/*#define BSP_UART_USING_FAST_ISR*/
+/*#define BSP_UART_USING_ISR_STAT*/
+
 /*-------------------------- UART CONFIG END --------------------------*/
 
 /*-------------------------- I2C CONFIG BEGIN --------------------------*/
@@ -9,6 +9,7 @@
  * 2018-12-12     balanceTWK   first version
  * 2019-06-11     WillianChan  Add SD card hot plug detection
  * 2020-11-09     whj4674672   fix sdio non-aligned access problem
+ * 2026-10-17     RT-Thread    support CMD23 pre-defined multi-block transfers
  */
 
 #include "board.h"
@@ -657,10 +658,14 @@ struct rt_mmcsd_host *sdio_host_create(struct stm32_sdio_des *sdio_des)
     host->freq_min = 400 * 1000;
     host->freq_max = SDIO_MAX_FREQ;
     host->valid_ocr = 0X00FFFF80;/* The voltage range supported is 1.65v-3.6v */
+    /*
+     * the data path stops by itself after dlen bytes and the stop command
+     * is only sent when the request has one, so a CMD23 block count works
+     */
 #ifndef SDIO_USING_1_BIT
-    host->flags = MMCSD_BUSWIDTH_4 | MMCSD_MUTBLKWRITE | MMCSD_SUP_SDIO_IRQ;
+    host->flags = MMCSD_BUSWIDTH_4 | MMCSD_MUTBLKWRITE | MMCSD_SUP_SDIO_IRQ | MMCSD_SUP_CMD23;
 #else
-    host->flags = MMCSD_MUTBLKWRITE | MMCSD_SUP_SDIO_IRQ;
+    host->flags = MMCSD_MUTBLKWRITE | MMCSD_SUP_SDIO_IRQ | MMCSD_SUP_CMD23;
 #endif
     host->max_seg_size = SDIO_BUFF_SIZE;
     host->max_dma_segs = 1;
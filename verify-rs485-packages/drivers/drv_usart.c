@@ -12,6 +12,8 @@
  * 2020-05-23     chenyaxing   modify stm32_uart_config
  * 2020-09-09     forest-rain  support stm32wl uart
  * 2020-10-14     Dozingfiretruck   Porting for stm32wbxx
+ * 2026-10-17     RT-Thread    support the interrupt tx ring buffer
+ * 2026-10-17     RT-Thread    add the register level isr and the isr statistics
  */
 
 #include "board.h"
@@ -36,6 +38,12 @@
 
 #ifdef RT_SERIAL_USING_DMA
 static void stm32_dma_config(struct rt_serial_device *serial, rt_ubase_t flag);
+static void _dma_tx_complete(struct rt_serial_device *serial);
+#endif
+
+#if defined(BSP_UART_USING_FAST_ISR) && !defined(SOC_SERIES_STM32F1) && !defined(SOC_SERIES_STM32F2) \
+    && !defined(SOC_SERIES_STM32F4)
+#error "BSP_UART_USING_FAST_ISR is for the USART with the SR register (STM32F1/F2/F4)"
 #endif
 
 enum
@@ -408,7 +416,7 @@ static rt_err_t stm32_configure(struct rt_serial_device *serial, struct serial_c
 static rt_err_t stm32_control(struct rt_serial_device *serial, int cmd, void *arg)
 {
     struct stm32_uart *uart;
-#ifdef RT_SERIAL_USING_DMA
+#if defined(RT_SERIAL_USING_DMA) || defined(RT_SERIAL_USING_TX_RB)
     rt_ubase_t ctrl_arg = (rt_ubase_t)arg;
 #endif
 
@@ -419,6 +427,15 @@ static rt_err_t stm32_control(struct rt_serial_device *serial, int cmd, void *ar
     {
     /* disable interrupt */
     case RT_DEVICE_CTRL_CLR_INT:
+#ifdef RT_SERIAL_USING_TX_RB
+        if (ctrl_arg == RT_DEVICE_FLAG_INT_TX)
+        {
+            /* rx keeps its irq */
+            __HAL_UART_DISABLE_IT(&(uart->handle), UART_IT_TXE);
+            __HAL_UART_DISABLE_IT(&(uart->handle), UART_IT_TC);
+            break;
+        }
+#endif
         /* disable rx irq */
         NVIC_DisableIRQ(uart->config->irq_type);
         /* disable interrupt */
@@ -452,6 +469,16 @@ static rt_err_t stm32_control(struct rt_serial_device *serial, int cmd, void *ar
 
     /* enable interrupt */
     case RT_DEVICE_CTRL_SET_INT:
+#ifdef RT_SERIAL_USING_TX_RB
+        if (ctrl_arg == RT_DEVICE_FLAG_INT_TX)
+        {
+            /* the tx fifo has data */
+            HAL_NVIC_SetPriority(uart->config->irq_type, 1, 0);
+            HAL_NVIC_EnableIRQ(uart->config->irq_type);
+            __HAL_UART_ENABLE_IT(&(uart->handle), UART_IT_TXE);
+            break;
+        }
+#endif
         /* enable rx irq */
         HAL_NVIC_SetPriority(uart->config->irq_type, 1, 0);
         HAL_NVIC_EnableIRQ(uart->config->irq_type);
@@ -459,6 +486,14 @@ static rt_err_t stm32_control(struct rt_serial_device *serial, int cmd, void *ar
         __HAL_UART_ENABLE_IT(&(uart->handle), UART_IT_RXNE);
         break;
 
+#ifdef RT_SERIAL_USING_TX_RB
+    /* the tx fifo is empty, interrupt once the last byte is out */
+    case RT_SERIAL_CTRL_TX_TC:
+        __HAL_UART_DISABLE_IT(&(uart->handle), UART_IT_TXE);
+        __HAL_UART_ENABLE_IT(&(uart->handle), UART_IT_TC);
+        break;
+#endif
+
 #ifdef RT_SERIAL_USING_DMA
     case RT_DEVICE_CTRL_CONFIG:
         stm32_dma_config(serial, ctrl_arg);
@@ -529,6 +564,14 @@ static int stm32_putc(struct rt_serial_device *serial, char c)
     RT_ASSERT(serial != RT_NULL);
 
     uart = rt_container_of(serial, struct stm32_uart, serial);
+#ifdef RT_SERIAL_USING_TX_RB
+    /* called from the tx interrupt, do not wait */
+    if ((serial->parent.open_flag & RT_DEVICE_FLAG_INT_TX) &&
+            (__HAL_UART_GET_FLAG(&(uart->handle), UART_FLAG_TXE) == RESET))
+    {
+        return -1;
+    }
+#endif
     UART_INSTANCE_CLEAR_FUNCTION(&(uart->handle), UART_FLAG_TC);
 #if defined(SOC_SERIES_STM32L4) || defined(SOC_SERIES_STM32WL) || defined(SOC_SERIES_STM32F7) || defined(SOC_SERIES_STM32F0) \
     || defined(SOC_SERIES_STM32L0) || defined(SOC_SERIES_STM32G0) || defined(SOC_SERIES_STM32H7) || defined(SOC_SERIES_STM32L5) \
@@ -537,6 +580,12 @@ static int stm32_putc(struct rt_serial_device *serial, char c)
     uart->handle.Instance->TDR = c;
 #else
     uart->handle.Instance->DR = c;
+#endif
+#ifdef RT_SERIAL_USING_TX_RB
+    if (serial->parent.open_flag & RT_DEVICE_FLAG_INT_TX)
+    {
+        return 1;
+    }
 #endif
     while (__HAL_UART_GET_FLAG(&(uart->handle), UART_FLAG_TC) == RESET);
     return 1;
@@ -590,12 +639,13 @@ static rt_size_t stm32_dma_transmit(struct rt_serial_device *serial, rt_uint8_t
     return 0;
 }
 
+#ifndef BSP_UART_USING_FAST_ISR
 /**
- * Uart common interrupt process. This need add to uart ISR.
+ * Uart common interrupt process through the HAL flag macros.
  *
  * @param serial serial device
  */
-static void uart_isr(struct rt_serial_device *serial)
+static void uart_hal_isr(struct rt_serial_device *serial)
 {
     struct stm32_uart *uart;
 #ifdef RT_SERIAL_USING_DMA
@@ -612,6 +662,22 @@ static void uart_isr(struct rt_serial_device *serial)
     {
         rt_hw_serial_isr(serial, RT_SERIAL_EVENT_RX_IND);
     }
+#ifdef RT_SERIAL_USING_TX_RB
+    /* UART in mode Transmitter with the tx fifo -----------------------------*/
+    else if ((__HAL_UART_GET_FLAG(&(uart->handle), UART_FLAG_TXE) != RESET) &&
+            (__HAL_UART_GET_IT_SOURCE(&(uart->handle), UART_IT_TXE) != RESET))
+    {
+        rt_hw_serial_isr(serial, RT_SERIAL_EVENT_TX_DONE);
+    }
+    else if ((serial->parent.open_flag & RT_DEVICE_FLAG_INT_TX) &&
+            (__HAL_UART_GET_FLAG(&(uart->handle), UART_FLAG_TC) != RESET) &&
+            (__HAL_UART_GET_IT_SOURCE(&(uart->handle), UART_IT_TC) != RESET))
+    {
+        __HAL_UART_DISABLE_IT(&(uart->handle), UART_IT_TC);
+        UART_INSTANCE_CLEAR_FUNCTION(&(uart->handle), UART_FLAG_TC);
+        rt_hw_serial_isr(serial, RT_SERIAL_EVENT_TX_TC);
+    }
+#endif
 #ifdef RT_SERIAL_USING_DMA
     else if ((uart->uart_dma_flag) && (__HAL_UART_GET_FLAG(&(uart->handle), UART_FLAG_IDLE) != RESET)
              && (__HAL_UART_GET_IT_SOURCE(&(uart->handle), UART_IT_IDLE) != RESET))
@@ -691,6 +757,153 @@ static void uart_isr(struct rt_serial_device *serial)
     }
 }
 
+#endif /* BSP_UART_USING_FAST_ISR */
+
+#ifdef BSP_UART_USING_FAST_ISR
+typedef void (*uart_event_handler_t)(struct stm32_uart *uart);
+
+static void uart_idle_handler(struct stm32_uart *uart)
+{
+#ifdef RT_SERIAL_USING_DMA
+    rt_size_t recv_total_index, recv_len;
+    rt_base_t level;
+#endif
+
+    /* IDLE is cleared by reading DR after SR */
+    (void)uart->handle.Instance->DR;
+
+#ifdef RT_SERIAL_USING_DMA
+    if (uart->uart_dma_flag)
+    {
+        level = rt_hw_interrupt_disable();
+        recv_total_index = uart->serial.config.bufsz - __HAL_DMA_GET_COUNTER(&(uart->dma_rx.handle));
+        recv_len = recv_total_index - uart->dma_rx.last_index;
+        uart->dma_rx.last_index = recv_total_index;
+        rt_hw_interrupt_enable(level);
+
+        if (recv_len)
+        {
+            rt_hw_serial_isr(&uart->serial, RT_SERIAL_EVENT_RX_DMADONE | (recv_len << 8));
+        }
+    }
+#endif
+}
+
+static void uart_rxne_handler(struct stm32_uart *uart)
+{
+    rt_hw_serial_isr(&uart->serial, RT_SERIAL_EVENT_RX_IND);
+}
+
+static void uart_tc_handler(struct stm32_uart *uart)
+{
+    CLEAR_BIT(uart->handle.Instance->CR1, USART_CR1_TCIE);
+    uart->handle.Instance->SR = ~USART_SR_TC;
+
+#ifdef RT_SERIAL_USING_DMA
+    if (uart->serial.parent.open_flag & RT_DEVICE_FLAG_DMA_TX)
+    {
+        /* the end of UART_EndTransmit_IT, without the rest of HAL_UART_IRQHandler */
+        uart->handle.gState = HAL_UART_STATE_READY;
+        _dma_tx_complete(&uart->serial);
+        return;
+    }
+#endif
+#ifdef RT_SERIAL_USING_TX_RB
+    if (uart->serial.parent.open_flag & RT_DEVICE_FLAG_INT_TX)
+    {
+        rt_hw_serial_isr(&uart->serial, RT_SERIAL_EVENT_TX_TC);
+    }
+#endif
+}
+
+static void uart_txe_handler(struct stm32_uart *uart)
+{
+#ifdef RT_SERIAL_USING_TX_RB
+    rt_hw_serial_isr(&uart->serial, RT_SERIAL_EVENT_TX_DONE);
+#else
+    CLEAR_BIT(uart->handle.Instance->CR1, USART_CR1_TXEIE);
+#endif
+}
+
+/* indexed by the flag bit - 4, IDLE, RXNE, TC and TXE are bit 4 to 7 of SR */
+static const uart_event_handler_t uart_event_handlers[] =
+{
+    uart_idle_handler,
+    uart_rxne_handler,
+    uart_tc_handler,
+    uart_txe_handler,
+};
+
+/**
+ * Uart interrupt process on the registers, SR is read once and the
+ * line errors are counted.
+ *
+ * @param uart stm32 uart
+ */
+static void uart_fast_isr(struct stm32_uart *uart)
+{
+    USART_TypeDef *regs = uart->handle.Instance;
+    rt_uint32_t sr, pending;
+
+    sr = regs->SR;
+    /* the interrupt enable bits of CR1 are at the same place as the flags */
+    pending = sr & regs->CR1 & (USART_SR_IDLE | USART_SR_RXNE | USART_SR_TC | USART_SR_TXE);
+
+    if (sr & (USART_SR_ORE | USART_SR_NE | USART_SR_FE | USART_SR_PE))
+    {
+        if (sr & USART_SR_ORE)
+            uart->stat.ore ++;
+        if (sr & USART_SR_NE)
+            uart->stat.ne ++;
+        if (sr & USART_SR_FE)
+            uart->stat.fe ++;
+        if (sr & USART_SR_PE)
+            uart->stat.pe ++;
+
+        /* cleared by reading DR after SR, unless the rx handlers read it */
+        if (!(pending & (USART_SR_IDLE | USART_SR_RXNE)))
+        {
+            (void)regs->DR;
+        }
+    }
+
+    while (pending)
+    {
+        uart_event_handlers[__rt_ffs(pending) - 1 - 4](uart);
+        pending &= pending - 1;
+    }
+}
+#endif /* BSP_UART_USING_FAST_ISR */
+
+/**
+ * Uart common interrupt process. This need add to uart ISR.
+ *
+ * @param serial serial device
+ */
+static void uart_isr(struct rt_serial_device *serial)
+{
+#ifdef BSP_UART_USING_ISR_STAT
+    struct stm32_uart *uart = rt_container_of(serial, struct stm32_uart, serial);
+    rt_uint32_t cycles = DWT->CYCCNT;
+#endif
+
+#ifdef BSP_UART_USING_FAST_ISR
+    uart_fast_isr(rt_container_of(serial, struct stm32_uart, serial));
+#else
+    uart_hal_isr(serial);
+#endif
+
+#ifdef BSP_UART_USING_ISR_STAT
+    cycles = DWT->CYCCNT - cycles;
+    uart->stat.isr_count ++;
+    uart->stat.cycles_total += cycles;
+    if (cycles > uart->stat.cycles_max)
+    {
+        uart->stat.cycles_max = cycles;
+    }
+#endif
+}
+
 #ifdef RT_SERIAL_USING_DMA
 static void dma_isr(struct rt_serial_device *serial)
 {
@@ -1357,6 +1570,13 @@ int rt_hw_usart_init(void)
 
     stm32_uart_get_dma_config();
 
+#ifdef BSP_UART_USING_ISR_STAT
+    /* start the DWT cycle counter */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+
     for (int i = 0; i < obj_num; i++)
     {
         /* init UART object */
@@ -1377,4 +1597,36 @@ int rt_hw_usart_init(void)
     return result;
 }
 
+#if defined(RT_USING_FINSH) && (defined(BSP_UART_USING_FAST_ISR) || defined(BSP_UART_USING_ISR_STAT))
+#include <finsh.h>
+static void uart_stat(int argc, char **argv)
+{
+    rt_size_t obj_num = sizeof(uart_obj) / sizeof(struct stm32_uart);
+    struct stm32_uart *uart;
+    rt_base_t level;
+
+    if (argc == 2 && rt_strcmp(argv[1], "reset") == 0)
+    {
+        for (int i = 0; i < obj_num; i++)
+        {
+            level = rt_hw_interrupt_disable();
+            rt_memset(&uart_obj[i].stat, 0, sizeof(uart_obj[i].stat));
+            rt_hw_interrupt_enable(level);
+        }
+        return;
+    }
+
+    rt_kprintf("uart     isr        avg cycles max cycles ore      ne       fe       pe\n");
+    rt_kprintf("-------- ---------- ---------- ---------- -------- -------- -------- --------\n");
+    for (int i = 0; i < obj_num; i++)
+    {
+        uart = &uart_obj[i];
+        rt_kprintf("%-8s %-10u %-10u %-10u %-8u %-8u %-8u %-8u\n", uart->config->name, uart->stat.isr_count,
+                   uart->stat.isr_count ? (rt_uint32_t)(uart->stat.cycles_total / uart->stat.isr_count) : 0,
+                   uart->stat.cycles_max, uart->stat.ore, uart->stat.ne, uart->stat.fe, uart->stat.pe);
+    }
+}
+MSH_CMD_EXPORT(uart_stat, show the uart isr cycles and line errors: uart_stat [reset]);
+#endif
+
 #endif /* RT_USING_SERIAL */
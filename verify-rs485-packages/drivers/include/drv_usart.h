@@ -8,6 +8,7 @@
  * 2018.10.30     SummerGift   first version
  * 2019.03.05     whj4674672   add stm32h7
  * 2020-10-14     Dozingfiretruck   Porting for stm32wbxx
+ * 2026-10-17     RT-Thread    add the uart isr statistics
  */
 
 #ifndef __DRV_USART_H__
@@ -69,6 +70,19 @@ struct stm32_uart
 #endif
     rt_uint16_t uart_dma_flag;
     struct rt_serial_device serial;
+
+#if defined(BSP_UART_USING_FAST_ISR) || defined(BSP_UART_USING_ISR_STAT)
+    struct
+    {
+        rt_uint32_t ore;                /* line errors */
+        rt_uint32_t ne;
+        rt_uint32_t fe;
+        rt_uint32_t pe;
+        rt_uint32_t isr_count;
+        rt_uint32_t cycles_max;         /* DWT cycles in uart_isr */
+        rt_uint64_t cycles_total;
+    } stat;
+#endif
 };
 
 #endif  /* __DRV_USART_H__ */
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "board.h"
+#include "drv_usart.h"
+
+#if defined(RT_USING_UTEST) && defined(BSP_UART_USING_FAST_ISR)
+#include "utest.h"
+
+/*
+ * The register level uart isr on a copy of the USART registers in RAM.
+ * The testcase points the handle of a uart nobody opened at the copy,
+ * with its interrupt off, and calls the interrupt handler of the uart.
+ * It checks that the line errors are counted, that only the flags with
+ * their interrupt enabled are handled, and that TC turns off TCIE and is
+ * cleared. RXNE and IDLE are left out, they need an open uart. Every run
+ * of the isr testcase makes USART_TC_CALLS calls with nothing pending,
+ * uart_stat shows the cycles with BSP_UART_USING_ISR_STAT. Time it with:
+ *
+ *     utest_bench -n 20 testcases.bsp.usart.isr
+ */
+
+#ifndef USART_TC_UART
+#define USART_TC_UART           "uart3"
+#define USART_TC_IRQ            USART3_IRQn
+#define USART_TC_IRQ_HANDLER    USART3_IRQHandler
+#endif
+#define USART_TC_CALLS          1000
+
+extern void USART_TC_IRQ_HANDLER(void);
+
+static struct stm32_uart *uart;
+static USART_TypeDef *instance;
+static USART_TypeDef regs;
+
+static rt_err_t usart_tc_init(void)
+{
+    rt_device_t dev;
+
+    dev = rt_device_find(USART_TC_UART);
+    if (dev == RT_NULL || dev->ref_count != 0)
+    {
+        LOG_E("%s is missing or open", USART_TC_UART);
+        return -RT_ERROR;
+    }
+
+    uart = rt_container_of(dev, struct stm32_uart, serial.parent);
+    HAL_NVIC_DisableIRQ(USART_TC_IRQ);
+    instance = uart->handle.Instance;
+    uart->handle.Instance = &regs;
+    rt_memset(&regs, 0, sizeof(regs));
+    rt_memset(&uart->stat, 0, sizeof(uart->stat));
+
+    return RT_EOK;
+}
+
+static rt_err_t usart_tc_cleanup(void)
+{
+    uart->handle.Instance = instance;
+    rt_memset(&uart->stat, 0, sizeof(uart->stat));
+    HAL_NVIC_EnableIRQ(USART_TC_IRQ);
+
+    return RT_EOK;
+}
+
+static void usart_errors(void)
+{
+    regs.SR = USART_SR_ORE | USART_SR_FE;
+    regs.CR1 = USART_CR1_UE;
+    USART_TC_IRQ_HANDLER();
+    regs.SR = USART_SR_NE | USART_SR_PE | USART_SR_ORE;
+    USART_TC_IRQ_HANDLER();
+
+    uassert_int_equal(uart->stat.ore, 2);
+    uassert_int_equal(uart->stat.fe, 1);
+    uassert_int_equal(uart->stat.ne, 1);
+    uassert_int_equal(uart->stat.pe, 1);
+}
+
+static void usart_events(void)
+{
+    rt_memset(&uart->stat, 0, sizeof(uart->stat));
+
+    /* TC without TCIE is left alone */
+    regs.SR = USART_SR_TC | USART_SR_TXE;
+    regs.CR1 = USART_CR1_UE | USART_CR1_TE;
+    USART_TC_IRQ_HANDLER();
+    uassert_int_equal(regs.SR, USART_SR_TC | USART_SR_TXE);
+    uassert_int_equal(regs.CR1, USART_CR1_UE | USART_CR1_TE);
+
+    /* TC with TCIE turns it off and is cleared */
+    regs.CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_TCIE;
+    USART_TC_IRQ_HANDLER();
+    uassert_int_equal(regs.SR & USART_SR_TC, 0);
+    uassert_int_equal(regs.CR1, USART_CR1_UE | USART_CR1_TE);
+
+#ifndef RT_SERIAL_USING_TX_RB
+    /* TXE only turns TXEIE off without the tx ring */
+    regs.SR = USART_SR_TXE;
+    regs.CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_TXEIE;
+    USART_TC_IRQ_HANDLER();
+    uassert_int_equal(regs.CR1, USART_CR1_UE | USART_CR1_TE);
+#else
+    regs.SR = USART_SR_TXE;
+    regs.CR1 = USART_CR1_UE | USART_CR1_TE;
+    USART_TC_IRQ_HANDLER();
+#endif
+
+    uassert_int_equal(uart->stat.ore + uart->stat.fe + uart->stat.ne + uart->stat.pe, 0);
+#ifdef BSP_UART_USING_ISR_STAT
+    uassert_int_equal(uart->stat.isr_count, 3);
+#endif
+}
+
+static void usart_isr(void)
+{
+    int i;
+
+    regs.SR = USART_SR_TC | USART_SR_TXE;
+    regs.CR1 = USART_CR1_UE | USART_CR1_TE | USART_CR1_RE;
+    for (i = 0; i < USART_TC_CALLS; i++)
+    {
+        USART_TC_IRQ_HANDLER();
+    }
+
+#ifdef BSP_UART_USING_ISR_STAT
+    LOG_I("%d isr calls, %d cycles max", uart->stat.isr_count, uart->stat.cycles_max);
+    uassert_true(uart->stat.isr_count >= USART_TC_CALLS);
+#endif
+}
+
+static void testcase_events(void)
+{
+    UTEST_UNIT_RUN(usart_errors);
+    UTEST_UNIT_RUN(usart_events);
+}
+UTEST_TC_EXPORT(testcase_events, "testcases.bsp.usart.events", usart_tc_init, usart_tc_cleanup, 10);
+
+static void testcase_isr(void)
+{
+    UTEST_UNIT_RUN(usart_isr);
+}
+UTEST_TC_EXPORT(testcase_isr, "testcases.bsp.usart.isr", usart_tc_init, usart_tc_cleanup, 10);
+
+#endif /* RT_USING_UTEST && BSP_UART_USING_FAST_ISR */
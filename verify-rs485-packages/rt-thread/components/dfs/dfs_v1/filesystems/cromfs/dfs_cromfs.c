@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2020/08/21     ShaoJinchun  first version
+ * 2026-10-17     RT-Thread    keep decompressed file data in an LRU cache after close
  */
 
 #include <rtthread.h>
@@ -24,6 +25,12 @@
 #define CROMFS_PATITION_HEAD_SIZE 256
 #define CROMFS_DIRENT_CACHE_SIZE  8
 
+#ifdef RT_DFS_CROMFS_DATA_CACHE_SIZE
+#define CROMFS_DATA_CACHE_SIZE    RT_DFS_CROMFS_DATA_CACHE_SIZE
+#else
+#define CROMFS_DATA_CACHE_SIZE    16384
+#endif
+
 #define CROMFS_MAGIC   "CROMFSMG"
 
 #define CROMFS_CT_ASSERT(name, x) \
@@ -94,10 +101,13 @@ typedef struct st_cromfs_info
     struct cromfs_avl_struct *cromfs_avl_root;
     rt_list_t cromfs_dirent_cache_head;
     int cromfs_dirent_cache_nr;
+    rt_list_t cromfs_data_cache_head;   /* closed files with valid data, most recent first */
+    uint32_t cromfs_data_cache_bytes;
 } cromfs_info;
 
 typedef struct
 {
+    rt_list_t list;                     /* node in cromfs_data_cache_head while ref is 0 */
     uint32_t ref;
     uint32_t partition_pos;
     cromfs_info *ci;
@@ -523,6 +533,9 @@ static int dfs_cromfs_mount(struct dfs_filesystem *fs, unsigned long rwflag, con
     rt_list_init(&ci->cromfs_dirent_cache_head);
     ci->cromfs_dirent_cache_nr = 0;
 
+    rt_list_init(&ci->cromfs_data_cache_head);
+    ci->cromfs_data_cache_bytes = 0;
+
     return RT_EOK;
 }
 
@@ -806,6 +819,12 @@ static file_info *get_file_info(cromfs_info *ci, uint32_t partition_pos, int inc
     {
         if (inc_ref)
         {
+            if (node->fi->ref == 0)
+            {
+                /* reopened while cached, take it out of the lru */
+                rt_list_remove(&node->fi->list);
+                ci->cromfs_data_cache_bytes -= node->fi->size;
+            }
             node->fi->ref++;
         }
         return node->fi;
@@ -846,6 +865,7 @@ static file_info *inset_file_info(cromfs_info *ci, uint32_t partition_pos, int i
     }
     fi->buff = file_buff;
     fi->ref = 1;
+    rt_list_init(&fi->list);
 
     node = (struct cromfs_avl_struct *)malloc(sizeof *node);
     if (!node)
@@ -868,6 +888,32 @@ err:
     return NULL;
 }
 
+static void free_file_info(cromfs_info *ci, struct cromfs_avl_struct *node)
+{
+    file_info *fi = node->fi;
+
+    cromfs_avl_remove(node, &ci->cromfs_avl_root);
+    free(node);
+    if (fi->buff)
+    {
+        free(fi->buff);
+    }
+    free(fi);
+}
+
+static void cromfs_data_cache_trim(cromfs_info *ci, uint32_t limit)
+{
+    file_info *fi = NULL;
+
+    while (ci->cromfs_data_cache_bytes > limit)
+    {
+        fi = rt_list_entry(ci->cromfs_data_cache_head.prev, file_info, list);
+        rt_list_remove(&fi->list);
+        ci->cromfs_data_cache_bytes -= fi->size;
+        free_file_info(ci, cromfs_avl_find(fi->partition_pos, ci->cromfs_avl_root));
+    }
+}
+
 static void deref_file_info(cromfs_info *ci, uint32_t partition_pos)
 {
     struct cromfs_avl_struct* node = cromfs_avl_find(partition_pos, ci->cromfs_avl_root);
@@ -879,13 +925,17 @@ static void deref_file_info(cromfs_info *ci, uint32_t partition_pos)
         if (node->fi->ref == 0)
         {
             fi = node->fi;
-            cromfs_avl_remove(node, &ci->cromfs_avl_root);
-            free(node);
-            if (fi->buff)
+            if (fi->buff && fi->data_valid && fi->size <= CROMFS_DATA_CACHE_SIZE)
+            {
+                /* keep the decompressed data for the next open */
+                rt_list_insert_after(&ci->cromfs_data_cache_head, &fi->list);
+                ci->cromfs_data_cache_bytes += fi->size;
+                cromfs_data_cache_trim(ci, CROMFS_DATA_CACHE_SIZE);
+            }
+            else
             {
-                free(fi->buff);
+                free_file_info(ci, node);
             }
-            free(fi);
         }
     }
 }
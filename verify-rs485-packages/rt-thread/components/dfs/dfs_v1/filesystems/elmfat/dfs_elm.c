@@ -15,6 +15,7 @@
  * 2017-02-13     Hichard      Update Fatfs version to 0.12b, support exFAT.
  * 2017-04-11     Bernard      fix the st_blksize issue.
  * 2017-05-26     Urey         fix f_mount error when mount more fats
+ * 2026-10-17     RT-Thread    add fast seek link map and contiguous allocation
  */
 
 #include <rtthread.h>
@@ -38,6 +39,81 @@
 
 static rt_device_t disk[FF_VOLUMES] = {0};
 
+#ifndef RT_DFS_ELM_FASTSEEK_THRESHOLD
+#define RT_DFS_ELM_FASTSEEK_THRESHOLD   (1024 * 1024)
+#endif
+#ifndef RT_DFS_ELM_FASTSEEK_MAX_ITEMS
+#define RT_DFS_ELM_FASTSEEK_MAX_ITEMS   256
+#endif
+
+/* the opened file, FIL must be the first member */
+struct elm_file
+{
+    FIL fil;
+#if FF_USE_FASTSEEK
+    FSIZE_t clmt_size;      /* file size the cluster link map was last built for */
+#endif
+};
+
+#if FF_USE_FASTSEEK
+static void elm_clmt_drop(FIL *fd)
+{
+    if (fd->cltbl)
+    {
+        rt_free(fd->cltbl);
+        fd->cltbl = RT_NULL;
+    }
+}
+
+/*
+ * Keep a cluster link map on large files, so a seek looks the cluster up in
+ * the map instead of following the FAT chain from the start. FatFs can not
+ * grow a file in fast seek mode, the map is dropped before any access beyond
+ * the end and built again on the next access within the file.
+ */
+static void elm_clmt_update(struct elm_file *ef, FSIZE_t end)
+{
+    FIL *fd = &ef->fil;
+    DWORD items = 32, *tbl;
+    FRESULT result;
+
+    if (end > f_size(fd))
+    {
+        elm_clmt_drop(fd);
+        return;
+    }
+
+    if (fd->cltbl || f_size(fd) < RT_DFS_ELM_FASTSEEK_THRESHOLD || ef->clmt_size == f_size(fd))
+    {
+        return;
+    }
+    /* one try per file size, a too fragmented file is not walked again */
+    ef->clmt_size = f_size(fd);
+
+    while (items <= RT_DFS_ELM_FASTSEEK_MAX_ITEMS)
+    {
+        tbl = (DWORD *)rt_malloc(items * sizeof(DWORD));
+        if (tbl == RT_NULL)
+            break;
+
+        tbl[0] = items;
+        fd->cltbl = tbl;
+        result = f_lseek(fd, CREATE_LINKMAP);
+        if (result == FR_OK)
+            break;
+
+        /* on FR_NOT_ENOUGH_CORE the first item tells the size needed */
+        items = tbl[0];
+        elm_clmt_drop(fd);
+        if (result != FR_NOT_ENOUGH_CORE)
+            break;
+    }
+}
+#else
+#define elm_clmt_drop(fd)
+#define elm_clmt_update(ef, end)
+#endif /* FF_USE_FASTSEEK */
+
 static int elm_result_to_dfs(FRESULT result)
 {
     int status = RT_EOK;
@@ -425,7 +501,7 @@ int dfs_elm_open(struct dfs_file *file)
             mode |= FA_CREATE_NEW;
 
         /* allocate a fd */
-        fd = (FIL *)rt_malloc(sizeof(FIL));
+        fd = (FIL *)rt_calloc(1, sizeof(struct elm_file));
         if (fd == RT_NULL)
         {
 #if FF_VOLUMES > 1
@@ -444,6 +520,7 @@ int dfs_elm_open(struct dfs_file *file)
             file->vnode->size = f_size(fd);
             file->vnode->type = FT_REGULAR;
             file->data = fd;
+            elm_clmt_update((struct elm_file *)fd, 0);
 
             if (file->flags & O_APPEND)
             {
@@ -490,6 +567,7 @@ int dfs_elm_close(struct dfs_file *file)
         RT_ASSERT(fd != RT_NULL);
 
         result = f_close(fd);
+        elm_clmt_drop(fd);
 
         /* release memory */
         rt_free(fd);
@@ -510,6 +588,9 @@ int dfs_elm_ioctl(struct dfs_file *file, int cmd, void *args)
             fd = (FIL *)(file->data);
             RT_ASSERT(fd != RT_NULL);
 
+            /* the cluster chain changes, the link map is stale */
+            elm_clmt_drop(fd);
+
             /* save file read/write point */
             fptr = fd->fptr;
             length = *(off_t*)args;
@@ -530,6 +611,29 @@ int dfs_elm_ioctl(struct dfs_file *file, int cmd, void *args)
             return 0;
     case F_SETLK:
             return 0;
+#if FF_USE_EXPAND
+    case RT_FIOFEXPAND:
+        {
+            FIL *fd;
+            FRESULT result;
+            fd = (FIL *)(file->data);
+            RT_ASSERT(fd != RT_NULL);
+
+            if (args == RT_NULL)
+                return -EINVAL;
+            if (!(fd->flag & FA_WRITE))
+                return -EBADF;
+            if (f_size(fd) != 0)
+                return -EINVAL;
+
+            /* allocate one contiguous cluster block now */
+            result = f_expand(fd, (FSIZE_t)*(off_t *)args, 1);
+            if (result == FR_DENIED)
+                return -ENOSPC;
+            file->vnode->size = f_size(fd);
+            return elm_result_to_dfs(result);
+        }
+#endif
     }
     return -ENOSYS;
 }
@@ -548,6 +652,7 @@ ssize_t dfs_elm_read(struct dfs_file *file, void *buf, size_t len)
     fd = (FIL *)(file->data);
     RT_ASSERT(fd != RT_NULL);
 
+    elm_clmt_update((struct elm_file *)fd, fd->fptr);
     result = f_read(fd, buf, len, &byte_read);
     /* update position */
     file->pos  = fd->fptr;
@@ -571,6 +676,7 @@ ssize_t dfs_elm_write(struct dfs_file *file, const void *buf, size_t len)
     fd = (FIL *)(file->data);
     RT_ASSERT(fd != RT_NULL);
 
+    elm_clmt_update((struct elm_file *)fd, fd->fptr + len);
     result = f_write(fd, buf, len, &byte_write);
     /* update position and file size */
     file->pos  = fd->fptr;
@@ -604,6 +710,7 @@ off_t dfs_elm_lseek(struct dfs_file *file, off_t offset)
         fd = (FIL *)(file->data);
         RT_ASSERT(fd != RT_NULL);
 
+        elm_clmt_update((struct elm_file *)fd, offset);
         result = f_lseek(fd, offset);
         if (result == FR_OK)
         {
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2023-07-04     zhkag        first Version
+ * 2026-10-17     RT-Thread    use the POSIX message ring instead of rt_mq
  */
 
 #include <rtthread.h>
@@ -74,9 +75,8 @@ int dfs_mqueue_open(struct dfs_file *file) {
     }
 
     if (file->flags & O_CREAT) {
-        rt_mq_t mq = rt_mq_create(file->vnode->path + 1, mq_file->msg_size, mq_file->max_msgs,
-                                  RT_IPC_FLAG_FIFO);
-        mq_file->data = (void *)mq;
+        if (mq_file->data == RT_NULL)
+            mq_file->data = (void *)mqueue_create(file->vnode->path + 1, mq_file->msg_size, mq_file->max_msgs);
         file->vnode->data = mq_file;
         file->vnode->size = 0;
     }
@@ -129,7 +129,7 @@ int dfs_mqueue_unlink(struct dfs_filesystem *fs, const char *path) {
         return -ENOENT;
     rt_list_remove(&(mq_file->list));
     if (mq_file->data != RT_NULL)
-        rt_mq_delete((rt_mq_t)mq_file->data);
+        mqueue_delete((struct mqueue *)mq_file->data);
     rt_free(mq_file);
     return RT_EOK;
 }
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2023-07-04     zhkag        first Version
+ * 2026-10-17     RT-Thread    use the POSIX message ring instead of rt_mq
  */
 
 #ifndef __DFS_MQUEUE_H__
@@ -25,4 +26,9 @@ struct mqueue_file {
 struct mqueue_file *dfs_mqueue_lookup(const char *path, rt_size_t *size);
 void dfs_mqueue_insert_after(rt_list_t *n);
 
+/* the queue behind mqueue_file->data, provided by the POSIX message queue */
+struct mqueue;
+struct mqueue *mqueue_create(const char *name, rt_uint16_t msg_size, rt_uint16_t max_msgs);
+void mqueue_delete(struct mqueue *mq);
+
 #endif
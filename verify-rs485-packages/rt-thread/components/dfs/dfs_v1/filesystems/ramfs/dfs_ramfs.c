@@ -8,6 +8,7 @@
  * 2013-04-15     Bernard      the first version
  * 2013-05-05     Bernard      remove CRC for ramfs persistence
  * 2013-05-22     Bernard      fix the no entry issue.
+ * 2026-10-17     RT-Thread    look up entries through a name hash table
  */
 
 #include <rtthread.h>
@@ -59,12 +60,75 @@ int dfs_ramfs_ioctl(struct dfs_file *file, int cmd, void *args)
     return -EIO;
 }
 
+static rt_uint32_t _name_hash(const char *name)
+{
+    rt_uint32_t val = 0;
+    rt_size_t len = RAMFS_NAME_MAX;
+
+    while (len -- && *name)
+    {
+        val = ((val << 5) + val) + *name++;
+    }
+    return val;
+}
+
+/* link dirent into the root directory, doubling the hash table when it is full */
+static void _dirent_insert(struct dfs_ramfs *ramfs, struct ramfs_dirent *dirent)
+{
+    struct ramfs_dirent *entry;
+    rt_size_t index, nr;
+    rt_list_t *buckets;
+
+    dirent->hash = _name_hash(dirent->name);
+    rt_list_init(&(dirent->hashlist));
+
+    if (ramfs->entry_nr + 1 > ramfs->bucket_nr * RAMFS_HASH_LOAD)
+    {
+        nr = ramfs->bucket_nr ? ramfs->bucket_nr << 1 : RAMFS_HASH_NR_MIN;
+        buckets = (rt_list_t *)rt_memheap_alloc(&(ramfs->memheap), nr * sizeof(rt_list_t));
+        /* keep the old table on failure, lookups only get slower */
+        if (buckets != NULL)
+        {
+            for (index = 0; index < nr; index ++)
+            {
+                rt_list_init(&buckets[index]);
+            }
+            for (entry = rt_list_entry(ramfs->root.list.next, struct ramfs_dirent, list);
+                 entry != &(ramfs->root);
+                 entry = rt_list_entry(entry->list.next, struct ramfs_dirent, list))
+            {
+                rt_list_insert_after(&buckets[entry->hash & (nr - 1)], &(entry->hashlist));
+            }
+            if (ramfs->buckets != NULL)
+                rt_memheap_free(ramfs->buckets);
+            ramfs->buckets = buckets;
+            ramfs->bucket_nr = nr;
+        }
+    }
+
+    rt_list_insert_after(&(ramfs->root.list), &(dirent->list));
+    if (ramfs->buckets != NULL)
+    {
+        rt_list_insert_after(&ramfs->buckets[dirent->hash & (ramfs->bucket_nr - 1)],
+                             &(dirent->hashlist));
+    }
+    ramfs->entry_nr ++;
+}
+
+static void _dirent_remove(struct dfs_ramfs *ramfs, struct ramfs_dirent *dirent)
+{
+    rt_list_remove(&(dirent->list));
+    rt_list_remove(&(dirent->hashlist));
+    ramfs->entry_nr --;
+}
+
 struct ramfs_dirent *dfs_ramfs_lookup(struct dfs_ramfs *ramfs,
                                       const char       *path,
                                       rt_size_t        *size)
 {
     const char *subpath;
     struct ramfs_dirent *dirent;
+    rt_uint32_t hash;
 
     subpath = path;
     while (*subpath == '/' && *subpath)
@@ -76,11 +140,32 @@ struct ramfs_dirent *dfs_ramfs_lookup(struct dfs_ramfs *ramfs,
         return &(ramfs->root);
     }
 
+    hash = _name_hash(subpath);
+    if (ramfs->buckets != NULL)
+    {
+        rt_list_t *head = &ramfs->buckets[hash & (ramfs->bucket_nr - 1)];
+
+        for (dirent = rt_list_entry(head->next, struct ramfs_dirent, hashlist);
+             &(dirent->hashlist) != head;
+             dirent = rt_list_entry(dirent->hashlist.next, struct ramfs_dirent, hashlist))
+        {
+            if (dirent->hash == hash && rt_strncmp(dirent->name, subpath, RAMFS_NAME_MAX) == 0)
+            {
+                *size = dirent->size;
+
+                return dirent;
+            }
+        }
+
+        /* not found */
+        return NULL;
+    }
+
     for (dirent = rt_list_entry(ramfs->root.list.next, struct ramfs_dirent, list);
          dirent != &(ramfs->root);
          dirent = rt_list_entry(dirent->list.next, struct ramfs_dirent, list))
     {
-        if (rt_strcmp(dirent->name, subpath) == 0)
+        if (dirent->hash == hash && rt_strncmp(dirent->name, subpath, RAMFS_NAME_MAX) == 0)
         {
             *size = dirent->size;
 
@@ -258,7 +343,7 @@ int dfs_ramfs_open(struct dfs_file *file)
                 file->vnode->type = FT_DIRECTORY;
 
                 /* add to the root directory */
-                rt_list_insert_after(&(ramfs->root.list), &(dirent->list));
+                _dirent_insert(ramfs, dirent);
             }
             else
                 return -ENOENT;
@@ -375,7 +460,7 @@ int dfs_ramfs_unlink(struct dfs_filesystem *fs, const char *path)
     if (dirent == NULL)
         return -ENOENT;
 
-    rt_list_remove(&(dirent->list));
+    _dirent_remove(ramfs, dirent);
     if (dirent->data != NULL)
         rt_memheap_free(dirent->data);
     rt_memheap_free(dirent);
@@ -402,7 +487,13 @@ int dfs_ramfs_rename(struct dfs_filesystem *fs,
     if (dirent == NULL)
         return -ENOENT;
 
+    /* names are kept without the '/' separator, as in open */
+    while (*newpath == '/' && *newpath)
+        newpath ++;
+
+    _dirent_remove(ramfs, dirent);
     strncpy(dirent->name, newpath, RAMFS_NAME_MAX);
+    _dirent_insert(ramfs, dirent);
 
     return RT_EOK;
 }
@@ -470,10 +561,15 @@ struct dfs_ramfs *dfs_ramfs_create(rt_uint8_t *pool, rt_size_t size)
     /* initialize root directory */
     rt_memset(&(ramfs->root), 0x00, sizeof(ramfs->root));
     rt_list_init(&(ramfs->root.list));
+    rt_list_init(&(ramfs->root.hashlist));
     ramfs->root.size = 0;
     strcpy(ramfs->root.name, ".");
     ramfs->root.fs = ramfs;
 
+    ramfs->buckets = NULL;
+    ramfs->bucket_nr = 0;
+    ramfs->entry_nr = 0;
+
     return ramfs;
 }
 
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2013-04-15     Bernard      the first version
  * 2013-05-05     Bernard      remove CRC for ramfs persistence
+ * 2026-10-17     RT-Thread    hash directory entries by name
  */
 
 #ifndef __DFS_RAMFS_H__
@@ -18,9 +19,14 @@
 #define RAMFS_NAME_MAX  32
 #define RAMFS_MAGIC     0x0A0A0A0A
 
+#define RAMFS_HASH_NR_MIN   8   /* initial buckets of the name hash table */
+#define RAMFS_HASH_LOAD     2   /* entries per bucket before the table doubles */
+
 struct ramfs_dirent
 {
     rt_list_t list;
+    rt_list_t hashlist;         /* node in name hash table */
+    rt_uint32_t hash;           /* name hash */
     struct dfs_ramfs *fs;       /* file system ref */
 
     char name[RAMFS_NAME_MAX];  /* dirent name */
@@ -38,6 +44,10 @@ struct dfs_ramfs
 
     struct rt_memheap memheap;
     struct ramfs_dirent root;
+
+    rt_list_t *buckets;         /* name hash table, NULL before first entry */
+    rt_size_t bucket_nr;        /* buckets in hash table, power of 2 */
+    rt_size_t entry_nr;         /* number of entries */
 };
 
 int dfs_ramfs_init(void);
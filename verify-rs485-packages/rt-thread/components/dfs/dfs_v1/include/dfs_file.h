@@ -103,6 +103,7 @@ int dfs_file_mmap2(struct dfs_file *fd, struct dfs_mmap2_args *mmap2);
 #define RT_FIOFTRUNCATE  0x52540000U
 #define RT_FIOGETADDR    0x52540001U
 #define RT_FIOMMAP2      0x52540002U
+#define RT_FIOFEXPAND    0x52540003U    /* args: off_t *, allocate contiguous clusters to an empty file */
 
 #ifdef __cplusplus
 }
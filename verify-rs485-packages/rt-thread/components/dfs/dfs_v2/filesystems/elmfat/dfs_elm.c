@@ -15,6 +15,7 @@
  * 2017-02-13     Hichard      Update Fatfs version to 0.12b, support exFAT.
  * 2017-04-11     Bernard      fix the st_blksize issue.
  * 2017-05-26     Urey         fix f_mount error when mount more fats
+ * 2026-10-17     RT-Thread    add fast seek link map and contiguous allocation
  */
 
 #include <rtthread.h>
@@ -60,6 +61,81 @@ static struct dfs_aspace_ops dfs_elm_aspace_ops =
 
 static rt_device_t disk[FF_VOLUMES] = {0};
 
+#ifndef RT_DFS_ELM_FASTSEEK_THRESHOLD
+#define RT_DFS_ELM_FASTSEEK_THRESHOLD   (1024 * 1024)
+#endif
+#ifndef RT_DFS_ELM_FASTSEEK_MAX_ITEMS
+#define RT_DFS_ELM_FASTSEEK_MAX_ITEMS   256
+#endif
+
+/* the opened file, FIL must be the first member */
+struct elm_file
+{
+    FIL fil;
+#if FF_USE_FASTSEEK
+    FSIZE_t clmt_size;      /* file size the cluster link map was last built for */
+#endif
+};
+
+#if FF_USE_FASTSEEK
+static void elm_clmt_drop(FIL *fd)
+{
+    if (fd->cltbl)
+    {
+        rt_free(fd->cltbl);
+        fd->cltbl = RT_NULL;
+    }
+}
+
+/*
+ * Keep a cluster link map on large files, so a seek looks the cluster up in
+ * the map instead of following the FAT chain from the start. FatFs can not
+ * grow a file in fast seek mode, the map is dropped before any access beyond
+ * the end and built again on the next access within the file.
+ */
+static void elm_clmt_update(struct elm_file *ef, FSIZE_t end)
+{
+    FIL *fd = &ef->fil;
+    DWORD items = 32, *tbl;
+    FRESULT result;
+
+    if (end > f_size(fd))
+    {
+        elm_clmt_drop(fd);
+        return;
+    }
+
+    if (fd->cltbl || f_size(fd) < RT_DFS_ELM_FASTSEEK_THRESHOLD || ef->clmt_size == f_size(fd))
+    {
+        return;
+    }
+    /* one try per file size, a too fragmented file is not walked again */
+    ef->clmt_size = f_size(fd);
+
+    while (items <= RT_DFS_ELM_FASTSEEK_MAX_ITEMS)
+    {
+        tbl = (DWORD *)rt_malloc(items * sizeof(DWORD));
+        if (tbl == RT_NULL)
+            break;
+
+        tbl[0] = items;
+        fd->cltbl = tbl;
+        result = f_lseek(fd, CREATE_LINKMAP);
+        if (result == FR_OK)
+            break;
+
+        /* on FR_NOT_ENOUGH_CORE the first item tells the size needed */
+        items = tbl[0];
+        elm_clmt_drop(fd);
+        if (result != FR_NOT_ENOUGH_CORE)
+            break;
+    }
+}
+#else
+#define elm_clmt_drop(fd)
+#define elm_clmt_update(ef, end)
+#endif /* FF_USE_FASTSEEK */
+
 int dfs_elm_unmount(struct dfs_mnt *mnt);
 
 static int elm_result_to_dfs(FRESULT result)
@@ -466,7 +542,7 @@ int dfs_elm_open(struct dfs_file *file)
             mode |= FA_CREATE_NEW;
 
         /* allocate a fd */
-        fd = (FIL *)rt_malloc(sizeof(FIL));
+        fd = (FIL *)rt_calloc(1, sizeof(struct elm_file));
         if (fd == RT_NULL)
         {
 #if FF_VOLUMES > 1
@@ -486,6 +562,7 @@ int dfs_elm_open(struct dfs_file *file)
             file->vnode->type = FT_REGULAR;
             file->vnode->data = fd;
             rt_mutex_init(&file->vnode->lock, file->dentry->pathname, RT_IPC_FLAG_PRIO);
+            elm_clmt_update((struct elm_file *)fd, 0);
 
             if (file->flags & O_APPEND)
             {
@@ -533,6 +610,7 @@ int dfs_elm_close(struct dfs_file *file)
         RT_ASSERT(fd != RT_NULL);
 
         f_close(fd);
+        elm_clmt_drop(fd);
         /* release memory */
         rt_free(fd);
     }
@@ -556,6 +634,34 @@ int dfs_elm_ioctl(struct dfs_file *file, int cmd, void *args)
         return 0;
     case F_SETLK:
         return 0;
+#if FF_USE_EXPAND
+    case RT_FIOFEXPAND:
+    {
+        FIL *fd;
+        FRESULT result;
+
+        fd = (FIL *)(file->vnode->data);
+        RT_ASSERT(fd != RT_NULL);
+        if (args == RT_NULL)
+            return -EINVAL;
+        if (!(fd->flag & FA_WRITE))
+            return -EBADF;
+
+        rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
+        if (f_size(fd) != 0)
+        {
+            rt_mutex_release(&file->vnode->lock);
+            return -EINVAL;
+        }
+        /* allocate one contiguous cluster block now */
+        result = f_expand(fd, (FSIZE_t)*(off_t *)args, 1);
+        file->vnode->size = f_size(fd);
+        rt_mutex_release(&file->vnode->lock);
+        if (result == FR_DENIED)
+            return -ENOSPC;
+        return elm_result_to_dfs(result);
+    }
+#endif
     }
     return -ENOSYS;
 }
@@ -576,6 +682,7 @@ ssize_t dfs_elm_read(struct dfs_file *file, void *buf, size_t len, off_t *pos)
         fd = (FIL *)(file->vnode->data);
         RT_ASSERT(fd != RT_NULL);
         rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
+        elm_clmt_update((struct elm_file *)fd, *pos);
         f_lseek(fd, *pos);
         result = f_read(fd, buf, len, &byte_read);
         /* update position */
@@ -602,6 +709,7 @@ ssize_t dfs_elm_write(struct dfs_file *file, const void *buf, size_t len, off_t
     fd = (FIL *)(file->vnode->data);
     RT_ASSERT(fd != RT_NULL);
     rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
+    elm_clmt_update((struct elm_file *)fd, *pos + len);
     f_lseek(fd, *pos);
     result = f_write(fd, buf, len, &byte_write);
     /* update position and file size */
@@ -655,6 +763,7 @@ off_t dfs_elm_lseek(struct dfs_file *file, off_t offset, int wherece)
         fd = (FIL *)(file->vnode->data);
         RT_ASSERT(fd != RT_NULL);
         rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
+        elm_clmt_update((struct elm_file *)fd, offset);
         result = f_lseek(fd, offset);
         rt_mutex_release(&file->vnode->lock);
         if (result == FR_OK)
@@ -691,6 +800,9 @@ static int dfs_elm_truncate(struct dfs_file *file, off_t offset)
     fd = (FIL *)(file->vnode->data);
     RT_ASSERT(fd != RT_NULL);
 
+    /* the cluster chain changes, the link map is stale */
+    elm_clmt_drop(fd);
+
     /* save file read/write point */
     fptr = fd->fptr;
     if (offset <= fd->obj.objsize)
@@ -1050,6 +1162,7 @@ ssize_t dfs_elm_page_write(struct dfs_page *page)
     fd = (FIL *)(page->aspace->vnode->data);
     RT_ASSERT(fd != RT_NULL);
     rt_mutex_take(&page->aspace->vnode->lock, RT_WAITING_FOREVER);
+    elm_clmt_update((struct elm_file *)fd, page->fpos + page->len);
     f_lseek(fd, page->fpos);
     result = f_write(fd, page->page, page->len, &byte_write);
     rt_mutex_release(&page->aspace->vnode->lock);
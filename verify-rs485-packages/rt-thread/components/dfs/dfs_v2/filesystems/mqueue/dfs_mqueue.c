@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2023-07-04     zhkag        first Version
+ * 2026-10-17     RT-Thread    use the POSIX message ring instead of rt_mq
  */
 
 #include <rtthread.h>
@@ -121,7 +122,7 @@ int dfs_mqueue_unlink(struct dfs_dentry *dentry) {
         return -ENOENT;
     rt_list_remove(&(mq_file->list));
     if (mq_file->data != RT_NULL)
-        rt_mq_delete((rt_mq_t)mq_file->data);
+        mqueue_delete((struct mqueue *)mq_file->data);
     rt_free(mq_file);
     return RT_EOK;
 }
@@ -151,9 +152,8 @@ static struct dfs_vnode *dfs_mqueue_create_vnode(struct dfs_dentry *dentry, int
 
         vnode->mode = S_IFREG | (S_IRWXU | S_IRWXG | S_IRWXO);
         vnode->type = FT_REGULAR;
-        rt_mq_t mq = rt_mq_create(dentry->pathname + 1, mq_file->msg_size, mq_file->max_msgs,
-                                  RT_IPC_FLAG_FIFO);
-        mq_file->data = (void *)mq;
+        if (mq_file->data == RT_NULL)
+            mq_file->data = (void *)mqueue_create(dentry->pathname + 1, mq_file->msg_size, mq_file->max_msgs);
         vnode->data = mq_file;
         vnode->size = 0;
     }
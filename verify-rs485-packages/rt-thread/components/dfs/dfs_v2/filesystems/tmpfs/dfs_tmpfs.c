@@ -8,6 +8,9 @@
  * 2022-10-24     flybreak     the first version
  * 2023-02-01     xqyjlj       fix cannot open the same file repeatedly in 'w' mode
  * 2023-09-20     zmq810150896 adds truncate functionality and standardized unlink adaptations
+ * 2026-10-17     RT-Thread    store file data in fixed-size chunks instead of one realloc'd buffer
+ * 2026-10-17     RT-Thread    hash directory entries, walk the whole path under one lock
+ * 2026-10-17     RT-Thread    free the hash table of a removed dir
  */
 
 #include <rthw.h>
@@ -83,18 +86,251 @@ __next_dir:
     return 0;
 }
 
-static int _get_subdir(const char *path, char *name)
+static rt_uint32_t _name_hash(const char *name, rt_size_t len)
 {
-    const char *subpath = path;
-    while (*subpath == '/' && *subpath)
-        subpath ++;
-    while (*subpath != '/' && *subpath)
+    rt_uint32_t val = 0;
+
+    while (len --)
     {
-        *name = *subpath;
-        name ++;
-        subpath ++;
+        val = ((val << 5) + val) + *name++;
     }
-    return 0;
+    return val;
+}
+
+/* find a subdir of dir by name[0, len), the superblock lock must be held */
+static struct tmpfs_file *_dir_find(struct tmpfs_file *dir, const char *name, rt_size_t len)
+{
+    struct tmpfs_file *file;
+    rt_uint32_t hash;
+
+    if (len >= TMPFS_NAME_MAX)
+        len = TMPFS_NAME_MAX;
+
+    hash = _name_hash(name, len);
+    if (dir->buckets)
+    {
+        rt_list_for_each_entry(file, &dir->buckets[hash & (dir->bucket_nr - 1)], hashlist)
+        {
+            if (file->hash == hash && rt_strncmp(file->name, name, len) == 0
+                && (len == TMPFS_NAME_MAX || file->name[len] == '\0'))
+            {
+                return file;
+            }
+        }
+        return RT_NULL;
+    }
+
+    /* no hash table yet (empty dir or allocation failure) */
+    rt_list_for_each_entry(file, &dir->subdirs, sibling)
+    {
+        if (file->hash == hash && rt_strncmp(file->name, name, len) == 0
+            && (len == TMPFS_NAME_MAX || file->name[len] == '\0'))
+        {
+            return file;
+        }
+    }
+    return RT_NULL;
+}
+
+/* link file into dir, the hash table grows before the lock is taken */
+static void _dir_insert(struct tmpfs_file *dir, struct tmpfs_file *file)
+{
+    struct tmpfs_sb *superblock = dir->sb;
+    rt_list_t *buckets = RT_NULL, *old = RT_NULL;
+    rt_size_t nr = 0, index;
+
+    file->hash = _name_hash(file->name, rt_strnlen(file->name, TMPFS_NAME_MAX));
+
+    if (dir->entry_nr + 1 > dir->bucket_nr * TMPFS_HASH_LOAD)
+    {
+        nr = dir->bucket_nr ? dir->bucket_nr << 1 : TMPFS_HASH_NR_MIN;
+        buckets = rt_malloc(nr * sizeof(rt_list_t));
+    }
+
+    rt_spin_lock(&superblock->lock);
+    if (buckets && nr > dir->bucket_nr)
+    {
+        struct tmpfs_file *child;
+
+        for (index = 0; index < nr; index ++)
+        {
+            rt_list_init(&buckets[index]);
+        }
+        rt_list_for_each_entry(child, &dir->subdirs, sibling)
+        {
+            rt_list_insert_after(&buckets[child->hash & (nr - 1)], &child->hashlist);
+        }
+        old = dir->buckets;
+        dir->buckets = buckets;
+        dir->bucket_nr = nr;
+        buckets = RT_NULL;
+    }
+
+    rt_list_insert_after(&dir->subdirs, &file->sibling);
+    if (dir->buckets)
+    {
+        rt_list_insert_after(&dir->buckets[file->hash & (dir->bucket_nr - 1)], &file->hashlist);
+    }
+    dir->entry_nr ++;
+    file->parent = dir;
+    rt_spin_unlock(&superblock->lock);
+
+    if (old)
+        rt_free(old);
+    if (buckets) /* lost the race to another insert */
+        rt_free(buckets);
+}
+
+static void _dir_remove(struct tmpfs_file *file)
+{
+    struct tmpfs_sb *superblock = file->sb;
+
+    rt_spin_lock(&superblock->lock);
+    rt_list_remove(&file->sibling);
+    rt_list_remove(&file->hashlist);
+    if (file->parent)
+    {
+        file->parent->entry_nr --;
+        file->parent = RT_NULL;
+    }
+    rt_spin_unlock(&superblock->lock);
+}
+
+#ifdef RT_USING_SMART
+#define TMPFS_CHUNK_ALIGN   ARCH_PAGE_SIZE
+#else
+#define TMPFS_CHUNK_ALIGN   RT_ALIGN_SIZE
+#endif
+
+#define TMPFS_CHUNK_INDEX(pos)  ((rt_size_t)(pos) / TMPFS_CHUNK_SIZE)
+#define TMPFS_CHUNK_OFFSET(pos) ((rt_size_t)(pos) % TMPFS_CHUNK_SIZE)
+
+/* take a zeroed chunk from the mount's free list, or from the heap when it is empty */
+static rt_uint8_t *_chunk_alloc(struct tmpfs_sb *superblock)
+{
+    rt_slist_t *node;
+    rt_uint8_t *chunk = RT_NULL;
+
+    rt_spin_lock(&superblock->lock);
+    node = rt_slist_first(&superblock->free_chunks);
+    if (node)
+    {
+        rt_slist_remove(&superblock->free_chunks, node);
+        superblock->free_nr --;
+        chunk = (rt_uint8_t *)node;
+    }
+    rt_spin_unlock(&superblock->lock);
+
+    if (chunk == RT_NULL)
+    {
+        chunk = rt_malloc_align(TMPFS_CHUNK_SIZE, TMPFS_CHUNK_ALIGN);
+        if (chunk == RT_NULL)
+        {
+            return RT_NULL;
+        }
+    }
+    rt_memset(chunk, 0, TMPFS_CHUNK_SIZE);
+
+    rt_spin_lock(&superblock->lock);
+    superblock->df_size += TMPFS_CHUNK_SIZE;
+    rt_spin_unlock(&superblock->lock);
+
+    return chunk;
+}
+
+static void _chunk_free(struct tmpfs_sb *superblock, rt_uint8_t *chunk)
+{
+    rt_spin_lock(&superblock->lock);
+    superblock->df_size -= TMPFS_CHUNK_SIZE;
+    if (superblock->free_nr < TMPFS_CHUNK_CACHE)
+    {
+        rt_slist_init((rt_slist_t *)chunk);
+        rt_slist_insert(&superblock->free_chunks, (rt_slist_t *)chunk);
+        superblock->free_nr ++;
+        chunk = RT_NULL;
+    }
+    rt_spin_unlock(&superblock->lock);
+
+    if (chunk)
+    {
+        rt_free_align(chunk);
+    }
+}
+
+/* grow the chunk table so that it holds at least nr slots */
+static int _chunk_table_expand(struct tmpfs_file *d_file, rt_size_t nr)
+{
+    rt_uint8_t **table;
+    rt_size_t new_nr;
+
+    if (nr <= d_file->chunk_nr)
+    {
+        return RT_EOK;
+    }
+
+    new_nr = d_file->chunk_nr ? d_file->chunk_nr : 4;
+    while (new_nr < nr)
+    {
+        new_nr <<= 1;
+    }
+
+    table = rt_realloc(d_file->chunks, new_nr * sizeof(rt_uint8_t *));
+    if (table == RT_NULL)
+    {
+        return -ENOMEM;
+    }
+    rt_memset(table + d_file->chunk_nr, 0, (new_nr - d_file->chunk_nr) * sizeof(rt_uint8_t *));
+
+    d_file->chunks = table;
+    d_file->chunk_nr = new_nr;
+
+    return RT_EOK;
+}
+
+/* drop the data beyond size, the tail of the last chunk is zeroed for later extension */
+static void _chunk_truncate(struct tmpfs_file *d_file, rt_size_t size)
+{
+    rt_size_t index;
+
+    index = (size + TMPFS_CHUNK_SIZE - 1) / TMPFS_CHUNK_SIZE;
+    for (; index < d_file->chunk_nr; index ++)
+    {
+        if (d_file->chunks[index])
+        {
+            _chunk_free(d_file->sb, d_file->chunks[index]);
+            d_file->chunks[index] = RT_NULL;
+        }
+    }
+
+    index = TMPFS_CHUNK_INDEX(size);
+    if (TMPFS_CHUNK_OFFSET(size) && index < d_file->chunk_nr && d_file->chunks[index])
+    {
+        rt_memset(d_file->chunks[index] + TMPFS_CHUNK_OFFSET(size), 0,
+                  TMPFS_CHUNK_SIZE - TMPFS_CHUNK_OFFSET(size));
+    }
+
+    if (size == 0 && d_file->chunks)
+    {
+        rt_free(d_file->chunks);
+        d_file->chunks = RT_NULL;
+        d_file->chunk_nr = 0;
+    }
+}
+
+static void _chunk_release(struct tmpfs_file *d_file)
+{
+    _chunk_truncate(d_file, 0);
+}
+
+/* free a file unlinked from its dir with its data or its hash table */
+static void _file_free(struct tmpfs_file *d_file)
+{
+    _chunk_release(d_file);
+    if (d_file->buckets)
+    {
+        rt_free(d_file->buckets);
+    }
+    rt_free(d_file);
 }
 
 static int _free_subdir(struct tmpfs_file *dfile)
@@ -112,20 +348,21 @@ static int _free_subdir(struct tmpfs_file *dfile)
         {
             _free_subdir(file);
         }
-        if (file->data != NULL)
-        {
-            /* TODO: fix for rt-smart */
-            rt_free(file->data);
-        }
 
         superblock = file->sb;
         RT_ASSERT(superblock != NULL);
+        RT_UNUSED(superblock);
 
-        rt_spin_lock(&superblock->lock);
-        rt_list_remove(&(file->sibling));
-        rt_spin_unlock(&superblock->lock);
+        _dir_remove(file);
 
-        rt_free(file);
+        _file_free(file);
+    }
+
+    if (dfile->buckets)
+    {
+        rt_free(dfile->buckets);
+        dfile->buckets = RT_NULL;
+        dfile->bucket_nr = 0;
     }
     return 0;
 }
@@ -142,12 +379,14 @@ static int dfs_tmpfs_mount(struct dfs_mnt *mnt,
         superblock->df_size = sizeof(struct tmpfs_sb);
         superblock->magic = TMPFS_MAGIC;
         rt_list_init(&superblock->sibling);
+        rt_slist_init(&superblock->free_chunks);
 
         superblock->root.name[0] = '/';
         superblock->root.sb = superblock;
         superblock->root.type = TMPFS_TYPE_DIR;
         rt_list_init(&superblock->root.sibling);
         rt_list_init(&superblock->root.subdirs);
+        rt_list_init(&superblock->root.hashlist);
 
         rt_spin_lock_init(&superblock->lock);
 
@@ -171,6 +410,13 @@ static int dfs_tmpfs_unmount(struct dfs_mnt *mnt)
 
     mnt->data = NULL;
     _free_subdir(&(superblock->root));
+    while (rt_slist_first(&superblock->free_chunks))
+    {
+        rt_slist_t *node = rt_slist_first(&superblock->free_chunks);
+
+        rt_slist_remove(&superblock->free_chunks, node);
+        rt_free_align(node);
+    }
     rt_free(superblock);
 
     return RT_EOK;
@@ -192,6 +438,57 @@ int dfs_tmpfs_statfs(struct dfs_mnt *mnt, struct statfs *buf)
     return RT_EOK;
 }
 
+#ifdef RT_USING_SMART
+/* map the chunks back to back into user space, holes are filled on the way */
+static void *_chunk_mmap(struct tmpfs_file *d_file, rt_size_t length)
+{
+    rt_size_t index, nr;
+    char *base = RT_NULL;
+
+    nr = (length + TMPFS_CHUNK_SIZE - 1) / TMPFS_CHUNK_SIZE;
+    if (_chunk_table_expand(d_file, nr) != RT_EOK)
+    {
+        return RT_NULL;
+    }
+
+    for (index = 0; index < nr; index ++)
+    {
+        void *va;
+
+        if (d_file->chunks[index] == RT_NULL)
+        {
+            d_file->chunks[index] = _chunk_alloc(d_file->sb);
+            if (d_file->chunks[index] == RT_NULL)
+            {
+                break;
+            }
+        }
+
+        va = lwp_map_user_phy(lwp_self(), base ? base + index * TMPFS_CHUNK_SIZE : RT_NULL,
+                              d_file->chunks[index], TMPFS_CHUNK_SIZE, 0);
+        if (va == RT_NULL)
+        {
+            break;
+        }
+        if (base == RT_NULL)
+        {
+            base = va;
+        }
+    }
+
+    if (index < nr)
+    {
+        while (base && index --)
+        {
+            lwp_unmap_user_phy(lwp_self(), base + index * TMPFS_CHUNK_SIZE);
+        }
+        return RT_NULL;
+    }
+
+    return base;
+}
+#endif
+
 int dfs_tmpfs_ioctl(struct dfs_file *file, int cmd, void *args)
 {
     struct tmpfs_file *d_file;
@@ -217,8 +514,10 @@ int dfs_tmpfs_ioctl(struct dfs_file *file, int cmd, void *args)
                 return -RT_ENOMEM;
             }
 
-            LOG_D("tmpfile mmap ptr:%x , size:%d\n", d_file->data, mmap2->length);
-            mmap2->ret = lwp_map_user_phy(lwp_self(), RT_NULL, d_file->data, mmap2->length, 0);
+            LOG_D("tmpfile mmap chunks:%d , size:%d\n", d_file->chunk_nr, mmap2->length);
+            rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
+            mmap2->ret = _chunk_mmap(d_file, mmap2->length);
+            rt_mutex_release(&file->vnode->lock);
         }
         return RT_EOK;
         break;
@@ -234,10 +533,8 @@ struct tmpfs_file *dfs_tmpfs_lookup(struct tmpfs_sb  *superblock,
                                       const char       *path,
                                       rt_size_t        *size)
 {
-    const char *subpath, *curpath, *filename = RT_NULL;
-    char subdir_name[TMPFS_NAME_MAX];
-    struct tmpfs_file *file, *curfile;
-    rt_list_t *list;
+    const char *subpath, *curpath;
+    struct tmpfs_file *curfile;
 
     subpath = path;
     while (*subpath == '/' && *subpath)
@@ -248,48 +545,54 @@ struct tmpfs_file *dfs_tmpfs_lookup(struct tmpfs_sb  *superblock,
         return &(superblock->root);
     }
 
-    curpath = subpath;
     curfile = &superblock->root;
 
-find_subpath:
-    while (*subpath != '/' && *subpath)
-        subpath ++;
+    /* walk the whole path under one lock, each component is a hash lookup */
+    rt_spin_lock(&superblock->lock);
+    while (curfile)
+    {
+        curpath = subpath;
+        while (*subpath != '/' && *subpath)
+            subpath ++;
 
-    if (! *subpath) /* is last directory */
-        filename = curpath;
-    else
-        subpath ++; /* skip '/' */
+        curfile = _dir_find(curfile, curpath, subpath - curpath);
+
+        while (*subpath == '/')
+            subpath ++; /* skip '/' */
+        if (! *subpath) /* is last directory */
+            break;
+    }
+    if (curfile)
+    {
+        *size = curfile->size;
+    }
+    rt_spin_unlock(&superblock->lock);
 
-    memset(subdir_name, 0, TMPFS_NAME_MAX);
-    _get_subdir(curpath, subdir_name);
+    return curfile;
+}
 
-    rt_spin_lock(&superblock->lock);
+static void _chunk_read(struct tmpfs_file *d_file, void *buf, rt_size_t count, off_t pos)
+{
+    rt_uint8_t *ptr = (rt_uint8_t *)buf;
 
-    rt_list_for_each(list, &curfile->subdirs)
+    while (count > 0)
     {
-        file = rt_list_entry(list, struct tmpfs_file, sibling);
-        if (filename) /* find file */
-        {
-            if (rt_strcmp(file->name, filename) == 0)
-            {
-                *size = file->size;
+        rt_size_t index = TMPFS_CHUNK_INDEX(pos);
+        rt_size_t offset = TMPFS_CHUNK_OFFSET(pos);
+        rt_size_t length = TMPFS_CHUNK_SIZE - offset;
 
-                rt_spin_unlock(&superblock->lock);
-                return file;
-            }
-        }
-        else if (rt_strcmp(file->name, subdir_name) == 0)
-        {
-            *size = file->size;
-            curpath = subpath;
-            curfile = file;
-            rt_spin_unlock(&superblock->lock);
-            goto find_subpath;
-        }
+        if (length > count)
+            length = count;
+
+        if (index < d_file->chunk_nr && d_file->chunks[index])
+            memcpy(ptr, d_file->chunks[index] + offset, length);
+        else /* a hole reads back as zeros */
+            memset(ptr, 0, length);
+
+        ptr += length;
+        pos += length;
+        count -= length;
     }
-    rt_spin_unlock(&superblock->lock);
-    /* not found */
-    return NULL;
 }
 
 static ssize_t dfs_tmpfs_read(struct dfs_file *file, void *buf, size_t count, off_t *pos)
@@ -302,13 +605,15 @@ static ssize_t dfs_tmpfs_read(struct dfs_file *file, void *buf, size_t count, of
 
     rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
 
-    if (count < file->vnode->size - *pos)
+    if (*pos >= (off_t)file->vnode->size)
+        length = 0;
+    else if (count < file->vnode->size - *pos)
         length = count;
     else
         length = file->vnode->size - *pos;
 
     if (length > 0)
-        memcpy(buf, &(d_file->data[*pos]), length);
+        _chunk_read(d_file, buf, length, *pos);
 
     /* update file current position */
     *pos += length;
@@ -320,39 +625,54 @@ static ssize_t dfs_tmpfs_read(struct dfs_file *file, void *buf, size_t count, of
 
 static ssize_t _dfs_tmpfs_write(struct tmpfs_file *d_file, const void *buf, size_t count, off_t *pos)
 {
-    struct tmpfs_sb *superblock;
+    const rt_uint8_t *ptr = (const rt_uint8_t *)buf;
+    rt_size_t written = 0;
 
     RT_ASSERT(d_file != NULL);
+    RT_ASSERT(d_file->sb != NULL);
 
-    superblock = d_file->sb;
-    RT_ASSERT(superblock != NULL);
+    if (count == 0)
+        return 0;
 
-    if (count + *pos > d_file->size)
+    if (_chunk_table_expand(d_file, TMPFS_CHUNK_INDEX(*pos + count - 1) + 1) != RT_EOK)
     {
-        rt_uint8_t *ptr;
-        ptr = rt_realloc(d_file->data, *pos + count);
-        if (ptr == NULL)
+        rt_set_errno(-ENOMEM);
+        return 0;
+    }
+
+    while (written < count)
+    {
+        rt_size_t index = TMPFS_CHUNK_INDEX(*pos);
+        rt_size_t offset = TMPFS_CHUNK_OFFSET(*pos);
+        rt_size_t length = TMPFS_CHUNK_SIZE - offset;
+
+        if (length > count - written)
+            length = count - written;
+
+        if (d_file->chunks[index] == RT_NULL)
         {
-            rt_set_errno(-ENOMEM);
-            return 0;
+            d_file->chunks[index] = _chunk_alloc(d_file->sb);
+            if (d_file->chunks[index] == RT_NULL)
+            {
+                rt_set_errno(-ENOMEM);
+                break;
+            }
         }
 
-        rt_spin_lock(&superblock->lock);
-        superblock->df_size += (*pos - d_file->size + count);
-        rt_spin_unlock(&superblock->lock);
-        /* update d_file and file size */
-        d_file->data = ptr;
-        d_file->size = *pos + count;
-        LOG_D("tmpfile ptr:%x, size:%d", ptr, d_file->size);
-    }
+        memcpy(d_file->chunks[index] + offset, ptr + written, length);
 
-    if (count > 0)
-        memcpy(d_file->data + *pos, buf, count);
+        written += length;
+        /* update file current position */
+        *pos += length;
+    }
 
-    /* update file current position */
-    *pos += count;
+    if ((rt_size_t)*pos > d_file->size)
+    {
+        d_file->size = *pos;
+        LOG_D("tmpfile chunks:%d, size:%d", d_file->chunk_nr, d_file->size);
+    }
 
-    return count;
+    return written;
 }
 
 static ssize_t dfs_tmpfs_write(struct dfs_file *file, const void *buf, size_t count, off_t *pos)
@@ -365,6 +685,7 @@ static ssize_t dfs_tmpfs_write(struct dfs_file *file, const void *buf, size_t co
     rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
 
     count = _dfs_tmpfs_write(d_file, buf, count, pos);
+    file->vnode->size = d_file->size;
 
     rt_mutex_release(&file->vnode->lock);
 
@@ -390,7 +711,8 @@ static off_t dfs_tmpfs_lseek(struct dfs_file *file, off_t offset, int wherece)
         return -EINVAL;
     }
 
-    if (offset <= (off_t)file->vnode->size)
+    /* seeking past the end is allowed, a later write leaves a hole behind */
+    if (offset >= 0)
     {
         return offset;
     }
@@ -414,13 +736,7 @@ static int dfs_tmpfs_close(struct dfs_file *file)
 
     if (d_file->fre_memory == RT_TRUE)
     {
-        if (d_file->data != NULL)
-        {
-            rt_free(d_file->data);
-            d_file->data = RT_NULL;
-        }
-
-        rt_free(d_file);
+        _file_free(d_file);
     }
 
     rt_mutex_detach(&file->vnode->lock);
@@ -442,12 +758,7 @@ static int dfs_tmpfs_open(struct dfs_file *file)
         d_file->size = 0;
         file->vnode->size = d_file->size;
         file->fpos = file->vnode->size;
-        if (d_file->data != NULL)
-        {
-            /* ToDo: fix for rt-smart. */
-            rt_free(d_file->data);
-            d_file->data = NULL;
-        }
+        _chunk_release(d_file);
     }
 
     if (file->flags & O_APPEND)
@@ -573,19 +884,11 @@ static int dfs_tmpfs_unlink(struct dfs_dentry *dentry)
     if (d_file == NULL)
         return -ENOENT;
 
-    rt_spin_lock(&superblock->lock);
-    rt_list_remove(&(d_file->sibling));
-    rt_spin_unlock(&superblock->lock);
+    _dir_remove(d_file);
 
     if (rt_atomic_load(&(dentry->ref_count)) == 1)
     {
-        if (d_file->data != NULL)
-        {
-            rt_free(d_file->data);
-            d_file->data = RT_NULL;
-        }
-
-        rt_free(d_file);
+        _file_free(d_file);
     }
     else
     {
@@ -631,15 +934,11 @@ static int dfs_tmpfs_rename(struct dfs_dentry *old_dentry, struct dfs_dentry *ne
     p_file = dfs_tmpfs_lookup(superblock, parent_path, &size);
     RT_ASSERT(p_file != NULL);
 
-    rt_spin_lock(&superblock->lock);
-    rt_list_remove(&(d_file->sibling));
-    rt_spin_unlock(&superblock->lock);
+    _dir_remove(d_file);
 
     strncpy(d_file->name, file_name, TMPFS_NAME_MAX);
 
-    rt_spin_lock(&superblock->lock);
-    rt_list_insert_after(&(p_file->subdirs), &(d_file->sibling));
-    rt_spin_unlock(&superblock->lock);
+    _dir_insert(p_file, d_file);
 
     rt_free(parent_path);
 
@@ -748,7 +1047,9 @@ static struct dfs_vnode *dfs_tmpfs_create_vnode(struct dfs_dentry *dentry, int t
 
         rt_list_init(&(d_file->subdirs));
         rt_list_init(&(d_file->sibling));
-        d_file->data = NULL;
+        rt_list_init(&(d_file->hashlist));
+        d_file->chunks = NULL;
+        d_file->chunk_nr = 0;
         d_file->size = 0;
         d_file->sb = superblock;
         d_file->fre_memory = RT_FALSE;
@@ -767,9 +1068,7 @@ static struct dfs_vnode *dfs_tmpfs_create_vnode(struct dfs_dentry *dentry, int t
             vnode->aspace = dfs_aspace_create(dentry, vnode, &dfs_tmp_aspace_ops);
 #endif
         }
-        rt_spin_lock(&superblock->lock);
-        rt_list_insert_after(&(p_file->subdirs), &(d_file->sibling));
-        rt_spin_unlock(&superblock->lock);
+        _dir_insert(p_file, d_file);
 
         vnode->mnt = dentry->mnt;
         vnode->data = d_file;
@@ -835,31 +1134,30 @@ ssize_t dfs_tmp_page_write(struct dfs_page *page)
 static int dfs_tmpfs_truncate(struct dfs_file *file, off_t offset)
 {
     struct tmpfs_file *d_file = RT_NULL;
-    struct tmpfs_sb *superblock = RT_NULL;
-    rt_uint8_t *ptr = RT_NULL;
 
     d_file = (struct tmpfs_file *)file->vnode->data;
     RT_ASSERT(d_file != RT_NULL);
+    RT_ASSERT(d_file->sb != RT_NULL);
 
-    superblock = d_file->sb;
-    RT_ASSERT(superblock != RT_NULL);
-
-    ptr = rt_realloc(d_file->data, offset);
-    if (ptr == RT_NULL)
+    if (offset < 0)
     {
-        rt_set_errno(-ENOMEM);
-        return 0;
+        return -EINVAL;
     }
 
-    rt_spin_lock(&superblock->lock);
-    superblock->df_size = offset;
-    rt_spin_unlock(&superblock->lock);
+    rt_mutex_take(&file->vnode->lock, RT_WAITING_FOREVER);
+
+    /* growing only moves the size, the new range stays a hole until written */
+    if ((rt_size_t)offset < d_file->size)
+    {
+        _chunk_truncate(d_file, offset);
+    }
 
     /* update d_file and file size */
-    d_file->data = ptr;
     d_file->size = offset;
     file->vnode->size = d_file->size;
-    LOG_D("tmpfile ptr:%x, size:%d", ptr, d_file->size);
+    LOG_D("tmpfile chunks:%d, size:%d", d_file->chunk_nr, d_file->size);
+
+    rt_mutex_release(&file->vnode->lock);
 
     return 0;
 }
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2022-10-24     flybreak     the first version
+ * 2026-10-17     RT-Thread    store file data in fixed-size chunks
+ * 2026-10-17     RT-Thread    hash directory entries by name
  */
 
 #ifndef __DFS_TMPFS_H__
@@ -19,6 +21,21 @@
 #define TMPFS_TYPE_FILE   0x00
 #define TMPFS_TYPE_DIR    0x01
 
+#ifdef RT_DFS_TMPFS_CHUNK_SIZE
+#define TMPFS_CHUNK_SIZE  RT_DFS_TMPFS_CHUNK_SIZE
+#else
+#define TMPFS_CHUNK_SIZE  512
+#endif
+
+#ifdef RT_DFS_TMPFS_CHUNK_CACHE
+#define TMPFS_CHUNK_CACHE RT_DFS_TMPFS_CHUNK_CACHE
+#else
+#define TMPFS_CHUNK_CACHE 16
+#endif
+
+#define TMPFS_HASH_NR_MIN 8     /* initial buckets of a directory hash table */
+#define TMPFS_HASH_LOAD   2     /* entries per bucket before the table doubles */
+
 struct tmpfs_sb;
 
 struct tmpfs_file
@@ -27,8 +44,15 @@ struct tmpfs_file
     char name[TMPFS_NAME_MAX]; /* file name */
     rt_list_t     subdirs;     /* file subdir list */
     rt_list_t     sibling;     /* file sibling list */
+    rt_list_t     hashlist;    /* node in parent's name hash table */
+    rt_uint32_t   hash;        /* name hash */
+    rt_list_t    *buckets;     /* subdir name hash table, NULL before first insert */
+    rt_size_t     bucket_nr;   /* buckets in hash table, power of 2 */
+    rt_size_t     entry_nr;    /* number of subdirs */
+    struct tmpfs_file *parent; /* parent dir ptr */
     struct tmpfs_sb *sb;       /* superblock ptr */
-    rt_uint8_t      *data;     /* file date ptr */
+    rt_uint8_t     **chunks;   /* file data chunk table, NULL slot is a hole */
+    rt_size_t        chunk_nr; /* slots in chunk table */
     rt_size_t        size;     /* file size */
     rt_bool_t       fre_memory;/* Whether to release memory upon close */
 };
@@ -40,6 +64,8 @@ struct tmpfs_sb
     struct tmpfs_file root;        /* root dir */
     rt_size_t         df_size;     /* df size */
     rt_list_t         sibling;     /* sb sibling list */
+    rt_slist_t        free_chunks; /* cached free data chunks */
+    rt_size_t         free_nr;     /* number of cached free chunks */
     struct rt_spinlock lock;       /* tmpfs lock */
 };
 
@@ -188,6 +188,7 @@ int dfs_file_mmap(struct dfs_file *file, struct dfs_mmap2_args *mmap2);
 #define RT_FIOFTRUNCATE  0x52540000U
 #define RT_FIOGETADDR    0x52540001U
 #define RT_FIOMMAP2      0x52540002U
+#define RT_FIOFEXPAND    0x52540003U    /* args: off_t *, allocate contiguous clusters to an empty file */
 
 /* dfs_file_realpath mode */
 #define DFS_REALPATH_EXCEPT_LAST    0
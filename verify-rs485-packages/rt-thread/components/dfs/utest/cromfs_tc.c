@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utest.h"
+
+/*
+ * Opens, reads and closes the same cromfs file CROMFS_TC_OPENS times in
+ * every run. A file no bigger than RT_DFS_CROMFS_DATA_CACHE_SIZE is only
+ * inflated by the first open, the others find its data in the cache.
+ * Point CROMFS_TC_FILE at such a file of a mounted cromfs image and time
+ * it with:
+ *
+ *     utest_bench -n 20 testcases.dfs.cromfs.reopen
+ */
+
+#ifndef CROMFS_TC_FILE
+#define CROMFS_TC_FILE      "/cromfs/tc.bin"
+#endif
+#define CROMFS_TC_OPENS     64
+#define CROMFS_TC_BLOCK     4096
+
+static off_t file_size;
+static rt_uint8_t buf[CROMFS_TC_BLOCK];
+
+static rt_err_t cromfs_tc_init(void)
+{
+    struct stat st;
+
+    if (stat(CROMFS_TC_FILE, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return -RT_ERROR;
+    }
+    file_size = st.st_size;
+
+    return RT_EOK;
+}
+
+static void cromfs_reopen(void)
+{
+    off_t got;
+    ssize_t n;
+    int i, fd, bad = 0;
+
+    for (i = 0; i < CROMFS_TC_OPENS; i++)
+    {
+        fd = open(CROMFS_TC_FILE, O_RDONLY, 0);
+        if (fd < 0)
+        {
+            bad ++;
+            continue;
+        }
+
+        got = 0;
+        while ((n = read(fd, buf, CROMFS_TC_BLOCK)) > 0)
+        {
+            got += n;
+        }
+        if (n < 0 || got != file_size)
+        {
+            bad ++;
+        }
+        close(fd);
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(cromfs_reopen);
+}
+UTEST_TC_EXPORT(testcase, "testcases.dfs.cromfs.reopen", cromfs_tc_init, RT_NULL, 30);
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "utest.h"
+
+/*
+ * Random 512 byte reads over a fragmented file on a FAT volume. The init
+ * writes two files in turns of ELMFAT_TC_FRAGMENT bytes, so that the one
+ * read back is fragmented every ELMFAT_TC_FRAGMENT bytes. Every run reads
+ * ELMFAT_TC_READS blocks at pseudo random offsets. With the file above
+ * RT_DFS_ELM_FASTSEEK_THRESHOLD each seek goes through the cluster link
+ * map instead of the FAT chain. The init needs twice ELMFAT_TC_FILE_SIZE
+ * free on the volume, define it smaller for a small RAM disk. Mount a FAT
+ * volume (a RAM disk keeps the device out of the numbers) on
+ * ELMFAT_TC_DIR and time it with:
+ *
+ *     utest_bench -n 20 testcases.dfs.elmfat.*
+ */
+
+#ifndef ELMFAT_TC_DIR
+#define ELMFAT_TC_DIR       ""
+#endif
+#ifndef ELMFAT_TC_FILE_SIZE
+#define ELMFAT_TC_FILE_SIZE (64 * 1024 * 1024)
+#endif
+#define ELMFAT_TC_FRAGMENT  (32 * 1024)
+#define ELMFAT_TC_BLOCK     512
+#define ELMFAT_TC_READS     256
+
+#define ELMFAT_TC_FILE      ELMFAT_TC_DIR "/elm_tc.bin"
+#define ELMFAT_TC_FILLER    ELMFAT_TC_DIR "/elm_tc.pad"
+
+static int fd = -1;
+static rt_uint32_t seed;
+static rt_uint32_t buf[ELMFAT_TC_FRAGMENT / sizeof(rt_uint32_t)];
+
+/* every word of the file holds its own offset */
+static int elmfat_tc_fill(int fd, rt_uint32_t offset)
+{
+    rt_size_t i;
+
+    for (i = 0; i < ELMFAT_TC_FRAGMENT / sizeof(rt_uint32_t); i++)
+    {
+        buf[i] = offset + i * sizeof(rt_uint32_t);
+    }
+
+    return write(fd, buf, ELMFAT_TC_FRAGMENT) == ELMFAT_TC_FRAGMENT ? 0 : -1;
+}
+
+static rt_err_t elmfat_tc_init(void)
+{
+    rt_uint32_t offset;
+    int filler;
+
+    fd = open(ELMFAT_TC_FILE, O_RDWR | O_CREAT | O_TRUNC, 0);
+    filler = open(ELMFAT_TC_FILLER, O_RDWR | O_CREAT | O_TRUNC, 0);
+    if (fd < 0 || filler < 0)
+    {
+        goto _error;
+    }
+
+    for (offset = 0; offset < ELMFAT_TC_FILE_SIZE; offset += ELMFAT_TC_FRAGMENT)
+    {
+        if (elmfat_tc_fill(fd, offset) != 0 || elmfat_tc_fill(filler, offset) != 0)
+        {
+            goto _error;
+        }
+    }
+    close(filler);
+    unlink(ELMFAT_TC_FILLER);
+
+    /* reopen read only, the map is built for files that are not written */
+    close(fd);
+    fd = open(ELMFAT_TC_FILE, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        unlink(ELMFAT_TC_FILE);
+        return -RT_ERROR;
+    }
+    seed = 1;
+
+    return RT_EOK;
+
+_error:
+    if (filler >= 0)
+    {
+        close(filler);
+        unlink(ELMFAT_TC_FILLER);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+        unlink(ELMFAT_TC_FILE);
+    }
+    fd = -1;
+
+    return -RT_ERROR;
+}
+
+static rt_err_t elmfat_tc_cleanup(void)
+{
+    close(fd);
+    fd = -1;
+    unlink(ELMFAT_TC_FILE);
+
+    return RT_EOK;
+}
+
+static void elmfat_random_read(void)
+{
+    rt_uint32_t offset;
+    int i, bad = 0;
+
+    for (i = 0; i < ELMFAT_TC_READS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        offset = (seed >> 8) % (ELMFAT_TC_FILE_SIZE - ELMFAT_TC_BLOCK);
+        offset &= ~(sizeof(rt_uint32_t) - 1);
+
+        if (lseek(fd, offset, SEEK_SET) != offset ||
+            read(fd, buf, ELMFAT_TC_BLOCK) != ELMFAT_TC_BLOCK ||
+            buf[0] != offset || buf[ELMFAT_TC_BLOCK / sizeof(rt_uint32_t) - 1] != offset + ELMFAT_TC_BLOCK - 4)
+        {
+            bad ++;
+        }
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(elmfat_random_read);
+}
+UTEST_TC_EXPORT(testcase, "testcases.dfs.elmfat.random_read", elmfat_tc_init, elmfat_tc_cleanup, 600);
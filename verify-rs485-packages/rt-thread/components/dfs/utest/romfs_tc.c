@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <dfs_fs.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include "dfs_romfs.h"
+#include "utest.h"
+
+/*
+ * Reads a ROMFS_TC_SIZE file of a romfs mounted on ROMFS_TC_DIR, once
+ * with read() in ROMFS_TC_BLOCK pieces and once through mmap(), which
+ * must hand out the file data in place instead of a copy. The image is
+ * built in RAM at init, define ROMFS_TC_SIZE smaller on a board without
+ * the RAM for it. Compare both with:
+ *
+ *     utest_bench -n 20 testcases.dfs.romfs.*
+ */
+
+#ifndef ROMFS_TC_DIR
+#define ROMFS_TC_DIR        "/romtc"
+#endif
+#ifndef ROMFS_TC_SIZE
+#define ROMFS_TC_SIZE       (256 * 1024)
+#endif
+#define ROMFS_TC_BLOCK      4096
+
+#define ROMFS_TC_FILE       ROMFS_TC_DIR "/data.bin"
+
+static rt_uint32_t *data;
+static rt_uint32_t buf[ROMFS_TC_BLOCK / sizeof(rt_uint32_t)];
+static struct romfs_dirent romfs_tc_files[] =
+{
+    {ROMFS_DIRENT_FILE, "data.bin", RT_NULL, ROMFS_TC_SIZE},
+};
+static struct romfs_dirent romfs_tc_root =
+{
+    ROMFS_DIRENT_DIR, "/", (rt_uint8_t *)romfs_tc_files, sizeof(romfs_tc_files) / sizeof(romfs_tc_files[0])
+};
+
+static rt_err_t romfs_tc_init(void)
+{
+    rt_size_t i;
+
+    data = rt_malloc(ROMFS_TC_SIZE);
+    if (data == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+
+    /* every word of the file holds its own offset */
+    for (i = 0; i < ROMFS_TC_SIZE / sizeof(rt_uint32_t); i++)
+    {
+        data[i] = i * sizeof(rt_uint32_t);
+    }
+    romfs_tc_files[0].data = (const rt_uint8_t *)data;
+
+    mkdir(ROMFS_TC_DIR, 0);
+    if (dfs_mount(RT_NULL, ROMFS_TC_DIR, "rom", 0, &romfs_tc_root) != 0)
+    {
+        rt_free(data);
+        data = RT_NULL;
+        return -RT_ERROR;
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t romfs_tc_cleanup(void)
+{
+    dfs_unmount(ROMFS_TC_DIR);
+    rmdir(ROMFS_TC_DIR);
+    rt_free(data);
+    data = RT_NULL;
+
+    return RT_EOK;
+}
+
+static void romfs_read(void)
+{
+    rt_uint32_t offset;
+    int fd, bad = 0;
+
+    fd = open(ROMFS_TC_FILE, O_RDONLY, 0);
+    uassert_true(fd >= 0);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    for (offset = 0; offset < ROMFS_TC_SIZE; offset += ROMFS_TC_BLOCK)
+    {
+        if (read(fd, buf, ROMFS_TC_BLOCK) != ROMFS_TC_BLOCK ||
+            buf[0] != offset || buf[ROMFS_TC_BLOCK / sizeof(rt_uint32_t) - 1] != offset + ROMFS_TC_BLOCK - 4)
+        {
+            bad ++;
+        }
+    }
+    close(fd);
+
+    uassert_int_equal(bad, 0);
+}
+
+static void romfs_mmap(void)
+{
+    rt_uint32_t *map;
+    rt_uint32_t offset;
+    int fd, bad = 0;
+
+    fd = open(ROMFS_TC_FILE, O_RDONLY, 0);
+    uassert_true(fd >= 0);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    map = mmap(RT_NULL, ROMFS_TC_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    uassert_true(map != MAP_FAILED);
+    if (map == MAP_FAILED)
+    {
+        return;
+    }
+
+    /* the file data itself, no copy */
+    uassert_true(map == data);
+    for (offset = 0; offset < ROMFS_TC_SIZE; offset += ROMFS_TC_BLOCK)
+    {
+        if (map[offset / sizeof(rt_uint32_t)] != offset)
+        {
+            bad ++;
+        }
+    }
+    uassert_int_equal(munmap(map, ROMFS_TC_SIZE), 0);
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase_read(void)
+{
+    UTEST_UNIT_RUN(romfs_read);
+}
+UTEST_TC_EXPORT(testcase_read, "testcases.dfs.romfs.read", romfs_tc_init, romfs_tc_cleanup, 30);
+
+static void testcase_mmap(void)
+{
+    UTEST_UNIT_RUN(romfs_mmap);
+}
+UTEST_TC_EXPORT(testcase_mmap, "testcases.dfs.romfs.mmap", romfs_tc_init, romfs_tc_cleanup, 30);
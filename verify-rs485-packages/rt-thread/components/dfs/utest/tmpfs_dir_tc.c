@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utest.h"
+
+/*
+ * Creates TMPFS_TC_DIRS directories of TMPFS_TC_FILES files on a tmpfs,
+ * looks every name up, then removes them all through unlink and rmdir.
+ * The directory hash tables grow several times on the way, so a table
+ * that is not freed with its directory shows up in the heap usage of the
+ * second round. Mount a tmpfs on TMPFS_TC_DIR and time the lookups with:
+ *
+ *     utest_bench -n 20 testcases.dfs.tmpfs.dirs
+ */
+
+#ifndef TMPFS_TC_DIR
+#define TMPFS_TC_DIR        "/tmp"
+#endif
+#define TMPFS_TC_DIRS       16
+#define TMPFS_TC_FILES      64
+/* the heap may move a little under the other threads */
+#define TMPFS_TC_SLACK      512
+
+#define TMPFS_TC_TOP        TMPFS_TC_DIR "/tmpfs_tc.d"
+
+static char path[64];
+
+static const char *tmpfs_tc_path(int dir, int file)
+{
+    if (file < 0)
+    {
+        rt_snprintf(path, sizeof(path), TMPFS_TC_TOP "/d%d", dir);
+    }
+    else
+    {
+        rt_snprintf(path, sizeof(path), TMPFS_TC_TOP "/d%d/file_%d", dir, file);
+    }
+
+    return path;
+}
+
+/* create, look up and remove the whole tree, returns the failed calls */
+static int tmpfs_tc_round(void)
+{
+    struct stat st;
+    int dir, file, fd, bad = 0;
+
+    if (mkdir(TMPFS_TC_TOP, 0) != 0)
+    {
+        return 1;
+    }
+
+    for (dir = 0; dir < TMPFS_TC_DIRS; dir++)
+    {
+        if (mkdir(tmpfs_tc_path(dir, -1), 0) != 0)
+        {
+            bad ++;
+            continue;
+        }
+        for (file = 0; file < TMPFS_TC_FILES; file++)
+        {
+            fd = open(tmpfs_tc_path(dir, file), O_RDWR | O_CREAT, 0);
+            if (fd < 0)
+            {
+                bad ++;
+                continue;
+            }
+            close(fd);
+        }
+    }
+
+    for (dir = 0; dir < TMPFS_TC_DIRS; dir++)
+    {
+        for (file = 0; file < TMPFS_TC_FILES; file++)
+        {
+            if (stat(tmpfs_tc_path(dir, file), &st) != 0 || !S_ISREG(st.st_mode))
+            {
+                bad ++;
+            }
+        }
+        /* a name one character off is not found */
+        rt_snprintf(path, sizeof(path), TMPFS_TC_TOP "/d%d/file_%d", dir, TMPFS_TC_FILES);
+        if (stat(path, &st) == 0)
+        {
+            bad ++;
+        }
+    }
+
+    for (dir = 0; dir < TMPFS_TC_DIRS; dir++)
+    {
+        for (file = 0; file < TMPFS_TC_FILES; file++)
+        {
+            if (unlink(tmpfs_tc_path(dir, file)) != 0)
+            {
+                bad ++;
+            }
+        }
+        if (rmdir(tmpfs_tc_path(dir, -1)) != 0)
+        {
+            bad ++;
+        }
+    }
+
+    if (rmdir(TMPFS_TC_TOP) != 0)
+    {
+        bad ++;
+    }
+
+    return bad;
+}
+
+static rt_err_t tmpfs_dir_tc_init(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t tmpfs_dir_tc_cleanup(void)
+{
+    int dir, file;
+
+    /* whatever a failed round left behind */
+    for (dir = 0; dir < TMPFS_TC_DIRS; dir++)
+    {
+        for (file = 0; file < TMPFS_TC_FILES; file++)
+        {
+            unlink(tmpfs_tc_path(dir, file));
+        }
+        rmdir(tmpfs_tc_path(dir, -1));
+    }
+    rmdir(TMPFS_TC_TOP);
+
+    return RT_EOK;
+}
+
+static void tmpfs_dirs(void)
+{
+    uassert_int_equal(tmpfs_tc_round(), 0);
+}
+
+#ifdef RT_USING_HEAP
+static void tmpfs_dirs_leak(void)
+{
+    rt_size_t total, used, used_after, max_used;
+
+    /* the first round fills the caches of the dfs layer */
+    tmpfs_tc_round();
+
+    rt_memory_info(&total, &used, &max_used);
+    uassert_int_equal(tmpfs_tc_round(), 0);
+    rt_memory_info(&total, &used_after, &max_used);
+
+    uassert_true(used_after <= used + TMPFS_TC_SLACK);
+}
+#endif
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(tmpfs_dirs);
+#ifdef RT_USING_HEAP
+    UTEST_UNIT_RUN(tmpfs_dirs_leak);
+#endif
+}
+UTEST_TC_EXPORT(testcase, "testcases.dfs.tmpfs.dirs", tmpfs_dir_tc_init, tmpfs_dir_tc_cleanup, 60);
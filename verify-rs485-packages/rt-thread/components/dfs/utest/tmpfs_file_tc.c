@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "utest.h"
+
+/*
+ * Appends to a tmpfs file in writes that do not line up with the data
+ * chunks, then reads it back at pseudo random offsets, writes past the
+ * end to leave a hole and truncates it. Every byte of the file is
+ * checked against the offset it was written at. Mount a tmpfs on
+ * TMPFS_TC_DIR and time the appends with:
+ *
+ *     utest_bench -n 20 testcases.dfs.tmpfs.append
+ */
+
+#ifndef TMPFS_TC_DIR
+#define TMPFS_TC_DIR        "/tmp"
+#endif
+#ifndef TMPFS_TC_FILE_SIZE
+#define TMPFS_TC_FILE_SIZE  (64 * 1024)
+#endif
+#define TMPFS_TC_WRITE      100
+#define TMPFS_TC_BLOCK      333
+#define TMPFS_TC_READS      64
+#define TMPFS_TC_HOLE       (3 * 4096)
+
+#define TMPFS_TC_FILE       TMPFS_TC_DIR "/tmpfs_tc.bin"
+
+static rt_uint8_t buf[TMPFS_TC_HOLE];
+static rt_uint32_t seed;
+
+static rt_uint8_t tmpfs_tc_byte(rt_uint32_t offset)
+{
+    return (rt_uint8_t)(offset * 7 + (offset >> 8));
+}
+
+static int tmpfs_tc_check(const rt_uint8_t *data, rt_uint32_t offset, rt_size_t len)
+{
+    rt_size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (data[i] != tmpfs_tc_byte(offset + i))
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static rt_err_t tmpfs_file_tc_init(void)
+{
+    seed = 1;
+    unlink(TMPFS_TC_FILE);
+
+    return RT_EOK;
+}
+
+static rt_err_t tmpfs_file_tc_cleanup(void)
+{
+    unlink(TMPFS_TC_FILE);
+
+    return RT_EOK;
+}
+
+static void tmpfs_append(void)
+{
+    rt_uint32_t offset;
+    rt_size_t len, i;
+    int fd, bad = 0;
+
+    fd = open(TMPFS_TC_FILE, O_RDWR | O_CREAT | O_TRUNC | O_APPEND, 0);
+    uassert_true(fd >= 0);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    for (offset = 0; offset < TMPFS_TC_FILE_SIZE; offset += len)
+    {
+        len = TMPFS_TC_FILE_SIZE - offset;
+        if (len > TMPFS_TC_WRITE)
+        {
+            len = TMPFS_TC_WRITE;
+        }
+        for (i = 0; i < len; i++)
+        {
+            buf[i] = tmpfs_tc_byte(offset + i);
+        }
+        if (write(fd, buf, len) != len)
+        {
+            bad ++;
+            break;
+        }
+    }
+
+    for (i = 0; i < TMPFS_TC_READS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        offset = (seed >> 8) % (TMPFS_TC_FILE_SIZE - TMPFS_TC_BLOCK);
+        if (lseek(fd, offset, SEEK_SET) != offset ||
+            read(fd, buf, TMPFS_TC_BLOCK) != TMPFS_TC_BLOCK ||
+            tmpfs_tc_check(buf, offset, TMPFS_TC_BLOCK) != 0)
+        {
+            bad ++;
+        }
+    }
+
+    close(fd);
+    uassert_int_equal(bad, 0);
+}
+
+static void tmpfs_hole(void)
+{
+    struct stat st;
+    rt_size_t i;
+    int fd, bad = 0;
+
+    fd = open(TMPFS_TC_FILE, O_RDWR, 0);
+    uassert_true(fd >= 0);
+    if (fd < 0)
+    {
+        return;
+    }
+
+    /* a byte after a hole, the hole reads back as zeros */
+    buf[0] = 0x5a;
+    if (lseek(fd, TMPFS_TC_FILE_SIZE + TMPFS_TC_HOLE, SEEK_SET) != TMPFS_TC_FILE_SIZE + TMPFS_TC_HOLE ||
+        write(fd, buf, 1) != 1)
+    {
+        bad ++;
+    }
+    if (lseek(fd, TMPFS_TC_FILE_SIZE, SEEK_SET) != TMPFS_TC_FILE_SIZE ||
+        read(fd, buf, TMPFS_TC_HOLE) != TMPFS_TC_HOLE)
+    {
+        bad ++;
+    }
+    for (i = 0; i < TMPFS_TC_HOLE; i++)
+    {
+        if (buf[i] != 0)
+        {
+            bad ++;
+            break;
+        }
+    }
+    if (fstat(fd, &st) != 0 || st.st_size != TMPFS_TC_FILE_SIZE + TMPFS_TC_HOLE + 1)
+    {
+        bad ++;
+    }
+
+    /* cut in the middle of a chunk, the data before stays */
+    if (ftruncate(fd, TMPFS_TC_FILE_SIZE / 2 + 1) != 0 ||
+        fstat(fd, &st) != 0 || st.st_size != TMPFS_TC_FILE_SIZE / 2 + 1)
+    {
+        bad ++;
+    }
+    if (lseek(fd, TMPFS_TC_FILE_SIZE / 2 - TMPFS_TC_BLOCK + 1, SEEK_SET) < 0 ||
+        read(fd, buf, TMPFS_TC_HOLE) != TMPFS_TC_BLOCK ||
+        tmpfs_tc_check(buf, TMPFS_TC_FILE_SIZE / 2 - TMPFS_TC_BLOCK + 1, TMPFS_TC_BLOCK) != 0)
+    {
+        bad ++;
+    }
+
+    close(fd);
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(tmpfs_append);
+    UTEST_UNIT_RUN(tmpfs_hole);
+}
+UTEST_TC_EXPORT(testcase, "testcases.dfs.tmpfs.append", tmpfs_file_tc_init, tmpfs_file_tc_cleanup, 30);
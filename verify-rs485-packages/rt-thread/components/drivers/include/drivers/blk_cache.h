@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#ifndef __BLK_CACHE_H__
+#define __BLK_CACHE_H__
+
+#include <rtthread.h>
+#include <drivers/classes/block.h>
+
+/* replacement policy */
+#define RT_BLK_CACHE_LRU                0   /**< plain least recently used */
+#define RT_BLK_CACHE_2Q                 1   /**< 2Q, keeps one-shot scans out of the hot set */
+
+/* write policy */
+#define RT_BLK_CACHE_WRITE_THROUGH      0
+#define RT_BLK_CACHE_WRITE_BACK         1
+
+/* block cache commands */
+#define RT_DEVICE_CTRL_BLK_CACHE_STAT   (RT_DEVICE_CTRL_BASE(Block) + 0x10) /**< get struct rt_blk_cache_stat */
+#define RT_DEVICE_CTRL_BLK_CACHE_RESET  (RT_DEVICE_CTRL_BASE(Block) + 0x11) /**< clear the statistics */
+#define RT_DEVICE_CTRL_BLK_CACHE_DROP   (RT_DEVICE_CTRL_BASE(Block) + 0x12) /**< write back and drop all cached sectors */
+
+struct rt_blk_cache_stat
+{
+    rt_uint32_t read_hits;                  /**< sectors read from the cache */
+    rt_uint32_t read_misses;                /**< sectors read from the device */
+    rt_uint32_t write_hits;                 /**< sectors written over a cached copy */
+    rt_uint32_t write_misses;               /**< sectors written with no cached copy */
+    rt_uint32_t writebacks;                 /**< dirty sectors written to the device */
+    rt_uint32_t evictions;                  /**< cached sectors reclaimed */
+};
+
+struct rt_blk_cache_entry
+{
+    rt_list_t list;                         /**< node in the replacement queue */
+    rt_list_t hash;                         /**< node in the sector hash */
+    rt_off_t sector;
+    rt_uint8_t queue;
+    rt_uint8_t dirty;
+    rt_uint8_t *data;                       /**< RT_NULL on 2Q ghost entries */
+};
+
+struct rt_blk_cache
+{
+    struct rt_device parent;
+    rt_device_t backing;
+
+    struct rt_device_blk_geometry geometry;
+    rt_uint8_t replace;
+    rt_uint8_t write_mode;
+
+    rt_size_t nr;                           /**< number of cached sectors */
+    struct rt_blk_cache_entry *entries;
+    rt_uint8_t *buf;
+
+    rt_list_t *buckets;
+    rt_size_t bucket_nr;
+
+    rt_list_t free;
+    rt_list_t hot;                          /**< LRU list, Am for 2Q */
+    rt_list_t in;                           /**< 2Q A1in fifo */
+    rt_list_t out;                          /**< 2Q A1out ghost fifo */
+    rt_size_t in_nr, in_max;
+    struct rt_blk_cache_entry *ghosts;
+    rt_size_t ghost_nr;
+    struct rt_blk_cache_entry **flush;      /**< scratch for sorted write back */
+
+    struct rt_mutex lock;
+    struct rt_blk_cache_stat stat;
+};
+typedef struct rt_blk_cache *rt_blk_cache_t;
+
+rt_blk_cache_t rt_blk_cache_create(const char *name, rt_device_t backing, rt_size_t sectors,
+                                   rt_uint8_t replace, rt_uint8_t write_mode);
+rt_err_t rt_blk_cache_delete(rt_blk_cache_t cache);
+
+#endif /* __BLK_CACHE_H__ */
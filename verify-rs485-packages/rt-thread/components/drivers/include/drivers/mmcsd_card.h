@@ -20,6 +20,9 @@ extern "C" {
 #define SD_SCR_BUS_WIDTH_1  (1 << 0)
 #define SD_SCR_BUS_WIDTH_4  (1 << 2)
 
+#define SD_SCR_CMD20_SUPPORT    (1 << 0)
+#define SD_SCR_CMD23_SUPPORT    (1 << 1)
+
 struct rt_mmcsd_cid {
     rt_uint8_t  mid;       /* ManufacturerID */
     rt_uint8_t  prv;       /* Product Revision */
@@ -55,6 +58,7 @@ struct rt_mmcsd_csd {
 struct rt_sd_scr {
     rt_uint8_t      sd_version;
     rt_uint8_t      sd_bus_widths;
+    rt_uint8_t      cmd_support;
 };
 
 struct rt_sdio_cccr {
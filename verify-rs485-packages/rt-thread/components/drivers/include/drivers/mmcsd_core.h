@@ -254,6 +254,27 @@ rt_int32_t read_lba(struct rt_mmcsd_card *card, size_t lba, uint8_t *buffer, siz
 rt_int32_t rt_mmcsd_blk_probe(struct rt_mmcsd_card *card);
 void rt_mmcsd_blk_remove(struct rt_mmcsd_card *card);
 
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+/* asynchronous sector request on a mmcsd block device */
+struct rt_mmcsd_blk_req
+{
+    rt_list_t    list;
+    rt_uint32_t  sector;        /* first sector, relative to the block device */
+    void        *buf;
+    rt_size_t    blks;          /* number of sectors */
+    rt_uint8_t   dir;           /* 0 - read, 1 - write */
+    rt_err_t     err;           /* result, valid in done() */
+
+    /* called from the queue thread when the request is finished */
+    void (*done)(struct rt_mmcsd_blk_req *req);
+    void        *user_data;
+
+    rt_uint32_t  lba;           /* private: absolute sector on the card */
+};
+
+rt_err_t rt_mmcsd_blk_submit(rt_device_t dev, struct rt_mmcsd_blk_req *req);
+#endif
+
 
 #ifdef __cplusplus
 }
@@ -9,6 +9,7 @@
  * 2012-05-28     bernard      change interfaces
  * 2013-02-20     bernard      use RT_SERIAL_RB_BUFSZ to define
  *                             the size of ring buffer.
+ * 2026-10-17     RT-Thread    add the interrupt tx ring buffer
  */
 
 #ifndef __SERIAL_H__
@@ -66,11 +67,19 @@
 #define RT_SERIAL_RB_BUFSZ              64
 #endif
 
+#if defined(RT_SERIAL_USING_TX_RB) && !defined(RT_SERIAL_TX_RB_BUFSZ)
+#define RT_SERIAL_TX_RB_BUFSZ           256
+#endif
+
 #define RT_SERIAL_EVENT_RX_IND          0x01    /* Rx indication */
 #define RT_SERIAL_EVENT_TX_DONE         0x02    /* Tx complete   */
 #define RT_SERIAL_EVENT_RX_DMADONE      0x03    /* Rx DMA transfer done */
 #define RT_SERIAL_EVENT_TX_DMADONE      0x04    /* Tx DMA transfer done */
 #define RT_SERIAL_EVENT_RX_TIMEOUT      0x05    /* Rx timeout    */
+#define RT_SERIAL_EVENT_TX_TC           0x06    /* Tx shift register empty */
+
+/* low level control of the tx fifo, stop the TX_DONE interrupts and raise TX_TC once */
+#define RT_SERIAL_CTRL_TX_TC            (RT_DEVICE_CTRL_BASE(Char) + 0x10)
 
 #define RT_SERIAL_DMA_RX                0x01
 #define RT_SERIAL_DMA_TX                0x02
@@ -140,6 +149,21 @@ struct rt_serial_rx_fifo
 struct rt_serial_tx_fifo
 {
     struct rt_completion completion;
+
+#ifdef RT_SERIAL_USING_TX_RB
+    /*
+     * software fifo drained by the tx interrupt, the low level driver
+     * raises RT_SERIAL_EVENT_TX_DONE when the data register is empty and
+     * RT_SERIAL_EVENT_TX_TC when the last byte is out.
+     */
+    rt_uint8_t *buffer;
+
+    rt_uint16_t put_index, get_index;
+
+    rt_uint8_t activated;       /* tx interrupt enabled */
+    rt_uint8_t busy;            /* not finished sending */
+    rt_uint16_t writers;        /* writes in progress */
+#endif /* RT_SERIAL_USING_TX_RB */
 };
 
 /*
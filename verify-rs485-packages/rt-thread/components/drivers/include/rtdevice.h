@@ -176,6 +176,10 @@ extern "C" {
 #include "drivers/mtdnand.h"
 #endif /* MTD_USING_NAND */
 
+#ifdef RT_USING_BLK_CACHE
+#include "drivers/blk_cache.h"
+#endif /* RT_USING_BLK_CACHE */
+
 #ifdef RT_USING_HWCRYPTO
 #include "drivers/crypto.h"
 #endif /* RT_USING_HWCRYPTO */
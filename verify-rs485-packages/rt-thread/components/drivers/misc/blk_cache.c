@@ -0,0 +1,693 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+
+#include <string.h>
+#include <stdlib.h>
+
+#define DBG_TAG "blk.cache"
+#define DBG_LVL DBG_INFO
+#include <rtdbg.h>
+
+#ifndef RT_BLK_CACHE_SECTORS
+#define RT_BLK_CACHE_SECTORS    32
+#endif
+
+/* which list an entry sits on */
+#define Q_FREE                  0
+#define Q_HOT                   1
+#define Q_IN                    2
+#define Q_OUT                   3
+
+/* reads and writes this large go straight to the device */
+#define BYPASS_SECTORS(c)       ((c)->nr / 2)
+
+static rt_list_t *_bucket(rt_blk_cache_t cache, rt_off_t sector)
+{
+    return &cache->buckets[(rt_size_t)sector & (cache->bucket_nr - 1)];
+}
+
+static struct rt_blk_cache_entry *_lookup(rt_blk_cache_t cache, rt_off_t sector)
+{
+    struct rt_blk_cache_entry *entry;
+    rt_list_t *head = _bucket(cache, sector);
+
+    rt_list_for_each_entry(entry, head, hash)
+    {
+        if (entry->sector == sector)
+            return entry;
+    }
+
+    return RT_NULL;
+}
+
+/* only entries holding data, 2Q ghosts are skipped */
+static struct rt_blk_cache_entry *_find(rt_blk_cache_t cache, rt_off_t sector)
+{
+    struct rt_blk_cache_entry *entry = _lookup(cache, sector);
+
+    return (entry && entry->queue != Q_OUT) ? entry : RT_NULL;
+}
+
+static void _touch(rt_blk_cache_t cache, struct rt_blk_cache_entry *entry)
+{
+    /* 2Q leaves A1in in fifo order, a second hit there proves nothing */
+    if (entry->queue == Q_HOT)
+    {
+        rt_list_remove(&entry->list);
+        rt_list_insert_after(&cache->hot, &entry->list);
+    }
+}
+
+static void _detach(rt_blk_cache_t cache, struct rt_blk_cache_entry *entry)
+{
+    if (entry->queue == Q_IN)
+        cache->in_nr --;
+
+    rt_list_remove(&entry->list);
+    rt_list_remove(&entry->hash);
+    entry->queue = Q_FREE;
+}
+
+static rt_err_t _writeback(rt_blk_cache_t cache, struct rt_blk_cache_entry *entry)
+{
+    if (rt_device_write(cache->backing, entry->sector, entry->data, 1) != 1)
+    {
+        LOG_E("write back sector %d to %s failed", (int)entry->sector,
+              cache->backing->parent.name);
+        return -RT_EIO;
+    }
+
+    entry->dirty = 0;
+    cache->stat.writebacks ++;
+
+    return RT_EOK;
+}
+
+/* remember a sector evicted from A1in, a hit on it later goes to Am */
+static void _ghost_add(rt_blk_cache_t cache, rt_off_t sector)
+{
+    struct rt_blk_cache_entry *ghost;
+
+    ghost = rt_list_entry(cache->out.prev, struct rt_blk_cache_entry, list);
+    rt_list_remove(&ghost->hash);
+    rt_list_remove(&ghost->list);
+
+    ghost->sector = sector;
+    rt_list_insert_after(&cache->out, &ghost->list);
+    rt_list_insert_after(_bucket(cache, sector), &ghost->hash);
+}
+
+static struct rt_blk_cache_entry *_evict(rt_blk_cache_t cache)
+{
+    struct rt_blk_cache_entry *entry;
+    rt_list_t *victim;
+
+    if (cache->replace == RT_BLK_CACHE_2Q &&
+        (cache->in_nr > cache->in_max || rt_list_isempty(&cache->hot)))
+    {
+        victim = cache->in.prev;
+    }
+    else
+    {
+        victim = cache->hot.prev;
+    }
+
+    entry = rt_list_entry(victim, struct rt_blk_cache_entry, list);
+    if (entry->dirty && _writeback(cache, entry) != RT_EOK)
+    {
+        return RT_NULL;
+    }
+
+    if (entry->queue == Q_IN)
+    {
+        _ghost_add(cache, entry->sector);
+    }
+    _detach(cache, entry);
+    cache->stat.evictions ++;
+
+    return entry;
+}
+
+static struct rt_blk_cache_entry *_alloc(rt_blk_cache_t cache, rt_off_t sector)
+{
+    struct rt_blk_cache_entry *entry, *ghost;
+
+    if (!rt_list_isempty(&cache->free))
+    {
+        entry = rt_list_first_entry(&cache->free, struct rt_blk_cache_entry, list);
+        rt_list_remove(&entry->list);
+    }
+    else
+    {
+        entry = _evict(cache);
+        if (entry == RT_NULL)
+            return RT_NULL;
+    }
+
+    entry->sector = sector;
+    entry->dirty = 0;
+
+    if (cache->replace == RT_BLK_CACHE_2Q)
+    {
+        ghost = _lookup(cache, sector);
+        if (ghost)
+        {
+            /* seen again after leaving A1in: it is hot, and the ghost is recycled first */
+            rt_list_remove(&ghost->hash);
+            rt_list_remove(&ghost->list);
+            rt_list_insert_before(&cache->out, &ghost->list);
+
+            entry->queue = Q_HOT;
+            rt_list_insert_after(&cache->hot, &entry->list);
+        }
+        else
+        {
+            entry->queue = Q_IN;
+            rt_list_insert_after(&cache->in, &entry->list);
+            cache->in_nr ++;
+        }
+    }
+    else
+    {
+        entry->queue = Q_HOT;
+        rt_list_insert_after(&cache->hot, &entry->list);
+    }
+    rt_list_insert_after(_bucket(cache, sector), &entry->hash);
+
+    return entry;
+}
+
+static void _drop(rt_blk_cache_t cache, struct rt_blk_cache_entry *entry)
+{
+    _detach(cache, entry);
+    rt_list_insert_after(&cache->free, &entry->list);
+}
+
+/* write back all dirty sectors in ascending order */
+static rt_err_t _flush(rt_blk_cache_t cache)
+{
+    struct rt_blk_cache_entry *entry, *tmp;
+    rt_size_t dirty_nr = 0, i, j;
+    rt_err_t err = RT_EOK;
+
+    for (i = 0; i < cache->nr; i ++)
+    {
+        entry = &cache->entries[i];
+        if (entry->queue == Q_FREE || !entry->dirty)
+            continue;
+
+        /* insertion sort, the dirty set is small */
+        for (j = dirty_nr; j > 0 && cache->flush[j - 1]->sector > entry->sector; j --)
+        {
+            cache->flush[j] = cache->flush[j - 1];
+        }
+        cache->flush[j] = entry;
+        dirty_nr ++;
+    }
+
+    for (i = 0; i < dirty_nr; i ++)
+    {
+        tmp = cache->flush[i];
+        if (_writeback(cache, tmp) != RT_EOK)
+            err = -RT_EIO;
+    }
+
+    return err;
+}
+
+static rt_err_t _blk_cache_open(rt_device_t dev, rt_uint16_t oflag)
+{
+    rt_blk_cache_t cache = (rt_blk_cache_t)dev;
+
+    return rt_device_open(cache->backing, RT_DEVICE_OFLAG_RDWR);
+}
+
+static rt_err_t _blk_cache_close(rt_device_t dev)
+{
+    rt_blk_cache_t cache = (rt_blk_cache_t)dev;
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    _flush(cache);
+    rt_mutex_release(&cache->lock);
+
+    return rt_device_close(cache->backing);
+}
+
+static rt_ssize_t _blk_cache_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    rt_blk_cache_t cache = (rt_blk_cache_t)dev;
+    struct rt_blk_cache_entry *entry;
+    rt_uint32_t bps = cache->geometry.bytes_per_sector;
+    rt_uint8_t *ptr = (rt_uint8_t *)buffer;
+    rt_size_t i = 0, run, k;
+    rt_bool_t fill = (size < BYPASS_SECTORS(cache)) ? RT_TRUE : RT_FALSE;
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    while (i < size)
+    {
+        entry = _find(cache, pos + i);
+        if (entry)
+        {
+            rt_memcpy(ptr + i * bps, entry->data, bps);
+            _touch(cache, entry);
+            cache->stat.read_hits ++;
+            i ++;
+            continue;
+        }
+
+        /* read the whole run of missing sectors in one go */
+        for (run = 1; i + run < size && !_find(cache, pos + i + run); run ++);
+
+        if (rt_device_read(cache->backing, pos + i, ptr + i * bps, run) != run)
+        {
+            rt_set_errno(-EIO);
+            break;
+        }
+        cache->stat.read_misses += run;
+
+        /* large sequential reads are not kept, they would only flush the cache */
+        for (k = 0; fill && k < run; k ++)
+        {
+            entry = _alloc(cache, pos + i + k);
+            if (entry == RT_NULL)
+                break;
+            rt_memcpy(entry->data, ptr + (i + k) * bps, bps);
+        }
+        i += run;
+    }
+    rt_mutex_release(&cache->lock);
+
+    return i;
+}
+
+static rt_ssize_t _blk_cache_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    rt_blk_cache_t cache = (rt_blk_cache_t)dev;
+    struct rt_blk_cache_entry *entry;
+    rt_uint32_t bps = cache->geometry.bytes_per_sector;
+    const rt_uint8_t *ptr = (const rt_uint8_t *)buffer;
+    rt_bool_t bypass = (size >= BYPASS_SECTORS(cache)) ? RT_TRUE : RT_FALSE;
+    rt_ssize_t written;
+    rt_size_t i;
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    if (cache->write_mode == RT_BLK_CACHE_WRITE_THROUGH || bypass)
+    {
+        written = rt_device_write(cache->backing, pos, buffer, size);
+        if (written < 0)
+            written = 0;
+
+        for (i = 0; i < (rt_size_t)written; i ++)
+        {
+            entry = _find(cache, pos + i);
+            if (entry)
+            {
+                cache->stat.write_hits ++;
+                _touch(cache, entry);
+            }
+            else
+            {
+                cache->stat.write_misses ++;
+                /* keep what was just written, FAT and directory sectors are read back soon */
+                entry = bypass ? RT_NULL : _alloc(cache, pos + i);
+                if (entry == RT_NULL)
+                    continue;
+            }
+            rt_memcpy(entry->data, ptr + i * bps, bps);
+            entry->dirty = 0;
+        }
+    }
+    else
+    {
+        for (i = 0; i < size; i ++)
+        {
+            entry = _find(cache, pos + i);
+            if (entry)
+            {
+                cache->stat.write_hits ++;
+                _touch(cache, entry);
+            }
+            else
+            {
+                cache->stat.write_misses ++;
+                entry = _alloc(cache, pos + i);
+                if (entry == RT_NULL)
+                {
+                    /* no clean sector to reuse, write this one through */
+                    if (rt_device_write(cache->backing, pos + i, ptr + i * bps, 1) != 1)
+                        break;
+                    continue;
+                }
+            }
+            rt_memcpy(entry->data, ptr + i * bps, bps);
+            entry->dirty = 1;
+        }
+        written = i;
+    }
+    rt_mutex_release(&cache->lock);
+
+    if ((rt_size_t)written != size)
+    {
+        rt_set_errno(-EIO);
+    }
+
+    return written;
+}
+
+static rt_err_t _blk_cache_control(rt_device_t dev, int cmd, void *args)
+{
+    rt_blk_cache_t cache = (rt_blk_cache_t)dev;
+    struct rt_blk_cache_entry *entry;
+    struct rt_device_blk_sectors *sectors;
+    rt_err_t err = RT_EOK;
+    rt_size_t i;
+
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_BLK_GETGEOME:
+        if (args == RT_NULL)
+            return -RT_EINVAL;
+        rt_memcpy(args, &cache->geometry, sizeof(struct rt_device_blk_geometry));
+        break;
+
+    case RT_DEVICE_CTRL_BLK_SYNC:
+        rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+        err = _flush(cache);
+        rt_mutex_release(&cache->lock);
+        if (err == RT_EOK)
+        {
+            err = rt_device_control(cache->backing, cmd, args);
+        }
+        break;
+
+    case RT_DEVICE_CTRL_BLK_ERASE:
+        sectors = (struct rt_device_blk_sectors *)args;
+        if (sectors == RT_NULL)
+            return -RT_EINVAL;
+        rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+        for (i = 0; i < cache->nr; i ++)
+        {
+            entry = &cache->entries[i];
+            if (entry->queue != Q_FREE && (rt_uint64_t)entry->sector >= sectors->sector_begin &&
+                (rt_uint64_t)entry->sector <= sectors->sector_end)
+            {
+                _drop(cache, entry);
+            }
+        }
+        err = rt_device_control(cache->backing, cmd, args);
+        rt_mutex_release(&cache->lock);
+        break;
+
+    case RT_DEVICE_CTRL_BLK_CACHE_STAT:
+        if (args == RT_NULL)
+            return -RT_EINVAL;
+        rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+        rt_memcpy(args, &cache->stat, sizeof(struct rt_blk_cache_stat));
+        rt_mutex_release(&cache->lock);
+        break;
+
+    case RT_DEVICE_CTRL_BLK_CACHE_RESET:
+        rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+        rt_memset(&cache->stat, 0, sizeof(struct rt_blk_cache_stat));
+        rt_mutex_release(&cache->lock);
+        break;
+
+    case RT_DEVICE_CTRL_BLK_CACHE_DROP:
+        rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+        err = _flush(cache);
+        if (err == RT_EOK)
+        {
+            for (i = 0; i < cache->nr; i ++)
+            {
+                if (cache->entries[i].queue != Q_FREE)
+                    _drop(cache, &cache->entries[i]);
+            }
+        }
+        rt_mutex_release(&cache->lock);
+        break;
+
+    default:
+        err = rt_device_control(cache->backing, cmd, args);
+        break;
+    }
+
+    return err;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops blk_cache_ops =
+{
+    RT_NULL,
+    _blk_cache_open,
+    _blk_cache_close,
+    _blk_cache_read,
+    _blk_cache_write,
+    _blk_cache_control
+};
+#endif
+
+static rt_bool_t _is_blk_cache(rt_device_t dev)
+{
+#ifdef RT_USING_DEVICE_OPS
+    return (dev->ops == &blk_cache_ops) ? RT_TRUE : RT_FALSE;
+#else
+    return (dev->read == _blk_cache_read) ? RT_TRUE : RT_FALSE;
+#endif
+}
+
+static void _blk_cache_free(rt_blk_cache_t cache)
+{
+    rt_free(cache->flush);
+    rt_free(cache->buckets);
+    rt_free(cache->ghosts);
+    rt_free(cache->entries);
+    rt_free(cache->buf);
+    rt_free(cache);
+}
+
+/**
+ * This function creates a sector cache on top of a block device and registers
+ * it as a new block device.
+ *
+ * @param name the name of the cache device.
+ * @param backing the block device to cache.
+ * @param sectors the number of sectors to cache, 0 for RT_BLK_CACHE_SECTORS.
+ * @param replace RT_BLK_CACHE_LRU or RT_BLK_CACHE_2Q.
+ * @param write_mode RT_BLK_CACHE_WRITE_THROUGH or RT_BLK_CACHE_WRITE_BACK.
+ *
+ * @return the cache device, or RT_NULL on error.
+ */
+rt_blk_cache_t rt_blk_cache_create(const char *name, rt_device_t backing, rt_size_t sectors,
+                                   rt_uint8_t replace, rt_uint8_t write_mode)
+{
+    rt_blk_cache_t cache;
+    struct rt_blk_cache_entry *entry;
+    rt_size_t i;
+
+    RT_ASSERT(name != RT_NULL);
+    RT_ASSERT(backing != RT_NULL);
+
+    if (backing->type != RT_Device_Class_Block)
+    {
+        LOG_E("%s is not a block device", backing->parent.name);
+        return RT_NULL;
+    }
+
+    if (sectors == 0)
+    {
+        sectors = RT_BLK_CACHE_SECTORS;
+    }
+    if (sectors < 4)
+    {
+        sectors = 4;
+    }
+
+    cache = rt_calloc(1, sizeof(struct rt_blk_cache));
+    if (cache == RT_NULL)
+        return RT_NULL;
+
+    if (rt_device_control(backing, RT_DEVICE_CTRL_BLK_GETGEOME, &cache->geometry) != RT_EOK ||
+        cache->geometry.bytes_per_sector == 0)
+    {
+        LOG_E("get geometry of %s failed", backing->parent.name);
+        rt_free(cache);
+        return RT_NULL;
+    }
+
+    cache->backing = backing;
+    cache->replace = replace;
+    cache->write_mode = write_mode;
+    cache->nr = sectors;
+    for (cache->bucket_nr = 1; cache->bucket_nr < sectors; cache->bucket_nr <<= 1);
+    /* 2Q tuning from the paper: A1in holds 1/4, A1out remembers 1/2 */
+    cache->in_max = sectors / 4;
+    cache->ghost_nr = (replace == RT_BLK_CACHE_2Q) ? sectors / 2 : 0;
+
+    cache->buf = rt_malloc(sectors * cache->geometry.bytes_per_sector);
+    cache->entries = rt_calloc(sectors, sizeof(struct rt_blk_cache_entry));
+    cache->buckets = rt_malloc(cache->bucket_nr * sizeof(rt_list_t));
+    cache->flush = rt_malloc(sectors * sizeof(struct rt_blk_cache_entry *));
+    if (cache->ghost_nr)
+    {
+        cache->ghosts = rt_calloc(cache->ghost_nr, sizeof(struct rt_blk_cache_entry));
+    }
+    if (!cache->buf || !cache->entries || !cache->buckets || !cache->flush ||
+        (cache->ghost_nr && !cache->ghosts))
+    {
+        LOG_E("no memory for %d sectors cache", sectors);
+        _blk_cache_free(cache);
+        return RT_NULL;
+    }
+
+    for (i = 0; i < cache->bucket_nr; i ++)
+    {
+        rt_list_init(&cache->buckets[i]);
+    }
+    rt_list_init(&cache->free);
+    rt_list_init(&cache->hot);
+    rt_list_init(&cache->in);
+    rt_list_init(&cache->out);
+    for (i = 0; i < sectors; i ++)
+    {
+        entry = &cache->entries[i];
+        entry->data = cache->buf + i * cache->geometry.bytes_per_sector;
+        rt_list_init(&entry->hash);
+        rt_list_insert_before(&cache->free, &entry->list);
+    }
+    for (i = 0; i < cache->ghost_nr; i ++)
+    {
+        entry = &cache->ghosts[i];
+        entry->queue = Q_OUT;
+        rt_list_init(&entry->hash);
+        rt_list_insert_before(&cache->out, &entry->list);
+    }
+
+    rt_mutex_init(&cache->lock, name, RT_IPC_FLAG_PRIO);
+
+    cache->parent.type = RT_Device_Class_Block;
+#ifdef RT_USING_DEVICE_OPS
+    cache->parent.ops = &blk_cache_ops;
+#else
+    cache->parent.init = RT_NULL;
+    cache->parent.open = _blk_cache_open;
+    cache->parent.close = _blk_cache_close;
+    cache->parent.read = _blk_cache_read;
+    cache->parent.write = _blk_cache_write;
+    cache->parent.control = _blk_cache_control;
+#endif
+    cache->parent.user_data = RT_NULL;
+
+    if (rt_device_register(&cache->parent, name, RT_DEVICE_FLAG_RDWR) != RT_EOK)
+    {
+        rt_mutex_detach(&cache->lock);
+        _blk_cache_free(cache);
+        return RT_NULL;
+    }
+
+    LOG_D("%s: %d sectors cache on %s", name, sectors, backing->parent.name);
+
+    return cache;
+}
+
+/**
+ * This function writes back the cache, unregisters and frees it.
+ *
+ * @param cache the cache created by rt_blk_cache_create.
+ *
+ * @return RT_EOK on success, -RT_EIO if dirty sectors can not be written back.
+ */
+rt_err_t rt_blk_cache_delete(rt_blk_cache_t cache)
+{
+    rt_err_t err;
+
+    RT_ASSERT(cache != RT_NULL);
+
+    rt_mutex_take(&cache->lock, RT_WAITING_FOREVER);
+    err = _flush(cache);
+    rt_mutex_release(&cache->lock);
+    if (err != RT_EOK)
+        return err;
+
+    rt_device_unregister(&cache->parent);
+    rt_mutex_detach(&cache->lock);
+    _blk_cache_free(cache);
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_FINSH
+static int blk_cache(int argc, char **argv)
+{
+    struct rt_blk_cache_stat stat;
+    rt_device_t dev, backing;
+    rt_uint32_t hits, total;
+    rt_uint8_t replace = RT_BLK_CACHE_LRU, write_mode = RT_BLK_CACHE_WRITE_THROUGH;
+    rt_size_t sectors = 0;
+
+    if (argc >= 4 && !strcmp(argv[1], "create"))
+    {
+        backing = rt_device_find(argv[3]);
+        if (backing == RT_NULL)
+        {
+            rt_kprintf("device %s not found\n", argv[3]);
+            return -RT_ERROR;
+        }
+        if (argc > 4)
+            sectors = atoi(argv[4]);
+        if (argc > 5 && !strcmp(argv[5], "2q"))
+            replace = RT_BLK_CACHE_2Q;
+        if (argc > 6 && !strcmp(argv[6], "wb"))
+            write_mode = RT_BLK_CACHE_WRITE_BACK;
+
+        return rt_blk_cache_create(argv[2], backing, sectors, replace, write_mode) ? RT_EOK : -RT_ERROR;
+    }
+    else if (argc == 3)
+    {
+        dev = rt_device_find(argv[2]);
+        if (dev == RT_NULL || !_is_blk_cache(dev))
+        {
+            rt_kprintf("%s is not a block cache\n", argv[2]);
+            return -RT_ERROR;
+        }
+
+        if (!strcmp(argv[1], "stat"))
+        {
+            rt_device_control(dev, RT_DEVICE_CTRL_BLK_CACHE_STAT, &stat);
+            hits = stat.read_hits;
+            total = stat.read_hits + stat.read_misses;
+            rt_kprintf("read  hit %u miss %u, hit rate %u%%\n", stat.read_hits, stat.read_misses,
+                       total ? hits * 100 / total : 0);
+            rt_kprintf("write hit %u miss %u\n", stat.write_hits, stat.write_misses);
+            rt_kprintf("writeback %u eviction %u\n", stat.writebacks, stat.evictions);
+            return RT_EOK;
+        }
+        else if (!strcmp(argv[1], "reset"))
+        {
+            return rt_device_control(dev, RT_DEVICE_CTRL_BLK_CACHE_RESET, RT_NULL);
+        }
+        else if (!strcmp(argv[1], "sync"))
+        {
+            return rt_device_control(dev, RT_DEVICE_CTRL_BLK_SYNC, RT_NULL);
+        }
+    }
+
+    rt_kprintf("Usage: \n");
+    rt_kprintf("blk_cache create <name> <block device> [sectors] [lru|2q] [wt|wb]\n");
+    rt_kprintf("blk_cache stat <name>  - show hit statistics\n");
+    rt_kprintf("blk_cache reset <name> - clear hit statistics\n");
+    rt_kprintf("blk_cache sync <name>  - write back dirty sectors\n");
+
+    return -RT_ERROR;
+}
+MSH_CMD_EXPORT(blk_cache, block device sector cache);
+#endif /* RT_USING_FINSH */
@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "utest.h"
+
+/*
+ * Stacks a sector cache on a block device that keeps its sectors in RAM
+ * and counts every sector it reads and writes. Checks hits and misses,
+ * the LRU victim, that large reads pass by the cache, and that a write
+ * back cache writes nothing until it is synced, then writes the dirty
+ * sectors in ascending order. Time the cache with:
+ *
+ *     utest_bench -n 20 testcases.drivers.blk_cache
+ */
+
+#define BC_TC_RAM           "bc_ram"
+#define BC_TC_NAME          "bc_tc"
+#define BC_TC_SECTORS       64
+#define BC_TC_CACHED        8
+
+static struct rt_device ram_dev;
+static rt_uint8_t ram[BC_TC_SECTORS][512];
+static rt_uint32_t ram_reads, ram_writes;
+static rt_off_t ram_order[BC_TC_SECTORS];
+static rt_blk_cache_t cache;
+static rt_uint8_t buf[BC_TC_CACHED][512];
+
+static rt_ssize_t ram_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    if (pos + size > BC_TC_SECTORS)
+        return 0;
+
+    rt_memcpy(buffer, ram[pos], size * 512);
+    ram_reads += size;
+
+    return size;
+}
+
+static rt_ssize_t ram_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    rt_size_t i;
+
+    if (pos + size > BC_TC_SECTORS)
+        return 0;
+
+    rt_memcpy(ram[pos], buffer, size * 512);
+    for (i = 0; i < size; i ++)
+    {
+        if (ram_writes < BC_TC_SECTORS)
+            ram_order[ram_writes] = pos + i;
+        ram_writes ++;
+    }
+
+    return size;
+}
+
+static rt_err_t ram_control(rt_device_t dev, int cmd, void *args)
+{
+    struct rt_device_blk_geometry *geometry;
+
+    if (cmd == RT_DEVICE_CTRL_BLK_GETGEOME)
+    {
+        geometry = (struct rt_device_blk_geometry *)args;
+        geometry->bytes_per_sector = 512;
+        geometry->block_size = 512;
+        geometry->sector_count = BC_TC_SECTORS;
+    }
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops ram_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    ram_read,
+    ram_write,
+    ram_control
+};
+#endif
+
+static int bc_tc_read(rt_off_t sector)
+{
+    return rt_device_read(&cache->parent, sector, buf[0], 1) == 1 ? 0 : 1;
+}
+
+static void bc_tc_stat(struct rt_blk_cache_stat *stat)
+{
+    rt_device_control(&cache->parent, RT_DEVICE_CTRL_BLK_CACHE_STAT, stat);
+}
+
+static rt_err_t bc_tc_create(rt_uint8_t replace, rt_uint8_t write_mode)
+{
+    cache = rt_blk_cache_create(BC_TC_NAME, &ram_dev, BC_TC_CACHED, replace, write_mode);
+    if (cache == RT_NULL)
+        return -RT_ERROR;
+    ram_reads = ram_writes = 0;
+
+    return rt_device_open(&cache->parent, RT_DEVICE_OFLAG_RDWR);
+}
+
+static void bc_tc_delete(void)
+{
+    if (cache)
+    {
+        rt_device_close(&cache->parent);
+        rt_blk_cache_delete(cache);
+        cache = RT_NULL;
+    }
+}
+
+static rt_err_t bc_tc_init(void)
+{
+    int i;
+
+    for (i = 0; i < BC_TC_SECTORS; i ++)
+    {
+        rt_memset(ram[i], i, 512);
+    }
+
+    ram_dev.type = RT_Device_Class_Block;
+#ifdef RT_USING_DEVICE_OPS
+    ram_dev.ops = &ram_ops;
+#else
+    ram_dev.read = ram_read;
+    ram_dev.write = ram_write;
+    ram_dev.control = ram_control;
+#endif
+
+    return rt_device_register(&ram_dev, BC_TC_RAM, RT_DEVICE_FLAG_RDWR);
+}
+
+static rt_err_t bc_tc_cleanup(void)
+{
+    bc_tc_delete();
+    rt_device_unregister(&ram_dev);
+
+    return RT_EOK;
+}
+
+static void blk_cache_hit(void)
+{
+    struct rt_blk_cache_stat stat;
+    int i, bad = 0;
+
+    uassert_int_equal(bc_tc_create(RT_BLK_CACHE_LRU, RT_BLK_CACHE_WRITE_BACK), RT_EOK);
+    if (cache == RT_NULL)
+        return;
+
+    for (i = 0; i < 4; i ++)
+        bad += bc_tc_read(i);
+    uassert_int_equal(ram_reads, 4);
+
+    /* the second time nothing reaches the device */
+    for (i = 0; i < 4; i ++)
+    {
+        bad += bc_tc_read(i);
+        if (buf[0][0] != i || buf[0][511] != i)
+            bad ++;
+    }
+    uassert_int_equal(ram_reads, 4);
+
+    bc_tc_stat(&stat);
+    uassert_int_equal(stat.read_misses, 4);
+    uassert_int_equal(stat.read_hits, 4);
+    uassert_int_equal(bad, 0);
+
+    bc_tc_delete();
+}
+
+static void blk_cache_lru(void)
+{
+    struct rt_blk_cache_stat stat;
+    int i, bad = 0;
+
+    uassert_int_equal(bc_tc_create(RT_BLK_CACHE_LRU, RT_BLK_CACHE_WRITE_BACK), RT_EOK);
+    if (cache == RT_NULL)
+        return;
+
+    for (i = 0; i < BC_TC_CACHED; i ++)
+        bad += bc_tc_read(i);
+
+    /* sector 0 is used again, so sector 1 is the oldest when 8 comes in */
+    bad += bc_tc_read(0);
+    bad += bc_tc_read(BC_TC_CACHED);
+    ram_reads = 0;
+    bad += bc_tc_read(0);
+    uassert_int_equal(ram_reads, 0);
+    bad += bc_tc_read(1);
+    uassert_int_equal(ram_reads, 1);
+
+    bc_tc_stat(&stat);
+    uassert_int_equal(stat.evictions >= 1, 1);
+    uassert_int_equal(bad, 0);
+
+    bc_tc_delete();
+}
+
+static void blk_cache_bypass(void)
+{
+    struct rt_blk_cache_stat stat;
+
+    uassert_int_equal(bc_tc_create(RT_BLK_CACHE_2Q, RT_BLK_CACHE_WRITE_BACK), RT_EOK);
+    if (cache == RT_NULL)
+        return;
+
+    /* a read of half the cache or more is not kept */
+    uassert_int_equal(rt_device_read(&cache->parent, 32, buf, BC_TC_CACHED), BC_TC_CACHED);
+    uassert_int_equal(buf[BC_TC_CACHED - 1][0], 32 + BC_TC_CACHED - 1);
+    uassert_int_equal(bc_tc_read(32), 0);
+
+    bc_tc_stat(&stat);
+    uassert_int_equal(stat.read_hits, 0);
+    uassert_int_equal(stat.read_misses, BC_TC_CACHED + 1);
+
+    bc_tc_delete();
+}
+
+static void blk_cache_writeback(void)
+{
+    static const rt_off_t sectors[] = {20, 12, 15};
+    struct rt_blk_cache_stat stat;
+    int i, bad = 0;
+
+    uassert_int_equal(bc_tc_create(RT_BLK_CACHE_LRU, RT_BLK_CACHE_WRITE_BACK), RT_EOK);
+    if (cache == RT_NULL)
+        return;
+
+    for (i = 0; i < 3; i ++)
+    {
+        rt_memset(buf[0], 0xa0 + i, 512);
+        if (rt_device_write(&cache->parent, sectors[i], buf[0], 1) != 1)
+            bad ++;
+    }
+    uassert_int_equal(ram_writes, 0);
+    uassert_int_equal(ram[12][0], 12);
+
+    /* read back from the cache before it reached the device */
+    bad += bc_tc_read(12);
+    uassert_int_equal(buf[0][0], 0xa1);
+    uassert_int_equal(ram_reads, 0);
+
+    uassert_int_equal(rt_device_control(&cache->parent, RT_DEVICE_CTRL_BLK_SYNC, RT_NULL), RT_EOK);
+    uassert_int_equal(ram_writes, 3);
+    uassert_int_equal(ram_order[0], 12);
+    uassert_int_equal(ram_order[1], 15);
+    uassert_int_equal(ram_order[2], 20);
+    uassert_int_equal(ram[20][0], 0xa0);
+    uassert_int_equal(ram[12][511], 0xa1);
+    uassert_int_equal(ram[15][0], 0xa2);
+
+    /* clean now, a second sync writes nothing */
+    uassert_int_equal(rt_device_control(&cache->parent, RT_DEVICE_CTRL_BLK_SYNC, RT_NULL), RT_EOK);
+    uassert_int_equal(ram_writes, 3);
+
+    bc_tc_stat(&stat);
+    uassert_int_equal(stat.writebacks, 3);
+    uassert_int_equal(stat.write_misses, 3);
+    uassert_int_equal(bad, 0);
+
+    bc_tc_delete();
+}
+
+static void blk_cache_evict_dirty(void)
+{
+    int i, bad = 0;
+
+    uassert_int_equal(bc_tc_create(RT_BLK_CACHE_LRU, RT_BLK_CACHE_WRITE_BACK), RT_EOK);
+    if (cache == RT_NULL)
+        return;
+
+    /* the dirty sector is written back when it is pushed out */
+    rt_memset(buf[0], 0x5a, 512);
+    bad += rt_device_write(&cache->parent, 40, buf[0], 1) == 1 ? 0 : 1;
+    for (i = 0; i < BC_TC_CACHED; i ++)
+        bad += bc_tc_read(i);
+    uassert_int_equal(ram_writes, 1);
+    uassert_int_equal(ram[40][0], 0x5a);
+    uassert_int_equal(bad, 0);
+
+    bc_tc_delete();
+}
+
+static void blk_cache_through(void)
+{
+    uassert_int_equal(bc_tc_create(RT_BLK_CACHE_LRU, RT_BLK_CACHE_WRITE_THROUGH), RT_EOK);
+    if (cache == RT_NULL)
+        return;
+
+    rt_memset(buf[0], 0x3c, 512);
+    uassert_int_equal(rt_device_write(&cache->parent, 50, buf[0], 1), 1);
+    uassert_int_equal(ram_writes, 1);
+    uassert_int_equal(ram[50][0], 0x3c);
+
+    /* and the written sector is kept for the next read */
+    uassert_int_equal(bc_tc_read(50), 0);
+    uassert_int_equal(ram_reads, 0);
+
+    bc_tc_delete();
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(blk_cache_hit);
+    UTEST_UNIT_RUN(blk_cache_lru);
+    UTEST_UNIT_RUN(blk_cache_bypass);
+    UTEST_UNIT_RUN(blk_cache_writeback);
+    UTEST_UNIT_RUN(blk_cache_evict_dirty);
+    UTEST_UNIT_RUN(blk_cache_through);
+}
+UTEST_TC_EXPORT(testcase, "testcases.drivers.blk_cache", bc_tc_init, bc_tc_cleanup, 30);
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author        Notes
  * 2011-07-25     weety     first version
+ * 2026-10-17     RT-Thread first version of request queue, CMD23 multi-block
+ * 2026-10-17     RT-Thread finish requests in a second stage, two batches in flight
  */
 
 #include <rtthread.h>
@@ -29,6 +31,59 @@ static rt_list_t blk_devices = RT_LIST_OBJECT_INIT(blk_devices);
 #define RT_DEVICE_CTRL_BLK_SSIZEGET      0x1268                                     /**< get number of bytes per sector */
 #define RT_DEVICE_CTRL_ALL_BLK_SSIZEGET  0x80081272                                 /**< get number of bytes per sector * sector counts*/
 
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+static rt_list_t blk_queues = RT_LIST_OBJECT_INIT(blk_queues);
+
+#ifndef RT_MMCSD_BLK_QUEUE_STACK_SIZE
+#define RT_MMCSD_BLK_QUEUE_STACK_SIZE   1024
+#endif
+#ifndef RT_MMCSD_BLK_QUEUE_PRIORITY
+#define RT_MMCSD_BLK_QUEUE_PRIORITY     21
+#endif
+#ifndef RT_MMCSD_BLK_QUEUE_MERGE_MAX
+#define RT_MMCSD_BLK_QUEUE_MERGE_MAX    16
+#endif
+/* how many queued requests a new one may overtake when sorted in */
+#define BLK_QUEUE_SORT_DEPTH            8
+
+/* requests sent as one transfer */
+struct mmcsd_blk_batch
+{
+    rt_list_t reqs;
+    rt_list_t node;                 /* in the free or the done list */
+    rt_uint8_t *bounce;             /* buffer for merged requests */
+    rt_err_t err;
+};
+
+/*
+ * one request queue per card, shared by all its partitions. The queue
+ * thread only drives the bus, the done thread copies merged reads out
+ * and runs the callbacks meanwhile, so two batches are in flight.
+ */
+struct mmcsd_blk_queue
+{
+    struct rt_mmcsd_card *card;
+    rt_list_t list;                 /* node in blk_queues */
+    rt_list_t reqs;                 /* pending requests */
+    struct rt_spinlock lock;
+    struct rt_semaphore sem;        /* pending request count */
+    struct rt_completion exit;
+    rt_thread_t thread;
+    rt_bool_t quit;
+    rt_size_t max_req_size;
+    rt_uint8_t *bounce;             /* one half per batch */
+    rt_size_t bounce_blks;
+    struct mmcsd_blk_batch batch[2];
+    rt_list_t frees;                /* batches for the queue thread */
+    rt_list_t dones;                /* batches for the done thread */
+    struct rt_semaphore free_sem;
+    struct rt_semaphore done_sem;
+    struct rt_completion done_exit;
+    rt_thread_t done_thread;
+    rt_bool_t done_quit;
+};
+#endif /* RT_MMCSD_USING_BLK_QUEUE */
+
 struct mmcsd_blk_device
 {
     struct rt_mmcsd_card *card;
@@ -37,6 +92,9 @@ struct mmcsd_blk_device
     struct dfs_partition part;
     struct rt_device_blk_geometry geometry;
     rt_size_t max_req_size;
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+    struct mmcsd_blk_queue *queue;
+#endif
 };
 
 #ifndef RT_MMCSD_MAX_PARTITION
@@ -165,13 +223,23 @@ rt_int32_t mmcsd_num_wr_blocks(struct rt_mmcsd_card *card)
     return blocks;
 }
 
+/* pre-defined block count (CMD23) needs both the host and the card to support it */
+static rt_bool_t card_use_sbc(struct rt_mmcsd_card *card)
+{
+    if (controller_is_spi(card->host) || !(card->host->flags & MMCSD_SUP_CMD23))
+        return RT_FALSE;
+
+    return (card->card_type == CARD_TYPE_SD &&
+            (card->scr.cmd_support & SD_SCR_CMD23_SUPPORT)) ? RT_TRUE : RT_FALSE;
+}
+
 static rt_err_t rt_mmcsd_req_blk(struct rt_mmcsd_card *card,
                                  rt_uint32_t           sector,
                                  void                 *buf,
                                  rt_size_t             blks,
                                  rt_uint8_t            dir)
 {
-    struct rt_mmcsd_cmd  cmd, stop;
+    struct rt_mmcsd_cmd  cmd, stop, sbc;
     struct rt_mmcsd_data  data;
     struct rt_mmcsd_req  req;
     struct rt_mmcsd_host *host = card->host;
@@ -181,6 +249,7 @@ static rt_err_t rt_mmcsd_req_blk(struct rt_mmcsd_card *card,
     rt_memset(&req, 0, sizeof(struct rt_mmcsd_req));
     rt_memset(&cmd, 0, sizeof(struct rt_mmcsd_cmd));
     rt_memset(&stop, 0, sizeof(struct rt_mmcsd_cmd));
+    rt_memset(&sbc, 0, sizeof(struct rt_mmcsd_cmd));
     rt_memset(&data, 0, sizeof(struct rt_mmcsd_data));
     req.cmd = &cmd;
     req.data = &data;
@@ -195,9 +264,27 @@ static rt_err_t rt_mmcsd_req_blk(struct rt_mmcsd_card *card,
     data.blksize = SECTOR_SIZE;
     data.blks  = blks;
 
+    if (!controller_is_spi(card->host) && (card->flags & 0x8000))
+    {
+        /* last request is WRITE,need check busy */
+        card_busy_detect(card, 10000, RT_NULL);
+    }
+
     if (blks > 1)
     {
-        if (!controller_is_spi(card->host) || !dir)
+        if (card_use_sbc(card))
+        {
+            /* the card ends the transfer by itself, no STOP_TRANSMISSION */
+            sbc.cmd_code = SET_BLOCK_COUNT;
+            sbc.arg = blks;
+            sbc.flags = RESP_R1 | CMD_AC;
+            if (mmcsd_send_cmd(host, &sbc, 0) != RT_EOK)
+            {
+                LOG_W("mmcsd set block count error, fall back to stop");
+                sbc.cmd_code = 0;
+            }
+        }
+        if (sbc.cmd_code == 0 && (!controller_is_spi(card->host) || !dir))
         {
             req.stop = &stop;
             stop.cmd_code = STOP_TRANSMISSION;
@@ -214,12 +301,6 @@ static rt_err_t rt_mmcsd_req_blk(struct rt_mmcsd_card *card,
         w_cmd = WRITE_BLOCK;
     }
 
-    if (!controller_is_spi(card->host) && (card->flags & 0x8000))
-    {
-        /* last request is WRITE,need check busy */
-        card_busy_detect(card, 10000, RT_NULL);
-    }
-
     if (!dir)
     {
         cmd.cmd_code = r_cmd;
@@ -238,6 +319,16 @@ static rt_err_t rt_mmcsd_req_blk(struct rt_mmcsd_card *card,
 
     mmcsd_send_request(host, &req);
 
+    if (sbc.cmd_code != 0 && (cmd.err || data.err))
+    {
+        /* the transfer did not end by the count, take the card out of the data state */
+        stop.cmd_code = STOP_TRANSMISSION;
+        stop.arg = 0;
+        stop.flags = RESP_R1B | CMD_AC;
+        stop.err = 0;
+        mmcsd_send_cmd(host, &stop, 0);
+    }
+
     mmcsd_host_unlock(host);
 
     if (cmd.err || data.err || stop.err)
@@ -294,6 +385,383 @@ static rt_err_t rt_mmcsd_control(rt_device_t dev, int cmd, void *args)
     return RT_EOK;
 }
 
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+/* issue sector range of any length, split by max_req_size */
+static rt_err_t blk_queue_xfer(struct mmcsd_blk_queue *queue, rt_uint32_t lba,
+                               void *buf, rt_size_t blks, rt_uint8_t dir)
+{
+    rt_err_t err = RT_EOK;
+    rt_size_t req_size;
+
+    while (blks)
+    {
+        req_size = (blks > queue->max_req_size) ? queue->max_req_size : blks;
+        err = rt_mmcsd_req_blk(queue->card, lba, buf, req_size, dir);
+        if (err)
+            break;
+        lba += req_size;
+        buf = (void *)((rt_uint8_t *)buf + (req_size << 9));
+        blks -= req_size;
+    }
+
+    return err;
+}
+
+/* take the head request and every queued one that continues it */
+static rt_size_t blk_queue_fetch(struct mmcsd_blk_queue *queue, rt_list_t *batch)
+{
+    struct rt_mmcsd_blk_req *req, *next;
+    rt_size_t blks = 0;
+
+    rt_spin_lock(&queue->lock);
+    if (!rt_list_isempty(&queue->reqs))
+    {
+        req = rt_list_first_entry(&queue->reqs, struct rt_mmcsd_blk_req, list);
+        rt_list_remove(&req->list);
+        rt_list_insert_before(batch, &req->list);
+        blks = req->blks;
+
+        while (!rt_list_isempty(&queue->reqs) && blks <= queue->bounce_blks)
+        {
+            next = rt_list_first_entry(&queue->reqs, struct rt_mmcsd_blk_req, list);
+            if (next->dir != req->dir || next->lba != req->lba + req->blks ||
+                blks + next->blks > queue->bounce_blks)
+            {
+                break;
+            }
+            /* the merged request no longer needs its own wakeup */
+            if (rt_sem_trytake(&queue->sem) != RT_EOK)
+            {
+                break;
+            }
+            rt_list_remove(&next->list);
+            rt_list_insert_before(batch, &next->list);
+            blks += next->blks;
+            req = next;
+        }
+    }
+    rt_spin_unlock(&queue->lock);
+
+    return blks;
+}
+
+static struct mmcsd_blk_batch *blk_batch_pop(struct mmcsd_blk_queue *queue, rt_list_t *list)
+{
+    struct mmcsd_blk_batch *batch = RT_NULL;
+
+    rt_spin_lock(&queue->lock);
+    if (!rt_list_isempty(list))
+    {
+        batch = rt_list_first_entry(list, struct mmcsd_blk_batch, node);
+        rt_list_remove(&batch->node);
+    }
+    rt_spin_unlock(&queue->lock);
+
+    return batch;
+}
+
+static void blk_batch_push(struct mmcsd_blk_queue *queue, rt_list_t *list,
+                           struct mmcsd_blk_batch *batch, struct rt_semaphore *sem)
+{
+    rt_spin_lock(&queue->lock);
+    rt_list_insert_before(list, &batch->node);
+    rt_spin_unlock(&queue->lock);
+
+    rt_sem_release(sem);
+}
+
+static void blk_queue_entry(void *parameter)
+{
+    struct mmcsd_blk_queue *queue = (struct mmcsd_blk_queue *)parameter;
+    struct mmcsd_blk_batch *batch;
+    struct rt_mmcsd_blk_req *req, *first;
+    rt_size_t blks;
+    rt_uint8_t *ptr;
+
+    while (1)
+    {
+        rt_sem_take(&queue->sem, RT_WAITING_FOREVER);
+        if (queue->quit)
+            break;
+
+        /* wait for the done thread when both batches are in flight */
+        rt_sem_take(&queue->free_sem, RT_WAITING_FOREVER);
+        batch = blk_batch_pop(queue, &queue->frees);
+        RT_ASSERT(batch != RT_NULL);
+
+        rt_list_init(&batch->reqs);
+        blks = blk_queue_fetch(queue, &batch->reqs);
+        if (blks == 0)
+        {
+            blk_batch_push(queue, &queue->frees, batch, &queue->free_sem);
+            continue;
+        }
+
+        first = rt_list_first_entry(&batch->reqs, struct rt_mmcsd_blk_req, list);
+        if (first->list.next == &batch->reqs)
+        {
+            /* single request, straight into the caller's buffer */
+            batch->err = blk_queue_xfer(queue, first->lba, first->buf, first->blks, first->dir);
+        }
+        else
+        {
+            /* adjacent requests go out as one multi-block transfer */
+            if (first->dir)
+            {
+                ptr = batch->bounce;
+                rt_list_for_each_entry(req, &batch->reqs, list)
+                {
+                    rt_memcpy(ptr, req->buf, req->blks << 9);
+                    ptr += req->blks << 9;
+                }
+            }
+            batch->err = blk_queue_xfer(queue, first->lba, batch->bounce, blks, first->dir);
+        }
+
+        blk_batch_push(queue, &queue->dones, batch, &queue->done_sem);
+    }
+
+    rt_completion_done(&queue->exit);
+}
+
+static void blk_queue_done_entry(void *parameter)
+{
+    struct mmcsd_blk_queue *queue = (struct mmcsd_blk_queue *)parameter;
+    struct mmcsd_blk_batch *batch;
+    struct rt_mmcsd_blk_req *req, *first, *n;
+    rt_uint8_t *ptr;
+
+    while (1)
+    {
+        rt_sem_take(&queue->done_sem, RT_WAITING_FOREVER);
+        batch = blk_batch_pop(queue, &queue->dones);
+        if (batch == RT_NULL)
+        {
+            if (queue->done_quit)
+                break;
+            continue;
+        }
+
+        first = rt_list_first_entry(&batch->reqs, struct rt_mmcsd_blk_req, list);
+        if (!first->dir && first->list.next != &batch->reqs && batch->err == RT_EOK)
+        {
+            ptr = batch->bounce;
+            rt_list_for_each_entry(req, &batch->reqs, list)
+            {
+                rt_memcpy(req->buf, ptr, req->blks << 9);
+                ptr += req->blks << 9;
+            }
+        }
+
+        rt_list_for_each_entry_safe(req, n, &batch->reqs, list)
+        {
+            rt_list_remove(&req->list);
+            req->err = batch->err;
+            if (req->done)
+                req->done(req);
+        }
+
+        blk_batch_push(queue, &queue->frees, batch, &queue->free_sem);
+    }
+
+    rt_completion_done(&queue->done_exit);
+}
+
+static struct mmcsd_blk_queue *blk_queue_get(struct rt_mmcsd_card *card)
+{
+    struct mmcsd_blk_queue *queue;
+    char name[RT_NAME_MAX];
+    int i;
+
+    rt_list_for_each_entry(queue, &blk_queues, list)
+    {
+        if (queue->card == card)
+            return queue;
+    }
+
+    queue = rt_calloc(1, sizeof(struct mmcsd_blk_queue));
+    if (queue == RT_NULL)
+        return RT_NULL;
+
+    queue->card = card;
+    queue->max_req_size = BLK_MIN((card->host->max_dma_segs *
+                                   card->host->max_seg_size) >> 9,
+                                  (card->host->max_blk_count *
+                                   card->host->max_blk_size) >> 9);
+    queue->bounce_blks = BLK_MIN(RT_MMCSD_BLK_QUEUE_MERGE_MAX, queue->max_req_size);
+    queue->bounce = rt_malloc_align((queue->bounce_blks << 9) * 2, RT_ALIGN_SIZE);
+    if (queue->bounce == RT_NULL)
+    {
+        rt_free(queue);
+        return RT_NULL;
+    }
+    rt_list_init(&queue->reqs);
+    rt_list_init(&queue->frees);
+    rt_list_init(&queue->dones);
+    for (i = 0; i < 2; i ++)
+    {
+        queue->batch[i].bounce = queue->bounce + (queue->bounce_blks << 9) * i;
+        rt_list_insert_before(&queue->frees, &queue->batch[i].node);
+    }
+    rt_spin_lock_init(&queue->lock);
+    rt_completion_init(&queue->exit);
+    rt_completion_init(&queue->done_exit);
+    rt_snprintf(name, sizeof(name), "blkq_%s", card->host->name);
+    rt_sem_init(&queue->sem, name, 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&queue->free_sem, name, 2, RT_IPC_FLAG_FIFO);
+    queue->thread = rt_thread_create(name, blk_queue_entry, queue,
+                                     RT_MMCSD_BLK_QUEUE_STACK_SIZE,
+                                     RT_MMCSD_BLK_QUEUE_PRIORITY, 20);
+
+    rt_snprintf(name, sizeof(name), "blkd_%s", card->host->name);
+    rt_sem_init(&queue->done_sem, name, 0, RT_IPC_FLAG_FIFO);
+    queue->done_thread = rt_thread_create(name, blk_queue_done_entry, queue,
+                                          RT_MMCSD_BLK_QUEUE_STACK_SIZE,
+                                          RT_MMCSD_BLK_QUEUE_PRIORITY, 20);
+    if (queue->thread == RT_NULL || queue->done_thread == RT_NULL)
+    {
+        if (queue->thread)
+            rt_thread_delete(queue->thread);
+        if (queue->done_thread)
+            rt_thread_delete(queue->done_thread);
+        rt_sem_detach(&queue->sem);
+        rt_sem_detach(&queue->free_sem);
+        rt_sem_detach(&queue->done_sem);
+        rt_free_align(queue->bounce);
+        rt_free(queue);
+        return RT_NULL;
+    }
+    rt_list_insert_after(&blk_queues, &queue->list);
+    rt_thread_startup(queue->thread);
+    rt_thread_startup(queue->done_thread);
+
+    return queue;
+}
+
+static void blk_queue_put(struct rt_mmcsd_card *card)
+{
+    struct mmcsd_blk_queue *queue, *n;
+    struct rt_mmcsd_blk_req *req, *r;
+
+    rt_list_for_each_entry_safe(queue, n, &blk_queues, list)
+    {
+        if (queue->card != card)
+            continue;
+
+        queue->quit = RT_TRUE;
+        rt_sem_release(&queue->sem);
+        rt_completion_wait(&queue->exit, RT_WAITING_FOREVER);
+
+        /* the done thread finishes the batches in flight first */
+        queue->done_quit = RT_TRUE;
+        rt_sem_release(&queue->done_sem);
+        rt_completion_wait(&queue->done_exit, RT_WAITING_FOREVER);
+
+        /* the card is gone, fail what is still pending */
+        rt_list_for_each_entry_safe(req, r, &queue->reqs, list)
+        {
+            rt_list_remove(&req->list);
+            req->err = -RT_EIO;
+            if (req->done)
+                req->done(req);
+        }
+
+        rt_list_remove(&queue->list);
+        rt_sem_detach(&queue->sem);
+        rt_sem_detach(&queue->free_sem);
+        rt_sem_detach(&queue->done_sem);
+        rt_free_align(queue->bounce);
+        rt_free(queue);
+    }
+}
+
+/**
+ * This function queues a sector request on a mmcsd block device. Requests
+ * are sorted by sector and adjacent ones of the same direction are merged
+ * into one multi-block transfer. req->done is called from the done thread
+ * of the queue once the request is finished, while the next transfer runs.
+ *
+ * @param dev the mmcsd block device.
+ * @param req the request, it must stay valid until done is called.
+ *
+ * @return RT_EOK on queued, or an error code.
+ */
+rt_err_t rt_mmcsd_blk_submit(rt_device_t dev, struct rt_mmcsd_blk_req *req)
+{
+    struct mmcsd_blk_device *blk_dev;
+    struct mmcsd_blk_queue *queue;
+    struct rt_mmcsd_blk_req *prev;
+    rt_list_t *pos;
+    int depth = 0;
+
+    if (dev == RT_NULL || req == RT_NULL || req->blks == 0)
+        return -RT_EINVAL;
+
+    blk_dev = (struct mmcsd_blk_device *)dev->user_data;
+    queue = blk_dev->queue;
+    if (queue == RT_NULL || queue->quit)
+        return -RT_EIO;
+
+    if (blk_dev->part.size && req->sector + req->blks > blk_dev->part.size)
+        return -RT_EINVAL;
+
+    req->lba = blk_dev->part.offset + req->sector;
+    req->err = RT_EOK;
+
+    rt_spin_lock(&queue->lock);
+    /*
+     * sort by sector, but never move across a request that overlaps this
+     * one, so a read always sees the writes queued before it.
+     */
+    pos = queue->reqs.prev;
+    while (pos != &queue->reqs && depth < BLK_QUEUE_SORT_DEPTH)
+    {
+        prev = rt_list_entry(pos, struct rt_mmcsd_blk_req, list);
+        if (prev->lba <= req->lba || prev->lba < req->lba + req->blks)
+            break;
+        pos = pos->prev;
+        depth ++;
+    }
+    rt_list_insert_after(pos, &req->list);
+    rt_spin_unlock(&queue->lock);
+
+    rt_sem_release(&queue->sem);
+
+    return RT_EOK;
+}
+
+static void blk_queue_sync_done(struct rt_mmcsd_blk_req *req)
+{
+    rt_completion_done((struct rt_completion *)req->user_data);
+}
+
+static rt_err_t blk_queue_sync(rt_device_t dev, rt_off_t pos, void *buf,
+                               rt_size_t size, rt_uint8_t dir)
+{
+    struct rt_mmcsd_blk_req req;
+    struct rt_completion comp;
+    rt_err_t err;
+
+    rt_completion_init(&comp);
+    rt_memset(&req, 0, sizeof(req));
+    req.sector = pos;
+    req.buf = buf;
+    req.blks = size;
+    req.dir = dir;
+    req.done = blk_queue_sync_done;
+    req.user_data = &comp;
+
+    err = rt_mmcsd_blk_submit(dev, &req);
+    if (err == RT_EOK)
+    {
+        rt_completion_wait(&comp, RT_WAITING_FOREVER);
+        err = req.err;
+    }
+
+    return err;
+}
+#endif /* RT_MMCSD_USING_BLK_QUEUE */
+
 static rt_ssize_t rt_mmcsd_read(rt_device_t dev,
                                rt_off_t    pos,
                                void       *buffer,
@@ -313,6 +781,18 @@ static rt_ssize_t rt_mmcsd_read(rt_device_t dev,
         return 0;
     }
 
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+    if (blk_dev->queue)
+    {
+        if (blk_queue_sync(dev, pos, buffer, size, 0) != RT_EOK)
+        {
+            rt_set_errno(-EIO);
+            return 0;
+        }
+        return size;
+    }
+#endif
+
     rt_sem_take(part->lock, RT_WAITING_FOREVER);
     while (remain_size)
     {
@@ -354,6 +834,18 @@ static rt_ssize_t rt_mmcsd_write(rt_device_t dev,
         return 0;
     }
 
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+    if (blk_dev->queue)
+    {
+        if (blk_queue_sync(dev, pos, (void *)buffer, size, 1) != RT_EOK)
+        {
+            rt_set_errno(-EIO);
+            return 0;
+        }
+        return size;
+    }
+#endif
+
     rt_sem_take(part->lock, RT_WAITING_FOREVER);
     while (remain_size)
     {
@@ -670,6 +1162,9 @@ rt_int32_t gpt_device_probe(struct rt_mmcsd_card *card)
     blk_dev->dev.control = rt_mmcsd_control;
 #endif
     blk_dev->card = card;
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+    blk_dev->queue = blk_queue_get(card);
+#endif
 
     blk_dev->geometry.bytes_per_sector = 1 << 9;
     blk_dev->geometry.block_size = card->card_blksize;
@@ -721,6 +1216,9 @@ rt_int32_t gpt_device_probe(struct rt_mmcsd_card *card)
             blk_dev->dev.control = rt_mmcsd_control;
 #endif
             blk_dev->card = card;
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+            blk_dev->queue = blk_queue_get(card);
+#endif
 
             blk_dev->geometry.bytes_per_sector = 1 << 9;
             blk_dev->geometry.block_size = card->card_blksize;
@@ -812,6 +1310,9 @@ rt_int32_t mbr_device_probe(struct rt_mmcsd_card *card)
         blk_dev->dev.control = rt_mmcsd_control;
 #endif
         blk_dev->card = card;
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+        blk_dev->queue = blk_queue_get(card);
+#endif
 
         blk_dev->geometry.bytes_per_sector = 1 << 9;
         blk_dev->geometry.block_size = card->card_blksize;
@@ -857,6 +1358,9 @@ rt_int32_t mbr_device_probe(struct rt_mmcsd_card *card)
                 blk_dev->dev.control = rt_mmcsd_control;
 #endif
                 blk_dev->card = card;
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+                blk_dev->queue = blk_queue_get(card);
+#endif
 
                 blk_dev->geometry.bytes_per_sector = 1 << 9;
                 blk_dev->geometry.block_size = card->card_blksize;
@@ -937,6 +1441,9 @@ void rt_mmcsd_blk_remove(struct rt_mmcsd_card *card)
             rt_free(blk_dev);
         }
     }
+#ifdef RT_MMCSD_USING_BLK_QUEUE
+    blk_queue_put(card);
+#endif
 }
 
 /*
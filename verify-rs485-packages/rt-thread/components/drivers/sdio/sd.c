@@ -144,6 +144,8 @@ static rt_int32_t mmcsd_parse_scr(struct rt_mmcsd_card *card)
     resp[2] = card->resp_scr[0];
     scr->sd_version = GET_BITS(resp, 56, 4);
     scr->sd_bus_widths = GET_BITS(resp, 48, 4);
+    if (scr->sd_version >= SCR_SPEC_VER_2)
+        scr->cmd_support = GET_BITS(resp, 32, 2);
 
     return 0;
 }
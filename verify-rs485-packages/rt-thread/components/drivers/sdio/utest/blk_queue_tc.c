@@ -0,0 +1,330 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <drivers/mmcsd_core.h>
+#include "utest.h"
+
+/*
+ * Runs the mmcsd request queue against a host that keeps the card in RAM.
+ * Adjacent requests queued together, also out of order, must go out as
+ * one multi-block transfer that ends by a CMD23 block count, or by a
+ * CMD12 when the host can not do CMD23, and the data of every request
+ * must land at its own sector. Time the queue with:
+ *
+ *     utest_bench -n 20 testcases.drivers.sdio.blk_queue
+ */
+
+#define BLK_TC_NAME         "sdq"
+#define BLK_TC_SECTORS      128
+#define BLK_TC_REQS         8
+#define BLK_TC_TIMEOUT      (RT_TICK_PER_SECOND * 2)
+
+static rt_uint8_t ram[BLK_TC_SECTORS][512];
+static rt_uint8_t bufs[BLK_TC_REQS][512];
+static struct rt_mmcsd_blk_req reqs[BLK_TC_REQS];
+static struct rt_semaphore done_sem;
+static struct rt_mmcsd_host *host;
+static struct rt_mmcsd_card *card;
+static rt_device_t dev;
+
+/* what the host saw */
+static int n_single, n_multi, n_sbc, n_stop, max_blks;
+
+static void blk_tc_request(struct rt_mmcsd_host *host, struct rt_mmcsd_req *req)
+{
+    struct rt_mmcsd_cmd *cmd = req->cmd;
+    struct rt_mmcsd_data *data = req->data;
+    rt_size_t len;
+
+    switch (cmd->cmd_code)
+    {
+    case SEND_STATUS:
+        /* ready, in the transfer state */
+        cmd->resp[0] = R1_READY_FOR_DATA | (4 << 9);
+        break;
+    case SET_BLOCK_COUNT:
+        n_sbc ++;
+        break;
+    case STOP_TRANSMISSION:
+        n_stop ++;
+        break;
+    case READ_SINGLE_BLOCK:
+    case READ_MULTIPLE_BLOCK:
+    case WRITE_BLOCK:
+    case WRITE_MULTIPLE_BLOCK:
+        if (data == RT_NULL || cmd->arg + data->blks > BLK_TC_SECTORS)
+        {
+            cmd->err = -RT_ERROR;
+            break;
+        }
+        len = data->blks * data->blksize;
+        if (data->flags & DATA_DIR_READ)
+            rt_memcpy(data->buf, ram[cmd->arg], len);
+        else
+            rt_memcpy(ram[cmd->arg], data->buf, len);
+
+        if (data->blks > 1)
+            n_multi ++;
+        else
+            n_single ++;
+        if ((int)data->blks > max_blks)
+            max_blks = data->blks;
+        if (req->stop)
+            n_stop ++;
+        break;
+    default:
+        break;
+    }
+
+    mmcsd_req_complete(host);
+}
+
+static const struct rt_mmcsd_host_ops blk_tc_ops =
+{
+    blk_tc_request,
+};
+
+static void blk_tc_done(struct rt_mmcsd_blk_req *req)
+{
+    rt_sem_release(&done_sem);
+}
+
+static void blk_tc_reset(void)
+{
+    n_single = n_multi = n_sbc = n_stop = max_blks = 0;
+}
+
+/* queue the requests at once so they meet in the queue, wait for all */
+static int blk_tc_submit(const rt_uint32_t *sectors, int count, rt_uint8_t dir)
+{
+    int i, bad = 0;
+
+    rt_enter_critical();
+    for (i = 0; i < count; i++)
+    {
+        rt_memset(&reqs[i], 0, sizeof(reqs[i]));
+        reqs[i].sector = sectors[i];
+        reqs[i].buf = bufs[i];
+        reqs[i].blks = 1;
+        reqs[i].dir = dir;
+        reqs[i].done = blk_tc_done;
+        if (rt_mmcsd_blk_submit(dev, &reqs[i]) != RT_EOK)
+            bad ++;
+    }
+    rt_exit_critical();
+
+    for (i = 0; i < count - bad; i++)
+    {
+        if (rt_sem_take(&done_sem, BLK_TC_TIMEOUT) != RT_EOK)
+            return -1;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (reqs[i].err != RT_EOK)
+            bad ++;
+    }
+
+    return bad;
+}
+
+static rt_err_t blk_tc_init(void)
+{
+    rt_memset(ram, 0, sizeof(ram));
+    rt_sem_init(&done_sem, "blk_tc", 0, RT_IPC_FLAG_FIFO);
+
+    host = mmcsd_alloc_host();
+    card = rt_calloc(1, sizeof(struct rt_mmcsd_card));
+    if (host == RT_NULL || card == RT_NULL)
+        return -RT_ENOMEM;
+
+    rt_strncpy(host->name, BLK_TC_NAME, sizeof(host->name) - 1);
+    host->ops = &blk_tc_ops;
+    host->flags = MMCSD_BUSWIDTH_4 | MMCSD_MUTBLKWRITE | MMCSD_SUP_CMD23;
+    host->io_cfg.clock = 25000000;
+    host->card = card;
+
+    card->host = host;
+    card->card_type = CARD_TYPE_SD;
+    card->flags = CARD_FLAG_SDHC;
+    card->scr.cmd_support = SD_SCR_CMD23_SUPPORT;
+    card->card_capacity = BLK_TC_SECTORS / 2;
+    card->card_blksize = 512;
+
+    if (rt_mmcsd_blk_probe(card) != RT_EOK)
+        return -RT_ERROR;
+    dev = rt_device_find(BLK_TC_NAME);
+
+    return dev ? RT_EOK : -RT_ERROR;
+}
+
+static rt_err_t blk_tc_cleanup(void)
+{
+    if (card)
+    {
+        rt_mmcsd_blk_remove(card);
+        rt_free(card);
+        card = RT_NULL;
+    }
+    if (host)
+    {
+        mmcsd_free_host(host);
+        host = RT_NULL;
+    }
+    dev = RT_NULL;
+    rt_sem_detach(&done_sem);
+
+    return RT_EOK;
+}
+
+/* adjacent writes queued backwards go out as one CMD23 transfer */
+static void blk_queue_merge(void)
+{
+    rt_uint32_t sectors[BLK_TC_REQS];
+    int i, j, bad = 0;
+
+    uassert_not_null(dev);
+    if (dev == RT_NULL)
+        return;
+
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        sectors[i] = 16 + BLK_TC_REQS - 1 - i;
+        rt_memset(bufs[i], 0x40 + sectors[i], 512);
+    }
+    blk_tc_reset();
+    uassert_int_equal(blk_tc_submit(sectors, BLK_TC_REQS, 1), 0);
+    uassert_int_equal(n_multi, 1);
+    uassert_int_equal(max_blks, BLK_TC_REQS);
+    uassert_int_equal(n_sbc, 1);
+    uassert_int_equal(n_stop, 0);
+
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        for (j = 0; j < 512; j++)
+        {
+            if (ram[16 + i][j] != (rt_uint8_t)(0x40 + 16 + i))
+            {
+                bad ++;
+                break;
+            }
+        }
+    }
+    uassert_int_equal(bad, 0);
+
+    /* and read back through one transfer into each request's buffer */
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        sectors[i] = 16 + i;
+        rt_memset(bufs[i], 0, 512);
+    }
+    blk_tc_reset();
+    uassert_int_equal(blk_tc_submit(sectors, BLK_TC_REQS, 0), 0);
+    uassert_int_equal(n_multi, 1);
+    uassert_int_equal(n_stop, 0);
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        if (bufs[i][0] != (rt_uint8_t)(0x40 + 16 + i) || bufs[i][511] != bufs[i][0])
+            bad ++;
+    }
+    uassert_int_equal(bad, 0);
+}
+
+/* without CMD23 on the host the transfer ends by a stop command */
+static void blk_queue_stop(void)
+{
+    rt_uint32_t sectors[BLK_TC_REQS];
+    int i;
+
+    uassert_not_null(dev);
+    if (dev == RT_NULL)
+        return;
+
+    host->flags &= ~MMCSD_SUP_CMD23;
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        sectors[i] = 48 + i;
+    }
+    blk_tc_reset();
+    uassert_int_equal(blk_tc_submit(sectors, BLK_TC_REQS, 0), 0);
+    host->flags |= MMCSD_SUP_CMD23;
+
+    uassert_int_equal(n_multi, 1);
+    uassert_int_equal(n_sbc, 0);
+    uassert_int_equal(n_stop, 1);
+}
+
+/* a write and a read of the same sector keep their order */
+static void blk_queue_order(void)
+{
+    rt_uint32_t sectors[2] = {64, 64};
+
+    uassert_not_null(dev);
+    if (dev == RT_NULL)
+        return;
+
+    rt_memset(ram[64], 0, 512);
+    rt_enter_critical();
+    rt_memset(&reqs[0], 0, sizeof(reqs[0]));
+    reqs[0].sector = sectors[0];
+    reqs[0].buf = bufs[0];
+    reqs[0].blks = 1;
+    reqs[0].dir = 1;
+    reqs[0].done = blk_tc_done;
+    rt_memset(bufs[0], 0xa5, 512);
+    rt_memset(&reqs[1], 0, sizeof(reqs[1]));
+    reqs[1].sector = sectors[1];
+    reqs[1].buf = bufs[1];
+    reqs[1].blks = 1;
+    reqs[1].dir = 0;
+    reqs[1].done = blk_tc_done;
+    rt_memset(bufs[1], 0, 512);
+    rt_mmcsd_blk_submit(dev, &reqs[0]);
+    rt_mmcsd_blk_submit(dev, &reqs[1]);
+    rt_exit_critical();
+
+    uassert_int_equal(rt_sem_take(&done_sem, BLK_TC_TIMEOUT), RT_EOK);
+    uassert_int_equal(rt_sem_take(&done_sem, BLK_TC_TIMEOUT), RT_EOK);
+    uassert_int_equal(bufs[1][0], 0xa5);
+    uassert_int_equal(bufs[1][511], 0xa5);
+}
+
+/* the device read and write calls go through the queue as well */
+static void blk_queue_sync(void)
+{
+    int i, bad = 0;
+
+    uassert_not_null(dev);
+    if (dev == RT_NULL)
+        return;
+
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        rt_memset(bufs[i], i + 1, 512);
+    }
+    uassert_int_equal(rt_device_write(dev, 96, bufs, BLK_TC_REQS), BLK_TC_REQS);
+    rt_memset(bufs, 0, sizeof(bufs));
+    uassert_int_equal(rt_device_read(dev, 96, bufs, BLK_TC_REQS), BLK_TC_REQS);
+    for (i = 0; i < BLK_TC_REQS; i++)
+    {
+        if (bufs[i][0] != i + 1 || ram[96 + i][511] != i + 1)
+            bad ++;
+    }
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(blk_queue_merge);
+    UTEST_UNIT_RUN(blk_queue_stop);
+    UTEST_UNIT_RUN(blk_queue_order);
+    UTEST_UNIT_RUN(blk_queue_sync);
+}
+UTEST_TC_EXPORT(testcase, "testcases.drivers.sdio.blk_queue", blk_tc_init, blk_tc_cleanup, 30);
@@ -27,6 +27,7 @@
  * 2020-12-14     Meco Man     implement function of setting window's size(TIOCSWINSZ)
  * 2021-08-22     Meco Man     implement function of getting window's size(TIOCGWINSZ)
  * 2023-09-15     xqyjlj       perf rt_hw_interrupt_disable/enable
+ * 2026-10-17     RT-Thread    add the interrupt tx ring buffer
  */
 
 #include <rthw.h>
@@ -338,6 +339,126 @@ rt_inline int _serial_int_rx(struct rt_serial_device *serial, rt_uint8_t *data,
     return size - length;
 }
 
+#ifdef RT_SERIAL_USING_TX_RB
+/* tell the upper layer that everything written is out */
+rt_inline void _serial_tx_notify(struct rt_serial_device *serial)
+{
+    if (serial->parent.tx_complete != RT_NULL)
+    {
+        serial->parent.tx_complete(&serial->parent, RT_NULL);
+    }
+}
+
+/*
+ * wait until the fifo is empty and its last byte is out, give up when the
+ * uart takes nothing for a while
+ */
+static void _serial_tx_drain(struct rt_serial_device *serial, struct rt_serial_tx_fifo *tx)
+{
+    rt_base_t level;
+    rt_uint16_t get_index;
+    rt_err_t result;
+
+    level = rt_spin_lock_irqsave(&(serial->spinlock));
+    while (tx->busy)
+    {
+        get_index = tx->get_index;
+        rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+
+        /* woken by the tx interrupts, a byte is out long before the timeout */
+        result = rt_completion_wait(&(tx->completion), RT_TICK_PER_SECOND / 10 + 1);
+
+        level = rt_spin_lock_irqsave(&(serial->spinlock));
+        if (result == -RT_ETIMEOUT && tx->get_index == get_index)
+        {
+            break;
+        }
+    }
+    rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+}
+
+rt_inline int _serial_int_tx(struct rt_serial_device *serial, const rt_uint8_t *data, int length)
+{
+    int size;
+    rt_base_t level;
+    rt_uint16_t put_index, next;
+    rt_bool_t done;
+    struct rt_serial_tx_fifo *tx;
+
+    RT_ASSERT(serial != RT_NULL);
+
+    size = length;
+    tx = (struct rt_serial_tx_fifo*) serial->serial_tx;
+    RT_ASSERT(tx != RT_NULL);
+
+    level = rt_spin_lock_irqsave(&(serial->spinlock));
+    tx->writers ++;
+    rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+
+    while (length)
+    {
+        level = rt_spin_lock_irqsave(&(serial->spinlock));
+
+        put_index = tx->put_index;
+        while (length)
+        {
+            next = (put_index + 1) % RT_SERIAL_TX_RB_BUFSZ;
+            if (next == tx->get_index)
+                break;
+
+            /*
+             * to be polite with serial console add a line feed
+             * to the carriage return character
+             */
+            if (*data == '\n' && (serial->parent.open_flag & RT_DEVICE_FLAG_STREAM))
+            {
+                if ((next + 1) % RT_SERIAL_TX_RB_BUFSZ == tx->get_index)
+                    break;
+                tx->buffer[put_index] = '\r';
+                put_index = next;
+                next = (put_index + 1) % RT_SERIAL_TX_RB_BUFSZ;
+            }
+
+            tx->buffer[put_index] = *data;
+            put_index = next;
+            data ++; length --;
+        }
+
+        if (put_index != tx->put_index)
+        {
+            tx->put_index = put_index;
+            tx->busy = RT_TRUE;
+
+            /* the tx interrupt comes at once if the data register is empty */
+            if (!tx->activated)
+            {
+                tx->activated = RT_TRUE;
+                serial->ops->control(serial, RT_DEVICE_CTRL_SET_INT, (void *)RT_DEVICE_FLAG_INT_TX);
+            }
+        }
+
+        rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+
+        /* the fifo is full, wait for the tx interrupt to take some */
+        if (length)
+        {
+            rt_completion_wait(&(tx->completion), RT_WAITING_FOREVER);
+        }
+    }
+
+    /* the last byte may be out already, nobody was told then */
+    level = rt_spin_lock_irqsave(&(serial->spinlock));
+    tx->writers --;
+    done = (tx->writers == 0 && !tx->busy);
+    rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+    if (done)
+    {
+        _serial_tx_notify(serial);
+    }
+
+    return size - length;
+}
+#else
 rt_inline int _serial_int_tx(struct rt_serial_device *serial, const rt_uint8_t *data, int length)
 {
     int size;
@@ -374,6 +495,7 @@ rt_inline int _serial_int_tx(struct rt_serial_device *serial, const rt_uint8_t *
 
     return size - length;
 }
+#endif /* RT_SERIAL_USING_TX_RB */
 
 static void _serial_check_buffer_size(void)
 {
@@ -720,15 +842,29 @@ static rt_err_t rt_serial_open(struct rt_device *dev, rt_uint16_t oflag)
         {
             struct rt_serial_tx_fifo *tx_fifo;
 
+#ifdef RT_SERIAL_USING_TX_RB
+            tx_fifo = (struct rt_serial_tx_fifo*) rt_malloc(sizeof(struct rt_serial_tx_fifo) +
+                RT_SERIAL_TX_RB_BUFSZ);
+            RT_ASSERT(tx_fifo != RT_NULL);
+            tx_fifo->buffer = (rt_uint8_t*) (tx_fifo + 1);
+            tx_fifo->put_index = 0;
+            tx_fifo->get_index = 0;
+            tx_fifo->activated = RT_FALSE;
+            tx_fifo->busy = RT_FALSE;
+            tx_fifo->writers = 0;
+#else
             tx_fifo = (struct rt_serial_tx_fifo*) rt_malloc(sizeof(struct rt_serial_tx_fifo));
             RT_ASSERT(tx_fifo != RT_NULL);
+#endif /* RT_SERIAL_USING_TX_RB */
 
             rt_completion_init(&(tx_fifo->completion));
             serial->serial_tx = tx_fifo;
 
             dev->open_flag |= RT_DEVICE_FLAG_INT_TX;
-            /* configure low level device */
+#ifndef RT_SERIAL_USING_TX_RB
+            /* configure low level device, the ring enables it when there are data */
             serial->ops->control(serial, RT_DEVICE_CTRL_SET_INT, (void *)RT_DEVICE_FLAG_INT_TX);
+#endif
         }
 #ifdef RT_SERIAL_USING_DMA
         else if (oflag & RT_DEVICE_FLAG_DMA_TX)
@@ -826,15 +962,29 @@ static rt_err_t rt_serial_close(struct rt_device *dev)
     if (dev->open_flag & RT_DEVICE_FLAG_INT_TX)
     {
         struct rt_serial_tx_fifo* tx_fifo;
-
-        serial->ops->control(serial, RT_DEVICE_CTRL_CLR_INT, (void*)RT_DEVICE_FLAG_INT_TX);
-        dev->open_flag &= ~RT_DEVICE_FLAG_INT_TX;
+#ifdef RT_SERIAL_USING_TX_RB
+        rt_base_t level;
+#endif
 
         tx_fifo = (struct rt_serial_tx_fifo*)serial->serial_tx;
         RT_ASSERT(tx_fifo != RT_NULL);
 
+#ifdef RT_SERIAL_USING_TX_RB
+        /* send what is queued, the tx interrupts must not find the fifo freed */
+        _serial_tx_drain(serial, tx_fifo);
+#endif
+        serial->ops->control(serial, RT_DEVICE_CTRL_CLR_INT, (void*)RT_DEVICE_FLAG_INT_TX);
+        dev->open_flag &= ~RT_DEVICE_FLAG_INT_TX;
+
+#ifdef RT_SERIAL_USING_TX_RB
+        level = rt_spin_lock_irqsave(&(serial->spinlock));
+        serial->serial_tx = RT_NULL;
+        rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+        rt_free(tx_fifo);
+#else
         rt_free(tx_fifo);
         serial->serial_tx = RT_NULL;
+#endif
 
         /* configure low level device */
     }
@@ -1464,11 +1614,63 @@ void rt_hw_serial_isr(struct rt_serial_device *serial, int event)
         case RT_SERIAL_EVENT_TX_DONE:
         {
             struct rt_serial_tx_fifo* tx_fifo;
+#ifdef RT_SERIAL_USING_TX_RB
+            rt_base_t level;
 
+            /* refill the data register as long as it takes */
+            level = rt_spin_lock_irqsave(&(serial->spinlock));
             tx_fifo = (struct rt_serial_tx_fifo*)serial->serial_tx;
+            if (tx_fifo == RT_NULL)
+            {
+                /* closed */
+                rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+                break;
+            }
+            while (tx_fifo->get_index != tx_fifo->put_index)
+            {
+                if (serial->ops->putc(serial, tx_fifo->buffer[tx_fifo->get_index]) == -1)
+                    break;
+                tx_fifo->get_index = (tx_fifo->get_index + 1) % RT_SERIAL_TX_RB_BUFSZ;
+            }
+            if (tx_fifo->get_index == tx_fifo->put_index && tx_fifo->activated)
+            {
+                /* nothing left, the driver raises RT_SERIAL_EVENT_TX_TC later */
+                tx_fifo->activated = RT_FALSE;
+                serial->ops->control(serial, RT_SERIAL_CTRL_TX_TC, (void *)RT_DEVICE_FLAG_INT_TX);
+            }
+            rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+#else
+            tx_fifo = (struct rt_serial_tx_fifo*)serial->serial_tx;
+#endif /* RT_SERIAL_USING_TX_RB */
             rt_completion_done(&(tx_fifo->completion));
             break;
         }
+#ifdef RT_SERIAL_USING_TX_RB
+        case RT_SERIAL_EVENT_TX_TC:
+        {
+            rt_base_t level;
+            rt_bool_t done = RT_FALSE;
+            struct rt_serial_tx_fifo* tx_fifo;
+
+            level = rt_spin_lock_irqsave(&(serial->spinlock));
+            tx_fifo = (struct rt_serial_tx_fifo*)serial->serial_tx;
+            if (tx_fifo != RT_NULL && !tx_fifo->activated && tx_fifo->busy)
+            {
+                tx_fifo->busy = RT_FALSE;
+                /* a writer still filling the fifo tells when it returns */
+                done = (tx_fifo->writers == 0);
+                /* for a close waiting for the fifo to drain */
+                rt_completion_done(&(tx_fifo->completion));
+            }
+            rt_spin_unlock_irqrestore(&(serial->spinlock), level);
+
+            if (done)
+            {
+                _serial_tx_notify(serial);
+            }
+            break;
+        }
+#endif /* RT_SERIAL_USING_TX_RB */
 #ifdef RT_SERIAL_USING_DMA
         case RT_SERIAL_EVENT_TX_DMADONE:
         {
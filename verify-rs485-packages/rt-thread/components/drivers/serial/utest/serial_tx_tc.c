@@ -0,0 +1,301 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "utest.h"
+
+/*
+ * The interrupt tx ring on a uart simulated by a thread. The thread moves
+ * the byte of the data register to the wire and raises TX_DONE while the
+ * tx interrupt is on, and TX_TC once the register is empty after the
+ * ring asked for it. Every run writes SERIAL_TC_BYTES in writes of
+ * different sizes, waits for tx_complete after each one and checks that
+ * the wire then holds everything written. The other units check the
+ * carriage returns of a stream device and that a close sends what is
+ * still in the ring. Time it with:
+ *
+ *     utest_bench -n 20 testcases.drivers.serial.tx_ring
+ */
+
+#define SERIAL_TC_NAME          "ser_tc"
+#define SERIAL_TC_BYTES         (16 * 1024)
+#define SERIAL_TC_WRITE_MAX     (RT_SERIAL_TX_RB_BUFSZ + RT_SERIAL_TX_RB_BUFSZ / 2)
+#define SERIAL_TC_WIRE_SIZE     (SERIAL_TC_BYTES + 64)
+#define SERIAL_TC_STACK_SIZE    2048
+
+static struct rt_serial_device serial;
+static struct rt_spinlock uart_lock;
+static struct rt_semaphore uart_kick, uart_exit, tx_done;
+static rt_bool_t uart_stop;
+/* the simulated registers */
+static rt_bool_t int_tx, tc_armed, dr_full;
+static rt_uint8_t dr;
+static rt_uint8_t wire[SERIAL_TC_WIRE_SIZE];
+static rt_size_t wire_len;
+static rt_uint8_t pattern[SERIAL_TC_WRITE_MAX];
+
+static rt_err_t uart_configure(struct rt_serial_device *serial, struct serial_configure *cfg)
+{
+    return RT_EOK;
+}
+
+static rt_err_t uart_control(struct rt_serial_device *serial, int cmd, void *arg)
+{
+    rt_base_t level;
+
+    if ((rt_ubase_t)arg != RT_DEVICE_FLAG_INT_TX)
+        return RT_EOK;
+
+    level = rt_spin_lock_irqsave(&uart_lock);
+    switch (cmd)
+    {
+    case RT_DEVICE_CTRL_SET_INT:
+        int_tx = RT_TRUE;
+        break;
+    case RT_DEVICE_CTRL_CLR_INT:
+        int_tx = RT_FALSE;
+        tc_armed = RT_FALSE;
+        break;
+    case RT_SERIAL_CTRL_TX_TC:
+        int_tx = RT_FALSE;
+        tc_armed = RT_TRUE;
+        break;
+    }
+    rt_spin_unlock_irqrestore(&uart_lock, level);
+
+    rt_sem_release(&uart_kick);
+
+    return RT_EOK;
+}
+
+static int uart_putc(struct rt_serial_device *serial, char c)
+{
+    rt_base_t level;
+    int ret = -1;
+
+    level = rt_spin_lock_irqsave(&uart_lock);
+    if (!dr_full)
+    {
+        dr = (rt_uint8_t)c;
+        dr_full = RT_TRUE;
+        ret = 1;
+    }
+    rt_spin_unlock_irqrestore(&uart_lock, level);
+
+    return ret;
+}
+
+static int uart_getc(struct rt_serial_device *serial)
+{
+    return -1;
+}
+
+static const struct rt_uart_ops uart_ops =
+{
+    uart_configure,
+    uart_control,
+    uart_putc,
+    uart_getc,
+    RT_NULL
+};
+
+/* the uart, one byte out of the data register per turn */
+static void uart_entry(void *param)
+{
+    rt_base_t level;
+    int event;
+
+    while (!uart_stop)
+    {
+        event = 0;
+        level = rt_spin_lock_irqsave(&uart_lock);
+        if (dr_full)
+        {
+            if (wire_len < SERIAL_TC_WIRE_SIZE)
+                wire[wire_len] = dr;
+            wire_len ++;
+            dr_full = RT_FALSE;
+        }
+        if (int_tx)
+        {
+            event = RT_SERIAL_EVENT_TX_DONE;
+        }
+        else if (tc_armed)
+        {
+            tc_armed = RT_FALSE;
+            event = RT_SERIAL_EVENT_TX_TC;
+        }
+        rt_spin_unlock_irqrestore(&uart_lock, level);
+
+        if (event != 0)
+            rt_hw_serial_isr(&serial, event);
+        else
+            rt_sem_take(&uart_kick, RT_WAITING_FOREVER);
+    }
+
+    rt_sem_release(&uart_exit);
+}
+
+static rt_err_t serial_tc_tx_complete(rt_device_t dev, void *buffer)
+{
+    return rt_sem_release(&tx_done);
+}
+
+static rt_err_t serial_tc_init(void)
+{
+    struct serial_configure config = RT_SERIAL_CONFIG_DEFAULT;
+    rt_thread_t tid;
+    int i;
+
+    for (i = 0; i < SERIAL_TC_WRITE_MAX; i++)
+    {
+        pattern[i] = (rt_uint8_t)(i * 7 + 1);
+    }
+    rt_spin_lock_init(&uart_lock);
+    rt_sem_init(&uart_kick, "ser_kick", 0, RT_IPC_FLAG_PRIO);
+    rt_sem_init(&uart_exit, "ser_exit", 0, RT_IPC_FLAG_PRIO);
+    rt_sem_init(&tx_done, "ser_done", 0, RT_IPC_FLAG_PRIO);
+    uart_stop = RT_FALSE;
+    int_tx = tc_armed = dr_full = RT_FALSE;
+    wire_len = 0;
+
+    /* above the testcase, like an interrupt */
+    tid = rt_thread_create("ser_tc", uart_entry, RT_NULL, SERIAL_TC_STACK_SIZE,
+                           RT_THREAD_PRIORITY_MAX / 4, 10);
+    if (tid == RT_NULL)
+        goto _error;
+
+    serial.ops = &uart_ops;
+    serial.config = config;
+    if (rt_hw_serial_register(&serial, SERIAL_TC_NAME, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_TX, RT_NULL) != RT_EOK)
+    {
+        rt_thread_delete(tid);
+        goto _error;
+    }
+    rt_thread_startup(tid);
+
+    if (rt_device_open(&serial.parent, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_INT_TX) != RT_EOK)
+    {
+        rt_device_unregister(&serial.parent);
+        uart_stop = RT_TRUE;
+        rt_sem_release(&uart_kick);
+        rt_sem_take(&uart_exit, RT_WAITING_FOREVER);
+        goto _error;
+    }
+    rt_device_set_tx_complete(&serial.parent, serial_tc_tx_complete);
+
+    return RT_EOK;
+
+_error:
+    rt_sem_detach(&uart_kick);
+    rt_sem_detach(&uart_exit);
+    rt_sem_detach(&tx_done);
+
+    return -RT_ERROR;
+}
+
+static rt_err_t serial_tc_cleanup(void)
+{
+    if (serial.parent.ref_count > 0)
+        rt_device_close(&serial.parent);
+    rt_device_unregister(&serial.parent);
+
+    uart_stop = RT_TRUE;
+    rt_sem_release(&uart_kick);
+    rt_sem_take(&uart_exit, RT_WAITING_FOREVER);
+
+    rt_sem_detach(&uart_kick);
+    rt_sem_detach(&uart_exit);
+    rt_sem_detach(&tx_done);
+
+    return RT_EOK;
+}
+
+/* the bytes of the wire from pos that are not the pattern */
+static int serial_tc_check(rt_size_t pos, rt_size_t size)
+{
+    rt_size_t i;
+    int bad = 0;
+
+    for (i = 0; i < size; i++)
+    {
+        if (wire[pos + i] != pattern[i])
+            bad ++;
+    }
+
+    return bad;
+}
+
+static void serial_tx_ring(void)
+{
+    rt_size_t sent = 0, size = 1;
+    int bad = 0;
+
+    wire_len = 0;
+    while (sent + size <= SERIAL_TC_BYTES)
+    {
+        if (rt_device_write(&serial.parent, 0, pattern, size) != size)
+        {
+            bad ++;
+            break;
+        }
+        /* told once the last byte is out */
+        if (rt_sem_take(&tx_done, RT_TICK_PER_SECOND) != RT_EOK || wire_len != sent + size)
+        {
+            bad ++;
+            break;
+        }
+        bad += serial_tc_check(sent, size);
+        sent += size;
+        size = size * 3 % SERIAL_TC_WRITE_MAX + 1;
+    }
+
+    uassert_int_equal(bad, 0);
+    /* one notification per write */
+    uassert_int_equal(rt_sem_take(&tx_done, 0), -RT_ETIMEOUT);
+}
+
+static void serial_tx_stream(void)
+{
+    const char *text = "ab\ncd\n";
+
+    wire_len = 0;
+    serial.parent.open_flag |= RT_DEVICE_FLAG_STREAM;
+    uassert_int_equal(rt_device_write(&serial.parent, 0, text, 6), 6);
+    serial.parent.open_flag &= ~RT_DEVICE_FLAG_STREAM;
+
+    uassert_int_equal(rt_sem_take(&tx_done, RT_TICK_PER_SECOND), RT_EOK);
+    uassert_int_equal(wire_len, 8);
+    uassert_int_equal(rt_memcmp(wire, "ab\r\ncd\r\n", 8), 0);
+}
+
+static void serial_tx_close(void)
+{
+    wire_len = 0;
+    uassert_int_equal(rt_device_write(&serial.parent, 0, pattern, RT_SERIAL_TX_RB_BUFSZ - 1),
+                      RT_SERIAL_TX_RB_BUFSZ - 1);
+    /* the close waits for the ring to drain */
+    rt_device_close(&serial.parent);
+    uassert_int_equal(wire_len, RT_SERIAL_TX_RB_BUFSZ - 1);
+    uassert_int_equal(serial_tc_check(0, RT_SERIAL_TX_RB_BUFSZ - 1), 0);
+    uassert_true(!int_tx && !tc_armed);
+
+    uassert_int_equal(rt_device_open(&serial.parent, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_INT_TX), RT_EOK);
+    rt_sem_control(&tx_done, RT_IPC_CMD_RESET, RT_NULL);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(serial_tx_ring);
+    UTEST_UNIT_RUN(serial_tx_stream);
+    UTEST_UNIT_RUN(serial_tx_close);
+}
+UTEST_TC_EXPORT(testcase, "testcases.drivers.serial.tx_ring", serial_tc_init, serial_tc_cleanup, 10);
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2012-10-03     Yi Qiu       first version
  * 2012-12-12     heyuanjie87  add CDC endpoints collection
+ * 2026-10-17     RT-Thread    add vcom bridge interface
  */
 
 #ifndef  __CDC_H__
@@ -226,4 +227,21 @@ typedef enum ucdc_notification_code ucdc_notification_code_t;
 
 #pragma pack()
 
+#ifdef RT_VCOM_USING_PINGPONG
+/* raw access to the vcom data interface, bypassing the serial device */
+struct vcom_bridge_ops
+{
+    /* an OUT packet arrived, buf is held until rt_usb_vcom_out_release() */
+    void (*out_packet)(void *buf, rt_size_t size, void *user_data);
+    /* the host set a new line coding */
+    void (*line_coding)(const struct ucdc_line_coding *coding, void *user_data);
+};
+
+rt_err_t rt_usb_vcom_bridge_attach(const struct vcom_bridge_ops *ops, void *user_data);
+rt_err_t rt_usb_vcom_bridge_detach(void);
+void rt_usb_vcom_out_release(void *buf);
+rt_err_t rt_usb_vcom_in_submit(void *buf, rt_size_t size);
+rt_err_t rt_usb_vcom_in_wait(rt_int32_t timeout);
+#endif /* RT_VCOM_USING_PINGPONG */
+
 #endif
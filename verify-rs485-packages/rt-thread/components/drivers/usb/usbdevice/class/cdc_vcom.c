@@ -11,6 +11,7 @@
  * 2013-07-20     Yi Qiu       do more test
  * 2016-02-01     Urey         Fix some error
  * 2021-10-14     mazhiyuan    Fix some error
+ * 2026-10-17     RT-Thread    add ping-pong bulk buffers and bridge interface
  */
 
 #include <rthw.h>
@@ -49,6 +50,10 @@
 #define VCOM_TX_USE_DMA
 #endif /*RT_VCOM_TX_USE_DMA*/
 
+#ifdef RT_VCOM_USING_PINGPONG
+#define VCOM_USING_PINGPONG
+#endif /*RT_VCOM_USING_PINGPONG*/
+
 #ifdef RT_VCOM_SERNO
 #define _SER_NO RT_VCOM_SERNO
 #else /*!RT_VCOM_SERNO*/
@@ -72,6 +77,13 @@ static struct ucdc_line_coding line_coding;
 #define CDC_TX_HAS_DATE   0x01
 #define CDC_TX_HAS_SPACE  0x02
 
+#ifdef VCOM_USING_PINGPONG
+/* state of an OUT buffer */
+#define VCOM_BUF_FREE     0
+#define VCOM_BUF_ARMED    1     /* queued on the OUT endpoint */
+#define VCOM_BUF_HELD     2     /* handed to the bridge */
+#endif
+
 struct vcom
 {
     struct rt_serial_device serial;
@@ -86,6 +98,16 @@ struct vcom
     rt_uint8_t tx_rbp[CDC_TX_BUFSIZE];
     struct rt_ringbuffer tx_ringbuffer;
     struct rt_event  tx_event;
+#ifdef VCOM_USING_PINGPONG
+    rt_uint8_t *out_buf[2];
+    rt_uint8_t out_state[2];
+    rt_uint8_t out_armed;           /* index of the armed buffer */
+    rt_uint8_t in_buf[2][CDC_BULKIN_MAXSIZE];
+    rt_bool_t in_busy;              /* an IN request is on the endpoint */
+    struct rt_mutex in_lock;
+    const struct vcom_bridge_ops *bridge;
+    void *bridge_data;
+#endif
 };
 
 struct vcom_tx_msg
@@ -257,6 +279,9 @@ const static char* _ustring[] =
     "Interface",
 };
 static void rt_usb_vcom_init(struct ufunction *func);
+#ifdef VCOM_USING_PINGPONG
+static struct ufunction *vcom_func = RT_NULL;
+#endif
 
 static void _vcom_reset_state(ufunction_t func)
 {
@@ -274,6 +299,75 @@ static void _vcom_reset_state(ufunction_t func)
     rt_hw_interrupt_enable(level);
 }
 
+#ifdef VCOM_USING_PINGPONG
+/* queue a free OUT buffer on the endpoint, nothing is done if one is armed */
+static void _vcom_out_arm(ufunction_t func)
+{
+    struct vcom *data = (struct vcom*)func->user_data;
+    rt_base_t level;
+    int i;
+
+    level = rt_hw_interrupt_disable();
+    if (data->out_buf[0] == RT_NULL || data->out_state[data->out_armed] == VCOM_BUF_ARMED)
+    {
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+    /* take turns, the buffer that just completed may still be read */
+    i = data->out_armed ^ 1;
+    if (data->out_state[i] != VCOM_BUF_FREE)
+    {
+        i ^= 1;
+    }
+    if (data->out_state[i] != VCOM_BUF_FREE)
+    {
+        /* both held by the bridge, the host is NAKed until one is released */
+        rt_hw_interrupt_enable(level);
+        return;
+    }
+    data->out_state[i] = VCOM_BUF_ARMED;
+    data->out_armed = i;
+    rt_hw_interrupt_enable(level);
+
+    data->ep_out->request.buffer = data->out_buf[i];
+    data->ep_out->request.size = EP_MAXPACKET(data->ep_out);
+    data->ep_out->request.req_type = UIO_REQUEST_READ_BEST;
+    rt_usbd_io_request(func->device, data->ep_out, &data->ep_out->request);
+}
+
+/* wait for the IN request on the endpoint, called with in_lock held */
+static rt_err_t _vcom_in_wait(struct vcom *data, rt_int32_t timeout)
+{
+    rt_err_t result = RT_EOK;
+
+    if (data->in_busy)
+    {
+        result = rt_completion_wait(&data->wait, timeout);
+        if (result != RT_EOK)
+        {
+            LOG_D("vcom tx timeout");
+        }
+        /* a timed out packet is given up */
+        data->in_busy = RT_FALSE;
+    }
+
+    return result;
+}
+
+/* start an IN request without waiting, called with in_lock held */
+static void _vcom_in_start(ufunction_t func, void *buf, rt_size_t size)
+{
+    struct vcom *data = (struct vcom*)func->user_data;
+
+    rt_completion_init(&data->wait);
+    data->in_busy = RT_TRUE;
+    data->ep_in->request.buffer     = buf;
+    data->ep_in->request.size       = size;
+    data->ep_in->request.req_type   = UIO_REQUEST_WRITE;
+    rt_usbd_io_request(func->device, data->ep_in, &data->ep_in->request);
+}
+#endif /* VCOM_USING_PINGPONG */
+
 /**
  * This function will handle cdc bulk in endpoint request.
  *
@@ -332,6 +426,34 @@ static rt_err_t _ep_out_handler(ufunction_t func, rt_size_t size)
     LOG_D("_ep_out_handler %d", size);
 
     data = (struct vcom*)func->user_data;
+#ifdef VCOM_USING_PINGPONG
+    {
+        int done = data->out_armed;
+
+        /* the completed buffer is out of the endpoint, arm the other one first */
+        level = rt_hw_interrupt_disable();
+        data->out_state[done] = data->bridge ? VCOM_BUF_HELD : VCOM_BUF_FREE;
+        rt_hw_interrupt_enable(level);
+        _vcom_out_arm(func);
+
+        if (data->bridge)
+        {
+            data->bridge->out_packet(data->out_buf[done], size, data->bridge_data);
+        }
+        else if ((data->serial.parent.flag & RT_DEVICE_FLAG_ACTIVATED)
+            && (data->serial.parent.open_flag & RT_DEVICE_OFLAG_OPEN))
+        {
+            /* handlers run on the usbd thread, the buffer is not armed before this copy */
+            level = rt_hw_interrupt_disable();
+            rt_ringbuffer_put(&data->rx_ringbuffer, data->out_buf[done], size);
+            rt_hw_interrupt_enable(level);
+
+            rt_hw_serial_isr(&data->serial,RT_SERIAL_EVENT_RX_IND);
+        }
+
+        return RT_EOK;
+    }
+#endif
     /* ensure serial is active */
     if((data->serial.parent.flag & RT_DEVICE_FLAG_ACTIVATED)
         && (data->serial.parent.open_flag & RT_DEVICE_OFLAG_OPEN))
@@ -389,10 +511,15 @@ static rt_err_t _cdc_get_line_coding(udevice_t device, ureq_t setup)
 
     LOG_D("_cdc_get_line_coding");
 
+#ifdef VCOM_USING_PINGPONG
+    /* report what the host set last */
+    data = line_coding;
+#else
     data.dwDTERate = 115200;
     data.bCharFormat = 0;
     data.bDataBits = 8;
     data.bParityType = 0;
+#endif
     size = setup->wLength > 7 ? 7 : setup->wLength;
 
     rt_usbd_ep0_write(device, (void*)&data, size);
@@ -406,6 +533,18 @@ static rt_err_t _cdc_set_line_coding_callback(udevice_t device, rt_size_t size)
 
     dcd_ep0_send_status(device->dcd);
 
+#ifdef VCOM_USING_PINGPONG
+    if (vcom_func != RT_NULL)
+    {
+        struct vcom *data = (struct vcom*)vcom_func->user_data;
+
+        if (data->bridge && data->bridge->line_coding)
+        {
+            data->bridge->line_coding(&line_coding, data->bridge_data);
+        }
+    }
+#endif
+
     return RT_EOK;
 }
 
@@ -506,6 +645,19 @@ static rt_err_t _function_enable(ufunction_t func)
     data->serial.serial_rx = &data->rx_ringbuffer;
 #endif
 
+#ifdef VCOM_USING_PINGPONG
+    /* the second buffer, both hold one max packet */
+    data->out_buf[1] = rt_malloc(CDC_RX_BUFSIZE);
+    RT_ASSERT(data->out_buf[1] != RT_NULL);
+    data->out_buf[0] = data->ep_out->buffer;
+    data->out_state[0] = VCOM_BUF_FREE;
+    data->out_state[1] = VCOM_BUF_FREE;
+    data->out_armed = 0;
+    _vcom_out_arm(func);
+
+    return RT_EOK;
+#endif
+
     data->ep_out->request.buffer = data->ep_out->buffer;
     data->ep_out->request.size = EP_MAXPACKET(data->ep_out);
 
@@ -533,6 +685,25 @@ static rt_err_t _function_disable(ufunction_t func)
     _vcom_reset_state(func);
 
     data = (struct vcom*)func->user_data;
+#ifdef VCOM_USING_PINGPONG
+    /* a buffer still held by the bridge is freed on release */
+    {
+        rt_base_t level;
+        int i;
+
+        level = rt_hw_interrupt_disable();
+        for (i = 0; i < 2; i++)
+        {
+            if (data->out_buf[i] != RT_NULL && data->out_state[i] != VCOM_BUF_HELD)
+            {
+                rt_free(data->out_buf[i]);
+            }
+            data->out_buf[i] = RT_NULL;
+        }
+        data->ep_out->buffer = RT_NULL;
+        rt_hw_interrupt_enable(level);
+    }
+#endif
     if(data->ep_out->buffer != RT_NULL)
     {
         rt_free(data->ep_out->buffer);
@@ -612,6 +783,9 @@ ufunction_t rt_usbd_function_cdc_create(udevice_t device)
     RT_ASSERT(data != RT_NULL);
     rt_memset(data, 0, sizeof(struct vcom));
     func->user_data = (void*)data;
+#ifdef VCOM_USING_PINGPONG
+    vcom_func = func;
+#endif
 
     /* initilize vcom */
     rt_usb_vcom_init(func);
@@ -863,7 +1037,12 @@ static void vcom_tx_thread_entry(void* parameter)
     rt_uint32_t res;
     struct ufunction *func = (struct ufunction *)parameter;
     struct vcom *data = (struct vcom*)func->user_data;
+#ifdef VCOM_USING_PINGPONG
+    int cur = 0;
+    rt_uint8_t *ch;
+#else
     rt_uint8_t ch[CDC_BULKIN_MAXSIZE];
+#endif
 
     while (1)
     {
@@ -883,6 +1062,10 @@ static void vcom_tx_thread_entry(void* parameter)
         }
         while(rt_ringbuffer_data_len(&data->tx_ringbuffer))
         {
+#ifdef VCOM_USING_PINGPONG
+            /* fill one buffer while the other is on the bus */
+            ch = data->in_buf[cur];
+#endif
             level = rt_hw_interrupt_disable();
             res = rt_ringbuffer_get(&data->tx_ringbuffer, ch, CDC_BULKIN_MAXSIZE);
             rt_hw_interrupt_enable(level);
@@ -913,6 +1096,14 @@ static void vcom_tx_thread_entry(void* parameter)
                 }
                 continue;
             }
+#ifdef VCOM_USING_PINGPONG
+            rt_mutex_take(&data->in_lock, RT_WAITING_FOREVER);
+            /* the previous packet, notified below in its place */
+            _vcom_in_wait(data, VCOM_TX_TIMEOUT);
+            _vcom_in_start(func, ch, res);
+            rt_mutex_release(&data->in_lock);
+            cur ^= 1;
+#else
             rt_completion_init(&data->wait);
             data->ep_in->request.buffer     = ch;
             data->ep_in->request.size       = res;
@@ -925,6 +1116,7 @@ static void vcom_tx_thread_entry(void* parameter)
             {
                 LOG_D("vcom tx timeout");
             }
+#endif
 #ifdef RT_USING_SERIAL_V1
 #ifndef VCOM_TX_USE_DMA
             if(data->serial.parent.open_flag & RT_DEVICE_FLAG_INT_TX)
@@ -960,6 +1152,14 @@ static void rt_usb_vcom_init(struct ufunction *func)
 
     rt_event_init(&data->tx_event, "vcom", RT_IPC_FLAG_FIFO);
 
+#ifdef VCOM_USING_PINGPONG
+    rt_mutex_init(&data->in_lock, "vcom", RT_IPC_FLAG_PRIO);
+    line_coding.dwDTERate = 115200;
+    line_coding.bCharFormat = 0;
+    line_coding.bDataBits = 8;
+    line_coding.bParityType = 0;
+#endif
+
     config.baud_rate    = BAUD_RATE_115200;
     config.data_bits    = DATA_BITS_8;
     config.stop_bits    = STOP_BITS_1;
@@ -993,6 +1193,151 @@ static void rt_usb_vcom_init(struct ufunction *func)
     result = rt_thread_startup(&vcom_thread);
     RT_ASSERT(result == RT_EOK);
 }
+#ifdef VCOM_USING_PINGPONG
+/**
+ * This function attaches a bridge to the vcom data interface. OUT packets go
+ * to the bridge instead of the vcom serial device.
+ *
+ * @param ops the bridge callbacks, called from the usbd thread.
+ * @param user_data the parameter of the callbacks.
+ *
+ * @return RT_EOK on successful, -RT_EBUSY if a bridge is attached.
+ */
+rt_err_t rt_usb_vcom_bridge_attach(const struct vcom_bridge_ops *ops, void *user_data)
+{
+    struct vcom *data;
+    rt_base_t level;
+
+    RT_ASSERT(ops != RT_NULL && ops->out_packet != RT_NULL);
+
+    if (vcom_func == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+    data = (struct vcom*)vcom_func->user_data;
+
+    level = rt_hw_interrupt_disable();
+    if (data->bridge != RT_NULL)
+    {
+        rt_hw_interrupt_enable(level);
+        return -RT_EBUSY;
+    }
+    data->bridge_data = user_data;
+    data->bridge = ops;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+/**
+ * This function detaches the bridge, OUT packets go to the vcom serial
+ * device again. Held buffers must still be released.
+ *
+ * @return RT_EOK on successful.
+ */
+rt_err_t rt_usb_vcom_bridge_detach(void)
+{
+    struct vcom *data;
+    rt_base_t level;
+
+    if (vcom_func == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+    data = (struct vcom*)vcom_func->user_data;
+
+    level = rt_hw_interrupt_disable();
+    data->bridge = RT_NULL;
+    data->bridge_data = RT_NULL;
+    rt_hw_interrupt_enable(level);
+
+    return RT_EOK;
+}
+
+/**
+ * This function gives an OUT buffer back to the endpoint.
+ *
+ * @param buf the buffer passed to out_packet.
+ */
+void rt_usb_vcom_out_release(void *buf)
+{
+    struct vcom *data;
+    rt_base_t level;
+    int i;
+
+    RT_ASSERT(vcom_func != RT_NULL);
+    data = (struct vcom*)vcom_func->user_data;
+
+    level = rt_hw_interrupt_disable();
+    for (i = 0; i < 2 && data->out_buf[i] != buf; i++);
+    if (i == 2)
+    {
+        /* the function was disabled while the bridge held it */
+        rt_hw_interrupt_enable(level);
+        rt_free(buf);
+        return;
+    }
+    data->out_state[i] = VCOM_BUF_FREE;
+    rt_hw_interrupt_enable(level);
+
+    /* rearm if both buffers were held */
+    _vcom_out_arm(vcom_func);
+}
+
+/**
+ * This function starts sending buf on the IN endpoint without copying it.
+ * It waits for the previous packet only, so the caller can fill a second
+ * buffer while this one is sent. buf must stay valid until the next call
+ * or rt_usb_vcom_in_wait().
+ *
+ * @param buf the data.
+ * @param size the data size.
+ *
+ * @return RT_EOK on successful, -RT_EIO if the host is not connected.
+ */
+rt_err_t rt_usb_vcom_in_submit(void *buf, rt_size_t size)
+{
+    struct vcom *data;
+
+    RT_ASSERT(vcom_func != RT_NULL);
+    data = (struct vcom*)vcom_func->user_data;
+
+    if (!data->connected)
+    {
+        return -RT_EIO;
+    }
+
+    rt_mutex_take(&data->in_lock, RT_WAITING_FOREVER);
+    _vcom_in_wait(data, VCOM_TX_TIMEOUT);
+    _vcom_in_start(vcom_func, buf, size);
+    rt_mutex_release(&data->in_lock);
+
+    return RT_EOK;
+}
+
+/**
+ * This function waits for the packet started by rt_usb_vcom_in_submit().
+ *
+ * @param timeout the wait timeout in ticks.
+ *
+ * @return RT_EOK on successful, -RT_ETIMEOUT on timeout.
+ */
+rt_err_t rt_usb_vcom_in_wait(rt_int32_t timeout)
+{
+    struct vcom *data;
+    rt_err_t result;
+
+    RT_ASSERT(vcom_func != RT_NULL);
+    data = (struct vcom*)vcom_func->user_data;
+
+    rt_mutex_take(&data->in_lock, RT_WAITING_FOREVER);
+    result = _vcom_in_wait(data, timeout);
+    rt_mutex_release(&data->in_lock);
+
+    return result;
+}
+#endif /* VCOM_USING_PINGPONG */
+
 struct udclass vcom_class =
 {
     .rt_usbd_function_create = rt_usbd_function_cdc_create
@@ -9,6 +9,7 @@
  * 2012-11-25     Heyuanjie87  reduce the memory consumption
  * 2012-12-09     Heyuanjie87  change function and endpoint handler
  * 2013-07-25     Yi Qiu       update for USB CV test
+ * 2026-10-17     RT-Thread    pipeline READ_10/WRITE_10 with a disk worker thread
  */
 
 #include <rtthread.h>
@@ -27,6 +28,12 @@
 #define DBG_LVL           DBG_INFO
 #include <rtdbg.h>
 
+#ifdef RT_USB_MSTORAGE_CHUNK_SECTORS
+#define MSTORAGE_CHUNK_SECTORS  RT_USB_MSTORAGE_CHUNK_SECTORS
+#else
+#define MSTORAGE_CHUNK_SECTORS  8
+#endif
+
 enum STAT
 {
     STAT_CBW,
@@ -50,6 +57,25 @@ typedef enum
     DIR_NONE,
 }CB_DIR;
 
+/* a chunk goes through the disk and the bus in turn, two of them overlap both */
+enum CHUNK_STAT
+{
+    CHUNK_FREE,
+    CHUNK_DISK,     /* owned by the disk worker */
+    CHUNK_READY,    /* read from disk, waiting for the bus */
+    CHUNK_USB,      /* on the bus */
+};
+
+struct mstorage_chunk
+{
+    rt_uint8_t *buffer;
+    int status;
+    CB_DIR dir;
+    rt_uint32_t block;
+    rt_uint32_t count;
+    rt_size_t size;
+};
+
 typedef rt_ssize_t (*cbw_handler)(ufunction_t func, ustorage_cbw_t cbw);
 
 struct scsi_cmd
@@ -75,6 +101,18 @@ struct mstorage
     rt_int32_t size;
     struct scsi_cmd* processing;
     struct rt_device_blk_geometry geometry;
+
+    struct mstorage_chunk chunk[2];
+    int io_idx;                 /* next chunk to start, disk for READ_10, bus for WRITE_10 */
+    int tx_idx;                 /* next chunk to send for READ_10 */
+    struct mstorage_chunk *rx_chunk;
+    rt_uint32_t io_block;       /* first block of the next chunk */
+    rt_size_t io_left;          /* bytes not given to a chunk yet */
+    rt_size_t xfer_left;        /* bytes not sent (READ_10) or not written (WRITE_10) yet */
+    rt_bool_t io_error;
+    struct rt_mutex lock;
+    rt_mailbox_t jobs;
+    struct rt_completion idle;  /* the disk worker has no chunk */
 };
 
 rt_align(4)
@@ -457,6 +495,187 @@ static rt_ssize_t _read_capacity(ufunction_t func, ustorage_cbw_t cbw)
     return data->cb_data_size;
 }
 
+static rt_bool_t _chunks_free(struct mstorage *data)
+{
+    return data->chunk[0].status == CHUNK_FREE && data->chunk[1].status == CHUNK_FREE;
+}
+
+/* give free chunks to the disk, the ready one to the bus, called with data->lock held */
+static void _read_pump(ufunction_t func)
+{
+    struct mstorage *data;
+    struct mstorage_chunk *chunk;
+    rt_size_t chunk_size;
+
+    data = (struct mstorage*)func->user_data;
+    if(data->status != STAT_SEND)
+    {
+        return;
+    }
+
+    if(data->io_error)
+    {
+        if(data->chunk[data->tx_idx].status != CHUNK_USB && data->chunk[data->tx_idx ^ 1].status != CHUNK_USB)
+        {
+            rt_kprintf("disk read error\n");
+            data->io_left = 0;
+            data->xfer_left = 0;
+            data->status = STAT_CBW;
+            rt_usbd_ep_set_stall(func->device, data->ep_in);
+        }
+        return;
+    }
+
+    chunk_size = MSTORAGE_CHUNK_SECTORS * data->geometry.bytes_per_sector;
+    while(data->io_left > 0 && data->chunk[data->io_idx].status == CHUNK_FREE)
+    {
+        chunk = &data->chunk[data->io_idx];
+        chunk->dir = DIR_IN;
+        chunk->block = data->io_block;
+        chunk->size = MIN(data->io_left, chunk_size);
+        chunk->count = (chunk->size + data->geometry.bytes_per_sector - 1) / data->geometry.bytes_per_sector;
+        chunk->status = CHUNK_DISK;
+        data->io_block += chunk->count;
+        data->io_left -= chunk->size;
+        rt_mb_send(data->jobs, (rt_ubase_t)data->io_idx);
+        data->io_idx ^= 1;
+    }
+
+    chunk = &data->chunk[data->tx_idx];
+    if(chunk->status == CHUNK_READY)
+    {
+        chunk->status = CHUNK_USB;
+        data->ep_in->request.buffer = chunk->buffer;
+        data->ep_in->request.size = chunk->size;
+        data->ep_in->request.req_type = UIO_REQUEST_WRITE;
+        rt_usbd_io_request(func->device, data->ep_in, &data->ep_in->request);
+    }
+    else if(data->xfer_left == 0 && _chunks_free(data))
+    {
+        _send_status(func);
+    }
+}
+
+/* arm the bulk out endpoint with a free chunk, called with data->lock held */
+static void _write_pump(ufunction_t func)
+{
+    struct mstorage *data;
+    struct mstorage_chunk *chunk;
+
+    data = (struct mstorage*)func->user_data;
+    if(data->status != STAT_RECEIVE)
+    {
+        return;
+    }
+
+    chunk = &data->chunk[data->io_idx];
+    if(data->io_left > 0 && data->rx_chunk == RT_NULL && chunk->status == CHUNK_FREE)
+    {
+        chunk->dir = DIR_OUT;
+        chunk->block = data->io_block;
+        chunk->size = MIN(data->io_left, MSTORAGE_CHUNK_SECTORS * data->geometry.bytes_per_sector);
+        chunk->count = chunk->size / data->geometry.bytes_per_sector;
+        chunk->status = CHUNK_USB;
+        data->io_block += chunk->count;
+        data->io_left -= chunk->size;
+        data->rx_chunk = chunk;
+        data->io_idx ^= 1;
+
+        data->ep_out->request.buffer = chunk->buffer;
+        data->ep_out->request.size = chunk->size;
+        data->ep_out->request.req_type = UIO_REQUEST_READ_FULL;
+        rt_usbd_io_request(func->device, data->ep_out, &data->ep_out->request);
+    }
+    else if(data->xfer_left == 0 && _chunks_free(data))
+    {
+        if(data->io_error)
+        {
+            rt_kprintf("disk write error\n");
+            data->csw_response.status = 1;
+        }
+        _send_status(func);
+    }
+}
+
+/* runs the disk side of the chunks, so the usbd thread keeps the bus busy meanwhile */
+static void _disk_worker_entry(void *parameter)
+{
+    ufunction_t func = (ufunction_t)parameter;
+    struct mstorage *data = (struct mstorage*)func->user_data;
+    struct mstorage_chunk *chunk;
+    rt_ubase_t idx;
+    rt_size_t size;
+
+    while(1)
+    {
+        if(rt_mb_recv(data->jobs, &idx, RT_WAITING_FOREVER) != RT_EOK)
+        {
+            continue;
+        }
+
+        chunk = &data->chunk[idx];
+        if(chunk->dir == DIR_IN)
+        {
+            size = rt_device_read(data->disk, chunk->block, chunk->buffer, chunk->count);
+        }
+        else
+        {
+            size = rt_device_write(data->disk, chunk->block, chunk->buffer, chunk->count);
+        }
+
+        rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+        if(size != chunk->count)
+        {
+            data->io_error = RT_TRUE;
+        }
+        if(chunk->dir == DIR_IN)
+        {
+            /* drop it if the pipe was stopped meanwhile */
+            chunk->status = (data->status == STAT_SEND && !data->io_error) ? CHUNK_READY : CHUNK_FREE;
+            _read_pump(func);
+        }
+        else
+        {
+            data->xfer_left -= chunk->size;
+            chunk->status = CHUNK_FREE;
+            _write_pump(func);
+        }
+        if(data->chunk[0].status != CHUNK_DISK && data->chunk[1].status != CHUNK_DISK)
+        {
+            rt_completion_done(&data->idle);
+        }
+        rt_mutex_release(&data->lock);
+    }
+}
+
+static void _pipe_wait_idle(struct mstorage *data)
+{
+    rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+    while(data->chunk[0].status == CHUNK_DISK || data->chunk[1].status == CHUNK_DISK)
+    {
+        /* the worker signals under the lock, so the signal is not missed */
+        rt_completion_init(&data->idle);
+        rt_mutex_release(&data->lock);
+        rt_completion_wait(&data->idle, RT_WAITING_FOREVER);
+        rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+    }
+    rt_mutex_release(&data->lock);
+}
+
+static void _pipe_start(struct mstorage *data, rt_uint32_t block, rt_size_t size)
+{
+    /* transfers of an aborted command never complete, the chunks are free again */
+    data->chunk[0].status = CHUNK_FREE;
+    data->chunk[1].status = CHUNK_FREE;
+    data->io_idx = 0;
+    data->tx_idx = 0;
+    data->rx_chunk = RT_NULL;
+    data->io_block = block;
+    data->io_left = size;
+    data->xfer_left = size;
+    data->io_error = RT_FALSE;
+}
+
 /**
  * This function will handle read_10 request.
  *
@@ -468,7 +687,6 @@ static rt_ssize_t _read_capacity(ufunction_t func, ustorage_cbw_t cbw)
 static rt_ssize_t _read_10(ufunction_t func, ustorage_cbw_t cbw)
 {
     struct mstorage *data;
-    rt_size_t size;
 
     RT_ASSERT(func != RT_NULL);
     RT_ASSERT(func->device != RT_NULL);
@@ -482,19 +700,20 @@ static rt_ssize_t _read_10(ufunction_t func, ustorage_cbw_t cbw)
     RT_ASSERT(data->count < data->geometry.sector_count);
 
     data->csw_response.data_reside = data->cb_data_size;
-    size = rt_device_read(data->disk, data->block, data->ep_in->buffer, 1);
-    if(size == 0)
+    if(data->cb_data_size == 0)
     {
-        rt_kprintf("read data error\n");
+        return 0;
     }
+    _pipe_wait_idle(data);
 
-    data->ep_in->request.buffer = data->ep_in->buffer;
-    data->ep_in->request.size = data->geometry.bytes_per_sector;
-    data->ep_in->request.req_type = UIO_REQUEST_WRITE;
-    rt_usbd_io_request(func->device, data->ep_in, &data->ep_in->request);
+    /* the first two chunks are read back to back, the first one is sent as soon as it is in */
+    rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+    _pipe_start(data, data->block, data->cb_data_size);
     data->status = STAT_SEND;
+    _read_pump(func);
+    rt_mutex_release(&data->lock);
 
-    return data->geometry.bytes_per_sector;
+    return data->cb_data_size;
 }
 
 /**
@@ -525,14 +744,28 @@ static rt_ssize_t _write_10(ufunction_t func, ustorage_cbw_t cbw)
                                 data->count, data->block, data->geometry.sector_count);
 
     data->csw_response.data_reside = data->cb_data_size;
+    if(data->cb_data_size == 0)
+    {
+        return 0;
+    }
+    if(data->cb_data_size % data->geometry.bytes_per_sector != 0)
+    {
+        /* the host sends less than it asked to write, a partial sector cannot be written */
+        rt_kprintf("write_10 size %d is not a sector multiple\n", data->cb_data_size);
+        rt_usbd_ep_set_stall(func->device, data->ep_out);
+        data->csw_response.status = 1;
+        return 0;
+    }
+    _pipe_wait_idle(data);
 
-    data->ep_out->request.buffer = data->ep_out->buffer;
-    data->ep_out->request.size = data->geometry.bytes_per_sector;
-    data->ep_out->request.req_type = UIO_REQUEST_READ_FULL;
-    rt_usbd_io_request(func->device, data->ep_out, &data->ep_out->request);
+    /* a received chunk is written while the next one comes in */
+    rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+    _pipe_start(data, data->block, data->cb_data_size);
     data->status = STAT_RECEIVE;
+    _write_pump(func);
+    rt_mutex_release(&data->lock);
 
-    return data->geometry.bytes_per_sector;
+    return data->cb_data_size;
 }
 
 /**
@@ -631,27 +864,13 @@ static rt_err_t _ep_in_handler(ufunction_t func, rt_size_t size)
         _send_status(func);
         break;
      case STAT_SEND:
+        rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
         data->csw_response.data_reside -= data->ep_in->request.size;
-        data->count--;
-        data->block++;
-        if(data->count > 0 && data->csw_response.data_reside > 0)
-        {
-            if(rt_device_read(data->disk, data->block, data->ep_in->buffer, 1) == 0)
-            {
-                rt_kprintf("disk read error\n");
-                rt_usbd_ep_set_stall(func->device, data->ep_in);
-                return -RT_ERROR;
-            }
-
-            data->ep_in->request.buffer = data->ep_in->buffer;
-            data->ep_in->request.size = data->geometry.bytes_per_sector;
-            data->ep_in->request.req_type = UIO_REQUEST_WRITE;
-            rt_usbd_io_request(func->device, data->ep_in, &data->ep_in->request);
-        }
-        else
-        {
-            _send_status(func);
-        }
+        data->xfer_left -= data->chunk[data->tx_idx].size;
+        data->chunk[data->tx_idx].status = CHUNK_FREE;
+        data->tx_idx ^= 1;
+        _read_pump(func);
+        rt_mutex_release(&data->lock);
         break;
      }
 
@@ -881,20 +1100,16 @@ static rt_err_t _ep_out_handler(ufunction_t func, rt_size_t size)
         data->size -= size;
         data->csw_response.data_reside -= size;
 
-        rt_device_write(data->disk, data->block, data->ep_out->buffer, 1);
-
-        if(data->csw_response.data_reside != 0)
+        /* hand the chunk to the disk worker and take the next one from the host */
+        rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+        if(data->rx_chunk != RT_NULL)
         {
-            data->ep_out->request.buffer = data->ep_out->buffer;
-            data->ep_out->request.size = data->geometry.bytes_per_sector;
-            data->ep_out->request.req_type = UIO_REQUEST_READ_FULL;
-            rt_usbd_io_request(func->device, data->ep_out, &data->ep_out->request);
-            data->block ++;
-        }
-        else
-        {
-            _send_status(func);
+            data->rx_chunk->status = CHUNK_DISK;
+            rt_mb_send(data->jobs, (rt_ubase_t)(data->rx_chunk - data->chunk));
+            data->rx_chunk = RT_NULL;
         }
+        _write_pump(func);
+        rt_mutex_release(&data->lock);
 
         return RT_EOK;
     }
@@ -1023,6 +1238,19 @@ static rt_err_t _function_enable(ufunction_t func)
         rt_kprintf("no memory\n");
         return -RT_ENOMEM;
     }
+    data->chunk[0].buffer = (rt_uint8_t*)rt_malloc(2 * MSTORAGE_CHUNK_SECTORS * data->geometry.bytes_per_sector);
+    if(data->chunk[0].buffer == RT_NULL)
+    {
+        rt_free(data->ep_in->buffer);
+        rt_free(data->ep_out->buffer);
+        data->ep_in->buffer = RT_NULL;
+        data->ep_out->buffer = RT_NULL;
+        rt_kprintf("no memory\n");
+        return -RT_ENOMEM;
+    }
+    data->chunk[1].buffer = data->chunk[0].buffer + MSTORAGE_CHUNK_SECTORS * data->geometry.bytes_per_sector;
+    data->chunk[0].status = CHUNK_FREE;
+    data->chunk[1].status = CHUNK_FREE;
 
     /* prepare to read CBW request */
     data->ep_out->request.buffer = data->ep_out->buffer;
@@ -1048,6 +1276,22 @@ static rt_err_t _function_disable(ufunction_t func)
     LOG_D("Mass storage function disabled");
 
     data = (struct mstorage*)func->user_data;
+
+    /* stop the pipe, then let the disk worker finish its chunk */
+    rt_mutex_take(&data->lock, RT_WAITING_FOREVER);
+    data->status = STAT_CBW;
+    rt_mutex_release(&data->lock);
+    _pipe_wait_idle(data);
+    if(data->chunk[0].buffer != RT_NULL)
+    {
+        rt_free(data->chunk[0].buffer);
+        data->chunk[0].buffer = RT_NULL;
+        data->chunk[1].buffer = RT_NULL;
+    }
+    data->chunk[0].status = CHUNK_FREE;
+    data->chunk[1].status = CHUNK_FREE;
+    data->rx_chunk = RT_NULL;
+
     if(data->ep_in->buffer != RT_NULL)
     {
         rt_free(data->ep_in->buffer);
@@ -1102,6 +1346,7 @@ ufunction_t rt_usbd_function_mstorage_create(udevice_t device)
     ufunction_t func;
     ualtsetting_t setting;
     umass_desc_t mass_desc;
+    rt_thread_t worker;
 
     /* parameter check */
     RT_ASSERT(device != RT_NULL);
@@ -1122,6 +1367,16 @@ ufunction_t rt_usbd_function_mstorage_create(udevice_t device)
     rt_memset(data, 0, sizeof(struct mstorage));
     func->user_data = (void*)data;
 
+    /* the disk side of the READ_10/WRITE_10 pipe */
+    rt_mutex_init(&data->lock, "msc", RT_IPC_FLAG_PRIO);
+    rt_completion_init(&data->idle);
+    data->jobs = rt_mb_create("msc", 2, RT_IPC_FLAG_FIFO);
+    RT_ASSERT(data->jobs != RT_NULL);
+    worker = rt_thread_create("mstorage", _disk_worker_entry, func,
+                              RT_USBD_THREAD_STACK_SZ, RT_USBD_THREAD_PRIO, 20);
+    RT_ASSERT(worker != RT_NULL);
+    rt_thread_startup(worker);
+
     /* create an interface object */
     intf = rt_usbd_interface_new(device, _interface_handler);
 
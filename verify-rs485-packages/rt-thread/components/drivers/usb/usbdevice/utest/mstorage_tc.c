@@ -0,0 +1,306 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "usbd_tc.h"
+#include "utest.h"
+
+/*
+ * Mass storage throughput on the stub controller, so only the class and
+ * the disk are measured, not a bus. Every run of a unit sends
+ * MSC_TC_COMMANDS READ_10 or WRITE_10 commands of MSC_TC_SECTORS sectors
+ * and checks each CSW. The write unit writes back what it read, the disk
+ * is left as it was. If the build has no disk named
+ * RT_USB_MSTORAGE_DISK_NAME a RAM disk is registered by that name; this
+ * has to happen before the first usb testcase configures the device, so
+ * run this testcase first then. KB/s is the bytes per run over the
+ * median of:
+ *
+ *     utest_bench -n 20 testcases.drivers.usb.mstorage
+ */
+
+#define MSC_TC_SECTORS      32      /* per command, four chunks of the default size */
+#define MSC_TC_COMMANDS     16
+#define MSC_TC_RAM_SECTORS  64
+
+static rt_uint8_t ep_in, ep_out;
+static struct rt_semaphore out_sem;
+static struct rt_semaphore csw_sem;
+static struct ustorage_csw csw;
+static rt_uint32_t tag;
+static rt_uint8_t *host_buf;
+static rt_uint8_t *in_buf;
+static rt_size_t in_got, in_len;
+static rt_device_t disk;
+static struct rt_device_blk_geometry geometry;
+
+static struct rt_device ram_disk;
+static rt_uint8_t *ram;
+static rt_uint32_t ram_reads, ram_writes;
+
+static rt_ssize_t ram_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    if (pos + size > MSC_TC_RAM_SECTORS)
+        return 0;
+
+    rt_memcpy(buffer, ram + pos * 512, size * 512);
+    ram_reads += size;
+
+    return size;
+}
+
+static rt_ssize_t ram_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    if (pos + size > MSC_TC_RAM_SECTORS)
+        return 0;
+
+    rt_memcpy(ram + pos * 512, buffer, size * 512);
+    ram_writes += size;
+
+    return size;
+}
+
+static rt_err_t ram_control(rt_device_t dev, int cmd, void *args)
+{
+    struct rt_device_blk_geometry *geo;
+
+    if (cmd == RT_DEVICE_CTRL_BLK_GETGEOME)
+    {
+        geo = (struct rt_device_blk_geometry *)args;
+        geo->bytes_per_sector = 512;
+        geo->block_size = 512;
+        geo->sector_count = MSC_TC_RAM_SECTORS;
+    }
+
+    return RT_EOK;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops ram_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    ram_read,
+    ram_write,
+    ram_control
+};
+#endif
+
+static rt_err_t ram_disk_register(void)
+{
+    int i;
+
+    ram = rt_malloc(MSC_TC_RAM_SECTORS * 512);
+    if (ram == RT_NULL)
+        return -RT_ENOMEM;
+    for (i = 0; i < MSC_TC_RAM_SECTORS; i ++)
+    {
+        rt_memset(ram + i * 512, i, 512);
+    }
+
+    ram_disk.type = RT_Device_Class_Block;
+#ifdef RT_USING_DEVICE_OPS
+    ram_disk.ops = &ram_ops;
+#else
+    ram_disk.read = ram_read;
+    ram_disk.write = ram_write;
+    ram_disk.control = ram_control;
+#endif
+
+    /* the class keeps it open, it stays registered */
+    return rt_device_register(&ram_disk, RT_USB_MSTORAGE_DISK_NAME, RT_DEVICE_FLAG_RDWR);
+}
+
+static void msc_tc_prepare(rt_uint8_t addr, void *buf, rt_size_t size)
+{
+    if (addr == ep_out)
+        rt_sem_release(&out_sem);
+}
+
+static void msc_tc_write(rt_uint8_t addr, void *buf, rt_size_t size)
+{
+    struct ustorage_csw status;
+
+    if (addr != ep_in)
+        return;
+
+    rt_memcpy(&status, buf, size < SIZEOF_CSW ? size : SIZEOF_CSW);
+    if (size == SIZEOF_CSW && status.signature == CSW_SIGNATURE)
+    {
+        csw = status;
+        rt_sem_release(&csw_sem);
+        return;
+    }
+
+    if (in_got + size <= in_len)
+        rt_memcpy(in_buf + in_got, buf, size);
+    in_got += size;
+}
+
+/* the host sends into every armed OUT packet in turn */
+static int msc_tc_out(const void *buf, rt_size_t len)
+{
+    struct usbd_tc_ep *out = &usbd_tc_out[USBD_TC_EP_IDX(ep_out)];
+    const rt_uint8_t *src = buf;
+    rt_size_t n;
+
+    while (len > 0)
+    {
+        if (rt_sem_take(&out_sem, RT_TICK_PER_SECOND) != RT_EOK)
+            return 1;
+
+        n = out->size < len ? out->size : len;
+        rt_memcpy(out->buf, src, n);
+        rt_usbd_ep_out_handler(&usbd_tc_dcd, ep_out, n);
+        src += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+static int msc_tc_command(rt_uint8_t op, rt_uint32_t block, rt_uint16_t count, void *buf)
+{
+    struct ustorage_cbw cbw;
+    rt_size_t len = count * geometry.bytes_per_sector;
+
+    rt_memset(&cbw, 0, sizeof(cbw));
+    cbw.signature = CBW_SIGNATURE;
+    cbw.tag = ++tag;
+    cbw.xfer_len = len;
+    cbw.dflags = (op == SCSI_READ_10) ? USB_DIR_IN : 0;
+    cbw.cb_len = 10;
+    cbw.cb[0] = op;
+    cbw.cb[2] = block >> 24;
+    cbw.cb[3] = block >> 16;
+    cbw.cb[4] = block >> 8;
+    cbw.cb[5] = block;
+    cbw.cb[7] = count >> 8;
+    cbw.cb[8] = count;
+
+    in_buf = buf;
+    in_got = 0;
+    in_len = (op == SCSI_READ_10) ? len : 0;
+
+    if (msc_tc_out(&cbw, SIZEOF_CBW) != 0)
+        return 1;
+    if (op == SCSI_WRITE_10 && msc_tc_out(buf, len) != 0)
+        return 1;
+    if (rt_sem_take(&csw_sem, RT_TICK_PER_SECOND) != RT_EOK)
+        return 1;
+
+    if (csw.tag != tag || csw.status != 0 || csw.data_reside != 0)
+        return 1;
+    if (in_got != in_len)
+        return 1;
+
+    return 0;
+}
+
+static rt_err_t msc_tc_init(void)
+{
+    if (rt_device_find(RT_USB_MSTORAGE_DISK_NAME) == RT_NULL && ram_disk_register() != RT_EOK)
+        return -RT_ERROR;
+
+    if (usbd_tc_setup() != RT_EOK)
+        return -RT_ERROR;
+
+    /* the class opens the disk when it is configured, not after */
+    disk = rt_device_find(RT_USB_MSTORAGE_DISK_NAME);
+    if (disk == RT_NULL || disk->ref_count == 0)
+        return -RT_ERROR;
+    if (rt_device_control(disk, RT_DEVICE_CTRL_BLK_GETGEOME, &geometry) != RT_EOK ||
+        geometry.sector_count <= MSC_TC_SECTORS)
+        return -RT_ERROR;
+
+    if (usbd_tc_intf(USB_CLASS_MASS_STORAGE, &ep_in, &ep_out) < 0)
+        return -RT_ERROR;
+
+    host_buf = rt_malloc(MSC_TC_SECTORS * geometry.bytes_per_sector);
+    if (host_buf == RT_NULL)
+        return -RT_ENOMEM;
+
+    /* the CBW is armed since the device was configured */
+    rt_sem_init(&out_sem, "msc_out", 1, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&csw_sem, "msc_csw", 0, RT_IPC_FLAG_FIFO);
+    usbd_tc_hooks.prepare = msc_tc_prepare;
+    usbd_tc_hooks.write = msc_tc_write;
+
+    return RT_EOK;
+}
+
+static rt_err_t msc_tc_cleanup(void)
+{
+    usbd_tc_hooks.prepare = RT_NULL;
+    usbd_tc_hooks.write = RT_NULL;
+    rt_sem_detach(&out_sem);
+    rt_sem_detach(&csw_sem);
+    rt_free(host_buf);
+    host_buf = RT_NULL;
+
+    return RT_EOK;
+}
+
+static void msc_read(void)
+{
+    rt_uint32_t block;
+    int i, j, bad = 0;
+
+    ram_reads = 0;
+    for (i = 0; i < MSC_TC_COMMANDS; i ++)
+    {
+        block = (i * MSC_TC_SECTORS) % (geometry.sector_count - MSC_TC_SECTORS);
+        bad += msc_tc_command(SCSI_READ_10, block, MSC_TC_SECTORS, host_buf);
+
+        if (disk != &ram_disk)
+            continue;
+        for (j = 0; j < MSC_TC_SECTORS; j ++)
+        {
+            if (host_buf[j * 512] != (rt_uint8_t)(block + j) ||
+                host_buf[j * 512 + 511] != (rt_uint8_t)(block + j))
+                bad ++;
+        }
+    }
+
+    if (disk == &ram_disk)
+        uassert_int_equal(ram_reads, MSC_TC_COMMANDS * MSC_TC_SECTORS);
+    uassert_int_equal(bad, 0);
+}
+
+static void msc_write(void)
+{
+    int i, bad = 0;
+
+    bad += msc_tc_command(SCSI_READ_10, 0, MSC_TC_SECTORS, host_buf);
+    uassert_int_equal(bad, 0);
+    if (bad)
+        return;
+
+    ram_writes = 0;
+    for (i = 0; i < MSC_TC_COMMANDS; i ++)
+    {
+        bad += msc_tc_command(SCSI_WRITE_10, 0, MSC_TC_SECTORS, host_buf);
+    }
+
+    if (disk == &ram_disk)
+    {
+        uassert_int_equal(ram_writes, MSC_TC_COMMANDS * MSC_TC_SECTORS);
+        uassert_int_equal(ram[(MSC_TC_SECTORS - 1) * 512], MSC_TC_SECTORS - 1);
+    }
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(msc_read);
+    UTEST_UNIT_RUN(msc_write);
+}
+UTEST_TC_EXPORT(testcase, "testcases.drivers.usb.mstorage", msc_tc_init, msc_tc_cleanup, 30);
@@ -0,0 +1,255 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include "usbd_tc.h"
+
+/* give the usbd thread time to handle what was signalled */
+#define USBD_TC_SETTLE_MS       10
+
+struct udcd usbd_tc_dcd;
+struct usbd_tc_ep usbd_tc_out[32];
+struct usbd_tc_ep usbd_tc_in[32];
+struct usbd_tc_hooks usbd_tc_hooks;
+
+static rt_bool_t ready;
+
+static struct ep_id _ep_pool[] =
+{
+    {0x0,  USB_EP_ATTR_CONTROL,     USB_DIR_INOUT,  64, ID_ASSIGNED  },
+    {0x1,  USB_EP_ATTR_BULK,        USB_DIR_IN,     64, ID_UNASSIGNED},
+    {0x1,  USB_EP_ATTR_BULK,        USB_DIR_OUT,    64, ID_UNASSIGNED},
+    {0x2,  USB_EP_ATTR_INT,         USB_DIR_IN,     64, ID_UNASSIGNED},
+    {0x2,  USB_EP_ATTR_INT,         USB_DIR_OUT,    64, ID_UNASSIGNED},
+    {0x3,  USB_EP_ATTR_BULK,        USB_DIR_IN,     64, ID_UNASSIGNED},
+    {0x3,  USB_EP_ATTR_BULK,        USB_DIR_OUT,    64, ID_UNASSIGNED},
+    {0x4,  USB_EP_ATTR_BULK,        USB_DIR_IN,     64, ID_UNASSIGNED},
+    {0x4,  USB_EP_ATTR_BULK,        USB_DIR_OUT,    64, ID_UNASSIGNED},
+    {0x5,  USB_EP_ATTR_INT,         USB_DIR_IN,     64, ID_UNASSIGNED},
+    {0xFF, USB_EP_ATTR_TYPE_MASK,   USB_DIR_MASK,   0,  ID_ASSIGNED  },
+};
+
+static rt_err_t _set_address(rt_uint8_t address)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _set_config(rt_uint8_t address)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _ep_set_stall(rt_uint8_t address)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _ep_clear_stall(rt_uint8_t address)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _ep_enable(uep_t ep)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _ep_disable(uep_t ep)
+{
+    return RT_EOK;
+}
+
+static rt_ssize_t _ep_read_prepare(rt_uint8_t address, void *buffer, rt_size_t size)
+{
+    struct usbd_tc_ep *ep = &usbd_tc_out[USBD_TC_EP_IDX(address)];
+
+    ep->buf = buffer;
+    ep->size = size;
+    ep->count ++;
+    if (usbd_tc_hooks.prepare)
+    {
+        usbd_tc_hooks.prepare(address, buffer, size);
+    }
+
+    return size;
+}
+
+static rt_ssize_t _ep_read(rt_uint8_t address, void *buffer)
+{
+    /* the testcase passes the size of every OUT packet */
+    return 0;
+}
+
+static rt_ssize_t _ep_write(rt_uint8_t address, void *buffer, rt_size_t size)
+{
+    struct usbd_tc_ep *ep = &usbd_tc_in[USBD_TC_EP_IDX(address)];
+
+    ep->buf = buffer;
+    ep->size = size;
+    ep->count ++;
+    if (usbd_tc_hooks.write)
+    {
+        usbd_tc_hooks.write(address, buffer, size);
+    }
+
+    /* the host takes every IN packet at once */
+    if ((address & 0x0f) != 0)
+    {
+        rt_usbd_ep_in_handler(&usbd_tc_dcd, address, size);
+    }
+
+    return size;
+}
+
+static rt_err_t _ep0_send_status(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _suspend(void)
+{
+    return RT_EOK;
+}
+
+static rt_err_t _wakeup(void)
+{
+    return RT_EOK;
+}
+
+const static struct udcd_ops _udc_ops =
+{
+    _set_address,
+    _set_config,
+    _ep_set_stall,
+    _ep_clear_stall,
+    _ep_enable,
+    _ep_disable,
+    _ep_read_prepare,
+    _ep_read,
+    _ep_write,
+    _ep0_send_status,
+    _suspend,
+    _wakeup,
+};
+
+/**
+ * This function registers the stub controller, builds the usb device on it
+ * and configures it the way a host would. It is done once, the usb device
+ * stack can not be torn down again.
+ *
+ * @return RT_EOK on successful, -RT_EBUSY if another controller is registered.
+ */
+rt_err_t usbd_tc_setup(void)
+{
+    rt_device_t udc;
+
+    if (ready)
+    {
+        return RT_EOK;
+    }
+
+    udc = rt_device_find("usbd");
+    if (udc != RT_NULL)
+    {
+        return (udc == &usbd_tc_dcd.parent) ? -RT_ERROR : -RT_EBUSY;
+    }
+
+    rt_memset(&usbd_tc_dcd, 0, sizeof(struct udcd));
+    usbd_tc_dcd.parent.type = RT_Device_Class_USBDevice;
+    usbd_tc_dcd.ops = &_udc_ops;
+    usbd_tc_dcd.ep_pool = _ep_pool;
+    usbd_tc_dcd.ep0.id = &_ep_pool[0];
+    rt_device_register(&usbd_tc_dcd.parent, "usbd", 0);
+    if (rt_usb_device_init() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    usbd_tc_request(USB_REQ_TYPE_STANDARD | USB_REQ_TYPE_DEVICE, USB_REQ_SET_ADDRESS, 1, 0, 0);
+    usbd_tc_request(USB_REQ_TYPE_STANDARD | USB_REQ_TYPE_DEVICE, USB_REQ_SET_CONFIGURATION, 1, 0, 0);
+    ready = RT_TRUE;
+
+    return RT_EOK;
+}
+
+/**
+ * This function sends a setup packet and waits for the stack to handle it.
+ */
+rt_err_t usbd_tc_request(rt_uint8_t type, rt_uint8_t request, rt_uint16_t value,
+                         rt_uint16_t index, rt_uint16_t length)
+{
+    struct urequest setup;
+    rt_err_t result;
+
+    setup.request_type = type;
+    setup.bRequest = request;
+    setup.wValue = value;
+    setup.wIndex = index;
+    setup.wLength = length;
+    result = rt_usbd_ep0_setup_handler(&usbd_tc_dcd, &setup);
+    rt_thread_mdelay(USBD_TC_SETTLE_MS);
+
+    return result;
+}
+
+/**
+ * This function finds the first interface of a class in the configuration.
+ *
+ * @param intf_class the interface class.
+ * @param ep_in the bulk IN endpoint address of the interface, may be RT_NULL.
+ * @param ep_out the bulk OUT endpoint address of the interface, may be RT_NULL.
+ *
+ * @return the interface number, or -1 if there is none.
+ */
+int usbd_tc_intf(rt_uint8_t intf_class, rt_uint8_t *ep_in, rt_uint8_t *ep_out)
+{
+    udevice_t device;
+    ufunction_t func;
+    uintf_t intf;
+    uep_t ep;
+    rt_list_t *i, *j, *k;
+
+    device = rt_usbd_find_device(&usbd_tc_dcd);
+    if (device == RT_NULL || device->curr_cfg == RT_NULL)
+    {
+        return -1;
+    }
+
+    for (i = device->curr_cfg->func_list.next; i != &device->curr_cfg->func_list; i = i->next)
+    {
+        func = rt_list_entry(i, struct ufunction, list);
+        for (j = func->intf_list.next; j != &func->intf_list; j = j->next)
+        {
+            intf = rt_list_entry(j, struct uinterface, list);
+            if (intf->curr_setting->intf_desc->bInterfaceClass != intf_class)
+            {
+                continue;
+            }
+            for (k = intf->curr_setting->ep_list.next; k != &intf->curr_setting->ep_list; k = k->next)
+            {
+                ep = rt_list_entry(k, struct uendpoint, list);
+                if ((ep->ep_desc->bmAttributes & USB_EP_ATTR_TYPE_MASK) != USB_EP_ATTR_BULK)
+                {
+                    continue;
+                }
+                if ((EP_ADDRESS(ep) & USB_DIR_IN) && ep_in)
+                {
+                    *ep_in = EP_ADDRESS(ep);
+                }
+                else if (!(EP_ADDRESS(ep) & USB_DIR_IN) && ep_out)
+                {
+                    *ep_out = EP_ADDRESS(ep);
+                }
+            }
+            return intf->intf_num;
+        }
+    }
+
+    return -1;
+}
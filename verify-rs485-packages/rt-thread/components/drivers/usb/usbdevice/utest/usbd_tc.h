@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#ifndef __USBD_TC_H__
+#define __USBD_TC_H__
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "drivers/usb_device.h"
+
+/*
+ * A device controller with no hardware behind it for the usb device
+ * testcases. It records the buffers the stack hands to the endpoints and
+ * completes IN packets at once, like a host that is always ready. The
+ * testcase plays the host for OUT packets with rt_usbd_ep_out_handler().
+ * It only works on a build with no other controller registered as "usbd".
+ */
+
+#define USBD_TC_EP_IDX(addr)    (((addr) & 0x0f) | (((addr) & USB_DIR_IN) ? 16 : 0))
+
+struct usbd_tc_ep
+{
+    void *buf;                  /* last buffer prepared or written */
+    rt_size_t size;
+    rt_uint32_t count;          /* prepares or writes so far */
+};
+
+struct usbd_tc_hooks
+{
+    /* called from the context of the stack, may be RT_NULL */
+    void (*prepare)(rt_uint8_t addr, void *buf, rt_size_t size);
+    void (*write)(rt_uint8_t addr, void *buf, rt_size_t size);
+};
+
+extern struct udcd usbd_tc_dcd;
+extern struct usbd_tc_ep usbd_tc_out[32];
+extern struct usbd_tc_ep usbd_tc_in[32];
+extern struct usbd_tc_hooks usbd_tc_hooks;
+
+rt_err_t usbd_tc_setup(void);
+rt_err_t usbd_tc_request(rt_uint8_t type, rt_uint8_t request, rt_uint16_t value,
+                         rt_uint16_t index, rt_uint16_t length);
+int usbd_tc_intf(rt_uint8_t intf_class, rt_uint8_t *ep_in, rt_uint8_t *ep_out);
+
+#endif /* __USBD_TC_H__ */
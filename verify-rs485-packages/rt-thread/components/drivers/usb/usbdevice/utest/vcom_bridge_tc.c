@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "usbd_tc.h"
+#include "../class/cdc.h"
+#include "utest.h"
+
+/*
+ * The vcom ping-pong endpoints and the bridge interface on the stub
+ * controller. An OUT packet must reach the bridge in the endpoint buffer
+ * itself with the other buffer already armed, the host is only held off
+ * while the bridge holds both, IN packets go out from the caller's buffer
+ * and a new line coding is handed to the bridge. Time a packet round with:
+ *
+ *     utest_bench -n 100 testcases.drivers.usb.vcom_bridge
+ */
+
+#define VCOM_TC_PACKET      48
+
+static int comm_intf;
+static rt_uint8_t ep_in, ep_out;
+static void *held[4];
+static rt_size_t held_size[4];
+static int held_nr;
+static struct ucdc_line_coding coding;
+static int coding_nr;
+
+static void vcom_tc_out_packet(void *buf, rt_size_t size, void *user_data)
+{
+    if (held_nr < 4)
+    {
+        held[held_nr] = buf;
+        held_size[held_nr] = size;
+    }
+    held_nr ++;
+}
+
+static void vcom_tc_line_coding(const struct ucdc_line_coding *line_coding, void *user_data)
+{
+    coding = *line_coding;
+    coding_nr ++;
+}
+
+static const struct vcom_bridge_ops vcom_tc_ops =
+{
+    vcom_tc_out_packet,
+    vcom_tc_line_coding,
+};
+
+/* the host sends one OUT packet into the armed buffer */
+static void *vcom_tc_host_out(rt_uint8_t fill)
+{
+    void *buf = usbd_tc_out[USBD_TC_EP_IDX(ep_out)].buf;
+
+    rt_memset(buf, fill, VCOM_TC_PACKET);
+    rt_usbd_ep_out_handler(&usbd_tc_dcd, ep_out, VCOM_TC_PACKET);
+    rt_thread_mdelay(10);
+
+    return buf;
+}
+
+static rt_err_t vcom_tc_init(void)
+{
+    if (usbd_tc_setup() != RT_EOK)
+        return -RT_ERROR;
+
+    comm_intf = usbd_tc_intf(USB_CDC_CLASS_COMM, RT_NULL, RT_NULL);
+    if (comm_intf < 0 || usbd_tc_intf(USB_CLASS_CDC_DATA, &ep_in, &ep_out) < 0)
+        return -RT_ERROR;
+
+    /* the host opens the port */
+    usbd_tc_request(USB_REQ_TYPE_CLASS | USB_REQ_TYPE_INTERFACE, CDC_SET_CONTROL_LINE_STATE,
+                    0x01, comm_intf, 0);
+    held_nr = 0;
+    coding_nr = 0;
+
+    return rt_usb_vcom_bridge_attach(&vcom_tc_ops, RT_NULL);
+}
+
+static rt_err_t vcom_tc_cleanup(void)
+{
+    int i;
+
+    rt_usb_vcom_bridge_detach();
+    for (i = 0; i < held_nr && i < 4; i++)
+    {
+        if (held[i])
+            rt_usb_vcom_out_release(held[i]);
+    }
+    held_nr = 0;
+
+    return RT_EOK;
+}
+
+static void vcom_pingpong(void)
+{
+    struct usbd_tc_ep *out = &usbd_tc_out[USBD_TC_EP_IDX(ep_out)];
+    rt_uint32_t count;
+    void *a, *b;
+
+    uassert_int_equal(rt_usb_vcom_bridge_attach(&vcom_tc_ops, RT_NULL), -RT_EBUSY);
+
+    /* the first packet is handed over in place, the other buffer is armed */
+    a = vcom_tc_host_out(0x11);
+    uassert_int_equal(held_nr, 1);
+    uassert_true(held[0] == a);
+    uassert_int_equal(held_size[0], VCOM_TC_PACKET);
+    uassert_int_equal(((rt_uint8_t *)held[0])[VCOM_TC_PACKET - 1], 0x11);
+    b = out->buf;
+    uassert_true(b != RT_NULL && b != a);
+
+    /* with both buffers held nothing is armed, the host is NAKed */
+    count = out->count;
+    uassert_true(vcom_tc_host_out(0x22) == b);
+    uassert_int_equal(held_nr, 2);
+    uassert_true(held[1] == b);
+    uassert_int_equal(out->count, count);
+
+    /* a released buffer goes back on the endpoint */
+    rt_usb_vcom_out_release(a);
+    held[0] = RT_NULL;
+    uassert_int_equal(out->count, count + 1);
+    uassert_true(out->buf == a);
+
+    /* the other one is not armed twice */
+    rt_usb_vcom_out_release(b);
+    held[1] = RT_NULL;
+    uassert_int_equal(out->count, count + 1);
+}
+
+static void vcom_in_zero_copy(void)
+{
+    struct usbd_tc_ep *in = &usbd_tc_in[USBD_TC_EP_IDX(ep_in)];
+    static rt_uint8_t packet[VCOM_TC_PACKET];
+    rt_uint32_t count = in->count;
+
+    uassert_int_equal(rt_usb_vcom_in_submit(packet, sizeof(packet)), RT_EOK);
+    uassert_int_equal(rt_usb_vcom_in_wait(RT_TICK_PER_SECOND), RT_EOK);
+    uassert_int_equal(in->count, count + 1);
+    uassert_true(in->buf == packet);
+    uassert_int_equal(in->size, sizeof(packet));
+}
+
+static void vcom_line_coding(void)
+{
+    struct ucdc_line_coding host_coding = {115200, 0, 0, 8};
+    struct usbd_tc_ep *ep0 = &usbd_tc_out[USBD_TC_EP_IDX(EP0_OUT_ADDR)];
+
+    usbd_tc_request(USB_REQ_TYPE_CLASS | USB_REQ_TYPE_INTERFACE, CDC_SET_LINE_CODING,
+                    0, comm_intf, sizeof(host_coding));
+    uassert_not_null(ep0->buf);
+    if (ep0->buf == RT_NULL)
+        return;
+
+    /* the data stage of the request */
+    rt_memcpy(ep0->buf, &host_coding, sizeof(host_coding));
+    rt_usbd_ep0_out_handler(&usbd_tc_dcd, sizeof(host_coding));
+    rt_thread_mdelay(10);
+
+    uassert_int_equal(coding_nr, 1);
+    uassert_int_equal(coding.dwDTERate, 115200);
+    uassert_int_equal(coding.bDataBits, 8);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(vcom_pingpong);
+    UTEST_UNIT_RUN(vcom_in_zero_copy);
+    UTEST_UNIT_RUN(vcom_line_coding);
+}
+UTEST_TC_EXPORT(testcase, "testcases.drivers.usb.vcom_bridge", vcom_tc_init, vcom_tc_cleanup, 10);
@@ -0,0 +1,245 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "utest.h"
+
+/*
+ * Operations per second of the virtio devices of QEMU virt. In every run
+ * of a blk testcase each of 1 or 4 threads reads VIRTIO_TC_OPS blocks of
+ * 4 KB at pseudo random sectors of virtio-blk0, so with a multi-queue
+ * disk (-device virtio-blk-device,num-queues=4) the threads go to their
+ * own queues. In every run of the net testcase VIRTIO_TC_FRAMES minimal
+ * broadcast frames of the local experimental ethertype are sent on an
+ * idle virtio-net0. The ops per second are VIRTIO_TC_OPS times the
+ * threads, or VIRTIO_TC_FRAMES, over the median of:
+ *
+ *     utest_bench -n 20 testcases.drivers.virtio.*
+ */
+
+#ifndef VIRTIO_TC_BLK
+#define VIRTIO_TC_BLK           "virtio-blk0"
+#endif
+#ifndef VIRTIO_TC_NET
+#define VIRTIO_TC_NET           "virtio-net0"
+#endif
+#define VIRTIO_TC_THREADS_MAX   4
+#define VIRTIO_TC_OPS           256
+#define VIRTIO_TC_SECTORS       8
+#define VIRTIO_TC_FRAMES        1024
+#define VIRTIO_TC_STACK_SIZE    2048
+
+#ifdef RT_USING_VIRTIO_BLK
+static rt_device_t blk;
+static rt_uint32_t blk_sectors;
+static struct rt_semaphore go_sem;
+static struct rt_semaphore done_sem;
+static int threads_num;
+static volatile int stopping;
+static rt_atomic_t fails;
+static rt_uint8_t bufs[VIRTIO_TC_THREADS_MAX][VIRTIO_TC_SECTORS * 512];
+
+static void virtio_tc_reader(void *param)
+{
+    rt_uint8_t *buf = bufs[(rt_ubase_t)param];
+    rt_uint32_t seed = (rt_ubase_t)param + 1;
+    rt_off_t pos;
+    int i;
+
+    while (1)
+    {
+        rt_sem_take(&go_sem, RT_WAITING_FOREVER);
+        if (stopping)
+        {
+            break;
+        }
+
+        for (i = 0; i < VIRTIO_TC_OPS; i++)
+        {
+            seed = seed * 1103515245 + 12345;
+            pos = (seed >> 8) % (blk_sectors - VIRTIO_TC_SECTORS);
+            if (rt_device_read(blk, pos, buf, VIRTIO_TC_SECTORS) != VIRTIO_TC_SECTORS)
+            {
+                rt_atomic_add(&fails, 1);
+                break;
+            }
+        }
+        rt_sem_release(&done_sem);
+    }
+
+    rt_sem_release(&done_sem);
+}
+
+static rt_err_t virtio_blk_tc_init(int num)
+{
+    struct rt_device_blk_geometry geometry;
+    rt_thread_t tid;
+    char name[RT_NAME_MAX];
+
+    blk = rt_device_find(VIRTIO_TC_BLK);
+    if (blk == RT_NULL || rt_device_open(blk, RT_DEVICE_OFLAG_RDONLY) != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+    if (rt_device_control(blk, RT_DEVICE_CTRL_BLK_GETGEOME, &geometry) != RT_EOK ||
+        geometry.sector_count <= VIRTIO_TC_SECTORS)
+    {
+        rt_device_close(blk);
+        return -RT_ERROR;
+    }
+    blk_sectors = geometry.sector_count;
+
+    rt_sem_init(&go_sem, "vio_go", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&done_sem, "vio_done", 0, RT_IPC_FLAG_FIFO);
+    rt_atomic_store(&fails, 0);
+    stopping = 0;
+
+    for (threads_num = 0; threads_num < num; threads_num++)
+    {
+        rt_snprintf(name, sizeof(name), "vio%d", threads_num);
+        tid = rt_thread_create(name, virtio_tc_reader, (void *)(rt_ubase_t)threads_num,
+                               VIRTIO_TC_STACK_SIZE, rt_thread_self()->current_priority, 10);
+        if (tid == RT_NULL)
+        {
+            break;
+        }
+        rt_thread_startup(tid);
+    }
+
+    return threads_num == num ? RT_EOK : -RT_ENOMEM;
+}
+
+static rt_err_t virtio_blk_tc_init_1(void)
+{
+    return virtio_blk_tc_init(1);
+}
+
+static rt_err_t virtio_blk_tc_init_4(void)
+{
+    return virtio_blk_tc_init(VIRTIO_TC_THREADS_MAX);
+}
+
+static rt_err_t virtio_blk_tc_cleanup(void)
+{
+    int i;
+
+    stopping = 1;
+    for (i = 0; i < threads_num; i++)
+    {
+        rt_sem_release(&go_sem);
+    }
+    for (i = 0; i < threads_num; i++)
+    {
+        rt_sem_take(&done_sem, RT_WAITING_FOREVER);
+    }
+    threads_num = 0;
+
+    rt_sem_detach(&go_sem);
+    rt_sem_detach(&done_sem);
+
+    return rt_device_close(blk);
+}
+
+static void virtio_blk_reads(void)
+{
+    int i;
+
+    for (i = 0; i < threads_num; i++)
+    {
+        rt_sem_release(&go_sem);
+    }
+    for (i = 0; i < threads_num; i++)
+    {
+        rt_sem_take(&done_sem, RT_WAITING_FOREVER);
+    }
+
+    uassert_int_equal(rt_atomic_load(&fails), 0);
+}
+
+static void testcase_blk_1(void)
+{
+    UTEST_UNIT_RUN(virtio_blk_reads);
+}
+UTEST_TC_EXPORT(testcase_blk_1, "testcases.drivers.virtio.blk_1", virtio_blk_tc_init_1, virtio_blk_tc_cleanup, 30);
+
+static void testcase_blk_4(void)
+{
+    UTEST_UNIT_RUN(virtio_blk_reads);
+}
+UTEST_TC_EXPORT(testcase_blk_4, "testcases.drivers.virtio.blk_4", virtio_blk_tc_init_4, virtio_blk_tc_cleanup, 30);
+#endif /* RT_USING_VIRTIO_BLK */
+
+#ifdef RT_USING_VIRTIO_NET
+#include <netif/ethernetif.h>
+
+static struct eth_device *eth;
+static struct pbuf *frame;
+
+static rt_err_t virtio_net_tc_init(void)
+{
+    rt_uint8_t *data;
+
+    eth = (struct eth_device *)rt_device_find(VIRTIO_TC_NET);
+    if (eth == RT_NULL || eth->eth_tx == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+
+    frame = pbuf_alloc(PBUF_RAW, 60, PBUF_RAM);
+    if (frame == RT_NULL)
+    {
+        return -RT_ENOMEM;
+    }
+    data = (rt_uint8_t *)frame->payload;
+    rt_memset(data, 0, 60);
+    /* broadcast, from the locally administered 02:00:00:00:00:01 */
+    rt_memset(data, 0xff, 6);
+    data[6] = 0x02;
+    data[11] = 0x01;
+    /* IEEE 802 local experimental ethertype, nobody answers it */
+    data[12] = 0x88;
+    data[13] = 0xb5;
+
+    return RT_EOK;
+}
+
+static rt_err_t virtio_net_tc_cleanup(void)
+{
+    if (frame)
+    {
+        pbuf_free(frame);
+        frame = RT_NULL;
+    }
+
+    return RT_EOK;
+}
+
+static void virtio_net_frames(void)
+{
+    int i, bad = 0;
+
+    for (i = 0; i < VIRTIO_TC_FRAMES; i++)
+    {
+        if (eth->eth_tx(&eth->parent, frame) != RT_EOK)
+        {
+            bad ++;
+        }
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase_net(void)
+{
+    UTEST_UNIT_RUN(virtio_net_frames);
+}
+UTEST_TC_EXPORT(testcase_net, "testcases.drivers.virtio.net_tx", virtio_net_tc_init, virtio_net_tc_cleanup, 30);
+#endif /* RT_USING_VIRTIO_NET */
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
  * 2023-10-12     fangjianzhou support SDL2
+ * 2026-10-17     RT-Thread    add batched avail updates and event index
  */
 
 #include <rtthread.h>
@@ -25,6 +26,7 @@ void virtio_reset_device(struct virtio_device *dev)
     _virtio_dev_check(dev);
 
     dev->mmio_config->status = 0;
+    dev->features = 0;
 }
 
 void virtio_status_acknowledge_driver(struct virtio_device *dev)
@@ -62,6 +64,16 @@ rt_bool_t virtio_has_feature(struct virtio_device *dev, rt_uint32_t feature_bit)
     return !!(dev->mmio_config->device_features & (1UL << feature_bit));
 }
 
+rt_uint32_t virtio_negotiate_features(struct virtio_device *dev, rt_uint32_t unsupported)
+{
+    _virtio_dev_check(dev);
+
+    dev->features = dev->mmio_config->device_features & ~unsupported;
+    dev->mmio_config->driver_features = dev->features;
+
+    return dev->features;
+}
+
 rt_err_t virtio_queues_alloc(struct virtio_device *dev, rt_size_t queues_num)
 {
     _virtio_dev_check(dev);
@@ -136,6 +148,9 @@ rt_err_t virtio_queue_init(struct virtio_device *dev, rt_uint32_t queue_index, r
             (rt_ubase_t)&queue->avail->ring[ring_size] + VIRTQ_AVAIL_RES_SIZE);
 
     queue->used_idx = 0;
+    queue->avail_pending = 0;
+    queue->kick_idx = 0;
+    queue->event_idx = !!(dev->features & (1UL << VIRTIO_F_RING_EVENT_IDX));
 
     /* All descriptors start out unused */
     for (i = 0; i < ring_size; ++i)
@@ -182,21 +197,110 @@ void virtio_queue_notify(struct virtio_device *dev, rt_uint32_t queue_index)
 
 void virtio_submit_chain(struct virtio_device *dev, rt_uint32_t queue_index, rt_uint16_t desc_index)
 {
-    rt_size_t ring_size;
+    virtio_queue_add_chain(dev, queue_index, desc_index);
+    virtio_queue_kick_prepare(dev, queue_index);
+}
+
+void virtio_queue_add_chain(struct virtio_device *dev, rt_uint32_t queue_index, rt_uint16_t desc_index)
+{
+    struct virtq *queue;
+
+    _virtio_dev_check(dev);
+
+    queue = &dev->queues[queue_index];
+
+    /* Tell the device the first index in our chain of descriptors, the idx is updated once per batch */
+    queue->avail->ring[(rt_uint16_t)(queue->avail->idx + queue->avail_pending) % queue->num] = desc_index;
+    queue->avail_pending++;
+}
+
+rt_bool_t virtio_queue_kick_prepare(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    rt_uint16_t old_idx, new_idx;
+    struct virtq *queue;
+
+    _virtio_dev_check(dev);
+
+    queue = &dev->queues[queue_index];
+
+    if (queue->avail_pending > 0)
+    {
+        rt_hw_dsb();
+
+        /* Tell the device all the avail ring entries of this batch are available */
+        queue->avail->idx += queue->avail_pending;
+        queue->avail_pending = 0;
+    }
+
+    /* The idx must be visible before we read the device's suppression hint */
+    rt_hw_dsb();
+
+    old_idx = queue->kick_idx;
+    new_idx = queue->avail->idx;
+
+    if (old_idx == new_idx)
+    {
+        return RT_FALSE;
+    }
+    queue->kick_idx = new_idx;
+
+    if (queue->event_idx)
+    {
+        return virtq_need_event(VIRTQ_AVAIL_EVENT(queue), new_idx, old_idx);
+    }
+
+    return !(queue->used->flags & VIRTQ_USED_F_NO_NOTIFY);
+}
+
+void virtio_queue_kick(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    if (virtio_queue_kick_prepare(dev, queue_index))
+    {
+        virtio_queue_notify(dev, queue_index);
+    }
+}
+
+void virtio_queue_disable_intr(struct virtio_device *dev, rt_uint32_t queue_index)
+{
     struct virtq *queue;
 
     _virtio_dev_check(dev);
 
     queue = &dev->queues[queue_index];
-    ring_size = queue->num;
 
-    /* Tell the device the first index in our chain of descriptors */
-    queue->avail->ring[queue->avail->idx % ring_size] = desc_index;
+    if (queue->event_idx)
+    {
+        /* An event the device has already passed, never hit before we move it */
+        VIRTQ_USED_EVENT(queue) = queue->used_idx - 1;
+    }
+    else
+    {
+        queue->avail->flags |= VIRTQ_AVAIL_F_NO_INTERRUPT;
+    }
     rt_hw_dsb();
+}
+
+rt_bool_t virtio_queue_enable_intr(struct virtio_device *dev, rt_uint32_t queue_index)
+{
+    struct virtq *queue;
+
+    _virtio_dev_check(dev);
 
-    /* Tell the device another avail ring entry is available */
-    queue->avail->idx++;
+    queue = &dev->queues[queue_index];
+
+    if (queue->event_idx)
+    {
+        /* Interrupt on the next used entry */
+        VIRTQ_USED_EVENT(queue) = queue->used_idx;
+    }
+    else
+    {
+        queue->avail->flags &= ~VIRTQ_AVAIL_F_NO_INTERRUPT;
+    }
     rt_hw_dsb();
+
+    /* Entries used before the device saw the hint will not interrupt, tell the caller to poll again */
+    return queue->used_idx != queue->used->idx;
 }
 
 rt_uint16_t virtio_alloc_desc(struct virtio_device *dev, rt_uint32_t queue_index)
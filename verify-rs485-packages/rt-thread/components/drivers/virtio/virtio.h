@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-9-16      GuEe-GUI     the first version
  * 2021-11-11     GuEe-GUI     modify to virtio common interface
+ * 2026-10-17     RT-Thread    add batched avail updates and event index
  */
 
 #ifndef __VIRTIO_H__
@@ -115,6 +116,8 @@ struct virtio_device
     struct virtq *queues;
     rt_size_t queues_num;
 
+    rt_uint32_t features;   /* Negotiated with virtio_negotiate_features() */
+
     union
     {
         rt_ubase_t *mmio_base;
@@ -135,6 +138,7 @@ void virtio_status_acknowledge_driver(struct virtio_device *dev);
 void virtio_status_driver_ok(struct virtio_device *dev);
 void virtio_interrupt_ack(struct virtio_device *dev);
 rt_bool_t virtio_has_feature(struct virtio_device *dev, rt_uint32_t feature_bit);
+rt_uint32_t virtio_negotiate_features(struct virtio_device *dev, rt_uint32_t unsupported);
 
 rt_err_t virtio_queues_alloc(struct virtio_device *dev, rt_size_t queues_num);
 void virtio_queues_free(struct virtio_device *dev);
@@ -143,6 +147,11 @@ void virtio_queue_destroy(struct virtio_device *dev, rt_uint32_t queue_index);
 void virtio_queue_notify(struct virtio_device *dev, rt_uint32_t queue_index);
 
 void virtio_submit_chain(struct virtio_device *dev, rt_uint32_t queue_index, rt_uint16_t desc_index);
+void virtio_queue_add_chain(struct virtio_device *dev, rt_uint32_t queue_index, rt_uint16_t desc_index);
+rt_bool_t virtio_queue_kick_prepare(struct virtio_device *dev, rt_uint32_t queue_index);
+void virtio_queue_kick(struct virtio_device *dev, rt_uint32_t queue_index);
+void virtio_queue_disable_intr(struct virtio_device *dev, rt_uint32_t queue_index);
+rt_bool_t virtio_queue_enable_intr(struct virtio_device *dev, rt_uint32_t queue_index);
 
 rt_uint16_t virtio_alloc_desc(struct virtio_device *dev, rt_uint32_t queue_index);
 void virtio_free_desc(struct virtio_device *dev, rt_uint32_t queue_index, rt_uint16_t desc_index);
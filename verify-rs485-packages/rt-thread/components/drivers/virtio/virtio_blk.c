@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-9-16      GuEe-GUI     the first version
  * 2021-11-11     GuEe-GUI     using virtio common interface
+ * 2026-10-17     RT-Thread    support multiqueue and event index, sleep on completion
  */
 
 #include <rthw.h>
@@ -18,69 +19,79 @@
 
 #include <virtio_blk.h>
 
+static rt_uint32_t virtio_blk_select_queue(struct virtio_blk_device *virtio_blk_dev)
+{
+    rt_uint32_t queues_num = virtio_blk_dev->virtio_dev.queues_num;
+
+    if (queues_num == 1)
+    {
+        return VIRTIO_BLK_QUEUE;
+    }
+
+#ifdef RT_USING_SMP
+    /* Keep each CPU on its own queue, they do not share a lock */
+    return rt_hw_cpu_id() % queues_num;
+#else
+    /* Spread the requests over the host's queue workers */
+    return virtio_blk_dev->next_queue++ % queues_num;
+#endif
+}
+
 static void virtio_blk_rw(struct virtio_blk_device *virtio_blk_dev, rt_off_t pos, void *buffer, rt_size_t count,
     int flags)
 {
+    rt_base_t level;
     rt_uint16_t idx[3];
     rt_size_t size = count * virtio_blk_dev->config->blk_size;
     struct virtio_device *virtio_dev = &virtio_blk_dev->virtio_dev;
+    rt_uint32_t queue_index = virtio_blk_select_queue(virtio_blk_dev);
+    struct virtio_blk_queue *blk_queue = &virtio_blk_dev->queues[queue_index];
 
-#ifdef RT_USING_SMP
-    rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
+    level = rt_spin_lock_irqsave(&blk_queue->spinlock);
 
     /* Allocate 3 descriptors */
-    while (virtio_alloc_desc_chain(virtio_dev, 0, 3, idx))
+    while (virtio_alloc_desc_chain(virtio_dev, queue_index, 3, idx))
     {
-#ifdef RT_USING_SMP
-        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
+        rt_spin_unlock_irqrestore(&blk_queue->spinlock, level);
+
         rt_thread_yield();
 
-#ifdef RT_USING_SMP
-        level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
+        level = rt_spin_lock_irqsave(&blk_queue->spinlock);
     }
 
-    virtio_blk_dev->info[idx[0]].status = 0xff;
-    virtio_blk_dev->info[idx[0]].valid = RT_TRUE;
-    virtio_blk_dev->info[idx[0]].req.type = flags;
-    virtio_blk_dev->info[idx[0]].req.ioprio = 0;
-    virtio_blk_dev->info[idx[0]].req.sector = pos * (virtio_blk_dev->config->blk_size / 512);
+    blk_queue->info[idx[0]].status = 0xff;
+    blk_queue->info[idx[0]].valid = RT_TRUE;
+    blk_queue->info[idx[0]].req.type = flags;
+    blk_queue->info[idx[0]].req.ioprio = 0;
+    blk_queue->info[idx[0]].req.sector = pos * (virtio_blk_dev->config->blk_size / 512);
+    rt_completion_init(&blk_queue->info[idx[0]].done);
 
     flags = flags == VIRTIO_BLK_T_OUT ? 0 : VIRTQ_DESC_F_WRITE;
 
-    virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[0],
-            VIRTIO_VA2PA(&virtio_blk_dev->info[idx[0]].req), sizeof(struct virtio_blk_req), VIRTQ_DESC_F_NEXT, idx[1]);
+    virtio_fill_desc(virtio_dev, queue_index, idx[0],
+            VIRTIO_VA2PA(&blk_queue->info[idx[0]].req), sizeof(struct virtio_blk_req), VIRTQ_DESC_F_NEXT, idx[1]);
 
-    virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[1],
+    virtio_fill_desc(virtio_dev, queue_index, idx[1],
             VIRTIO_VA2PA(buffer), size, flags | VIRTQ_DESC_F_NEXT, idx[2]);
 
-    virtio_fill_desc(virtio_dev, VIRTIO_BLK_QUEUE, idx[2],
-            VIRTIO_VA2PA(&virtio_blk_dev->info[idx[0]].status), sizeof(rt_uint8_t), VIRTQ_DESC_F_WRITE, 0);
+    virtio_fill_desc(virtio_dev, queue_index, idx[2],
+            VIRTIO_VA2PA(&blk_queue->info[idx[0]].status), sizeof(rt_uint8_t), VIRTQ_DESC_F_WRITE, 0);
+
+    virtio_queue_add_chain(virtio_dev, queue_index, idx[0]);
 
-    virtio_submit_chain(virtio_dev, VIRTIO_BLK_QUEUE, idx[0]);
+    /* No notify if the device is still working on the requests of other threads */
+    virtio_queue_kick(virtio_dev, queue_index);
 
-    virtio_queue_notify(virtio_dev, VIRTIO_BLK_QUEUE);
+    rt_spin_unlock_irqrestore(&blk_queue->spinlock, level);
 
     /* Wait for virtio_blk_isr() to done */
-    while (virtio_blk_dev->info[idx[0]].valid)
-    {
-#ifdef RT_USING_SMP
-        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
-        rt_thread_yield();
+    rt_completion_wait(&blk_queue->info[idx[0]].done, RT_WAITING_FOREVER);
 
-#ifdef RT_USING_SMP
-        level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
-    }
+    level = rt_spin_lock_irqsave(&blk_queue->spinlock);
 
-    virtio_free_desc_chain(virtio_dev, VIRTIO_BLK_QUEUE, idx[0]);
+    virtio_free_desc_chain(virtio_dev, queue_index, idx[0]);
 
-#ifdef RT_USING_SMP
-    rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
+    rt_spin_unlock_irqrestore(&blk_queue->spinlock, level);
 }
 
 static rt_ssize_t virtio_blk_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t count)
@@ -141,45 +152,54 @@ const static struct rt_device_ops virtio_blk_ops =
 
 static void virtio_blk_isr(int irqno, void *param)
 {
+    int i;
     rt_uint32_t id;
+    rt_base_t level;
     struct virtio_blk_device *virtio_blk_dev = (struct virtio_blk_device *)param;
     struct virtio_device *virtio_dev = &virtio_blk_dev->virtio_dev;
-    struct virtq *queue = &virtio_dev->queues[VIRTIO_BLK_QUEUE];
-
-#ifdef RT_USING_SMP
-    rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
 
     virtio_interrupt_ack(virtio_dev);
     rt_hw_dsb();
 
-    /* The device increments disk.used->idx when it adds an entry to the used ring */
-    while (queue->used_idx != queue->used->idx)
+    for (i = 0; i < virtio_dev->queues_num; ++i)
     {
-        rt_hw_dsb();
-        id = queue->used->ring[queue->used_idx % queue->num].id;
+        struct virtq *queue = &virtio_dev->queues[i];
+        struct virtio_blk_queue *blk_queue = &virtio_blk_dev->queues[i];
 
-        RT_ASSERT(virtio_blk_dev->info[id].status == 0);
+        level = rt_spin_lock_irqsave(&blk_queue->spinlock);
 
-        /* Done with buffer */
-        virtio_blk_dev->info[id].valid = RT_FALSE;
+        do
+        {
+            /* The device increments disk.used->idx when it adds an entry to the used ring */
+            while (queue->used_idx != queue->used->idx)
+            {
+                rt_hw_dsb();
+                id = queue->used->ring[queue->used_idx % queue->num].id;
 
-        queue->used_idx++;
-    }
+                RT_ASSERT(blk_queue->info[id].status == 0);
 
-#ifdef RT_USING_SMP
-    rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
+                /* Done with buffer */
+                blk_queue->info[id].valid = RT_FALSE;
+                rt_completion_done(&blk_queue->info[id].done);
+
+                queue->used_idx++;
+            }
+        } while (virtio_queue_enable_intr(virtio_dev, i));
+
+        rt_spin_unlock_irqrestore(&blk_queue->spinlock, level);
+    }
 }
 
 rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 {
+    int i;
     static int dev_no = 0;
     char dev_name[RT_NAME_MAX];
+    rt_uint32_t queues_num = 1;
     struct virtio_device *virtio_dev;
     struct virtio_blk_device *virtio_blk_dev;
 
-    virtio_blk_dev = rt_malloc(sizeof(struct virtio_blk_device));
+    virtio_blk_dev = rt_calloc(1, sizeof(struct virtio_blk_device));
 
     if (virtio_blk_dev == RT_NULL)
     {
@@ -200,29 +220,52 @@ rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     virtio_status_acknowledge_driver(virtio_dev);
 
     /* Negotiate features */
-    virtio_dev->mmio_config->driver_features = virtio_dev->mmio_config->device_features & ~(
+    virtio_negotiate_features(virtio_dev,
             (1 << VIRTIO_BLK_F_RO) |
-            (1 << VIRTIO_BLK_F_MQ) |
             (1 << VIRTIO_BLK_F_SCSI) |
             (1 << VIRTIO_BLK_F_CONFIG_WCE) |
             (1 << VIRTIO_F_ANY_LAYOUT) |
-            (1 << VIRTIO_F_RING_EVENT_IDX) |
             (1 << VIRTIO_F_RING_INDIRECT_DESC));
 
+    if ((virtio_dev->features & (1 << VIRTIO_BLK_F_MQ)) && virtio_blk_dev->config->num_queues > 1)
+    {
+        queues_num = virtio_blk_dev->config->num_queues;
+
+        if (queues_num > VIRTIO_BLK_MAX_QUEUES)
+        {
+            queues_num = VIRTIO_BLK_MAX_QUEUES;
+        }
+    }
+
     /* Tell device that feature negotiation is complete and we're completely ready */
     virtio_status_driver_ok(virtio_dev);
 
-    if (virtio_queues_alloc(virtio_dev, 1) != RT_EOK)
+    if (virtio_queues_alloc(virtio_dev, queues_num) != RT_EOK)
     {
         goto _alloc_fail;
     }
 
-    /* Initialize queue 0 */
-    if (virtio_queue_init(virtio_dev, 0, VIRTIO_BLK_QUEUE_RING_SIZE) != RT_EOK)
+    virtio_blk_dev->queues = rt_malloc(sizeof(struct virtio_blk_queue) * queues_num);
+
+    if (virtio_blk_dev->queues == RT_NULL)
     {
         goto _alloc_fail;
     }
 
+    for (i = 0; i < queues_num; ++i)
+    {
+        rt_spin_lock_init(&virtio_blk_dev->queues[i].spinlock);
+
+        if (virtio_queue_init(virtio_dev, i, VIRTIO_BLK_QUEUE_RING_SIZE) != RT_EOK)
+        {
+            while (i-- > 0)
+            {
+                virtio_queue_destroy(virtio_dev, i);
+            }
+            goto _alloc_fail;
+        }
+    }
+
     virtio_blk_dev->parent.type = RT_Device_Class_Block;
 #ifdef RT_USING_DEVICE_OPS
     virtio_blk_dev->parent.ops  = &virtio_blk_ops;
@@ -247,6 +290,7 @@ _alloc_fail:
     if (virtio_blk_dev != RT_NULL)
     {
         virtio_queues_free(virtio_dev);
+        rt_free(virtio_blk_dev->queues);
         rt_free(virtio_blk_dev);
     }
     return -RT_ENOMEM;
@@ -7,18 +7,31 @@
  * Date           Author       Notes
  * 2021-9-16      GuEe-GUI     the first version
  * 2021-11-11     GuEe-GUI     using virtio common interface
+ * 2026-10-17     RT-Thread    support multiqueue and more requests in flight
  */
 
 #ifndef __VIRTIO_BLK_H__
 #define __VIRTIO_BLK_H__
 
 #include <rtdef.h>
+#include <ipc/completion.h>
 
 #include <virtio.h>
 
 #define VIRTIO_BLK_QUEUE            0
 #define VIRTIO_BLK_BYTES_PER_SECTOR 512
-#define VIRTIO_BLK_QUEUE_RING_SIZE  4
+
+#ifdef RT_VIRTIO_BLK_QUEUE_RING_SIZE
+#define VIRTIO_BLK_QUEUE_RING_SIZE  RT_VIRTIO_BLK_QUEUE_RING_SIZE
+#else
+#define VIRTIO_BLK_QUEUE_RING_SIZE  16
+#endif
+
+#ifdef RT_VIRTIO_BLK_MAX_QUEUES
+#define VIRTIO_BLK_MAX_QUEUES       RT_VIRTIO_BLK_MAX_QUEUES
+#else
+#define VIRTIO_BLK_MAX_QUEUES       4
+#endif
 
 #define VIRTIO_BLK_F_RO             5   /* Disk is read-only */
 #define VIRTIO_BLK_F_SCSI           7   /* Supports scsi command passthru */
@@ -82,13 +95,9 @@ struct virtio_blk_config
     rt_uint32_t secure_erase_sector_alignment;
 } __attribute__((packed));
 
-struct virtio_blk_device
+struct virtio_blk_queue
 {
-    struct rt_device parent;
-
-    struct virtio_device virtio_dev;
-
-    struct virtio_blk_config *config;
+    struct rt_spinlock spinlock;
 
     struct
     {
@@ -96,10 +105,24 @@ struct virtio_blk_device
         rt_uint8_t status;
 
         struct virtio_blk_req req;
+        struct rt_completion done;
 
     } info[VIRTIO_BLK_QUEUE_RING_SIZE];
 };
 
+struct virtio_blk_device
+{
+    struct rt_device parent;
+
+    struct virtio_device virtio_dev;
+
+    struct virtio_blk_config *config;
+
+    /* One per virtqueue, requests of a queue only take its own lock */
+    struct virtio_blk_queue *queues;
+    rt_uint32_t next_queue;
+};
+
 rt_err_t rt_virtio_blk_init(rt_ubase_t *mmio_base, rt_uint32_t irq);
 
 #endif /* __VIRTIO_BLK_H__ */
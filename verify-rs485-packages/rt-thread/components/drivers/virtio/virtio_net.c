@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2026-10-17     RT-Thread    batch avail updates, event index, rx interrupt mitigation
  */
 
 #include <rthw.h>
@@ -17,6 +18,9 @@
 
 #include <virtio_net.h>
 
+/* Delay before polling rx again when no pbuf could be allocated */
+#define VIRTIO_NET_RX_RETRY_TICK    (RT_TICK_PER_SECOND / 100 + 1)
+
 static rt_err_t virtio_net_tx(rt_device_t dev, struct pbuf *p)
 {
     rt_uint16_t id;
@@ -28,6 +32,20 @@ static rt_err_t virtio_net_tx(rt_device_t dev, struct pbuf *p)
     rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
 #endif
 
+    /* The slot is reused in ring order, wait for the device if it is still in flight */
+    while ((rt_uint16_t)(queue_tx->avail->idx - queue_tx->used->idx) >= queue_tx->num / 2)
+    {
+#ifdef RT_USING_SMP
+        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
+#endif
+        rt_thread_yield();
+
+#ifdef RT_USING_SMP
+        level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
+#endif
+        rt_hw_dsb();
+    }
+
     id = (queue_tx->avail->idx * 2) % queue_tx->num;
 
     virtio_net_dev->info[id].hdr.flags = 0;
@@ -49,9 +67,10 @@ static rt_err_t virtio_net_tx(rt_device_t dev, struct pbuf *p)
     virtio_fill_desc(virtio_dev, VIRTIO_NET_QUEUE_TX, id + 1,
             VIRTIO_VA2PA(virtio_net_dev->info[id].rx_buffer), p->tot_len, 0, 0);
 
-    virtio_submit_chain(virtio_dev, VIRTIO_NET_QUEUE_TX, id);
+    virtio_queue_add_chain(virtio_dev, VIRTIO_NET_QUEUE_TX, id);
 
-    virtio_queue_notify(virtio_dev, VIRTIO_NET_QUEUE_TX);
+    /* The device is still sending the earlier frames if it has not asked for a notify */
+    virtio_queue_kick(virtio_dev, VIRTIO_NET_QUEUE_TX);
 
     virtio_alloc_desc(virtio_dev, VIRTIO_NET_QUEUE_TX);
     virtio_alloc_desc(virtio_dev, VIRTIO_NET_QUEUE_TX);
@@ -67,65 +86,80 @@ static struct pbuf *virtio_net_rx(rt_device_t dev)
 {
     rt_uint16_t id;
     rt_uint32_t len;
-    struct pbuf *p = RT_NULL, *new, *ret = RT_NULL;
+    struct pbuf *p = RT_NULL;
     struct virtio_net_device *virtio_net_dev = (struct virtio_net_device *)dev;
     struct virtio_device *virtio_dev = &virtio_net_dev->virtio_dev;
     struct virtq *queue_rx = &virtio_dev->queues[VIRTIO_NET_QUEUE_RX];
 
-    while (queue_rx->used_idx != queue_rx->used->idx)
-    {
 #ifdef RT_USING_SMP
-        rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
+    rt_base_t level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
 #endif
-        id = (queue_rx->used->ring[queue_rx->used_idx % queue_rx->num].id + 1) % queue_rx->num;
-        len = queue_rx->used->ring[queue_rx->used_idx % queue_rx->num].len - VIRTIO_NET_HDR_SIZE;
 
+    rt_hw_dsb();
+
+    if (queue_rx->used_idx == queue_rx->used->idx)
+    {
+        /* Give all the buffers consumed by this burst back with one notify */
+        virtio_queue_kick(virtio_dev, VIRTIO_NET_QUEUE_RX);
+
+        /* Interrupt on the next frame, or go on if one slipped in before that */
+        if (!virtio_queue_enable_intr(virtio_dev, VIRTIO_NET_QUEUE_RX))
+        {
 #ifdef RT_USING_SMP
-        rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
+            rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
 #endif
-        if (len > VIRTIO_NET_PAYLOAD_MAX_SIZE)
-        {
-            rt_kprintf("%s: Receive buffer's size = %u is too big!\n", virtio_net_dev->parent.parent.parent.name, len);
-            len = VIRTIO_NET_PAYLOAD_MAX_SIZE;
+            return RT_NULL;
         }
+        virtio_queue_disable_intr(virtio_dev, VIRTIO_NET_QUEUE_RX);
+    }
 
-        new = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    id = (queue_rx->used->ring[queue_rx->used_idx % queue_rx->num].id + 1) % queue_rx->num;
+    len = queue_rx->used->ring[queue_rx->used_idx % queue_rx->num].len - VIRTIO_NET_HDR_SIZE;
 
-        if (p != RT_NULL)
-        {
-            p->next = new;
-            p = p->next;
-        }
-        else
-        {
-            p = new;
-            ret = p;
-        }
+    if (len > VIRTIO_NET_PAYLOAD_MAX_SIZE)
+    {
+        rt_kprintf("%s: Receive buffer's size = %u is too big!\n", virtio_net_dev->parent.parent.parent.name, len);
+        len = VIRTIO_NET_PAYLOAD_MAX_SIZE;
+    }
 
-        if (p != RT_NULL)
-        {
-#ifdef RT_USING_SMP
-            level = rt_spin_lock_irqsave(&virtio_dev->spinlock);
-#endif
-            rt_memcpy(p->payload, (void *)queue_rx->desc[id].addr - PV_OFFSET, len);
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
 
-            queue_rx->used_idx++;
+    if (p != RT_NULL)
+    {
+        rt_memcpy(p->payload, (void *)queue_rx->desc[id].addr - PV_OFFSET, len);
 
-            virtio_submit_chain(virtio_dev, VIRTIO_NET_QUEUE_RX, id - 1);
+        queue_rx->used_idx++;
 
-            virtio_queue_notify(virtio_dev, VIRTIO_NET_QUEUE_RX);
+        virtio_queue_add_chain(virtio_dev, VIRTIO_NET_QUEUE_RX, id - 1);
 
-#ifdef RT_USING_SMP
-            rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
-#endif
-        }
-        else
+        /* Do not let a long burst starve the device of buffers */
+        if (queue_rx->avail_pending >= queue_rx->num / 2)
         {
-            break;
+            virtio_queue_kick(virtio_dev, VIRTIO_NET_QUEUE_RX);
         }
     }
+    else
+    {
+        /*
+         * Out of memory, leave the frame in the ring. The device has produced it
+         * already, so it will not interrupt for it: poll again from a timer.
+         */
+        virtio_queue_kick(virtio_dev, VIRTIO_NET_QUEUE_RX);
+        rt_timer_start(&virtio_net_dev->rx_retry);
+    }
 
-    return ret;
+#ifdef RT_USING_SMP
+    rt_spin_unlock_irqrestore(&virtio_dev->spinlock, level);
+#endif
+
+    return p;
+}
+
+static void virtio_net_rx_retry(void *param)
+{
+    struct virtio_net_device *virtio_net_dev = (struct virtio_net_device *)param;
+
+    eth_device_ready(&virtio_net_dev->parent);
 }
 
 static rt_err_t virtio_net_init(rt_device_t dev)
@@ -164,9 +198,12 @@ static rt_err_t virtio_net_init(rt_device_t dev)
 
     queue_rx->used_idx = queue_rx->used->idx;
 
-    queue_tx->avail->flags = VIRTQ_AVAIL_F_NO_INTERRUPT;
     queue_tx->avail->idx = 0;
 
+    /* Sent frames are reclaimed by ring order, no interrupt needed */
+    virtio_queue_disable_intr(virtio_dev, VIRTIO_NET_QUEUE_TX);
+
+    queue_rx->kick_idx = queue_rx->avail->idx;
     virtio_queue_notify(virtio_dev, VIRTIO_NET_QUEUE_RX);
 
     return eth_device_linkchange(&virtio_net_dev->parent, RT_TRUE);
@@ -225,6 +262,9 @@ static void virtio_net_isr(int irqno, void *param)
     {
         rt_hw_dsb();
 
+        /* virtio_net_rx() polls until the ring is empty, then turns it on again */
+        virtio_queue_disable_intr(virtio_dev, VIRTIO_NET_QUEUE_RX);
+
         eth_device_ready(&virtio_net_dev->parent);
     }
 
@@ -260,9 +300,9 @@ rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
     virtio_reset_device(virtio_dev);
     virtio_status_acknowledge_driver(virtio_dev);
 
-    virtio_dev->mmio_config->driver_features = virtio_dev->mmio_config->device_features & ~(
+    virtio_negotiate_features(virtio_dev,
             (1 << VIRTIO_NET_F_CTRL_VQ) |
-            (1 << VIRTIO_F_RING_EVENT_IDX));
+            (1 << VIRTIO_NET_F_MQ));
 
     virtio_status_driver_ok(virtio_dev);
 
@@ -298,6 +338,9 @@ rt_err_t rt_virtio_net_init(rt_ubase_t *mmio_base, rt_uint32_t irq)
 
     rt_snprintf(dev_name, RT_NAME_MAX, "virtio-net%d", dev_no++);
 
+    rt_timer_init(&virtio_net_dev->rx_retry, dev_name, virtio_net_rx_retry, virtio_net_dev,
+            VIRTIO_NET_RX_RETRY_TICK, RT_TIMER_FLAG_ONE_SHOT | RT_TIMER_FLAG_SOFT_TIMER);
+
     rt_hw_interrupt_install(irq, virtio_net_isr, virtio_net_dev, dev_name);
     rt_hw_interrupt_umask(irq);
 
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2026-10-17     RT-Thread    poll rx from a timer after running out of pbufs
  */
 
 #ifndef __VIRTIO_NET_H__
@@ -101,6 +102,9 @@ struct virtio_net_device
 
     struct virtio_net_config *config;
 
+    /* Poll rx again after running out of pbufs */
+    struct rt_timer rx_retry;
+
     struct
     {
         /* Transmit hdr */
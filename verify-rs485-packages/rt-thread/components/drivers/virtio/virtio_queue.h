@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2021-11-11     GuEe-GUI     the first version
+ * 2026-10-17     RT-Thread    add batched avail updates and event index
  */
 
 #ifndef __VIRTIO_QUEUE_H__
@@ -81,6 +82,10 @@ struct virtq
     rt_uint16_t used_idx;
     rt_bool_t *free;
     rt_size_t free_count;
+
+    rt_uint16_t avail_pending;  /* Chains in the avail ring not yet published by idx */
+    rt_uint16_t kick_idx;       /* avail->idx at the last notify */
+    rt_bool_t event_idx;        /* VIRTIO_F_RING_EVENT_IDX was negotiated */
 };
 
 #define VIRTQ_DESC_TOTAL_SIZE(ring_size)    (sizeof(struct virtq_desc) * (ring_size))
@@ -94,4 +99,17 @@ struct virtq
 
 #define VIRTQ_INVALID_DESC_ID   RT_UINT16_MAX
 
+/* Only valid if VIRTIO_F_RING_EVENT_IDX */
+#define VIRTQ_USED_EVENT(queue)     ((queue)->avail->ring[(queue)->num])
+#define VIRTQ_AVAIL_EVENT(queue)    (*(rt_uint16_t *)&(queue)->used->ring[(queue)->num])
+
+/*
+ * Whether moving an index from old_idx to new_idx passes event_idx, the
+ * other side only wants to hear about it in that case.
+ */
+rt_inline rt_bool_t virtq_need_event(rt_uint16_t event_idx, rt_uint16_t new_idx, rt_uint16_t old_idx)
+{
+    return (rt_uint16_t)(new_idx - event_idx - 1) < (rt_uint16_t)(new_idx - old_idx);
+}
+
 #endif /* __VIRTIO_QUEUE_H__ */
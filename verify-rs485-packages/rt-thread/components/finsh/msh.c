@@ -8,6 +8,7 @@
  * 2013-03-30     Bernard      the first verion for finsh
  * 2014-01-03     Bernard      msh can execute module.
  * 2017-07-19     Aubr.Cool    limit argc to RT_FINSH_ARG_MAX
+ * 2026-10-17     RT-Thread    binary search a sorted command index, batch execution
  */
 #include <rtthread.h>
 #include <string.h>
@@ -29,9 +30,26 @@
 #ifdef RT_USING_MODULE
 #include <dlmodule.h>
 #endif /* RT_USING_MODULE */
+#if defined(FINSH_USING_CMD_STAT) && defined(RT_USING_CPUTIME)
+#include <drivers/cputime.h>
+#endif /* FINSH_USING_CMD_STAT && RT_USING_CPUTIME */
 
 typedef int (*cmd_function_t)(int argc, char **argv);
 
+/* FSymTab sorted by name, built on the first lookup */
+static struct finsh_syscall **msh_cmd_index;
+static int msh_cmd_count;
+
+#ifdef FINSH_USING_CMD_STAT
+struct msh_cmd_stat
+{
+    rt_uint32_t count;
+    rt_uint64_t total;          /* microseconds */
+    rt_uint32_t max;            /* microseconds */
+};
+static struct msh_cmd_stat *msh_cmd_stats;
+#endif /* FINSH_USING_CMD_STAT */
+
 static int msh_help(int argc, char **argv)
 {
     rt_kprintf("RT-Thread shell commands:\n");
@@ -171,11 +189,131 @@ static int msh_split(char *cmd, rt_size_t length, char *argv[FINSH_ARG_MAX])
     return argc;
 }
 
-static cmd_function_t msh_get_cmd(char *cmd, int size)
+static void msh_cmd_index_sift(struct finsh_syscall **table, int root, int count)
+{
+    struct finsh_syscall *item = table[root];
+    int child;
+
+    while ((child = root * 2 + 1) < count)
+    {
+        if (child + 1 < count && strcmp(table[child + 1]->name, table[child]->name) > 0)
+            child ++;
+        if (strcmp(table[child]->name, item->name) <= 0)
+            break;
+
+        table[root] = table[child];
+        root = child;
+    }
+    table[root] = item;
+}
+
+static void msh_cmd_index_init(void)
+{
+    struct finsh_syscall *index;
+    struct finsh_syscall **table;
+#ifdef FINSH_USING_CMD_STAT
+    struct msh_cmd_stat *stats;
+#endif /* FINSH_USING_CMD_STAT */
+    rt_base_t level;
+    int count, i;
+
+    count = 0;
+    for (index = _syscall_table_begin;
+            index < _syscall_table_end;
+            FINSH_NEXT_SYSCALL(index))
+    {
+        count ++;
+    }
+    if (count == 0)
+        return;
+
+    table = (struct finsh_syscall **)rt_malloc(count * sizeof(struct finsh_syscall *));
+    if (table == RT_NULL)
+        return;
+
+    i = 0;
+    for (index = _syscall_table_begin;
+            index < _syscall_table_end;
+            FINSH_NEXT_SYSCALL(index))
+    {
+        table[i ++] = index;
+    }
+
+    /* heap sort, the table is only built once */
+    for (i = count / 2 - 1; i >= 0; i --)
+        msh_cmd_index_sift(table, i, count);
+    for (i = count - 1; i > 0; i --)
+    {
+        index = table[0];
+        table[0] = table[i];
+        table[i] = index;
+        msh_cmd_index_sift(table, 0, i);
+    }
+
+#ifdef FINSH_USING_CMD_STAT
+    stats = (struct msh_cmd_stat *)rt_calloc(count, sizeof(struct msh_cmd_stat));
+#endif /* FINSH_USING_CMD_STAT */
+
+    level = rt_hw_interrupt_disable();
+    if (msh_cmd_index == RT_NULL)
+    {
+#ifdef FINSH_USING_CMD_STAT
+        msh_cmd_stats = stats;
+        stats = RT_NULL;
+#endif /* FINSH_USING_CMD_STAT */
+        msh_cmd_count = count;
+        msh_cmd_index = table;
+        table = RT_NULL;
+    }
+    rt_hw_interrupt_enable(level);
+
+    /* someone else built it first */
+    if (table != RT_NULL)
+        rt_free(table);
+#ifdef FINSH_USING_CMD_STAT
+    if (stats != RT_NULL)
+        rt_free(stats);
+#endif /* FINSH_USING_CMD_STAT */
+}
+
+/* find a command by the first size characters of cmd, pos is its place in the index or -1 */
+static struct finsh_syscall *msh_find_syscall(const char *cmd, int size, int *pos)
 {
     struct finsh_syscall *index;
-    cmd_function_t cmd_func = RT_NULL;
+    int low, high, mid, result;
 
+    *pos = -1;
+    if (msh_cmd_index == RT_NULL)
+        msh_cmd_index_init();
+
+    if (msh_cmd_index != RT_NULL)
+    {
+        low = 0;
+        high = msh_cmd_count - 1;
+        while (low <= high)
+        {
+            mid = (low + high) / 2;
+            index = msh_cmd_index[mid];
+
+            result = strncmp(index->name, cmd, size);
+            if (result == 0 && index->name[size] != '\0')
+                result = 1;
+
+            if (result == 0)
+            {
+                *pos = mid;
+                return index;
+            }
+            if (result < 0)
+                low = mid + 1;
+            else
+                high = mid - 1;
+        }
+
+        return RT_NULL;
+    }
+
+    /* no memory for the index */
     for (index = _syscall_table_begin;
             index < _syscall_table_end;
             FINSH_NEXT_SYSCALL(index))
@@ -183,14 +321,82 @@ static cmd_function_t msh_get_cmd(char *cmd, int size)
         if (strncmp(index->name, cmd, size) == 0 &&
                 index->name[size] == '\0')
         {
-            cmd_func = (cmd_function_t)index->func;
-            break;
+            return index;
         }
     }
 
-    return cmd_func;
+    return RT_NULL;
+}
+
+static cmd_function_t msh_get_cmd(char *cmd, int size)
+{
+    struct finsh_syscall *index;
+    int pos;
+
+    index = msh_find_syscall(cmd, size, &pos);
+
+    return index ? (cmd_function_t)index->func : RT_NULL;
 }
 
+#ifdef FINSH_USING_CMD_STAT
+static rt_uint64_t msh_cmd_time(void)
+{
+#ifdef RT_USING_CPUTIME
+    return clock_cpu_microsecond(clock_cpu_gettime());
+#else
+    return (rt_uint64_t)rt_tick_get() * 1000000 / RT_TICK_PER_SECOND;
+#endif /* RT_USING_CPUTIME */
+}
+
+static void msh_cmd_stat_add(int pos, rt_uint64_t start)
+{
+    struct msh_cmd_stat *stat;
+    rt_uint32_t time;
+
+    if (pos < 0 || msh_cmd_stats == RT_NULL)
+        return;
+
+    time = (rt_uint32_t)(msh_cmd_time() - start);
+    stat = &msh_cmd_stats[pos];
+    stat->count ++;
+    stat->total += time;
+    if (time > stat->max)
+        stat->max = time;
+}
+
+static int msh_stat(int argc, char **argv)
+{
+    struct msh_cmd_stat *stat;
+    int i;
+
+    if (msh_cmd_index == RT_NULL || msh_cmd_stats == RT_NULL)
+    {
+        rt_kprintf("no command statistics.\n");
+        return -RT_ERROR;
+    }
+
+    if (argc == 2 && strcmp(argv[1], "-c") == 0)
+    {
+        rt_memset(msh_cmd_stats, 0, msh_cmd_count * sizeof(struct msh_cmd_stat));
+        return 0;
+    }
+
+    rt_kprintf("%-16s %10s %12s %10s\n", "command", "count", "avg(us)", "max(us)");
+    for (i = 0; i < msh_cmd_count; i ++)
+    {
+        stat = &msh_cmd_stats[i];
+        if (stat->count == 0)
+            continue;
+
+        rt_kprintf("%-16s %10u %12u %10u\n", msh_cmd_index[i]->name, stat->count,
+                   (rt_uint32_t)(stat->total / stat->count), stat->max);
+    }
+
+    return 0;
+}
+MSH_CMD_EXPORT(msh_stat, show the execution time of commands. -c to clear);
+#endif /* FINSH_USING_CMD_STAT */
+
 #if defined(RT_USING_MODULE) && defined(DFS_USING_POSIX)
 /* Return 0 on module executed. Other value indicate error.
  */
@@ -268,8 +474,13 @@ static int _msh_exec_cmd(char *cmd, rt_size_t length, int *retp)
 {
     int argc;
     rt_size_t cmd0_size = 0;
+    struct finsh_syscall *syscall;
     cmd_function_t cmd_func;
     char *argv[FINSH_ARG_MAX];
+    int pos;
+#ifdef FINSH_USING_CMD_STAT
+    rt_uint64_t start;
+#endif /* FINSH_USING_CMD_STAT */
 
     RT_ASSERT(cmd);
     RT_ASSERT(retp);
@@ -280,9 +491,10 @@ static int _msh_exec_cmd(char *cmd, rt_size_t length, int *retp)
     if (cmd0_size == 0)
         return -RT_ERROR;
 
-    cmd_func = msh_get_cmd(cmd, cmd0_size);
-    if (cmd_func == RT_NULL)
+    syscall = msh_find_syscall(cmd, cmd0_size, &pos);
+    if (syscall == RT_NULL)
         return -RT_ERROR;
+    cmd_func = (cmd_function_t)syscall->func;
 
     /* split arguments */
     rt_memset(argv, 0x00, sizeof(argv));
@@ -291,7 +503,13 @@ static int _msh_exec_cmd(char *cmd, rt_size_t length, int *retp)
         return -RT_ERROR;
 
     /* exec this command */
+#ifdef FINSH_USING_CMD_STAT
+    start = msh_cmd_time();
     *retp = cmd_func(argc, argv);
+    msh_cmd_stat_add(pos, start);
+#else
+    *retp = cmd_func(argc, argv);
+#endif /* FINSH_USING_CMD_STAT */
     return 0;
 }
 
@@ -552,6 +770,66 @@ int msh_exec(char *cmd, rt_size_t length)
     return -1;
 }
 
+/**
+ * @brief Execute newline separated commands in a buffer, without the shell.
+ *
+ * Empty lines and lines starting with '#' are skipped. The buffer is used
+ * as the command line of each command, so it is modified. Commands are
+ * dispatched directly, there is no echo, prompt or history.
+ *
+ * @param buf is the commands.
+ * @param size is the length of buf.
+ *
+ * @return the number of commands that returned a non-zero value.
+ */
+int msh_exec_batch(char *buf, rt_size_t size)
+{
+    char *line, *end;
+    rt_size_t length;
+    rt_bool_t terminated;
+    int failed = 0;
+
+    end = buf + size;
+    while (buf < end)
+    {
+        line = buf;
+        while (buf < end && *buf != '\n' && *buf != '\r' && *buf != '\0')
+            buf ++;
+        length = buf - line;
+        terminated = buf < end;
+        if (terminated)
+            *buf++ = '\0';
+
+        while (length > 0 && (*line == ' ' || *line == '\t'))
+        {
+            line ++;
+            length --;
+        }
+        if (length == 0 || *line == '#')
+            continue;
+
+        /* only a line that runs to the end of buf has no room for the terminator */
+        if (!terminated)
+        {
+            char last[FINSH_CMD_SIZE + 1];
+
+            if (length > FINSH_CMD_SIZE)
+                length = FINSH_CMD_SIZE;
+            rt_memcpy(last, line, length);
+            last[length] = '\0';
+            line = last;
+            if (msh_exec(line, length) != 0)
+                failed ++;
+            break;
+        }
+
+        if (msh_exec(line, length) != 0)
+            failed ++;
+    }
+
+    return failed;
+}
+
 static int str_common(const char *str1, const char *str2)
 {
     const char *str = str1;
@@ -795,7 +1073,7 @@ static msh_cmd_opt_t *msh_get_cmd_opt(char *opt_str)
     struct finsh_syscall *index;
     msh_cmd_opt_t *opt = RT_NULL;
     char *ptr;
-    int len;
+    int len, pos;
 
     ptr = strchr(opt_str, ' ');
     if (ptr)
@@ -807,16 +1085,9 @@ static msh_cmd_opt_t *msh_get_cmd_opt(char *opt_str)
         len = strlen(opt_str);
     }
 
-    for (index = _syscall_table_begin;
-            index < _syscall_table_end;
-            FINSH_NEXT_SYSCALL(index))
-    {
-        if (strncmp(index->name, opt_str, len) == 0 && index->name[len] == '\0')
-        {
-            opt = index->opt;
-            break;
-        }
-    }
+    index = msh_find_syscall(opt_str, len, &pos);
+    if (index)
+        opt = index->opt;
 
     return opt;
 }
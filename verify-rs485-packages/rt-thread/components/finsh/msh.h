@@ -18,6 +18,8 @@ void msh_auto_complete(char *prefix);
 
 int msh_exec_module(const char *cmd_line, int size);
 int msh_exec_script(const char *cmd_line, int size);
+int msh_exec_batch(char *buf, rt_size_t size);
+int msh_exec_batch_file(const char *path);
 
 #ifdef FINSH_USING_OPTION_COMPLETION
 void msh_opt_auto_complete(char *prefix);
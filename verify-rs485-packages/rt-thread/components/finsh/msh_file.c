@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2015-09-25     Bernard      the first verion for FinSH
  * 2021-06-09     Meco Man     implement tail command
+ * 2026-10-17     RT-Thread    add batch command
  */
 
 #include <rtthread.h>
@@ -152,6 +153,83 @@ int msh_exec_script(const char *cmd_line, int size)
     return ret;
 }
 
+/**
+ * @brief Execute a command file with msh_exec_batch(), a block at a time.
+ *
+ * @param path is the command file.
+ *
+ * @return the number of commands that returned a non-zero value, or -1 if
+ *         the file can not be read.
+ */
+int msh_exec_batch_file(const char *path)
+{
+    char *buf;
+    int fd, failed = 0;
+    int length = 0, size, used;
+
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return -1;
+
+    buf = (char *)rt_malloc(RT_CONSOLEBUF_SIZE * 2);
+    if (buf == RT_NULL)
+    {
+        close(fd);
+        return -1;
+    }
+
+    do
+    {
+        size = read(fd, buf + length, RT_CONSOLEBUF_SIZE * 2 - length);
+        if (size > 0)
+            length += size;
+
+        /* run the complete lines, keep the tail for the next block */
+        used = length;
+        if (size > 0)
+        {
+            while (used > 0 && buf[used - 1] != '\n' && buf[used - 1] != '\r')
+                used --;
+            /* a line longer than the buffer is cut */
+            if (used == 0 && length == RT_CONSOLEBUF_SIZE * 2)
+                used = length;
+        }
+
+        failed += msh_exec_batch(buf, used);
+        length -= used;
+        rt_memmove(buf, buf + used, length);
+    }
+    while (size > 0);
+
+    close(fd);
+    rt_free(buf);
+
+    return failed;
+}
+
+static int cmd_batch(int argc, char **argv)
+{
+    int failed;
+
+    if (argc != 2)
+    {
+        rt_kprintf("Usage: batch FILE\n");
+        return -1;
+    }
+
+    failed = msh_exec_batch_file(argv[1]);
+    if (failed < 0)
+    {
+        rt_kprintf("batch: can not read %s\n", argv[1]);
+        return -1;
+    }
+    if (failed > 0)
+        rt_kprintf("batch: %d commands failed\n", failed);
+
+    return failed ? -1 : 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_batch, batch, Run the commands in FILE without echo and prompt.);
+
 #ifdef DFS_USING_WORKDIR
     extern char working_directory[];
 #endif
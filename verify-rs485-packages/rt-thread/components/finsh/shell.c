@@ -16,6 +16,7 @@
  *                             initialization when use GNU GCC compiler.
  * 2016-11-26     armink       add password authentication
  * 2018-07-02     aozima       add custom prompt support.
+ * 2026-10-17     RT-Thread    enter the framed binary command mode on request.
  */
 
 #include <rthw.h>
@@ -666,6 +667,13 @@ static void finsh_thread_entry(void *parameter)
             if (shell->echo_mode)
                 rt_kprintf("\n");
             msh_exec(shell->line, shell->line_position);
+#ifdef FINSH_USING_FRAME
+            if (shell->frame_mode)
+            {
+                finsh_frame_run(shell);
+                shell->frame_mode = 0;
+            }
+#endif /* FINSH_USING_FRAME */
 
             rt_kprintf(FINSH_PROMPT);
             rt_memset(shell->line, 0, sizeof(shell->line));
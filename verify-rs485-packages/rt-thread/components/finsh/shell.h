@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2011-06-02     Bernard      Add finsh_get_prompt function declaration
+ * 2026-10-17     RT-Thread    add the framed binary command mode
  */
 
 #ifndef __SHELL_H__
@@ -66,6 +67,9 @@ struct finsh_shell
 
     rt_uint8_t echo_mode: 1;
     rt_uint8_t prompt_mode: 1;
+#ifdef FINSH_USING_FRAME
+    rt_uint8_t frame_mode: 1;
+#endif
 
 #ifdef FINSH_USING_HISTORY
     rt_uint16_t current_history;
@@ -106,4 +110,8 @@ void finsh_set_prompt_mode(rt_uint32_t prompt_mode);
 void finsh_thread_entry_sethook(void (*hook)(void));
 #endif /* RT_USING_HOOK */
 
+#ifdef FINSH_USING_FRAME
+void finsh_frame_run(struct finsh_shell *shell);
+#endif /* FINSH_USING_FRAME */
+
 #endif
@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+/*
+ * Framed binary command mode of the shell, for a program on the other end
+ * of the console instead of a terminal. The "frame" command switches the
+ * shell into it. All fields are little endian.
+ *
+ *   request : A5 5A | id:u16 | len:u16 | command[len]                  | crc:u16
+ *   response: A5 5A | id:u16 | len:u16 | ret:i32 | output[len - 4]     | crc:u16
+ *
+ * The crc is CRC-16/CCITT (0x1021, initial 0xFFFF) over id up to the end
+ * of the payload. A request with no command leaves the mode. The response
+ * with id 0 is sent once the mode is entered. Requests can be sent without
+ * waiting for the responses, they are executed in order.
+ *
+ * What the shell thread prints to the console while a command runs is
+ * returned in its response, output beyond FINSH_FRAME_OUT_SIZE is dropped.
+ * The other threads and the interrupts print to the console as before.
+ */
+
+#include <rthw.h>
+#include <string.h>
+
+#ifdef RT_USING_FINSH
+
+#include "shell.h"
+#include "msh.h"
+
+#ifdef FINSH_USING_FRAME
+
+#ifndef FINSH_FRAME_CMD_SIZE
+#define FINSH_FRAME_CMD_SIZE    256
+#endif
+#ifndef FINSH_FRAME_OUT_SIZE
+#define FINSH_FRAME_OUT_SIZE    1024
+#endif
+
+#define FRAME_MAGIC0            0xA5
+#define FRAME_MAGIC1            0x5A
+#define FRAME_HEAD_SIZE         6
+#define FRAME_CRC_SIZE          2
+#define FRAME_RET_SIZE          4
+#define FRAME_RX_SIZE           (2 * (FRAME_HEAD_SIZE + FINSH_FRAME_CMD_SIZE + FRAME_CRC_SIZE))
+#define FRAME_TX_SIZE           (FRAME_HEAD_SIZE + FRAME_RET_SIZE + FINSH_FRAME_OUT_SIZE + FRAME_CRC_SIZE)
+
+struct finsh_frame
+{
+    struct rt_device capture;   /* console in the frame mode */
+    rt_device_t console;        /* console outside of the frame mode */
+    rt_uint16_t console_flag;
+    rt_thread_t owner;          /* thread whose output is captured */
+    rt_size_t out_len;
+
+    rt_size_t rx_len;
+    rt_uint8_t rx[FRAME_RX_SIZE];
+    rt_uint8_t tx[FRAME_TX_SIZE];
+    char cmd[FINSH_FRAME_CMD_SIZE + 1];
+};
+
+static struct finsh_frame _frame;
+extern struct finsh_shell *shell;
+
+static rt_uint16_t finsh_frame_crc(const rt_uint8_t *data, rt_size_t size)
+{
+    rt_uint16_t crc = 0xFFFF;
+    int i;
+
+    while (size--)
+    {
+        crc ^= (rt_uint16_t)(*data++) << 8;
+        for (i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+}
+
+static rt_ssize_t finsh_frame_capture_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    struct finsh_frame *frame = (struct finsh_frame *)dev->user_data;
+    rt_size_t len, offset;
+    rt_base_t level;
+
+    if (rt_interrupt_get_nest() != 0 || rt_thread_self() != frame->owner)
+    {
+        /* not the output of the running command */
+        if (frame->console != RT_NULL)
+            rt_device_write(frame->console, pos, buffer, size);
+        return size;
+    }
+
+    level = rt_hw_interrupt_disable();
+    offset = frame->out_len;
+    len = FINSH_FRAME_OUT_SIZE - offset;
+    if (len > size)
+        len = size;
+    frame->out_len += len;
+    rt_hw_interrupt_enable(level);
+
+    rt_memcpy(&frame->tx[FRAME_HEAD_SIZE + FRAME_RET_SIZE + offset], buffer, len);
+
+    return size;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops finsh_frame_capture_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    finsh_frame_capture_write,
+    RT_NULL
+};
+#endif
+
+static void finsh_frame_send(rt_device_t dev, struct finsh_frame *frame, rt_uint16_t id, rt_int32_t ret)
+{
+    rt_uint8_t *tx = frame->tx;
+    rt_size_t len = FRAME_RET_SIZE + frame->out_len;
+    rt_uint16_t crc;
+
+    tx[0] = FRAME_MAGIC0;
+    tx[1] = FRAME_MAGIC1;
+    tx[2] = id & 0xFF;
+    tx[3] = id >> 8;
+    tx[4] = len & 0xFF;
+    tx[5] = len >> 8;
+    tx[6] = ret & 0xFF;
+    tx[7] = (ret >> 8) & 0xFF;
+    tx[8] = (ret >> 16) & 0xFF;
+    tx[9] = (ret >> 24) & 0xFF;
+
+    crc = finsh_frame_crc(&tx[2], FRAME_HEAD_SIZE - 2 + len);
+    tx[FRAME_HEAD_SIZE + len] = crc & 0xFF;
+    tx[FRAME_HEAD_SIZE + len + 1] = crc >> 8;
+
+    rt_device_write(dev, 0, tx, FRAME_HEAD_SIZE + len + FRAME_CRC_SIZE);
+}
+
+/* make the capture device the console until the frame mode is left */
+static void finsh_frame_console_capture(struct finsh_frame *frame, rt_device_t dev)
+{
+    frame->console = rt_console_get_device();
+    if (frame->console == RT_NULL)
+        return;
+
+    /*
+     * switching the console closes the old device, keep a console other than
+     * the shell device open for the output that is passed through
+     */
+    if (frame->console != dev)
+        rt_device_open(frame->console, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_STREAM);
+    frame->console_flag = frame->console->open_flag;
+    rt_console_set_device(frame->capture.parent.name);
+}
+
+static void finsh_frame_console_restore(struct finsh_frame *frame, rt_device_t dev)
+{
+    if (frame->console == RT_NULL)
+        return;
+
+    /* reopening it as the console must not change how the device is read */
+    rt_console_set_device(frame->console->parent.name);
+    frame->console->open_flag = frame->console_flag;
+    if (frame->console != dev)
+        rt_device_close(frame->console);
+    frame->console = RT_NULL;
+}
+
+static rt_int32_t finsh_frame_exec(struct finsh_frame *frame, rt_size_t len)
+{
+    rt_base_t level;
+    rt_int32_t ret;
+
+    level = rt_hw_interrupt_disable();
+    frame->out_len = 0;
+    rt_hw_interrupt_enable(level);
+    if (len == 0)
+        return 0;
+
+    /* print into the response while the command runs */
+    frame->owner = rt_thread_self();
+    ret = msh_exec(frame->cmd, len);
+    frame->owner = RT_NULL;
+
+    return ret;
+}
+
+/*
+ * handle the complete requests in the receive buffer,
+ * return RT_FALSE when asked to leave the frame mode
+ */
+static rt_bool_t finsh_frame_parse(rt_device_t dev, struct finsh_frame *frame)
+{
+    rt_uint8_t *rx = frame->rx;
+    rt_size_t pos = 0, len;
+    rt_uint16_t id, crc;
+    rt_bool_t running = RT_TRUE;
+
+    while (running && frame->rx_len - pos >= FRAME_HEAD_SIZE)
+    {
+        if (rx[pos] != FRAME_MAGIC0 || rx[pos + 1] != FRAME_MAGIC1)
+        {
+            pos ++;
+            continue;
+        }
+
+        len = rx[pos + 4] | (rx[pos + 5] << 8);
+        if (len > FINSH_FRAME_CMD_SIZE)
+        {
+            /* not a header, look for the next one */
+            pos ++;
+            continue;
+        }
+        if (frame->rx_len - pos < FRAME_HEAD_SIZE + len + FRAME_CRC_SIZE)
+            break;
+
+        crc = rx[pos + FRAME_HEAD_SIZE + len] | (rx[pos + FRAME_HEAD_SIZE + len + 1] << 8);
+        if (crc != finsh_frame_crc(&rx[pos + 2], FRAME_HEAD_SIZE - 2 + len))
+        {
+            pos ++;
+            continue;
+        }
+
+        id = rx[pos + 2] | (rx[pos + 3] << 8);
+        rt_memcpy(frame->cmd, &rx[pos + FRAME_HEAD_SIZE], len);
+        frame->cmd[len] = '\0';
+        pos += FRAME_HEAD_SIZE + len + FRAME_CRC_SIZE;
+
+        finsh_frame_send(dev, frame, id, finsh_frame_exec(frame, len));
+        if (len == 0)
+            running = RT_FALSE;
+    }
+
+    frame->rx_len -= pos;
+    rt_memmove(rx, rx + pos, frame->rx_len);
+
+    return running;
+}
+
+/**
+ * @ingroup finsh
+ *
+ * This function runs the framed binary command mode on the shell device,
+ * it returns when the other end leaves the mode.
+ *
+ * @param shell the shell.
+ */
+void finsh_frame_run(struct finsh_shell *shell)
+{
+    struct finsh_frame *frame = &_frame;
+    rt_device_t dev = shell->device;
+    rt_uint16_t stream;
+    rt_ssize_t size;
+
+    if (dev == RT_NULL)
+        return;
+
+    if (frame->capture.parent.name[0] == '\0')
+    {
+        frame->capture.type = RT_Device_Class_Char;
+#ifdef RT_USING_DEVICE_OPS
+        frame->capture.ops = &finsh_frame_capture_ops;
+#else
+        frame->capture.write = finsh_frame_capture_write;
+#endif
+        frame->capture.user_data = frame;
+        if (rt_device_register(&frame->capture, "fsh_cap", RT_DEVICE_FLAG_WRONLY) != RT_EOK)
+            return;
+    }
+
+    /* binary data, no "\r\n" conversion */
+    stream = dev->open_flag & RT_DEVICE_FLAG_STREAM;
+    dev->open_flag &= ~RT_DEVICE_FLAG_STREAM;
+
+    frame->rx_len = 0;
+    frame->out_len = 0;
+    frame->owner = RT_NULL;
+    finsh_frame_send(dev, frame, 0, 0);
+
+    finsh_frame_console_capture(frame, dev);
+
+    do
+    {
+        size = rt_device_read(dev, -1, &frame->rx[frame->rx_len], FRAME_RX_SIZE - frame->rx_len);
+        if (size <= 0)
+        {
+            rt_sem_take(&shell->rx_sem, RT_WAITING_FOREVER);
+            if (shell->device != dev)
+                break;
+            continue;
+        }
+        frame->rx_len += size;
+    }
+    while (finsh_frame_parse(dev, frame));
+
+    finsh_frame_console_restore(frame, dev);
+    dev->open_flag |= stream;
+}
+
+static int cmd_frame(int argc, char **argv)
+{
+    if (shell == RT_NULL || rt_thread_self() != rt_thread_find(FINSH_THREAD_NAME))
+    {
+        rt_kprintf("frame: only from the shell.\n");
+        return -RT_ERROR;
+    }
+
+    /* switched by the shell thread when this command returns */
+    shell->frame_mode = 1;
+
+    return 0;
+}
+MSH_CMD_EXPORT_ALIAS(cmd_frame, frame, switch the shell to the framed binary command mode);
+
+#endif /* FINSH_USING_FRAME */
+#endif /* RT_USING_FINSH */
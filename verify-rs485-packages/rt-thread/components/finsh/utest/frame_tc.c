@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shell.h"
+#include "msh.h"
+#include "utest.h"
+
+/*
+ * The framed command mode on a stub console device. Every run feeds
+ * FRAME_TC_REQS requests, handed out FRAME_TC_CHUNK bytes per read so
+ * that frames are split across reads, with a stray magic byte and a
+ * request with a broken crc in between, then the request that leaves the
+ * mode. The test checks that each good request is answered once, in
+ * order, with the return value and the output of its command. Time it
+ * with:
+ *
+ *     utest_bench -n 20 testcases.finsh.frame
+ */
+
+#define FRAME_TC_DEV        "frame_tc"
+#define FRAME_TC_REQS       64
+#define FRAME_TC_CHUNK      100
+#define FRAME_TC_EXIT_ID    0xFFFF
+#define FRAME_TC_IN_SIZE    (FRAME_TC_REQS * 64)
+#define FRAME_TC_OUT_SIZE   (FRAME_TC_REQS * 64)
+
+static struct rt_device frame_dev;
+static struct finsh_shell frame_shell;
+static rt_uint8_t in_buf[FRAME_TC_IN_SIZE];
+static rt_size_t in_len, in_pos;
+static rt_uint8_t out_buf[FRAME_TC_OUT_SIZE];
+static rt_size_t out_len;
+
+static int frame_tc_cmd(int argc, char **argv)
+{
+    if (argc != 2)
+        return -1;
+
+    rt_kprintf("frame tc %s\n", argv[1]);
+
+    return atoi(argv[1]);
+}
+MSH_CMD_EXPORT(frame_tc_cmd, command of the frame mode testcase);
+
+static rt_uint16_t frame_tc_crc(const rt_uint8_t *data, rt_size_t size)
+{
+    rt_uint16_t crc = 0xFFFF;
+    int i;
+
+    while (size--)
+    {
+        crc ^= (rt_uint16_t)(*data++) << 8;
+        for (i = 0; i < 8; i++)
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+
+    return crc;
+}
+
+static rt_ssize_t frame_tc_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+    if (size > FRAME_TC_CHUNK)
+        size = FRAME_TC_CHUNK;
+    if (size > in_len - in_pos)
+        size = in_len - in_pos;
+
+    rt_memcpy(buffer, &in_buf[in_pos], size);
+    in_pos += size;
+
+    return size;
+}
+
+static rt_ssize_t frame_tc_write(rt_device_t dev, rt_off_t pos, const void *buffer, rt_size_t size)
+{
+    if (out_len + size > FRAME_TC_OUT_SIZE)
+        return 0;
+
+    rt_memcpy(&out_buf[out_len], buffer, size);
+    out_len += size;
+
+    return size;
+}
+
+#ifdef RT_USING_DEVICE_OPS
+const static struct rt_device_ops frame_tc_ops =
+{
+    RT_NULL,
+    RT_NULL,
+    RT_NULL,
+    frame_tc_read,
+    frame_tc_write,
+    RT_NULL
+};
+#endif
+
+static void frame_tc_put(rt_uint16_t id, const char *cmd, rt_bool_t good)
+{
+    rt_uint8_t *p = &in_buf[in_len];
+    rt_size_t len = rt_strlen(cmd);
+    rt_uint16_t crc;
+
+    p[0] = 0xA5;
+    p[1] = 0x5A;
+    p[2] = id & 0xFF;
+    p[3] = id >> 8;
+    p[4] = len & 0xFF;
+    p[5] = len >> 8;
+    rt_memcpy(&p[6], cmd, len);
+
+    crc = frame_tc_crc(&p[2], 4 + len);
+    if (!good)
+        crc ^= 1;
+    p[6 + len] = crc & 0xFF;
+    p[7 + len] = crc >> 8;
+
+    in_len += 8 + len;
+}
+
+/* check the response at out_buf[*pos], move *pos past it */
+static int frame_tc_check(rt_size_t *pos, rt_uint16_t id, rt_int32_t ret, const char *output)
+{
+    rt_uint8_t *p = &out_buf[*pos];
+    rt_size_t len, olen = output ? rt_strlen(output) : 0;
+
+    if (out_len - *pos < 12 || p[0] != 0xA5 || p[1] != 0x5A)
+        return 1;
+
+    len = p[4] | (p[5] << 8);
+    if (out_len - *pos < 8 + len)
+        return 1;
+    *pos += 8 + len;
+
+    if ((p[2] | (p[3] << 8)) != id || len != 4 + olen)
+        return 1;
+    if ((rt_int32_t)(p[6] | (p[7] << 8) | (p[8] << 16) | ((rt_uint32_t)p[9] << 24)) != ret)
+        return 1;
+    if (rt_memcmp(&p[10], output, olen) != 0)
+        return 1;
+    if ((p[6 + len] | (p[7 + len] << 8)) != frame_tc_crc(&p[2], 4 + len))
+        return 1;
+
+    return 0;
+}
+
+static rt_err_t frame_tc_init(void)
+{
+    char cmd[32];
+    int i;
+
+    frame_dev.type = RT_Device_Class_Char;
+#ifdef RT_USING_DEVICE_OPS
+    frame_dev.ops = &frame_tc_ops;
+#else
+    frame_dev.read = frame_tc_read;
+    frame_dev.write = frame_tc_write;
+#endif
+    if (rt_device_register(&frame_dev, FRAME_TC_DEV, RT_DEVICE_FLAG_RDWR) != RT_EOK)
+        return -RT_ERROR;
+    if (rt_device_open(&frame_dev, RT_DEVICE_OFLAG_RDWR | RT_DEVICE_FLAG_STREAM) != RT_EOK)
+    {
+        rt_device_unregister(&frame_dev);
+        return -RT_ERROR;
+    }
+
+    rt_sem_init(&frame_shell.rx_sem, "frame_tc", 0, RT_IPC_FLAG_FIFO);
+    frame_shell.device = &frame_dev;
+
+    in_len = 0;
+    for (i = 0; i < FRAME_TC_REQS; i++)
+    {
+        rt_snprintf(cmd, sizeof(cmd), "frame_tc_cmd %d", i);
+        if (i % 8 == 3)
+            in_buf[in_len++] = 0xA5;
+        if (i % 16 == 5)
+            frame_tc_put(i + 1, cmd, RT_FALSE);
+        frame_tc_put(i + 1, cmd, RT_TRUE);
+    }
+    frame_tc_put(FRAME_TC_EXIT_ID, "", RT_TRUE);
+
+    return RT_EOK;
+}
+
+static rt_err_t frame_tc_cleanup(void)
+{
+    rt_sem_detach(&frame_shell.rx_sem);
+    frame_shell.device = RT_NULL;
+    rt_device_close(&frame_dev);
+    rt_device_unregister(&frame_dev);
+
+    return RT_EOK;
+}
+
+static void frame_requests(void)
+{
+    char output[32];
+    rt_size_t pos = 0;
+    int i, bad = 0;
+
+    in_pos = 0;
+    out_len = 0;
+    finsh_frame_run(&frame_shell);
+
+    uassert_int_equal(in_pos, in_len);
+    /* entering the mode is answered with id 0 */
+    bad += frame_tc_check(&pos, 0, 0, RT_NULL);
+    for (i = 0; i < FRAME_TC_REQS; i++)
+    {
+        rt_snprintf(output, sizeof(output), "frame tc %d\n", i);
+        bad += frame_tc_check(&pos, i + 1, i, output);
+    }
+    bad += frame_tc_check(&pos, FRAME_TC_EXIT_ID, 0, RT_NULL);
+
+    uassert_int_equal(bad, 0);
+    uassert_int_equal(pos, out_len);
+    /* the stream flag is given back */
+    uassert_true(frame_dev.open_flag & RT_DEVICE_FLAG_STREAM);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(frame_requests);
+}
+UTEST_TC_EXPORT(testcase, "testcases.finsh.frame", frame_tc_init, frame_tc_cleanup, 10);
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "msh.h"
+#include "utest.h"
+
+/*
+ * Command dispatch cost. Every run dispatches MSH_TC_DISPATCHES commands,
+ * one msh_exec() call each, or in msh_exec_batch() scripts of
+ * MSH_TC_BATCH_LINES lines. Time them with:
+ *
+ *     utest_bench -n 20 testcases.finsh.msh.*
+ */
+
+#define MSH_TC_DISPATCHES   10000
+#define MSH_TC_BATCH_LINES  1000
+#define MSH_TC_LINE         "msh_tc_nop 1 2"
+
+static rt_uint32_t nop_calls;
+static char *batch_script;
+static char *batch_buf;
+static rt_size_t batch_size;
+
+static int msh_tc_nop(int argc, char **argv)
+{
+    nop_calls ++;
+
+    return argc == 3 ? 0 : -1;
+}
+MSH_CMD_EXPORT(msh_tc_nop, no-op command of the msh dispatch testcases);
+
+static rt_err_t msh_tc_init(void)
+{
+    rt_size_t i, len = sizeof(MSH_TC_LINE);
+
+    /* one line per command, each one ends with a newline */
+    batch_size = len * MSH_TC_BATCH_LINES;
+    batch_script = rt_malloc(batch_size);
+    batch_buf = rt_malloc(batch_size);
+    if (batch_script == RT_NULL || batch_buf == RT_NULL)
+    {
+        rt_free(batch_script);
+        rt_free(batch_buf);
+        batch_script = batch_buf = RT_NULL;
+        return -RT_ENOMEM;
+    }
+
+    for (i = 0; i < MSH_TC_BATCH_LINES; i++)
+    {
+        rt_memcpy(batch_script + i * len, MSH_TC_LINE, len - 1);
+        batch_script[i * len + len - 1] = '\n';
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t msh_tc_cleanup(void)
+{
+    rt_free(batch_script);
+    rt_free(batch_buf);
+    batch_script = batch_buf = RT_NULL;
+
+    return RT_EOK;
+}
+
+static void msh_dispatch(void)
+{
+    char line[sizeof(MSH_TC_LINE)];
+    int i, failed = 0;
+
+    nop_calls = 0;
+    for (i = 0; i < MSH_TC_DISPATCHES; i++)
+    {
+        /* msh_exec() splits the arguments in place */
+        rt_memcpy(line, MSH_TC_LINE, sizeof(line));
+        if (msh_exec(line, sizeof(line) - 1) != 0)
+            failed ++;
+    }
+
+    uassert_int_equal(failed, 0);
+    uassert_int_equal(nop_calls, MSH_TC_DISPATCHES);
+}
+
+static void msh_dispatch_batch(void)
+{
+    int i, failed = 0;
+
+    nop_calls = 0;
+    for (i = 0; i < MSH_TC_DISPATCHES / MSH_TC_BATCH_LINES; i++)
+    {
+        rt_memcpy(batch_buf, batch_script, batch_size);
+        failed += msh_exec_batch(batch_buf, batch_size);
+    }
+
+    uassert_int_equal(failed, 0);
+    uassert_int_equal(nop_calls, MSH_TC_DISPATCHES);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(msh_dispatch);
+}
+UTEST_TC_EXPORT(testcase, "testcases.finsh.msh.dispatch_10k", RT_NULL, RT_NULL, 10);
+
+static void testcase_batch(void)
+{
+    UTEST_UNIT_RUN(msh_dispatch_batch);
+}
+UTEST_TC_EXPORT(testcase_batch, "testcases.finsh.msh.batch_10k", msh_tc_init, msh_tc_cleanup, 10);
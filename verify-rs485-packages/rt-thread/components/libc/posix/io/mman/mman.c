@@ -7,6 +7,7 @@
  * Date           Author            Notes
  * 2017/11/30     Bernard           The first version.
  * 2024/03/29     TroyMitchelle     Add all function comments
+ * 2026-10-17     RT-Thread         map read-only files in place when the file system supports it
  */
 
 #include <stdint.h>
@@ -18,9 +19,91 @@
 #include <sys/stat.h>
 #include <sys/statfs.h>
 #include <sys/errno.h>
+#include <sys/ioctl.h>
 
 #include "sys/mman.h"
 
+#ifdef RT_USING_DFS
+#include <dfs_file.h>
+
+/* mappings that point straight into the file system image (e.g. romfs in flash) */
+struct mmap_xip
+{
+    rt_list_t list;
+    void *addr;
+};
+
+static rt_list_t _xip_list = RT_LIST_OBJECT_INIT(_xip_list);
+static RT_DEFINE_SPINLOCK(_xip_lock);
+
+/**
+ * @brief   Tries to map a read-only region without copying it.
+ * @param   length  Length of the mapping.
+ * @param   prot    Protection of the mapped memory region.
+ * @param   fd      File descriptor of the file to be mapped.
+ * @param   offset  Offset within the file to start the mapping.
+ * @return  The address of the file data, or RT_NULL if it has to be copied.
+ */
+static void *_mmap_xip(size_t length, int prot, int fd, off_t offset)
+{
+    struct mmap_xip *xip;
+    struct stat st;
+    rt_ubase_t base = 0;
+    rt_base_t level;
+
+    if ((prot & PROT_WRITE) || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode))
+        return RT_NULL;
+
+    if (offset < 0 || (off_t)length > st.st_size || offset > st.st_size - (off_t)length)
+        return RT_NULL;
+
+    /* only file systems which keep the file contiguous in memory answer this */
+    if (ioctl(fd, RT_FIOGETADDR, &base) != 0 || base == 0)
+        return RT_NULL;
+
+    xip = (struct mmap_xip *)rt_malloc(sizeof(struct mmap_xip));
+    if (xip == RT_NULL)
+        return RT_NULL;
+
+    xip->addr = (void *)(base + offset);
+    level = rt_spin_lock_irqsave(&_xip_lock);
+    rt_list_insert_after(&_xip_list, &xip->list);
+    rt_spin_unlock_irqrestore(&_xip_lock, level);
+
+    return xip->addr;
+}
+
+/**
+ * @brief   Releases an in-place mapping.
+ * @param   addr    Starting address of the mapping.
+ * @return  0 if addr was an in-place mapping, -1 otherwise.
+ */
+static int _munmap_xip(void *addr)
+{
+    struct mmap_xip *xip = RT_NULL;
+    rt_list_t *node;
+    rt_base_t level;
+
+    level = rt_spin_lock_irqsave(&_xip_lock);
+    rt_list_for_each(node, &_xip_list)
+    {
+        if (rt_list_entry(node, struct mmap_xip, list)->addr == addr)
+        {
+            xip = rt_list_entry(node, struct mmap_xip, list);
+            rt_list_remove(&xip->list);
+            break;
+        }
+    }
+    rt_spin_unlock_irqrestore(&_xip_lock, level);
+
+    if (xip == RT_NULL)
+        return -1;
+
+    rt_free(xip);
+    return 0;
+}
+#endif /* RT_USING_DFS */
+
 /**
  * @brief   Maps a region of memory into the calling process's address space.
  * @param   addr    Desired starting address of the mapping.
@@ -36,6 +119,17 @@ void *mmap(void *addr, size_t length, int prot, int flags,
 {
     uint8_t *mem;
 
+#ifdef RT_USING_DFS
+    if (addr == RT_NULL)
+    {
+        mem = (uint8_t *)_mmap_xip(length, prot, fd, offset);
+        if (mem)
+        {
+            return mem;
+        }
+    }
+#endif
+
     if (addr)
     {
         mem = addr;
@@ -80,6 +174,12 @@ int munmap(void *addr, size_t length)
 {
     if (addr)
     {
+#ifdef RT_USING_DFS
+        if (_munmap_xip(addr) == 0)
+        {
+            return 0;
+        }
+#endif
         free(addr);
         return 0;
     }
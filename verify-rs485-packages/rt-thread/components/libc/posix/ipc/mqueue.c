@@ -5,12 +5,376 @@
  *
  * Change Logs:
  * Date           Author       Notes
+ * 2026-10-17     RT-Thread    message ring with in place access, mq_notify and batch receive
+ * 2026-10-17     RT-Thread    check in place buffers, fail blocked callers on unlink
  */
 
 #include <dfs_file.h>
+#include <ipc/completion.h>
 #include <unistd.h>
 #include "mqueue.h"
 
+/*
+ * A message queue is a pool of fixed size slots. Queued slots are kept in
+ * a ring of slot indexes sorted by priority, free slots in a list. Data is
+ * copied once on each side, directly between the caller and the slot, and
+ * in-kernel users can skip that copy with mq_send_alloc()/mq_receive_get().
+ */
+#define MQ_SLOT_NONE            0xFFFF
+
+struct mqueue_msg
+{
+    rt_uint16_t next;           /* next free slot */
+    rt_uint16_t len;
+    unsigned    prio;
+};
+
+struct mqueue
+{
+    rt_uint16_t msg_size;
+    rt_uint16_t max_msgs;
+    rt_size_t   slot_size;
+
+    rt_uint8_t  *pool;
+    rt_uint16_t *order;         /* queued slots, highest priority first */
+    rt_uint16_t head;
+    rt_uint16_t count;
+    rt_uint16_t free;
+
+    struct rt_spinlock lock;
+    struct rt_semaphore msgs;   /* queued messages */
+    struct rt_semaphore slots;  /* free slots */
+    int nrecv;                  /* receivers blocked on msgs */
+    int nwait;                  /* callers inside a slot alloc or dequeue */
+    rt_bool_t deleted;
+    struct rt_completion drained;   /* the last of nwait left a deleted queue */
+
+    rt_bool_t notify_armed;
+    struct sigevent notify;
+    rt_thread_t notify_thread;
+};
+
+#define MQ_SLOT(mq, i)          ((struct mqueue_msg *)((mq)->pool + (rt_size_t)(i) * (mq)->slot_size))
+#define MQ_SLOT_HDR_SIZE        RT_ALIGN(sizeof(struct mqueue_msg), RT_ALIGN_SIZE)
+#define MQ_SLOT_DATA(slot)      ((void *)((rt_uint8_t *)(slot) + MQ_SLOT_HDR_SIZE))
+
+struct mqueue *mqueue_create(const char *name, rt_uint16_t msg_size, rt_uint16_t max_msgs)
+{
+    struct mqueue *mq;
+    rt_uint16_t i;
+
+    if (msg_size == 0 || max_msgs == 0 || max_msgs == MQ_SLOT_NONE)
+        return RT_NULL;
+
+    mq = (struct mqueue *)rt_calloc(1, sizeof(struct mqueue));
+    if (mq == RT_NULL)
+        return RT_NULL;
+
+    mq->msg_size = msg_size;
+    mq->max_msgs = max_msgs;
+    mq->slot_size = MQ_SLOT_HDR_SIZE + RT_ALIGN(msg_size, RT_ALIGN_SIZE);
+    mq->pool = (rt_uint8_t *)rt_malloc(mq->slot_size * max_msgs);
+    mq->order = (rt_uint16_t *)rt_malloc(sizeof(rt_uint16_t) * max_msgs);
+    if (mq->pool == RT_NULL || mq->order == RT_NULL)
+    {
+        rt_free(mq->pool);
+        rt_free(mq->order);
+        rt_free(mq);
+        return RT_NULL;
+    }
+
+    for (i = 0; i < max_msgs; i++)
+        MQ_SLOT(mq, i)->next = (i + 1 < max_msgs) ? i + 1 : MQ_SLOT_NONE;
+    mq->free = 0;
+
+    rt_spin_lock_init(&mq->lock);
+    rt_sem_init(&mq->msgs, name, 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&mq->slots, name, max_msgs, RT_IPC_FLAG_FIFO);
+    rt_completion_init(&mq->drained);
+
+    return mq;
+}
+
+void mqueue_delete(struct mqueue *mq)
+{
+    rt_base_t level;
+    int i, nwait;
+
+    if (mq == RT_NULL)
+        return;
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    mq->deleted = RT_TRUE;
+    nwait = mq->nwait;
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    /*
+     * Wake every blocked sender and receiver, they see the flag and fail
+     * with EBADF. A caller about to block takes one of these counts too,
+     * so nobody is left sleeping on a semaphore that is detached below.
+     */
+    if (nwait > 0)
+    {
+        for (i = 0; i < nwait; i++)
+        {
+            rt_sem_release(&mq->msgs);
+            rt_sem_release(&mq->slots);
+        }
+        rt_completion_wait(&mq->drained, RT_WAITING_FOREVER);
+    }
+
+    rt_sem_detach(&mq->msgs);
+    rt_sem_detach(&mq->slots);
+    rt_free(mq->order);
+    rt_free(mq->pool);
+    rt_free(mq);
+}
+
+static struct mqueue *_mq_get(mqd_t id, int *nonblock)
+{
+    struct dfs_file *file;
+    struct mqueue_file *mq_file;
+
+    file = fd_get(id);
+    if (file == RT_NULL || file->vnode == RT_NULL || file->vnode->data == RT_NULL)
+    {
+        rt_set_errno(EBADF);
+        return RT_NULL;
+    }
+
+    mq_file = (struct mqueue_file *)file->vnode->data;
+    if (mq_file->data == RT_NULL)
+    {
+        rt_set_errno(EBADF);
+        return RT_NULL;
+    }
+
+    if (nonblock)
+        *nonblock = (file->flags & O_NONBLOCK) ? 1 : 0;
+
+    return (struct mqueue *)mq_file->data;
+}
+
+static rt_int32_t _mq_tick(int nonblock, const struct timespec *abs_timeout)
+{
+    if (nonblock)
+        return 0;
+    if (abs_timeout != RT_NULL)
+        return rt_timespec_to_tick(abs_timeout);
+
+    return RT_WAITING_FOREVER;
+}
+
+static void _mq_errno(rt_err_t result, int nonblock)
+{
+    if (result == -RT_ETIMEOUT)
+        rt_set_errno(nonblock ? EAGAIN : ETIMEDOUT);
+    else if (result == -RT_EINTR)
+        rt_set_errno(EINTR);
+    else
+        rt_set_errno(EBADF);
+}
+
+static void _mq_notify(struct sigevent *event, rt_thread_t thread)
+{
+    switch (event->sigev_notify)
+    {
+    case SIGEV_THREAD:
+        if (event->sigev_notify_function != RT_NULL)
+            event->sigev_notify_function(event->sigev_value);
+        break;
+#ifdef RT_USING_SIGNALS
+    case SIGEV_SIGNAL:
+        rt_thread_kill(thread, event->sigev_signo);
+        break;
+#endif
+    default:
+        break;
+    }
+}
+
+/* the slot of a buffer handed out by this queue, RT_NULL for any other pointer */
+static struct mqueue_msg *_mq_slot_of(struct mqueue *mq, void *msg_ptr)
+{
+    rt_size_t offset;
+
+    if ((rt_uint8_t *)msg_ptr < mq->pool + MQ_SLOT_HDR_SIZE)
+        return RT_NULL;
+
+    offset = (rt_uint8_t *)msg_ptr - MQ_SLOT_HDR_SIZE - mq->pool;
+    if (offset >= mq->slot_size * mq->max_msgs || offset % mq->slot_size != 0)
+        return RT_NULL;
+
+    return (struct mqueue_msg *)(mq->pool + offset);
+}
+
+static rt_bool_t _mq_enter(struct mqueue *mq)
+{
+    rt_bool_t deleted;
+    rt_base_t level;
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    deleted = mq->deleted;
+    if (!deleted)
+        mq->nwait++;
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    return !deleted;
+}
+
+static void _mq_leave(struct mqueue *mq)
+{
+    rt_bool_t last;
+    rt_base_t level;
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    last = (--mq->nwait == 0) && mq->deleted;
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    /* mqueue_delete() frees mq once this is done */
+    if (last)
+        rt_completion_done(&mq->drained);
+}
+
+static struct mqueue_msg *_mq_slot_alloc(struct mqueue *mq, rt_int32_t tick, rt_err_t *result)
+{
+    struct mqueue_msg *slot = RT_NULL;
+    rt_base_t level;
+
+    if (!_mq_enter(mq))
+    {
+        *result = -RT_ERROR;
+        return RT_NULL;
+    }
+
+    *result = rt_sem_take(&mq->slots, tick);
+    if (*result == RT_EOK)
+    {
+        level = rt_spin_lock_irqsave(&mq->lock);
+        if (mq->deleted)
+        {
+            *result = -RT_ERROR;
+        }
+        else
+        {
+            slot = MQ_SLOT(mq, mq->free);
+            mq->free = slot->next;
+        }
+        rt_spin_unlock_irqrestore(&mq->lock, level);
+    }
+    _mq_leave(mq);
+
+    return slot;
+}
+
+static void _mq_slot_free(struct mqueue *mq, struct mqueue_msg **slots, int n)
+{
+    rt_base_t level;
+    int i;
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    for (i = 0; i < n; i++)
+    {
+        slots[i]->next = mq->free;
+        mq->free = (rt_uint16_t)(((rt_uint8_t *)slots[i] - mq->pool) / mq->slot_size);
+    }
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    for (i = 0; i < n; i++)
+        rt_sem_release(&mq->slots);
+}
+
+static void _mq_slot_queue(struct mqueue *mq, struct mqueue_msg *slot)
+{
+    struct sigevent event;
+    rt_thread_t thread = RT_NULL;
+    rt_uint16_t index, pos, prev;
+    rt_base_t level;
+
+    index = (rt_uint16_t)(((rt_uint8_t *)slot - mq->pool) / mq->slot_size);
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+
+    /* insert behind the messages of the same or higher priority */
+    pos = (mq->head + mq->count) % mq->max_msgs;
+    while (pos != mq->head)
+    {
+        prev = pos ? pos - 1 : mq->max_msgs - 1;
+        if (MQ_SLOT(mq, mq->order[prev])->prio >= slot->prio)
+            break;
+        mq->order[pos] = mq->order[prev];
+        pos = prev;
+    }
+    mq->order[pos] = index;
+
+    /* notify only when the queue becomes non-empty and nobody is waiting */
+    if (mq->count++ == 0 && mq->notify_armed && mq->nrecv == 0)
+    {
+        mq->notify_armed = RT_FALSE;
+        event = mq->notify;
+        thread = mq->notify_thread;
+    }
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    rt_sem_release(&mq->msgs);
+
+    if (thread != RT_NULL)
+        _mq_notify(&event, thread);
+}
+
+/* take up to count messages, waiting only for the first one */
+static int _mq_slot_dequeue(struct mqueue *mq, struct mqueue_msg **slots, int count,
+                            rt_int32_t tick, rt_err_t *result)
+{
+    rt_base_t level;
+    int n;
+
+    if (!_mq_enter(mq))
+    {
+        *result = -RT_ERROR;
+        return 0;
+    }
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    mq->nrecv++;
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    *result = rt_sem_take(&mq->msgs, tick);
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    mq->nrecv--;
+    if (*result == RT_EOK && mq->deleted)
+        *result = -RT_ERROR;
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    if (*result != RT_EOK)
+    {
+        _mq_leave(mq);
+        return 0;
+    }
+
+    for (n = 1; n < count; n++)
+    {
+        if (rt_sem_trytake(&mq->msgs) != RT_EOK)
+            break;
+    }
+
+    level = rt_spin_lock_irqsave(&mq->lock);
+    /* the extra counts may be the wake-ups of a delete */
+    if (n > mq->count)
+        n = mq->count;
+    for (count = 0; count < n; count++)
+    {
+        slots[count] = MQ_SLOT(mq, mq->order[mq->head]);
+        mq->head = (mq->head + 1) % mq->max_msgs;
+        mq->count--;
+    }
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+    _mq_leave(mq);
+
+    return n;
+}
+
 int mq_setattr(mqd_t                 id,
                const struct mq_attr *mqstat,
                struct mq_attr       *omqstat)
@@ -26,10 +390,10 @@ RTM_EXPORT(mq_setattr);
 
 int mq_getattr(mqd_t id, struct mq_attr *mqstat)
 {
-    rt_mq_t mq;
-    struct mqueue_file *mq_file;
-    mq_file = fd_get(id)->vnode->data;
-    mq = (rt_mq_t)mq_file->data;
+    struct mqueue *mq;
+    int nonblock;
+
+    mq = _mq_get(id, &nonblock);
     if ((mq == RT_NULL) || mqstat == RT_NULL)
     {
         rt_set_errno(EBADF);
@@ -38,8 +402,8 @@ int mq_getattr(mqd_t id, struct mq_attr *mqstat)
 
     mqstat->mq_maxmsg = mq->max_msgs;
     mqstat->mq_msgsize = mq->msg_size;
-    mqstat->mq_curmsgs = 0;
-    mqstat->mq_flags = 0;
+    mqstat->mq_curmsgs = mq->count;
+    mqstat->mq_flags = nonblock ? O_NONBLOCK : 0;
 
     return 0;
 }
@@ -115,115 +479,331 @@ mqd_t mq_open(const char *name, int oflag, ...)
 }
 RTM_EXPORT(mq_open);
 
-ssize_t mq_receive(mqd_t id, char *msg_ptr, size_t msg_len, unsigned *msg_prio)
+ssize_t mq_timedreceive(mqd_t                  id,
+                        char                  *msg_ptr,
+                        size_t                 msg_len,
+                        unsigned              *msg_prio,
+                        const struct timespec *abs_timeout)
 {
-    rt_mq_t mq;
+    struct mqueue *mq;
+    struct mqueue_msg *slot;
     rt_err_t result;
-    struct mqueue_file *mq_file;
-    mq_file = fd_get(id)->vnode->data;
-    mq = (rt_mq_t)mq_file->data;
+    int nonblock;
+    ssize_t len;
+
+    mq = _mq_get(id, &nonblock);
+    /* parameters check */
     if ((mq == RT_NULL) || (msg_ptr == RT_NULL))
     {
         rt_set_errno(EINVAL);
         return -1;
     }
+    if (msg_len < mq->msg_size)
+    {
+        rt_set_errno(EMSGSIZE);
+        return -1;
+    }
 
-    result = rt_mq_recv_prio(mq, msg_ptr, msg_len, (rt_int32_t *)msg_prio, RT_WAITING_FOREVER, RT_UNINTERRUPTIBLE);
-    if (result >= 0)
-        return result;
+    if (_mq_slot_dequeue(mq, &slot, 1, _mq_tick(nonblock, abs_timeout), &result) == 0)
+    {
+        _mq_errno(result, nonblock);
+        return -1;
+    }
 
-    rt_set_errno(EBADF);
-    return -1;
+    len = slot->len;
+    rt_memcpy(msg_ptr, MQ_SLOT_DATA(slot), len);
+    if (msg_prio)
+        *msg_prio = slot->prio;
+    _mq_slot_free(mq, &slot, 1);
+
+    return len;
+}
+RTM_EXPORT(mq_timedreceive);
+
+ssize_t mq_receive(mqd_t id, char *msg_ptr, size_t msg_len, unsigned *msg_prio)
+{
+    return mq_timedreceive(id, msg_ptr, msg_len, msg_prio, RT_NULL);
 }
 RTM_EXPORT(mq_receive);
 
-int mq_send(mqd_t id, const char *msg_ptr, size_t msg_len, unsigned msg_prio)
+int mq_timedsend(mqd_t                  id,
+                 const char            *msg_ptr,
+                 size_t                 msg_len,
+                 unsigned               msg_prio,
+                 const struct timespec *abs_timeout)
 {
-    rt_mq_t mq;
+    struct mqueue *mq;
+    struct mqueue_msg *slot;
     rt_err_t result;
-    struct mqueue_file *mq_file;
-    mq_file = fd_get(id)->vnode->data;
-    mq = (rt_mq_t)mq_file->data;
+    int nonblock;
 
+    mq = _mq_get(id, &nonblock);
     if ((mq == RT_NULL) || (msg_ptr == RT_NULL))
     {
         rt_set_errno(EINVAL);
         return -1;
     }
-    result = rt_mq_send_wait_prio(mq, (void *)msg_ptr, msg_len, msg_prio, 0, RT_UNINTERRUPTIBLE);
-    if (result == RT_EOK)
-        return 0;
+    if (msg_len > mq->msg_size)
+    {
+        rt_set_errno(EMSGSIZE);
+        return -1;
+    }
 
-    rt_set_errno(EBADF);
+    slot = _mq_slot_alloc(mq, _mq_tick(nonblock, abs_timeout), &result);
+    if (slot == RT_NULL)
+    {
+        _mq_errno(result, nonblock);
+        return -1;
+    }
 
-    return -1;
+    rt_memcpy(MQ_SLOT_DATA(slot), msg_ptr, msg_len);
+    slot->len = (rt_uint16_t)msg_len;
+    slot->prio = msg_prio;
+    _mq_slot_queue(mq, slot);
+
+    return 0;
+}
+RTM_EXPORT(mq_timedsend);
+
+int mq_send(mqd_t id, const char *msg_ptr, size_t msg_len, unsigned msg_prio)
+{
+    return mq_timedsend(id, msg_ptr, msg_len, msg_prio, RT_NULL);
 }
 RTM_EXPORT(mq_send);
 
-ssize_t mq_timedreceive(mqd_t                  id,
-                        char                  *msg_ptr,
-                        size_t                 msg_len,
-                        unsigned              *msg_prio,
-                        const struct timespec *abs_timeout)
+/**
+ * @brief    Receive up to count messages with one call (non-standard).
+ *
+ * @note     It waits as mq_timedreceive() does for the first message only,
+ *           the rest are the messages already queued.
+ *
+ * @param    id is the message queue descriptor.
+ *
+ * @param    msgs are the receive buffers, msg_len is updated to the length of each message.
+ *
+ * @param    count is the number of entries in msgs.
+ *
+ * @param    abs_timeout is the absolute timeout, RT_NULL to wait forever.
+ *
+ * @return   The number of messages received, or -1 with errno set.
+ */
+int mq_receive_batch(mqd_t id, struct mq_msg *msgs, int count, const struct timespec *abs_timeout)
 {
-    rt_mq_t mq;
+    struct mqueue *mq;
+    struct mqueue_msg *slots[MQ_BATCH_MAX];
     rt_err_t result;
-    int tick = 0;
-    struct mqueue_file *mq_file;
-    mq_file = fd_get(id)->vnode->data;
-    mq = (rt_mq_t)mq_file->data;
-    /* parameters check */
-    if ((mq == RT_NULL) || (msg_ptr == RT_NULL))
+    int nonblock;
+    int i, n;
+
+    mq = _mq_get(id, &nonblock);
+    if ((mq == RT_NULL) || (msgs == RT_NULL) || (count <= 0))
     {
         rt_set_errno(EINVAL);
         return -1;
     }
-    if (abs_timeout != RT_NULL)
-        tick = rt_timespec_to_tick(abs_timeout);
-    else
-        tick = RT_WAITING_FOREVER;
+    if (count > MQ_BATCH_MAX)
+        count = MQ_BATCH_MAX;
+
+    for (i = 0; i < count; i++)
+    {
+        if (msgs[i].msg_ptr == RT_NULL || msgs[i].msg_len < mq->msg_size)
+        {
+            rt_set_errno(EMSGSIZE);
+            return -1;
+        }
+    }
 
-    result = rt_mq_recv_prio(mq, msg_ptr, msg_len, (rt_int32_t *)msg_prio, tick, RT_UNINTERRUPTIBLE);
+    n = _mq_slot_dequeue(mq, slots, count, _mq_tick(nonblock, abs_timeout), &result);
+    if (n == 0)
+    {
+        _mq_errno(result, nonblock);
+        return -1;
+    }
 
-    if (result >= 0)
-        return result;
+    for (i = 0; i < n; i++)
+    {
+        rt_memcpy(msgs[i].msg_ptr, MQ_SLOT_DATA(slots[i]), slots[i]->len);
+        msgs[i].msg_len = slots[i]->len;
+        msgs[i].msg_prio = slots[i]->prio;
+    }
+    _mq_slot_free(mq, slots, n);
 
-    if (result == -RT_ETIMEOUT)
-        rt_set_errno(ETIMEDOUT);
-    else if (result == -RT_ERROR)
+    return n;
+}
+RTM_EXPORT(mq_receive_batch);
+
+/**
+ * @brief    Get a free message buffer in the queue (non-standard).
+ *
+ * @note     The buffer is msg_size bytes, fill it in place and pass it to
+ *           mq_send_commit(). This saves the copy of mq_send() for in-kernel users.
+ *
+ * @return   The message buffer, or RT_NULL with errno set.
+ */
+void *mq_send_alloc(mqd_t id, const struct timespec *abs_timeout)
+{
+    struct mqueue *mq;
+    struct mqueue_msg *slot;
+    rt_err_t result;
+    int nonblock;
+
+    mq = _mq_get(id, &nonblock);
+    if (mq == RT_NULL)
+        return RT_NULL;
+
+    slot = _mq_slot_alloc(mq, _mq_tick(nonblock, abs_timeout), &result);
+    if (slot == RT_NULL)
+    {
+        _mq_errno(result, nonblock);
+        return RT_NULL;
+    }
+
+    return MQ_SLOT_DATA(slot);
+}
+RTM_EXPORT(mq_send_alloc);
+
+/**
+ * @brief    Queue a buffer got from mq_send_alloc() (non-standard).
+ *
+ * @return   0 on success, or -1 with errno set. The buffer is given back on error,
+ *           except for EINVAL: msg_ptr is no buffer of this queue.
+ */
+int mq_send_commit(mqd_t id, void *msg_ptr, size_t msg_len, unsigned msg_prio)
+{
+    struct mqueue *mq;
+    struct mqueue_msg *slot;
+
+    mq = _mq_get(id, RT_NULL);
+    if ((mq == RT_NULL) || (msg_ptr == RT_NULL))
+    {
+        rt_set_errno(EINVAL);
+        return -1;
+    }
+
+    slot = _mq_slot_of(mq, msg_ptr);
+    if (slot == RT_NULL)
+    {
+        rt_set_errno(EINVAL);
+        return -1;
+    }
+    if (msg_len > mq->msg_size)
+    {
+        _mq_slot_free(mq, &slot, 1);
         rt_set_errno(EMSGSIZE);
-    else
-        rt_set_errno(EBADMSG);
+        return -1;
+    }
 
-    return -1;
+    slot->len = (rt_uint16_t)msg_len;
+    slot->prio = msg_prio;
+    _mq_slot_queue(mq, slot);
+
+    return 0;
 }
-RTM_EXPORT(mq_timedreceive);
+RTM_EXPORT(mq_send_commit);
 
-int mq_timedsend(mqd_t                  id,
-                 const char            *msg_ptr,
-                 size_t                 msg_len,
-                 unsigned               msg_prio,
-                 const struct timespec *abs_timeout)
+/**
+ * @brief    Take the next message without copying it (non-standard).
+ *
+ * @note     The message stays in the queue buffer until mq_receive_put().
+ *
+ * @return   The message length, or -1 with errno set.
+ */
+ssize_t mq_receive_get(mqd_t id, void **msg_ptr, unsigned *msg_prio, const struct timespec *abs_timeout)
+{
+    struct mqueue *mq;
+    struct mqueue_msg *slot;
+    rt_err_t result;
+    int nonblock;
+
+    mq = _mq_get(id, &nonblock);
+    if ((mq == RT_NULL) || (msg_ptr == RT_NULL))
+    {
+        rt_set_errno(EINVAL);
+        return -1;
+    }
+
+    if (_mq_slot_dequeue(mq, &slot, 1, _mq_tick(nonblock, abs_timeout), &result) == 0)
+    {
+        _mq_errno(result, nonblock);
+        return -1;
+    }
+
+    *msg_ptr = MQ_SLOT_DATA(slot);
+    if (msg_prio)
+        *msg_prio = slot->prio;
+
+    return slot->len;
+}
+RTM_EXPORT(mq_receive_get);
+
+/**
+ * @brief    Give back a message got from mq_receive_get() (non-standard).
+ *
+ * @return   0 on success, or -1 with errno EINVAL if msg_ptr is no buffer of this queue.
+ */
+int mq_receive_put(mqd_t id, void *msg_ptr)
 {
-    /* RT-Thread does not support timed send */
-    return mq_send(id, msg_ptr, msg_len, msg_prio);
+    struct mqueue *mq;
+    struct mqueue_msg *slot;
+
+    mq = _mq_get(id, RT_NULL);
+    if ((mq == RT_NULL) || (msg_ptr == RT_NULL))
+    {
+        rt_set_errno(EINVAL);
+        return -1;
+    }
+
+    slot = _mq_slot_of(mq, msg_ptr);
+    if (slot == RT_NULL)
+    {
+        rt_set_errno(EINVAL);
+        return -1;
+    }
+    _mq_slot_free(mq, &slot, 1);
+
+    return 0;
 }
-RTM_EXPORT(mq_timedsend);
+RTM_EXPORT(mq_receive_put);
 
 int mq_notify(mqd_t id, const struct sigevent *notification)
 {
-    rt_mq_t mq;
-    struct mqueue_file *mq_file;
-    mq_file = fd_get(id)->vnode->data;
-    mq = (rt_mq_t)mq_file->data;
+    struct mqueue *mq;
+    rt_base_t level;
+    int result = 0;
+
+    mq = _mq_get(id, RT_NULL);
     if (mq == RT_NULL)
     {
         rt_set_errno(EBADF);
         return -1;
     }
-    rt_set_errno(-RT_ERROR);
 
-    return -1;
+    level = rt_spin_lock_irqsave(&mq->lock);
+    if (notification == RT_NULL)
+    {
+        /* remove the registration of the calling thread */
+        if (mq->notify_armed && mq->notify_thread == rt_thread_self())
+            mq->notify_armed = RT_FALSE;
+    }
+    else if (mq->notify_armed)
+    {
+        result = EBUSY;
+    }
+    else
+    {
+        mq->notify = *notification;
+        mq->notify_thread = rt_thread_self();
+        mq->notify_armed = RT_TRUE;
+    }
+    rt_spin_unlock_irqrestore(&mq->lock, level);
+
+    if (result != 0)
+    {
+        rt_set_errno(result);
+        return -1;
+    }
+
+    return 0;
 }
 RTM_EXPORT(mq_notify);
 
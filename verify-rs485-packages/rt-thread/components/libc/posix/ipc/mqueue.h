@@ -27,6 +27,18 @@ struct mq_attr
     long mq_curmsgs;    /* Number of messages currently queued. */
 };
 
+/* one entry of mq_receive_batch() */
+struct mq_msg
+{
+    char     *msg_ptr;  /* Receive buffer. */
+    size_t    msg_len;  /* Buffer size, set to the message length. */
+    unsigned  msg_prio; /* Message priority. */
+};
+
+#ifndef MQ_BATCH_MAX
+#define MQ_BATCH_MAX    16  /* messages taken by one mq_receive_batch() call */
+#endif
+
 int     mq_close(mqd_t mqdes);
 int     mq_getattr(mqd_t mqdes, struct mq_attr *mqstat);
 int     mq_notify(mqd_t mqdes, const struct sigevent *notification);
@@ -49,4 +61,11 @@ int     mq_timedsend(mqd_t                  mqdes,
 
 int     mq_unlink(const char *name);
 
+/* non-standard extensions */
+int     mq_receive_batch(mqd_t mqdes, struct mq_msg *msgs, int count, const struct timespec *abs_timeout);
+void   *mq_send_alloc(mqd_t mqdes, const struct timespec *abs_timeout);
+int     mq_send_commit(mqd_t mqdes, void *msg_ptr, size_t msg_len, unsigned msg_prio);
+ssize_t mq_receive_get(mqd_t mqdes, void **msg_ptr, unsigned *msg_prio, const struct timespec *abs_timeout);
+int     mq_receive_put(mqd_t mqdes, void *msg_ptr);
+
 #endif
@@ -0,0 +1,365 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <fcntl.h>
+#include <mqueue.h>
+#include "utest.h"
+
+/*
+ * Message queue throughput. In every run of a testcase a sender thread
+ * queues MQ_TC_MSGS messages and the testcase receives them, through
+ * mq_send()/mq_receive() with 16, 64 and 256 byte messages, through
+ * mq_receive_batch(), and through the in-place mq_send_alloc()/
+ * mq_receive_get() calls. Time them with:
+ *
+ *     utest_bench -n 100 testcases.posix.mqueue.*
+ *
+ * The checks testcase is no benchmark: the in-place calls must refuse a
+ * pointer that is no buffer of the queue, and mq_unlink() must wake a
+ * receiver blocked on the queue with EBADF.
+ */
+
+#define MQ_TC_NAME          "/mq_tc"
+#define MQ_TC_MAXMSG        16
+#define MQ_TC_MSGS          256
+#define MQ_TC_MSGSIZE_MAX   256
+#define MQ_TC_STACK_SIZE    2048
+#define MQ_TC_CHK_NAME      "/mq_tc_chk"
+#define MQ_TC_CHK_MSGSIZE   64
+
+enum mq_tc_mode
+{
+    MQ_TC_COPY,
+    MQ_TC_BATCH,
+    MQ_TC_INPLACE,
+};
+
+static mqd_t mqd = (mqd_t)-1;
+static enum mq_tc_mode mode;
+static size_t msg_size;
+static struct rt_semaphore go_sem;
+static struct rt_semaphore done_sem;
+static volatile int stopping;
+static volatile int send_fails;
+static rt_uint32_t rx_buf[MQ_BATCH_MAX][MQ_TC_MSGSIZE_MAX / sizeof(rt_uint32_t)];
+
+static void mq_tc_sender(void *param)
+{
+    rt_uint32_t buf[MQ_TC_MSGSIZE_MAX / sizeof(rt_uint32_t)] = {0};
+    rt_uint32_t *msg;
+    rt_uint32_t i;
+
+    while (1)
+    {
+        rt_sem_take(&go_sem, RT_WAITING_FOREVER);
+        if (stopping)
+        {
+            break;
+        }
+
+        for (i = 0; i < MQ_TC_MSGS; i++)
+        {
+            if (mode == MQ_TC_INPLACE)
+            {
+                msg = mq_send_alloc(mqd, RT_NULL);
+                if (msg == RT_NULL)
+                {
+                    send_fails++;
+                    break;
+                }
+                msg[0] = i;
+                if (mq_send_commit(mqd, msg, msg_size, 0) != 0)
+                {
+                    send_fails++;
+                    break;
+                }
+            }
+            else
+            {
+                buf[0] = i;
+                if (mq_send(mqd, (const char *)buf, msg_size, 0) != 0)
+                {
+                    send_fails++;
+                    break;
+                }
+            }
+        }
+        rt_sem_release(&done_sem);
+    }
+
+    rt_sem_release(&done_sem);
+}
+
+static rt_err_t mq_tc_init(enum mq_tc_mode tc_mode, size_t size)
+{
+    struct mq_attr attr = {0};
+    rt_thread_t tid;
+
+    mode = tc_mode;
+    msg_size = size;
+    attr.mq_maxmsg = MQ_TC_MAXMSG;
+    attr.mq_msgsize = size;
+    mqd = mq_open(MQ_TC_NAME, O_CREAT | O_RDWR, 0666, &attr);
+    if (mqd == (mqd_t)-1)
+    {
+        return -RT_ERROR;
+    }
+
+    rt_sem_init(&go_sem, "mq_go", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&done_sem, "mq_done", 0, RT_IPC_FLAG_FIFO);
+    stopping = 0;
+    send_fails = 0;
+
+    tid = rt_thread_create("mq_tc", mq_tc_sender, RT_NULL, MQ_TC_STACK_SIZE,
+                           rt_thread_self()->current_priority, 10);
+    if (tid == RT_NULL)
+    {
+        rt_sem_detach(&go_sem);
+        rt_sem_detach(&done_sem);
+        mq_close(mqd);
+        mq_unlink(MQ_TC_NAME);
+        mqd = (mqd_t)-1;
+        return -RT_ENOMEM;
+    }
+    rt_thread_startup(tid);
+
+    return RT_EOK;
+}
+
+static rt_err_t mq_tc_init_copy_16(void)
+{
+    return mq_tc_init(MQ_TC_COPY, 16);
+}
+
+static rt_err_t mq_tc_init_copy_64(void)
+{
+    return mq_tc_init(MQ_TC_COPY, 64);
+}
+
+static rt_err_t mq_tc_init_copy_256(void)
+{
+    return mq_tc_init(MQ_TC_COPY, 256);
+}
+
+static rt_err_t mq_tc_init_batch_64(void)
+{
+    return mq_tc_init(MQ_TC_BATCH, 64);
+}
+
+static rt_err_t mq_tc_init_inplace_64(void)
+{
+    return mq_tc_init(MQ_TC_INPLACE, 64);
+}
+
+static rt_err_t mq_tc_cleanup(void)
+{
+    stopping = 1;
+    rt_sem_release(&go_sem);
+    rt_sem_take(&done_sem, RT_WAITING_FOREVER);
+
+    rt_sem_detach(&go_sem);
+    rt_sem_detach(&done_sem);
+    mq_close(mqd);
+    mq_unlink(MQ_TC_NAME);
+    mqd = (mqd_t)-1;
+
+    return RT_EOK;
+}
+
+static void mq_throughput(void)
+{
+    struct mq_msg msgs[MQ_BATCH_MAX];
+    rt_uint32_t *msg;
+    rt_uint32_t next = 0;
+    int bad = 0;
+    ssize_t len;
+    int i, n;
+
+    rt_sem_release(&go_sem);
+
+    /* the checks only count, so that the receive loop stays what is timed */
+    while (next < MQ_TC_MSGS)
+    {
+        if (mode == MQ_TC_BATCH)
+        {
+            for (i = 0; i < MQ_BATCH_MAX; i++)
+            {
+                msgs[i].msg_ptr = (char *)rx_buf[i];
+                msgs[i].msg_len = sizeof(rx_buf[i]);
+            }
+            n = mq_receive_batch(mqd, msgs, MQ_BATCH_MAX, RT_NULL);
+            if (n <= 0)
+            {
+                break;
+            }
+            for (i = 0; i < n; i++, next++)
+            {
+                if (msgs[i].msg_len != msg_size || rx_buf[i][0] != next)
+                    bad++;
+            }
+        }
+        else if (mode == MQ_TC_INPLACE)
+        {
+            len = mq_receive_get(mqd, (void **)&msg, RT_NULL, RT_NULL);
+            if (len < 0)
+            {
+                break;
+            }
+            if (len != msg_size || msg[0] != next)
+                bad++;
+            mq_receive_put(mqd, msg);
+            next++;
+        }
+        else
+        {
+            len = mq_receive(mqd, (char *)rx_buf[0], sizeof(rx_buf[0]), RT_NULL);
+            if (len < 0)
+            {
+                break;
+            }
+            if (len != msg_size || rx_buf[0][0] != next)
+                bad++;
+            next++;
+        }
+    }
+
+    rt_sem_take(&done_sem, RT_WAITING_FOREVER);
+    uassert_int_equal(next, MQ_TC_MSGS);
+    uassert_int_equal(bad, 0);
+    uassert_int_equal(send_fails, 0);
+}
+
+static void testcase_copy_16(void)
+{
+    UTEST_UNIT_RUN(mq_throughput);
+}
+UTEST_TC_EXPORT(testcase_copy_16, "testcases.posix.mqueue.copy_16", mq_tc_init_copy_16, mq_tc_cleanup, 10);
+
+static void testcase_copy_64(void)
+{
+    UTEST_UNIT_RUN(mq_throughput);
+}
+UTEST_TC_EXPORT(testcase_copy_64, "testcases.posix.mqueue.copy_64", mq_tc_init_copy_64, mq_tc_cleanup, 10);
+
+static void testcase_copy_256(void)
+{
+    UTEST_UNIT_RUN(mq_throughput);
+}
+UTEST_TC_EXPORT(testcase_copy_256, "testcases.posix.mqueue.copy_256", mq_tc_init_copy_256, mq_tc_cleanup, 10);
+
+static void testcase_batch_64(void)
+{
+    UTEST_UNIT_RUN(mq_throughput);
+}
+UTEST_TC_EXPORT(testcase_batch_64, "testcases.posix.mqueue.batch_64", mq_tc_init_batch_64, mq_tc_cleanup, 10);
+
+static void testcase_inplace_64(void)
+{
+    UTEST_UNIT_RUN(mq_throughput);
+}
+UTEST_TC_EXPORT(testcase_inplace_64, "testcases.posix.mqueue.inplace_64", mq_tc_init_inplace_64, mq_tc_cleanup, 10);
+
+static volatile ssize_t chk_result;
+static volatile int chk_errno;
+
+static void mq_tc_blocked(void *param)
+{
+    rt_uint32_t buf[MQ_TC_CHK_MSGSIZE / sizeof(rt_uint32_t)];
+
+    chk_result = mq_receive(mqd, (char *)buf, sizeof(buf), RT_NULL);
+    chk_errno = rt_get_errno();
+    rt_sem_release(&done_sem);
+}
+
+static rt_err_t mq_tc_init_checks(void)
+{
+    struct mq_attr attr = {0};
+
+    attr.mq_maxmsg = 4;
+    attr.mq_msgsize = MQ_TC_CHK_MSGSIZE;
+    mqd = mq_open(MQ_TC_CHK_NAME, O_CREAT | O_RDWR, 0666, &attr);
+    if (mqd == (mqd_t)-1)
+    {
+        return -RT_ERROR;
+    }
+    rt_sem_init(&done_sem, "mq_done", 0, RT_IPC_FLAG_FIFO);
+
+    return RT_EOK;
+}
+
+static rt_err_t mq_tc_cleanup_checks(void)
+{
+    rt_sem_detach(&done_sem);
+    mq_close(mqd);
+    /* already gone when the unlink unit ran */
+    mq_unlink(MQ_TC_CHK_NAME);
+    mqd = (mqd_t)-1;
+
+    return RT_EOK;
+}
+
+static void mq_bad_buffer(void)
+{
+    rt_uint8_t *msg;
+    rt_uint8_t other[MQ_TC_CHK_MSGSIZE];
+    void *got;
+
+    msg = mq_send_alloc(mqd, RT_NULL);
+    uassert_not_null(msg);
+    if (msg == RT_NULL)
+    {
+        return;
+    }
+
+    uassert_int_equal(mq_send_commit(mqd, other, MQ_TC_CHK_MSGSIZE, 0), -1);
+    uassert_int_equal(rt_get_errno(), EINVAL);
+    uassert_int_equal(mq_send_commit(mqd, msg + 4, MQ_TC_CHK_MSGSIZE, 0), -1);
+    uassert_int_equal(rt_get_errno(), EINVAL);
+    /* a refused pointer does not give the buffer back, it still commits */
+    uassert_int_equal(mq_send_commit(mqd, msg, MQ_TC_CHK_MSGSIZE, 0), 0);
+
+    uassert_int_equal(mq_receive_get(mqd, &got, RT_NULL, RT_NULL), MQ_TC_CHK_MSGSIZE);
+    uassert_true(got == msg);
+    uassert_int_equal(mq_receive_put(mqd, other), -1);
+    uassert_int_equal(rt_get_errno(), EINVAL);
+    uassert_int_equal(mq_receive_put(mqd, msg - 4), -1);
+    uassert_int_equal(rt_get_errno(), EINVAL);
+    uassert_int_equal(mq_receive_put(mqd, got), 0);
+}
+
+static void mq_unlink_wakes(void)
+{
+    rt_thread_t tid;
+
+    chk_result = 0;
+    chk_errno = 0;
+    /* the higher priority runs it at once, it blocks on the empty queue */
+    tid = rt_thread_create("mq_tc_rx", mq_tc_blocked, RT_NULL, MQ_TC_STACK_SIZE,
+                           rt_thread_self()->current_priority - 1, 10);
+    uassert_not_null(tid);
+    if (tid == RT_NULL)
+    {
+        return;
+    }
+    rt_thread_startup(tid);
+
+    uassert_int_equal(mq_unlink(MQ_TC_CHK_NAME), 0);
+    uassert_int_equal(rt_sem_take(&done_sem, RT_TICK_PER_SECOND), RT_EOK);
+    uassert_int_equal(chk_result, -1);
+    uassert_int_equal(chk_errno, EBADF);
+}
+
+static void testcase_checks(void)
+{
+    UTEST_UNIT_RUN(mq_bad_buffer);
+    UTEST_UNIT_RUN(mq_unlink_wakes);
+}
+UTEST_TC_EXPORT(testcase_checks, "testcases.posix.mqueue.checks", mq_tc_init_checks, mq_tc_cleanup_checks, 10);
@@ -7,6 +7,7 @@
  * Date           Author      Notes
  * 2018/08/29     Bernard     first version
  * 2021/04/23     chunyexixiaoyu    distinguish 32-bit and 64-bit
+ * 2026-10-17     RT-Thread         index the module symbol table
  */
 
 #include "dlmodule.h"
@@ -234,6 +235,7 @@ rt_err_t dlmodule_load_shared_object(struct rt_dlmodule* module, void *module_pt
                       length);
             count ++;
         }
+        module->symhash = dlmodule_symhash_build(module->symtab, module->nsym, &module->nbucket);
 
         /* get priority & stack size params*/
         rt_uint32_t flag = 0;
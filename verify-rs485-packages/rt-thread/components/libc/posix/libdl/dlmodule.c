@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author      Notes
  * 2018/08/29     Bernard     first version
+ * 2026-10-17     RT-Thread   look up kernel symbols through a hash index
  */
 
 #include <rthw.h>
@@ -28,6 +29,10 @@
 
 static struct rt_module_symtab *_rt_module_symtab_begin = RT_NULL;
 static struct rt_module_symtab *_rt_module_symtab_end   = RT_NULL;
+static rt_uint16_t *_rt_module_symhash = RT_NULL;
+static rt_uint16_t _rt_module_nbucket = 0;
+
+#define SYMHASH_NONE    0xFFFF
 
 #if defined(__IAR_SYSTEMS_ICC__) /* for IAR compiler */
     #pragma section="RTMSymTab"
@@ -392,6 +397,10 @@ rt_err_t dlmodule_destroy(struct rt_dlmodule* module)
     {
         rt_free(module->symtab);
     }
+    if (module->symhash != RT_NULL)
+    {
+        rt_free(module->symhash);
+    }
 
     /* destory module */
     rt_free(module->mem_space);
@@ -792,17 +801,109 @@ void dlmodule_exit(int ret_code)
     rt_exit_critical();
 }
 
-rt_uint32_t dlmodule_symbol_find(const char *sym_str)
+/* the hash function of the GNU hash section */
+static rt_uint32_t _symhash_calc(const char *name)
 {
-    /* find in kernel symbol table */
-    struct rt_module_symtab *index;
+    rt_uint32_t h = 5381;
+
+    while (*name)
+    {
+        h = (h << 5) + h + (rt_uint8_t)*name++;
+    }
+
+    return h;
+}
+
+/**
+ * This function will build a hash index for a symbol table.
+ *
+ * @param symtab the symbol table
+ * @param nsym the number of symbols
+ * @param nbucket the number of buckets of the index
+ *
+ * @return the bucket heads followed by one chain link per symbol, RT_NULL on failure
+ */
+rt_uint16_t *dlmodule_symhash_build(const struct rt_module_symtab *symtab, rt_size_t nsym, rt_uint16_t *nbucket)
+{
+    rt_uint16_t *symhash, *chain;
+    rt_size_t i, n = 1;
+    rt_uint32_t b;
+
+    /* indexes are 16 bits wide, SYMHASH_NONE ends a chain */
+    if (nsym == 0 || nsym >= SYMHASH_NONE)
+        return RT_NULL;
+
+    /* a power of two with about two symbols per bucket */
+    while (n * 2 < nsym && n < 0x4000)
+        n <<= 1;
+
+    symhash = (rt_uint16_t *)rt_malloc((n + nsym) * sizeof(rt_uint16_t));
+    if (symhash == RT_NULL)
+        return RT_NULL;
+
+    chain = symhash + n;
+    rt_memset(symhash, 0xFF, n * sizeof(rt_uint16_t));
+
+    /* insert backwards, so duplicated names resolve to the first entry like a linear search */
+    for (i = nsym; i > 0; i --)
+    {
+        b = _symhash_calc(symtab[i - 1].name) & (n - 1);
+        chain[i - 1] = symhash[b];
+        symhash[b] = (rt_uint16_t)(i - 1);
+    }
+
+    *nbucket = (rt_uint16_t)n;
+    return symhash;
+}
+
+/**
+ * This function will find a symbol in a symbol table.
+ *
+ * @param symtab the symbol table
+ * @param nsym the number of symbols
+ * @param symhash the index from dlmodule_symhash_build, or RT_NULL to search linearly
+ * @param nbucket the number of buckets of the index
+ * @param name the symbol name
+ *
+ * @return the symbol entry, RT_NULL if not found
+ */
+const struct rt_module_symtab *dlmodule_symhash_find(const struct rt_module_symtab *symtab, rt_size_t nsym,
+        const rt_uint16_t *symhash, rt_uint16_t nbucket, const char *name)
+{
+    rt_uint16_t index;
+    rt_size_t i;
 
-    for (index = _rt_module_symtab_begin; index != _rt_module_symtab_end; index ++)
+    if (symhash == RT_NULL)
     {
-        if (rt_strcmp(index->name, sym_str) == 0)
-            return (rt_uint32_t)index->addr;
+        for (i = 0; i < nsym; i ++)
+        {
+            if (rt_strcmp(symtab[i].name, name) == 0)
+                return &symtab[i];
+        }
+        return RT_NULL;
     }
 
+    index = symhash[_symhash_calc(name) & (nbucket - 1)];
+    while (index != SYMHASH_NONE)
+    {
+        if (rt_strcmp(symtab[index].name, name) == 0)
+            return &symtab[index];
+        index = symhash[nbucket + index];
+    }
+
+    return RT_NULL;
+}
+
+rt_uint32_t dlmodule_symbol_find(const char *sym_str)
+{
+    /* find in kernel symbol table */
+    const struct rt_module_symtab *index;
+
+    index = dlmodule_symhash_find(_rt_module_symtab_begin, _rt_module_symtab_end - _rt_module_symtab_begin,
+                                  _rt_module_symhash, _rt_module_nbucket, sym_str);
+    if (index)
+        return (rt_uint32_t)index->addr;
+
     return 0;
 }
 
@@ -825,6 +926,11 @@ int rt_system_dlmodule_init(void)
     _rt_module_symtab_end   = __section_end("RTMSymTab");
 #endif
 
+    /* relocations look up every undefined symbol here, index it once; linear search if it fails */
+    _rt_module_symhash = dlmodule_symhash_build(_rt_module_symtab_begin,
+                                                _rt_module_symtab_end - _rt_module_symtab_begin,
+                                                &_rt_module_nbucket);
+
     return 0;
 }
 INIT_COMPONENT_EXPORT(rt_system_dlmodule_init);
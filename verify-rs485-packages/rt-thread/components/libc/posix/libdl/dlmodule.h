@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018/08/11     Bernard      the first version
+ * 2026-10-17     RT-Thread    hash the kernel and module symbol tables
  */
 
 #ifndef RT_DL_MODULE_H__
@@ -57,6 +58,9 @@ struct rt_dlmodule
 
     rt_uint16_t nsym;       /* number of symbols in the module */
     struct rt_module_symtab *symtab;    /* module symbol table */
+
+    rt_uint16_t nbucket;    /* number of buckets in symhash */
+    rt_uint16_t *symhash;   /* bucket heads followed by the chains, RT_NULL if not built */
 };
 
 struct rt_dlmodule_ops
@@ -84,4 +88,8 @@ struct rt_dlmodule *dlmodule_find(const char *name);
 
 rt_uint32_t dlmodule_symbol_find(const char *sym_str);
 
+rt_uint16_t *dlmodule_symhash_build(const struct rt_module_symtab *symtab, rt_size_t nsym, rt_uint16_t *nbucket);
+const struct rt_module_symtab *dlmodule_symhash_find(const struct rt_module_symtab *symtab, rt_size_t nsym,
+        const rt_uint16_t *symhash, rt_uint16_t nbucket, const char *name);
+
 #endif
@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author      Notes
  * 2010-11-17     yi.qiu      first version
+ * 2026-10-17     RT-Thread   use the module symbol hash
  */
 
 #include <rtthread.h>
@@ -15,18 +16,16 @@
 
 void* dlsym(void *handle, const char* symbol)
 {
-    int i;
     struct rt_dlmodule *module;
+    const struct rt_module_symtab *sym;
 
     RT_ASSERT(handle != RT_NULL);
 
     module = (struct rt_dlmodule *)handle;
 
-    for(i=0; i<module->nsym; i++)
-    {
-        if (rt_strcmp(module->symtab[i].name, symbol) == 0)
-            return (void*)module->symtab[i].addr;
-    }
+    sym = dlmodule_symhash_find(module->symtab, module->nsym, module->symhash, module->nbucket, symbol);
+    if (sym)
+        return (void*)sym->addr;
 
     return RT_NULL;
 }
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "dlmodule.h"
+#include "utest.h"
+
+/*
+ * Symbol lookups in a table of DL_TC_SYMS generated names, the size of a
+ * kernel with a few thousand exports. The index testcase checks that the
+ * hash index finds what the linear search finds, the first of duplicated
+ * names included, and that the kernel table resolves its own exports.
+ * Every run of the lookup testcases looks up DL_TC_LOOKUPS pseudo random
+ * names with and without the index. Compare them with:
+ *
+ *     utest_bench -n 20 testcases.posix.libdl.lookup_*
+ */
+
+#define DL_TC_SYMS          2048
+#define DL_TC_NAME_LEN      16
+#define DL_TC_LOOKUPS       1024
+#define DL_TC_DUP           7
+
+static struct rt_module_symtab *symtab;
+static char *names;
+static rt_uint16_t *symhash;
+static rt_uint16_t nbucket;
+static rt_uint32_t seed;
+
+static rt_err_t dl_tc_init(void)
+{
+    int i;
+
+    symtab = rt_malloc(DL_TC_SYMS * sizeof(struct rt_module_symtab));
+    names = rt_malloc(DL_TC_SYMS * DL_TC_NAME_LEN);
+    if (symtab == RT_NULL || names == RT_NULL)
+    {
+        goto _error;
+    }
+
+    /* names share a prefix like the exports of one subsystem */
+    for (i = 0; i < DL_TC_SYMS; i++)
+    {
+        rt_snprintf(names + i * DL_TC_NAME_LEN, DL_TC_NAME_LEN, "rt_tc_sym_%d", i);
+        symtab[i].name = names + i * DL_TC_NAME_LEN;
+        symtab[i].addr = (void *)(rt_ubase_t)(i + 1);
+    }
+    /* the last entry repeats an earlier name */
+    symtab[DL_TC_SYMS - 1].name = symtab[DL_TC_DUP].name;
+
+    symhash = dlmodule_symhash_build(symtab, DL_TC_SYMS, &nbucket);
+    if (symhash == RT_NULL)
+    {
+        goto _error;
+    }
+    seed = 1;
+
+    return RT_EOK;
+
+_error:
+    rt_free(symtab);
+    rt_free(names);
+    symtab = RT_NULL;
+    names = RT_NULL;
+
+    return -RT_ENOMEM;
+}
+
+static rt_err_t dl_tc_cleanup(void)
+{
+    rt_free(symhash);
+    rt_free(symtab);
+    rt_free(names);
+    symhash = RT_NULL;
+    symtab = RT_NULL;
+    names = RT_NULL;
+
+    return RT_EOK;
+}
+
+static void dl_index(void)
+{
+    const struct rt_module_symtab *sym;
+    int i, bad = 0;
+
+    uassert_true(nbucket >= DL_TC_SYMS / 2 && (nbucket & (nbucket - 1)) == 0);
+
+    for (i = 0; i < DL_TC_SYMS - 1; i++)
+    {
+        sym = dlmodule_symhash_find(symtab, DL_TC_SYMS, symhash, nbucket, symtab[i].name);
+        if (sym != &symtab[i] ||
+            sym != dlmodule_symhash_find(symtab, DL_TC_SYMS, RT_NULL, 0, symtab[i].name))
+        {
+            bad ++;
+        }
+    }
+    uassert_int_equal(bad, 0);
+
+    sym = dlmodule_symhash_find(symtab, DL_TC_SYMS, symhash, nbucket, names + (DL_TC_SYMS - 1) * DL_TC_NAME_LEN);
+    uassert_null(sym);
+    sym = dlmodule_symhash_find(symtab, DL_TC_SYMS, symhash, nbucket, symtab[DL_TC_DUP].name);
+    uassert_true(sym == &symtab[DL_TC_DUP]);
+    uassert_null(dlmodule_symhash_find(symtab, DL_TC_SYMS, symhash, nbucket, "rt_tc_sym_"));
+
+    /* the kernel table, RTM_EXPORT(rt_kprintf) is in kservice.c */
+    uassert_int_equal(dlmodule_symbol_find("rt_kprintf"), (rt_uint32_t)(rt_ubase_t)rt_kprintf);
+    uassert_int_equal(dlmodule_symbol_find("rt_tc_no_such_symbol"), 0);
+}
+
+static void dl_lookups(const rt_uint16_t *index)
+{
+    const struct rt_module_symtab *sym;
+    int i, n, bad = 0;
+
+    for (i = 0; i < DL_TC_LOOKUPS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        n = (seed >> 8) % (DL_TC_SYMS - 1);
+        sym = dlmodule_symhash_find(symtab, DL_TC_SYMS, index, nbucket, names + n * DL_TC_NAME_LEN);
+        if (sym == RT_NULL || sym->addr != (void *)(rt_ubase_t)(n + 1))
+        {
+            bad ++;
+        }
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void dl_lookup_hash(void)
+{
+    dl_lookups(symhash);
+}
+
+static void dl_lookup_linear(void)
+{
+    dl_lookups(RT_NULL);
+}
+
+static void testcase_index(void)
+{
+    UTEST_UNIT_RUN(dl_index);
+}
+UTEST_TC_EXPORT(testcase_index, "testcases.posix.libdl.index", dl_tc_init, dl_tc_cleanup, 10);
+
+static void testcase_hash(void)
+{
+    UTEST_UNIT_RUN(dl_lookup_hash);
+}
+UTEST_TC_EXPORT(testcase_hash, "testcases.posix.libdl.lookup_hash", dl_tc_init, dl_tc_cleanup, 10);
+
+static void testcase_linear(void)
+{
+    UTEST_UNIT_RUN(dl_lookup_linear);
+}
+UTEST_TC_EXPORT(testcase_linear, "testcases.posix.libdl.lookup_linear", dl_tc_init, dl_tc_cleanup, 30);
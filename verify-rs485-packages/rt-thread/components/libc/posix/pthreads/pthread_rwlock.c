@@ -6,10 +6,21 @@
  * Change Logs:
  * Date           Author       Notes
  * 2010-10-26     Bernard      the first version
+ * 2026-10-17     RT-Thread    take read locks with one atomic operation when uncontended
  */
 
 #include <pthread.h>
 
+/*
+ * rw_state holds the number of readers in the low bits. Readers lock and
+ * unlock it with a single atomic operation while no writer flag is set;
+ * everything else goes through rw_mutex. The flags are only changed with
+ * rw_mutex held.
+ */
+#define RWLOCK_WRITER           ((rt_atomic_t)1 << 30)  /* held by a writer */
+#define RWLOCK_WAITERS          ((rt_atomic_t)1 << 29)  /* a writer holds or waits, readers take the slow path */
+#define RWLOCK_READERS          (RWLOCK_WAITERS - 1)
+
 int pthread_rwlockattr_init(pthread_rwlockattr_t *attr)
 {
     if (!attr)
@@ -63,7 +74,7 @@ int pthread_rwlock_init(pthread_rwlock_t           *rwlock,
 
     rwlock->rw_nwaitwriters = 0;
     rwlock->rw_nwaitreaders = 0;
-    rwlock->rw_refcount = 0;
+    rt_atomic_store(&rwlock->rw_state, 0);
 
     return 0;
 }
@@ -81,7 +92,7 @@ int pthread_rwlock_destroy (pthread_rwlock_t *rwlock)
     if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
         return(result);
 
-    if (rwlock->rw_refcount != 0 ||
+    if (rt_atomic_load(&rwlock->rw_state) != 0 ||
         rwlock->rw_nwaitreaders != 0 ||
         rwlock->rw_nwaitwriters != 0)
     {
@@ -122,135 +133,155 @@ int pthread_rwlock_destroy (pthread_rwlock_t *rwlock)
 }
 RTM_EXPORT(pthread_rwlock_destroy);
 
-int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
+/* add a reader unless a writer holds or waits for the lock */
+static int _rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+{
+    rt_atomic_t state;
+
+    state = rt_atomic_load(&rwlock->rw_state);
+    while ((state & (RWLOCK_WRITER | RWLOCK_WAITERS)) == 0)
+    {
+        if (rt_atomic_compare_exchange_strong(&rwlock->rw_state, &state, state + 1))
+            return 0;
+    }
+
+    return EBUSY;
+}
+
+static int _rwlock_rdlock(pthread_rwlock_t *rwlock, const struct timespec *abstime)
 {
     int result;
 
-    if (!rwlock)
-        return EINVAL;
-    if (rwlock->attr == -1)
-        pthread_rwlock_init(rwlock, NULL);
+    if (_rwlock_tryrdlock(rwlock) == 0)
+        return 0;
 
     if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
         return(result);
 
     /* give preference to waiting writers */
-    while (rwlock->rw_refcount < 0 || rwlock->rw_nwaitwriters > 0)
+    while (rt_atomic_load(&rwlock->rw_state) & (RWLOCK_WRITER | RWLOCK_WAITERS))
     {
         rwlock->rw_nwaitreaders++;
         /* rw_mutex will be released when waiting for rw_condreaders */
-        result = pthread_cond_wait(&rwlock->rw_condreaders, &rwlock->rw_mutex);
+        if (abstime)
+            result = pthread_cond_timedwait(&rwlock->rw_condreaders, &rwlock->rw_mutex, abstime);
+        else
+            result = pthread_cond_wait(&rwlock->rw_condreaders, &rwlock->rw_mutex);
         /* rw_mutex should have been taken again when returned from waiting */
         rwlock->rw_nwaitreaders--;
         if (result != 0) /* wait error */
             break;
     }
 
-    /* another reader has a read lock */
+    /* the flags can not change while rw_mutex is held */
     if (result == 0)
-        rwlock->rw_refcount++;
+        rt_atomic_add(&rwlock->rw_state, 1);
 
     pthread_mutex_unlock(&rwlock->rw_mutex);
 
     return (result);
 }
-RTM_EXPORT(pthread_rwlock_rdlock);
 
-int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+static int _rwlock_wrlock(pthread_rwlock_t *rwlock, const struct timespec *abstime)
 {
     int result;
 
-    if (!rwlock)
-        return EINVAL;
-    if (rwlock->attr == -1)
-        pthread_rwlock_init(rwlock, NULL);
-
     if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
         return(result);
 
-    if (rwlock->rw_refcount < 0 || rwlock->rw_nwaitwriters > 0)
-        result = EBUSY;                 /* held by a writer or waiting writers */
-    else
-        rwlock->rw_refcount++;          /* increment count of reader locks */
+    /* new readers will queue on rw_mutex from now on */
+    rwlock->rw_nwaitwriters++;
+    rt_atomic_or(&rwlock->rw_state, RWLOCK_WAITERS);
+
+    while (rt_atomic_load(&rwlock->rw_state) & (RWLOCK_WRITER | RWLOCK_READERS))
+    {
+        /* rw_mutex will be released when waiting for rw_condwriters */
+        if (abstime)
+            result = pthread_cond_timedwait(&rwlock->rw_condwriters, &rwlock->rw_mutex, abstime);
+        else
+            result = pthread_cond_wait(&rwlock->rw_condwriters, &rwlock->rw_mutex);
+        /* rw_mutex should have been taken again when returned from waiting */
+        if (result != 0)
+            break;
+    }
+    rwlock->rw_nwaitwriters--;
+
+    if (result == 0)
+    {
+        rt_atomic_or(&rwlock->rw_state, RWLOCK_WRITER);
+    }
+    else if ((rt_atomic_load(&rwlock->rw_state) & RWLOCK_WRITER) == 0)
+    {
+        if (rwlock->rw_nwaitwriters > 0)
+        {
+            /* the wake up may have been meant for us */
+            if ((rt_atomic_load(&rwlock->rw_state) & RWLOCK_READERS) == 0)
+                pthread_cond_signal(&rwlock->rw_condwriters);
+        }
+        else
+        {
+            rt_atomic_and(&rwlock->rw_state, ~RWLOCK_WAITERS);
+            if (rwlock->rw_nwaitreaders > 0)
+                pthread_cond_broadcast(&rwlock->rw_condreaders);
+        }
+    }
 
     pthread_mutex_unlock(&rwlock->rw_mutex);
 
     return(result);
 }
-RTM_EXPORT(pthread_rwlock_tryrdlock);
 
-int pthread_rwlock_timedrdlock(pthread_rwlock_t      *rwlock,
-                               const struct timespec *abstime)
+int pthread_rwlock_rdlock(pthread_rwlock_t *rwlock)
 {
-    int result;
-
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
+    return _rwlock_rdlock(rwlock, NULL);
+}
+RTM_EXPORT(pthread_rwlock_rdlock);
 
-    /* give preference to waiting writers */
-    while (rwlock->rw_refcount < 0 || rwlock->rw_nwaitwriters > 0)
-    {
-        rwlock->rw_nwaitreaders++;
-        /* rw_mutex will be released when waiting for rw_condreaders */
-        result = pthread_cond_timedwait(&rwlock->rw_condreaders, &rwlock->rw_mutex, abstime);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitreaders--;
-        if (result != 0)
-            break;
-    }
+int pthread_rwlock_tryrdlock(pthread_rwlock_t *rwlock)
+{
+    if (!rwlock)
+        return EINVAL;
+    if (rwlock->attr == -1)
+        pthread_rwlock_init(rwlock, NULL);
 
-    /* another reader has a read lock */
-    if (result == 0)
-        rwlock->rw_refcount++;
+    /* held by a writer or waiting writers */
+    return _rwlock_tryrdlock(rwlock);
+}
+RTM_EXPORT(pthread_rwlock_tryrdlock);
 
-    pthread_mutex_unlock(&rwlock->rw_mutex);
+int pthread_rwlock_timedrdlock(pthread_rwlock_t      *rwlock,
+                               const struct timespec *abstime)
+{
+    if (!rwlock)
+        return EINVAL;
+    if (rwlock->attr == -1)
+        pthread_rwlock_init(rwlock, NULL);
 
-    return (result);
+    return _rwlock_rdlock(rwlock, abstime);
 }
 RTM_EXPORT(pthread_rwlock_timedrdlock);
 
 int pthread_rwlock_timedwrlock(pthread_rwlock_t      *rwlock,
                                const struct timespec *abstime)
 {
-    int result;
-
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
-
-    while (rwlock->rw_refcount != 0)
-    {
-        rwlock->rw_nwaitwriters++;
-        /* rw_mutex will be released when waiting for rw_condwriters */
-        result = pthread_cond_timedwait(&rwlock->rw_condwriters, &rwlock->rw_mutex, abstime);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitwriters--;
-
-        if (result != 0)
-            break;
-    }
-
-    if (result == 0)
-        rwlock->rw_refcount = -1;
-
-    pthread_mutex_unlock(&rwlock->rw_mutex);
-
-    return(result);
+    return _rwlock_wrlock(rwlock, abstime);
 }
 RTM_EXPORT(pthread_rwlock_timedwrlock);
 
 int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
 {
     int result;
+    rt_atomic_t state = 0;
 
     if (!rwlock)
         return EINVAL;
@@ -260,10 +291,9 @@ int pthread_rwlock_trywrlock(pthread_rwlock_t *rwlock)
     if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
         return(result);
 
-    if (rwlock->rw_refcount != 0)
+    /* only an idle lock can be taken, a racing reader makes it fail */
+    if (!rt_atomic_compare_exchange_strong(&rwlock->rw_state, &state, RWLOCK_WRITER))
         result = EBUSY;                 /* held by either writer or reader(s) */
-    else
-        rwlock->rw_refcount = -1;       /* available, indicate a writer has it */
 
     pthread_mutex_unlock(&rwlock->rw_mutex);
 
@@ -274,29 +304,47 @@ RTM_EXPORT(pthread_rwlock_trywrlock);
 int pthread_rwlock_unlock(pthread_rwlock_t *rwlock)
 {
     int result;
+    rt_atomic_t state;
 
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
+    state = rt_atomic_load(&rwlock->rw_state);
+    if ((state & RWLOCK_WRITER) == 0)
+    {
+        if ((state & RWLOCK_READERS) == 0)
+            return 0;                       /* not locked */
+
+        /* releasing a reader, only the last one may have a writer to wake up */
+        state = rt_atomic_sub(&rwlock->rw_state, 1);
+        if ((state & RWLOCK_WAITERS) == 0 || (state & RWLOCK_READERS) != 1)
+            return 0;
+
+        if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
+            return(result);
+        if (rwlock->rw_nwaitwriters > 0)
+            result = pthread_cond_signal(&rwlock->rw_condwriters);
+        pthread_mutex_unlock(&rwlock->rw_mutex);
+
         return(result);
+    }
 
-    if (rwlock->rw_refcount > 0)
-        rwlock->rw_refcount--;              /* releasing a reader */
-    else if (rwlock->rw_refcount == -1)
-        rwlock->rw_refcount = 0;            /* releasing a writer */
+    if ( (result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
+        return(result);
 
-    /* give preference to waiting writers over waiting readers */
+    /* releasing a writer, give preference to waiting writers over waiting readers */
     if (rwlock->rw_nwaitwriters > 0)
     {
-        if (rwlock->rw_refcount == 0)
-            result = pthread_cond_signal(&rwlock->rw_condwriters);
+        rt_atomic_and(&rwlock->rw_state, ~RWLOCK_WRITER);
+        result = pthread_cond_signal(&rwlock->rw_condwriters);
     }
-    else if (rwlock->rw_nwaitreaders > 0)
+    else
     {
-        result = pthread_cond_broadcast(&rwlock->rw_condreaders);
+        rt_atomic_and(&rwlock->rw_state, ~(RWLOCK_WRITER | RWLOCK_WAITERS));
+        if (rwlock->rw_nwaitreaders > 0)
+            result = pthread_cond_broadcast(&rwlock->rw_condreaders);
     }
 
     pthread_mutex_unlock(&rwlock->rw_mutex);
@@ -307,34 +355,11 @@ RTM_EXPORT(pthread_rwlock_unlock);
 
 int pthread_rwlock_wrlock(pthread_rwlock_t *rwlock)
 {
-    int result;
-
     if (!rwlock)
         return EINVAL;
     if (rwlock->attr == -1)
         pthread_rwlock_init(rwlock, NULL);
 
-    if ((result = pthread_mutex_lock(&rwlock->rw_mutex)) != 0)
-        return(result);
-
-    while (rwlock->rw_refcount != 0)
-    {
-        rwlock->rw_nwaitwriters++;
-        /* rw_mutex will be released when waiting for rw_condwriters */
-        result = pthread_cond_wait(&rwlock->rw_condwriters, &rwlock->rw_mutex);
-        /* rw_mutex should have been taken again when returned from waiting */
-        rwlock->rw_nwaitwriters--;
-
-        if (result != 0)
-            break;
-    }
-
-    if (result == 0)
-        rwlock->rw_refcount = -1;
-
-    pthread_mutex_unlock(&rwlock->rw_mutex);
-
-    return(result);
+    return _rwlock_wrlock(rwlock, NULL);
 }
 RTM_EXPORT(pthread_rwlock_wrlock);
-
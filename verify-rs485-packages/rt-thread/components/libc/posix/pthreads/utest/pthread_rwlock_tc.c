@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <pthread.h>
+#include "utest.h"
+
+/*
+ * Read lock throughput with 1, 4 and 8 concurrent readers. In every run
+ * of a testcase each reader takes and releases the lock RWLOCK_TC_LOOPS
+ * times, time it with:
+ *
+ *     utest_bench -n 100 testcases.posix.pthread_rwlock.*
+ */
+
+#define RWLOCK_TC_READERS_MAX   8
+#define RWLOCK_TC_LOOPS         1000
+#define RWLOCK_TC_STACK_SIZE    1024
+
+static pthread_rwlock_t rwlock;
+static struct rt_semaphore go_sem;
+static struct rt_semaphore done_sem;
+static int readers_num;
+static volatile int stopping;
+static rt_atomic_t fails;
+
+static void rwlock_reader(void *param)
+{
+    int i;
+
+    while (1)
+    {
+        rt_sem_take(&go_sem, RT_WAITING_FOREVER);
+        if (stopping)
+        {
+            break;
+        }
+
+        for (i = 0; i < RWLOCK_TC_LOOPS; i++)
+        {
+            if (pthread_rwlock_rdlock(&rwlock) != 0)
+            {
+                rt_atomic_add(&fails, 1);
+                break;
+            }
+            pthread_rwlock_unlock(&rwlock);
+        }
+        rt_sem_release(&done_sem);
+    }
+
+    rt_sem_release(&done_sem);
+}
+
+static rt_err_t rwlock_tc_init(int num)
+{
+    rt_thread_t tid;
+    char name[RT_NAME_MAX];
+
+    if (pthread_rwlock_init(&rwlock, NULL) != 0)
+    {
+        return -RT_ERROR;
+    }
+    rt_sem_init(&go_sem, "rwl_go", 0, RT_IPC_FLAG_FIFO);
+    rt_sem_init(&done_sem, "rwl_done", 0, RT_IPC_FLAG_FIFO);
+    rt_atomic_store(&fails, 0);
+    stopping = 0;
+
+    /* the readers run at the priority of the testcase thread */
+    for (readers_num = 0; readers_num < num; readers_num++)
+    {
+        rt_snprintf(name, sizeof(name), "rwl%d", readers_num);
+        tid = rt_thread_create(name, rwlock_reader, RT_NULL, RWLOCK_TC_STACK_SIZE,
+                               rt_thread_self()->current_priority, 10);
+        if (tid == RT_NULL)
+        {
+            break;
+        }
+        rt_thread_startup(tid);
+    }
+
+    return readers_num == num ? RT_EOK : -RT_ENOMEM;
+}
+
+static rt_err_t rwlock_tc_init_1(void)
+{
+    return rwlock_tc_init(1);
+}
+
+static rt_err_t rwlock_tc_init_4(void)
+{
+    return rwlock_tc_init(4);
+}
+
+static rt_err_t rwlock_tc_init_8(void)
+{
+    return rwlock_tc_init(8);
+}
+
+static rt_err_t rwlock_tc_cleanup(void)
+{
+    int i;
+
+    stopping = 1;
+    for (i = 0; i < readers_num; i++)
+    {
+        rt_sem_release(&go_sem);
+    }
+    for (i = 0; i < readers_num; i++)
+    {
+        rt_sem_take(&done_sem, RT_WAITING_FOREVER);
+    }
+    readers_num = 0;
+
+    rt_sem_detach(&go_sem);
+    rt_sem_detach(&done_sem);
+
+    return pthread_rwlock_destroy(&rwlock) == 0 ? RT_EOK : -RT_ERROR;
+}
+
+static void rwlock_readers(void)
+{
+    int i;
+
+    for (i = 0; i < readers_num; i++)
+    {
+        rt_sem_release(&go_sem);
+    }
+    for (i = 0; i < readers_num; i++)
+    {
+        rt_sem_take(&done_sem, RT_WAITING_FOREVER);
+    }
+
+    uassert_int_equal(rt_atomic_load(&fails), 0);
+    /* all the readers have let go of the lock */
+    uassert_int_equal(pthread_rwlock_trywrlock(&rwlock), 0);
+    uassert_int_equal(pthread_rwlock_unlock(&rwlock), 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(rwlock_readers);
+}
+UTEST_TC_EXPORT(testcase, "testcases.posix.pthread_rwlock.readers_1", rwlock_tc_init_1, rwlock_tc_cleanup, 10);
+
+static void testcase_4(void)
+{
+    UTEST_UNIT_RUN(rwlock_readers);
+}
+UTEST_TC_EXPORT(testcase_4, "testcases.posix.pthread_rwlock.readers_4", rwlock_tc_init_4, rwlock_tc_cleanup, 10);
+
+static void testcase_8(void)
+{
+    UTEST_UNIT_RUN(rwlock_readers);
+}
+UTEST_TC_EXPORT(testcase_8, "testcases.posix.pthread_rwlock.readers_8", rwlock_tc_init_8, rwlock_tc_cleanup, 10);
@@ -31,6 +31,7 @@
  * Date           Author       Notes
  * 2014-04-01     Ren.Haibo    the first version
  * 2018-06-12     aozima       ignore DHCP_OPTION_SERVER_ID.
+ * 2026-10-17     RT-Thread    index the leases by mac and ip, reply options template.
  */
 
 #include <stdio.h>
@@ -91,8 +92,16 @@
 /** dhcp default live time */
 #define DHCP_DEFAULT_LIVE_TIME      0x80510100
 
-/** Minimum length for request before packet is parsed */
-#define DHCP_MIN_REQUEST_LEN        44
+/** Minimum length for request before packet is parsed, up to the magic cookie */
+#define DHCP_MIN_REQUEST_LEN        DHCP_OPTIONS_OFS
+
+/** Length of the reply options after the message type */
+#define DHCP_REPLY_OPTIONS_MAX      32
+
+/** Max number of leases of a dhcp server */
+#ifndef DHCPD_LEASE_MAX
+    #define DHCPD_LEASE_MAX         (DHCPD_CLIENT_IP_MAX - DHCPD_CLIENT_IP_MIN + 1)
+#endif
 
 #define LWIP_NETIF_LOCK(...)
 #define LWIP_NETIF_UNLOCK(...)
@@ -106,7 +115,7 @@
 */
 struct dhcp_client_node
 {
-    struct dhcp_client_node *next;
+    struct dhcp_client_node *next;  /* in the free list */
     u8_t chaddr[DHCP_MAX_HLEN];
     ip4_addr_t ipaddr;
     u32_t lease_end;
@@ -120,10 +129,19 @@ struct dhcp_server
     struct dhcp_server *next;
     struct netif *netif;
     struct udp_pcb *pcb;
-    struct dhcp_client_node *node_list;
+    /* lease table, the indexes hold node index + 1, 0 is empty */
+    struct dhcp_client_node *node_table;
+    struct dhcp_client_node *node_free;
+    u16_t *ip_index;                /* by address offset in the pool */
+    u16_t *mac_index;               /* open addressing by mac address */
+    u16_t mac_mask;
+    u16_t pool_size;
     ip4_addr_t start;
     ip4_addr_t end;
     ip4_addr_t current;
+    /* options of the OFFER and ACK after the message type, up to the end */
+    u8_t reply_opts[DHCP_REPLY_OPTIONS_MAX];
+    u8_t reply_opts_len;
 };
 
 static u8_t *dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option);
@@ -133,6 +151,78 @@ static u8_t *dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option);
 */
 static struct dhcp_server *lw_dhcp_server;
 
+static u16_t
+dhcp_client_mac_hash(const u8_t *chaddr)
+{
+    u32_t hash = 2166136261UL;  /* FNV-1a */
+    int i;
+
+    for (i = 0; i < DHCP_MAX_HLEN; i++)
+    {
+        hash = (hash ^ chaddr[i]) * 16777619UL;
+    }
+
+    return (u16_t)(hash ^ (hash >> 16));
+}
+
+/**
+* Allocate the lease table for the address pool of a dhcp server,
+* the leases in the old table are dropped
+*
+* @param dhcpserver The dhcp server
+* @return lwIP error code
+*/
+static err_t
+dhcp_lease_table_init(struct dhcp_server *dhcpserver)
+{
+    u32_t pool_size, capacity, mac_size, i;
+    u8_t *buf;
+
+    if (dhcpserver->node_table != NULL)
+    {
+        mem_free(dhcpserver->node_table);
+        dhcpserver->node_table = NULL;
+    }
+    dhcpserver->node_free = NULL;
+    dhcpserver->pool_size = 0;
+
+    if (ntohl(dhcpserver->end.addr) < ntohl(dhcpserver->start.addr))
+    {
+        return ERR_ARG;
+    }
+    pool_size = ntohl(dhcpserver->end.addr) - ntohl(dhcpserver->start.addr) + 1;
+    if (pool_size > 0xFFFF)
+    {
+        return ERR_ARG;
+    }
+
+    capacity = LWIP_MIN(pool_size, DHCPD_LEASE_MAX);
+    /* at most half full */
+    for (mac_size = 4; mac_size < capacity * 2; mac_size <<= 1);
+
+    buf = (u8_t *)mem_malloc(capacity * sizeof(struct dhcp_client_node)
+                             + (pool_size + mac_size) * sizeof(u16_t));
+    if (buf == NULL)
+    {
+        return ERR_MEM;
+    }
+
+    dhcpserver->node_table = (struct dhcp_client_node *)buf;
+    dhcpserver->ip_index = (u16_t *)(buf + capacity * sizeof(struct dhcp_client_node));
+    dhcpserver->mac_index = dhcpserver->ip_index + pool_size;
+    memset(dhcpserver->ip_index, 0, (pool_size + mac_size) * sizeof(u16_t));
+    dhcpserver->mac_mask = mac_size - 1;
+    dhcpserver->pool_size = pool_size;
+
+    for (i = capacity; i > 0; i--)
+    {
+        dhcpserver->node_table[i - 1].next = dhcpserver->node_free;
+        dhcpserver->node_free = &dhcpserver->node_table[i - 1];
+    }
+
+    return ERR_OK;
+}
+
 /**
 * Find a dhcp client node by mac address
 *
@@ -145,13 +235,24 @@ static struct dhcp_client_node *
 dhcp_client_find_by_mac(struct dhcp_server *dhcpserver, const u8_t *chaddr, u8_t hlen)
 {
     struct dhcp_client_node *node;
+    u8_t key[DHCP_MAX_HLEN] = {0};
+    u16_t slot;
 
-    for (node = dhcpserver->node_list; node != NULL; node = node->next)
+    if (dhcpserver->pool_size == 0)
     {
-        if (memcmp(node->chaddr, chaddr, hlen) == 0)
+        return NULL;
+    }
+
+    SMEMCPY(key, chaddr, hlen);
+    slot = dhcp_client_mac_hash(key) & dhcpserver->mac_mask;
+    while (dhcpserver->mac_index[slot] != 0)
+    {
+        node = &dhcpserver->node_table[dhcpserver->mac_index[slot] - 1];
+        if (memcmp(node->chaddr, key, DHCP_MAX_HLEN) == 0)
         {
             return node;
         }
+        slot = (slot + 1) & dhcpserver->mac_mask;
     }
 
     return NULL;
@@ -167,17 +268,58 @@ dhcp_client_find_by_mac(struct dhcp_server *dhcpserver, const u8_t *chaddr, u8_t
 static struct dhcp_client_node *
 dhcp_client_find_by_ip(struct dhcp_server *dhcpserver, const ip4_addr_t *ip)
 {
-    struct dhcp_client_node *node;
+    u32_t offset;
 
-    for (node = dhcpserver->node_list; node != NULL; node = node->next)
+    offset = ntohl(ip4_addr_get_u32(ip)) - ntohl(dhcpserver->start.addr);
+    if (offset >= dhcpserver->pool_size || dhcpserver->ip_index[offset] == 0)
     {
-        if (ip4_addr_cmp(&node->ipaddr, ip))
+        return NULL;
+    }
+
+    return &dhcpserver->node_table[dhcpserver->ip_index[offset] - 1];
+}
+
+/**
+* Free a dhcp client node
+*
+* @param dhcpserver The dhcp server
+* @param node The dhcp client node
+*/
+static void
+dhcp_client_free(struct dhcp_server *dhcpserver, struct dhcp_client_node *node)
+{
+    u16_t index = (u16_t)(node - dhcpserver->node_table) + 1;
+    u16_t slot, next, home;
+
+    dhcpserver->ip_index[ntohl(node->ipaddr.addr) - ntohl(dhcpserver->start.addr)] = 0;
+
+    slot = dhcp_client_mac_hash(node->chaddr) & dhcpserver->mac_mask;
+    while (dhcpserver->mac_index[slot] != index)
+    {
+        slot = (slot + 1) & dhcpserver->mac_mask;
+    }
+
+    /* move the following nodes of the probe sequence back into the hole */
+    next = slot;
+    for (;;)
+    {
+        next = (next + 1) & dhcpserver->mac_mask;
+        if (dhcpserver->mac_index[next] == 0)
         {
-            return node;
+            break;
+        }
+        home = dhcp_client_mac_hash(dhcpserver->node_table[dhcpserver->mac_index[next] - 1].chaddr)
+               & dhcpserver->mac_mask;
+        if (((next - home) & dhcpserver->mac_mask) >= ((next - slot) & dhcpserver->mac_mask))
+        {
+            dhcpserver->mac_index[slot] = dhcpserver->mac_index[next];
+            slot = next;
         }
     }
+    dhcpserver->mac_index[slot] = 0;
 
-    return NULL;
+    node->next = dhcpserver->node_free;
+    dhcpserver->node_free = node;
 }
 
 /**
@@ -194,7 +336,7 @@ dhcp_client_find(struct dhcp_server *dhcpserver, struct dhcp_msg *msg,
                  u8_t *opt_buf, u16_t len)
 {
     u8_t *opt;
-    //u32_t ipaddr;
+    ip4_addr_t ipaddr;
     struct dhcp_client_node *node;
 
     node = dhcp_client_find_by_mac(dhcpserver, msg->chaddr, msg->hlen);
@@ -204,9 +346,10 @@ dhcp_client_find(struct dhcp_server *dhcpserver, struct dhcp_msg *msg,
     }
 
     opt = dhcp_server_option_find(opt_buf, len, DHCP_OPTION_REQUESTED_IP);
-    if (opt != NULL)
+    if ((opt != NULL) && (opt[1] >= 4))
     {
-        node = dhcp_client_find_by_ip(dhcpserver, (ip4_addr_t *)(&opt[2]));
+        SMEMCPY(&ipaddr, &opt[2], 4);
+        node = dhcp_client_find_by_ip(dhcpserver, &ipaddr);
         if (node != NULL)
         {
             return node;
@@ -223,54 +366,61 @@ dhcp_client_find(struct dhcp_server *dhcpserver, struct dhcp_msg *msg,
 * @param msg is the dhcp message
 * @param opt_buf is the optional buffer
 * @param len is the buffer length
-* @return dhcp client node
+* @return dhcp client node, NULL if the pool or the lease table is full
 */
 static struct dhcp_client_node *
 dhcp_client_alloc(struct dhcp_server *dhcpserver, struct dhcp_msg *msg,
                   u8_t *opt_buf, u16_t len)
 {
-    u8_t *opt;
-    u32_t ipaddr;
+    u32_t offset, i;
+    u16_t slot;
     struct dhcp_client_node *node;
 
-    node = dhcp_client_find_by_mac(dhcpserver, msg->chaddr, msg->hlen);
+    node = dhcp_client_find(dhcpserver, msg, opt_buf, len);
     if (node != NULL)
     {
         return node;
     }
 
-    opt = dhcp_server_option_find(opt_buf, len, DHCP_OPTION_REQUESTED_IP);
-    if (opt != NULL)
+    node = dhcpserver->node_free;
+    if (node == NULL)
     {
-        node = dhcp_client_find_by_ip(dhcpserver, (ip4_addr_t *)(&opt[2]));
-        if (node != NULL)
-        {
-            return node;
-        }
+        return NULL;
     }
 
-dhcp_alloc_again:
-    node = dhcp_client_find_by_ip(dhcpserver, &dhcpserver->current);
-    if (node != NULL)
+    /* the next free address from the current one */
+    offset = ntohl(dhcpserver->current.addr) - ntohl(dhcpserver->start.addr);
+    for (i = 0; i < dhcpserver->pool_size; i++, offset++)
     {
-        ipaddr = (ntohl(dhcpserver->current.addr) + 1);
-        if (ipaddr > ntohl(dhcpserver->end.addr))
+        if (offset >= dhcpserver->pool_size)
         {
-            ipaddr = ntohl(dhcpserver->start.addr);
+            offset = 0;
+        }
+        if (dhcpserver->ip_index[offset] == 0)
+        {
+            break;
         }
-        dhcpserver->current.addr = htonl(ipaddr);
-        goto dhcp_alloc_again;
     }
-    node = (struct dhcp_client_node *)mem_malloc(sizeof(struct dhcp_client_node));
-    if (node == NULL)
+    if (i == dhcpserver->pool_size)
     {
         return NULL;
     }
+    dhcpserver->node_free = node->next;
+
+    memset(node->chaddr, 0, DHCP_MAX_HLEN);
     SMEMCPY(node->chaddr, msg->chaddr, msg->hlen);
-    node->ipaddr = dhcpserver->current;
+    node->ipaddr.addr = htonl(ntohl(dhcpserver->start.addr) + offset);
+    node->next = NULL;
+
+    dhcpserver->ip_index[offset] = (u16_t)(node - dhcpserver->node_table) + 1;
+    slot = dhcp_client_mac_hash(node->chaddr) & dhcpserver->mac_mask;
+    while (dhcpserver->mac_index[slot] != 0)
+    {
+        slot = (slot + 1) & dhcpserver->mac_mask;
+    }
+    dhcpserver->mac_index[slot] = dhcpserver->ip_index[offset];
 
-    node->next = dhcpserver->node_list;
-    dhcpserver->node_list = node;
+    dhcpserver->current = node->ipaddr;
 
     return node;
 }
@@ -281,7 +431,7 @@ dhcp_alloc_again:
 * @param buf The buffer to find option
 * @param len The buffer length
 * @param option Which option to find
-* @return dhcp option buffer
+* @return dhcp option buffer, its data (buf[1] bytes) is inside the buffer
 */
 static u8_t *
 dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option)
@@ -289,6 +439,16 @@ dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option)
     u8_t *end = buf + len;
     while ((buf < end) && (*buf != DHCP_OPTION_END))
     {
+        if (*buf == DHCP_OPTION_PAD)
+        {
+            buf++;
+            continue;
+        }
+        /* a truncated option ends the search */
+        if ((buf + 2 > end) || (buf + 2 + buf[1] > end))
+        {
+            break;
+        }
         if (*buf == option)
         {
             return buf;
@@ -298,6 +458,124 @@ dhcp_server_option_find(u8_t *buf, u16_t len, u8_t option)
     return NULL;
 }
 
+/**
+* Build the options of the OFFER and ACK replies, they are the same for every client
+*
+* @param dhcpserver The dhcp server
+*/
+static void
+dhcp_server_reply_init(struct dhcp_server *dhcpserver)
+{
+    u8_t *opt_buf = dhcpserver->reply_opts;
+    u32_t tmp;
+
+    /* add server id, the NAK only has this one */
+    *opt_buf++ = DHCP_OPTION_SERVER_ID;
+    *opt_buf++ = 4;
+    SMEMCPY(opt_buf, &(dhcpserver->netif->ip_addr), 4);
+    opt_buf += 4;
+
+    /* add_lease_time */
+    *opt_buf++ = DHCP_OPTION_LEASE_TIME;
+    *opt_buf++ = 4;
+    tmp = PP_HTONL(DHCP_DEFAULT_LIVE_TIME);
+    SMEMCPY(opt_buf, &tmp, 4);
+    opt_buf += 4;
+
+    /* add config */
+    *opt_buf++ = DHCP_OPTION_SUBNET_MASK;
+    *opt_buf++ = 4;
+    SMEMCPY(opt_buf, &ip_2_ip4(&dhcpserver->netif->netmask)->addr, 4);
+    opt_buf += 4;
+
+    *opt_buf++ = DHCP_OPTION_DNS_SERVER;
+    *opt_buf++ = 4;
+#ifdef DHCP_DNS_SERVER_IP
+    {
+        ip_addr_t dns_addr;
+        ipaddr_aton(DHCP_DNS_SERVER_IP, &dns_addr);
+        SMEMCPY(opt_buf, &ip_2_ip4(&dns_addr)->addr, 4);
+    }
+#else
+    /* default use gatewary dns server */
+    SMEMCPY(opt_buf, &(dhcpserver->netif->ip_addr), 4);
+#endif /* DHCP_DNS_SERVER_IP */
+    opt_buf += 4;
+
+    *opt_buf++ = DHCP_OPTION_ROUTER;
+    *opt_buf++ = 4;
+    SMEMCPY(opt_buf, &ip_2_ip4(&dhcpserver->netif->ip_addr)->addr, 4);
+    opt_buf += 4;
+
+    /* add option end */
+    *opt_buf++ = DHCP_OPTION_END;
+
+    dhcpserver->reply_opts_len = opt_buf - dhcpserver->reply_opts;
+}
+
+/**
+* Turn a request into the reply and broadcast it
+*
+* @param dhcpserver The dhcp server
+* @param q The request
+* @param port The port of the client
+* @param msg_type DHCP_OFFER, DHCP_ACK or DHCP_NAK
+* @param node The dhcp client node, NULL for DHCP_NAK
+*/
+static void
+dhcp_server_reply(struct dhcp_server *dhcpserver, struct pbuf *q, u16_t port,
+                  u8_t msg_type, struct dhcp_client_node *node)
+{
+    struct dhcp_msg *msg = (struct dhcp_msg *)q->payload;
+    u8_t *opt_buf;
+    ip_addr_t addr;
+    u16_t length;
+
+    msg->op = DHCP_BOOTREPLY;
+    msg->hops = 0;
+    msg->secs = 0;
+    SMEMCPY(&msg->siaddr, &(dhcpserver->netif->ip_addr), 4);
+    msg->sname[0] = '\0';
+    msg->file[0] = '\0';
+    msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
+    if (node != NULL)
+    {
+        SMEMCPY(&msg->yiaddr, &node->ipaddr, 4);
+    }
+    else
+    {
+        memset(&msg->yiaddr, 0, 4);
+    }
+
+    opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
+    /* add msg type */
+    *opt_buf++ = DHCP_OPTION_MESSAGE_TYPE;
+    *opt_buf++ = 1;
+    *opt_buf++ = msg_type;
+
+    if (msg_type == DHCP_NAK)
+    {
+        /* server id and option end */
+        SMEMCPY(opt_buf, dhcpserver->reply_opts, 6);
+        opt_buf += 6;
+        *opt_buf++ = DHCP_OPTION_END;
+    }
+    else
+    {
+        SMEMCPY(opt_buf, dhcpserver->reply_opts, dhcpserver->reply_opts_len);
+        opt_buf += dhcpserver->reply_opts_len;
+    }
+
+    length = (u16_t)(opt_buf - (u8_t *)msg);
+    if (length < q->tot_len)
+    {
+        pbuf_realloc(q, length);
+    }
+
+    ip_addr_set_ip4_u32(&addr, INADDR_BROADCAST);
+    udp_sendto_if(dhcpserver->pcb, q, &addr, port, dhcpserver->netif);
+}
+
 /**
 * If an incoming DHCP message is in response to us, then trigger the state machine
 */
@@ -311,40 +589,41 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
     u8_t *opt;
     struct dhcp_client_node *node;
     u8_t msg_type;
-    u16_t length;
-    ip_addr_t addr = *recv_addr;
-    u32_t tmp;
+    u16_t length, reply_len;
 
     LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("[%s:%d] %c%c recv %d\n", __FUNCTION__, __LINE__, dhcp_server->netif->name[0], dhcp_server->netif->name[1], p->tot_len));
     /* prevent warnings about unused arguments */
     LWIP_UNUSED_ARG(pcb);
-    LWIP_UNUSED_ARG(addr);
-    LWIP_UNUSED_ARG(port);
+    LWIP_UNUSED_ARG(recv_addr);
 
-    if (p->len < DHCP_MIN_REQUEST_LEN)
+    if (p->tot_len < DHCP_MIN_REQUEST_LEN)
     {
         LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_WARNING, ("DHCP request message or pbuf too short\n"));
         pbuf_free(p);
         return;
     }
 
-    q = pbuf_alloc(PBUF_TRANSPORT, 1500, PBUF_RAM);
-    if (q == NULL)
+    length = p->tot_len - DHCP_OPTIONS_OFS;
+    reply_len = DHCP_OPTIONS_OFS + 3 + dhcp_server->reply_opts_len;
+    if (p->next == NULL && p->len >= reply_len)
     {
-        LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_WARNING, ("pbuf_alloc dhcp_msg failed!\n"));
-        pbuf_free(p);
-        return;
+        /* the reply is written over the request */
+        q = p;
     }
-    if (q->tot_len < p->tot_len)
+    else
     {
-        LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_WARNING, ("pbuf_alloc dhcp_msg too small %d:%d\n", q->tot_len, p->tot_len));
+        q = pbuf_alloc(PBUF_TRANSPORT, LWIP_MAX(p->tot_len, reply_len), PBUF_RAM);
+        if (q == NULL)
+        {
+            LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_WARNING, ("pbuf_alloc dhcp_msg failed!\n"));
+            pbuf_free(p);
+            return;
+        }
+
+        pbuf_copy(q, p);
         pbuf_free(p);
-        return;
     }
 
-    pbuf_copy(q, p);
-    pbuf_free(p);
-
     msg = (struct dhcp_msg *)q->payload;
     if (msg->op != DHCP_BOOTREQUEST)
     {
@@ -364,9 +643,8 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
     }
 
     opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
-    length = q->tot_len - DHCP_OPTIONS_OFS;
     opt = dhcp_server_option_find(opt_buf, length, DHCP_OPTION_MESSAGE_TYPE);
-    if (opt)
+    if (opt && (opt[1] >= 1))
     {
         msg_type = *(opt + 2);
         if (msg_type == DHCP_DISCOVER)
@@ -378,222 +656,39 @@ dhcp_server_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t
             }
             node->lease_end = DHCP_DEFAULT_LIVE_TIME;
             /* create dhcp offer and send */
-            msg->op = DHCP_BOOTREPLY;
-            msg->hops = 0;
-            msg->secs = 0;
-            SMEMCPY(&msg->siaddr, &(dhcp_server->netif->ip_addr), 4);
-            msg->sname[0] = '\0';
-            msg->file[0] = '\0';
-            msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
-            SMEMCPY(&msg->yiaddr, &node->ipaddr, 4);
-
-            opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
-            /* add msg type */
-            *opt_buf++ = DHCP_OPTION_MESSAGE_TYPE;
-            *opt_buf++ = 1;
-            *opt_buf++ = DHCP_OFFER;
-
-            /* add server id */
-            *opt_buf++ = DHCP_OPTION_SERVER_ID;
-            *opt_buf++ = 4;
-            SMEMCPY(opt_buf, &(dhcp_server->netif->ip_addr), 4);
-            opt_buf += 4;
-
-            /* add_lease_time */
-            *opt_buf++ = DHCP_OPTION_LEASE_TIME;
-            *opt_buf++ = 4;
-            tmp = PP_HTONL(DHCP_DEFAULT_LIVE_TIME);
-            SMEMCPY(opt_buf, &tmp, 4);
-            opt_buf += 4;
-
-            /* add config */
-            *opt_buf++ = DHCP_OPTION_SUBNET_MASK;
-            *opt_buf++ = 4;
-            SMEMCPY(opt_buf, &ip_2_ip4(&dhcp_server->netif->netmask)->addr, 4);
-            opt_buf += 4;
-
-            *opt_buf++ = DHCP_OPTION_DNS_SERVER;
-            *opt_buf++ = 4;
-#ifdef DHCP_DNS_SERVER_IP
+            dhcp_server_reply(dhcp_server, q, port, DHCP_OFFER, node);
+        }
+        else if (msg_type == DHCP_REQUEST)
+        {
+            node = dhcp_client_find(dhcp_server, msg, opt_buf, length);
+            if (node != NULL)
             {
-                ip_addr_t dns_addr;
-                ipaddr_aton(DHCP_DNS_SERVER_IP, &dns_addr);
-                SMEMCPY(opt_buf, &ip_2_ip4(&dns_addr)->addr, 4);
+                /* Send ack */
+                node->lease_end = DHCP_DEFAULT_LIVE_TIME;
+                dhcp_server_reply(dhcp_server, q, port, DHCP_ACK, node);
             }
-#else
-            /* default use gatewary dns server */
-            SMEMCPY(opt_buf, &(dhcp_server->netif->ip_addr), 4);
-#endif /* DHCP_DNS_SERVER_IP */
-            opt_buf += 4;
-
-            *opt_buf++ = DHCP_OPTION_ROUTER;
-            *opt_buf++ = 4;
-            SMEMCPY(opt_buf, &ip_2_ip4(&dhcp_server->netif->ip_addr)->addr, 4);
-            opt_buf += 4;
-
-            /* add option end */
-            *opt_buf++ = DHCP_OPTION_END;
-
-            length = (u32_t)opt_buf - (u32_t)msg;
-            if (length < q->tot_len)
+            else
             {
-                pbuf_realloc(q, length);
+                /* Send no ack */
+                dhcp_server_reply(dhcp_server, q, port, DHCP_NAK, NULL);
             }
-
-            ip_2_ip4(&addr)->addr = INADDR_BROADCAST;
-            udp_sendto_if(pcb, q, &addr, port, dhcp_server->netif);
         }
-        else
+        else if (msg_type == DHCP_RELEASE)
         {
-            if (1)
+            node = dhcp_client_find_by_mac(dhcp_server, msg->chaddr, msg->hlen);
+            if (node != NULL)
             {
-                if (msg_type == DHCP_REQUEST)
-                {
-                    node = dhcp_client_find(dhcp_server, msg, opt_buf, length);
-                    if (node != NULL)
-                    {
-                        /* Send ack */
-                        node->lease_end = DHCP_DEFAULT_LIVE_TIME;
-                        /* create dhcp offer and send */
-                        msg->op = DHCP_BOOTREPLY;
-                        msg->hops = 0;
-                        msg->secs = 0;
-                        SMEMCPY(&msg->siaddr, &(dhcp_server->netif->ip_addr), 4);
-                        msg->sname[0] = '\0';
-                        msg->file[0] = '\0';
-                        msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
-                        SMEMCPY(&msg->yiaddr, &node->ipaddr, 4);
-                        opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
-
-                        /* add msg type */
-                        *opt_buf++ = DHCP_OPTION_MESSAGE_TYPE;
-                        *opt_buf++ = 1;
-                        *opt_buf++ = DHCP_ACK;
-
-                        /* add server id */
-                        *opt_buf++ = DHCP_OPTION_SERVER_ID;
-                        *opt_buf++ = 4;
-                        SMEMCPY(opt_buf, &(dhcp_server->netif->ip_addr), 4);
-                        opt_buf += 4;
-
-                        /* add_lease_time */
-                        *opt_buf++ = DHCP_OPTION_LEASE_TIME;
-                        *opt_buf++ = 4;
-                        tmp = PP_HTONL(DHCP_DEFAULT_LIVE_TIME);
-                        SMEMCPY(opt_buf, &tmp, 4);
-                        opt_buf += 4;
-
-                        /* add config */
-                        *opt_buf++ = DHCP_OPTION_SUBNET_MASK;
-                        *opt_buf++ = 4;
-                        SMEMCPY(opt_buf, &ip_2_ip4(&dhcp_server->netif->netmask)->addr, 4);
-                        opt_buf += 4;
-
-                        *opt_buf++ = DHCP_OPTION_DNS_SERVER;
-                        *opt_buf++ = 4;
-#ifdef DHCP_DNS_SERVER_IP
-                        {
-                            ip_addr_t dns_addr;
-                            ipaddr_aton(DHCP_DNS_SERVER_IP, &dns_addr);
-                            SMEMCPY(opt_buf, &ip_2_ip4(&dns_addr)->addr, 4);
-                        }
-#else
-                        /* default use gatewary dns server */
-                        SMEMCPY(opt_buf, &(dhcp_server->netif->ip_addr), 4);
-#endif /* DHCP_DNS_SERVER_IP */
-                        opt_buf += 4;
-
-                        *opt_buf++ = DHCP_OPTION_ROUTER;
-                        *opt_buf++ = 4;
-                        SMEMCPY(opt_buf, &ip_2_ip4(&dhcp_server->netif->ip_addr)->addr, 4);
-                        opt_buf += 4;
-
-                        /* add option end */
-                        *opt_buf++ = DHCP_OPTION_END;
-
-                        length = (u32_t)opt_buf - (u32_t)msg;
-                        if (length < q->tot_len)
-                        {
-                            pbuf_realloc(q, length);
-                        }
-
-                        ip_2_ip4(&addr)->addr = INADDR_BROADCAST;
-                        udp_sendto_if(pcb, q, &addr, port, dhcp_server->netif);
-                    }
-                    else
-                    {
-                        /* Send no ack */
-                        /* create dhcp offer and send */
-                        msg->op = DHCP_BOOTREPLY;
-                        msg->hops = 0;
-                        msg->secs = 0;
-                        SMEMCPY(&msg->siaddr, &(dhcp_server->netif->ip_addr), 4);
-                        msg->sname[0] = '\0';
-                        msg->file[0] = '\0';
-                        msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
-                        memset(&msg->yiaddr, 0, 4);
-                        opt_buf = (u8_t *)msg + DHCP_OPTIONS_OFS;
-
-                        /* add msg type */
-                        *opt_buf++ = DHCP_OPTION_MESSAGE_TYPE;
-                        *opt_buf++ = 1;
-                        *opt_buf++ = DHCP_NAK;
-
-                        /* add server id */
-                        *opt_buf++ = DHCP_OPTION_SERVER_ID;
-                        *opt_buf++ = 4;
-                        SMEMCPY(opt_buf, &(dhcp_server->netif->ip_addr), 4);
-                        opt_buf += 4;
-
-                        /* add option end */
-                        *opt_buf++ = DHCP_OPTION_END;
-                        length = (u32_t)opt_buf - (u32_t)msg;
-                        if (length < q->tot_len)
-                        {
-                            pbuf_realloc(q, length);
-                        }
-
-                        ip_2_ip4(&addr)->addr = INADDR_BROADCAST;
-                        udp_sendto_if(pcb, q, &addr, port, dhcp_server->netif);
-                    }
-                }
-                else if (msg_type == DHCP_RELEASE)
-                {
-                    struct dhcp_client_node *node_prev = NULL;
-
-                    for (node = dhcp_server->node_list; node != NULL; node = node->next)
-                    {
-                        if (memcmp(node->chaddr, msg->chaddr, msg->hlen) == 0)
-                        {
-                            if (node == dhcp_server->node_list)
-                            {
-                                dhcp_server->node_list = node->next;
-                            }
-                            else
-                            {
-                                node_prev->next = node->next;
-                            }
-                            break;
-                        }
-                        node_prev = node;
-                        node = node->next;
-                    }
-
-                    if (node != NULL)
-                    {
-                        mem_free(node);
-                    }
-                }
-                else if (msg_type ==  DHCP_DECLINE)
-                {
-                    ;
-                }
-                else if (msg_type == DHCP_INFORM)
-                {
-                    ;
-                }
+                dhcp_client_free(dhcp_server, node);
             }
         }
+        else if (msg_type ==  DHCP_DECLINE)
+        {
+            ;
+        }
+        else if (msg_type == DHCP_INFORM)
+        {
+            ;
+        }
     }
 
 free_pbuf_and_return:
@@ -609,6 +704,7 @@ free_pbuf_and_return:
 * @return lwIP error code
 * - ERR_OK - No error
 * - ERR_MEM - Out of memory
+* - ERR_ARG - Bad address range
 */
 err_t
 dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end)
@@ -620,10 +716,17 @@ dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end)
     {
         if (dhcp_server->netif == netif)
         {
+            dhcp_server_reply_init(dhcp_server);
+            if (dhcp_server->node_table != NULL &&
+                ip4_addr_cmp(&dhcp_server->start, start) && ip4_addr_cmp(&dhcp_server->end, end))
+            {
+                /* same pool, keep the leases */
+                return ERR_OK;
+            }
             dhcp_server->start = *start;
             dhcp_server->end = *end;
             dhcp_server->current = *start;
-            return ERR_OK;
+            return dhcp_lease_table_init(dhcp_server);
         }
     }
 
@@ -643,10 +746,15 @@ dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end)
     dhcp_server->next = lw_dhcp_server;
     lw_dhcp_server = dhcp_server;
     dhcp_server->netif = netif;
-    dhcp_server->node_list = NULL;
     dhcp_server->start = *start;
     dhcp_server->end = *end;
     dhcp_server->current = *start;
+    dhcp_server_reply_init(dhcp_server);
+    if (dhcp_lease_table_init(dhcp_server) != ERR_OK)
+    {
+        LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_server_start(): could not allocate the lease table\n"));
+        return ERR_MEM;
+    }
 
     /* allocate UDP PCB */
     dhcp_server->pcb = udp_new();
@@ -754,7 +862,6 @@ void dhcpd_stop(const char *netif_name)
 {
     struct dhcp_server *dhcp_server, *server_node;
     struct netif *netif = netif_list;
-    struct dhcp_client_node *node, *next;
 
     DEBUG_PRINTF("%s: %s\r\n", __FUNCTION__, netif_name);
 
@@ -818,10 +925,9 @@ void dhcpd_stop(const char *netif_name)
     udp_remove(dhcp_server->pcb);
 
     /* remove all client node */
-    for (node = dhcp_server->node_list; node != NULL; node = next)
+    if (dhcp_server->node_table != NULL)
     {
-        next = node->next;
-        mem_free(node);
+        mem_free(dhcp_server->node_table);
     }
 
     mem_free(dhcp_server);
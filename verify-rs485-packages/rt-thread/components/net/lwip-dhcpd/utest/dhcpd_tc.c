@@ -0,0 +1,347 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "lwip/ip.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "lwip/prot/dhcp.h"
+#include "utest.h"
+
+/*
+ * The lease table of the DHCP server on a netif that only catches what
+ * the server sends. The requests are handed to the receive callback of
+ * the server pcb. The lease testcase fills a pool of DHCPD_TC_POOL
+ * addresses with one client per address, checks that every client keeps
+ * its address, that a full pool is not answered and that the clients are
+ * still found after every other one released its lease. Every run of the
+ * lookup testcase renews DHCPD_TC_LOOKUPS pseudo random leases of a full
+ * pool. The server binds port 67, so run them without dhcpd and time them
+ * with:
+ *
+ *     utest_bench -n 20 testcases.net.dhcpd.*
+ */
+
+#define DHCPD_TC_POOL           128
+#define DHCPD_TC_LOOKUPS        1024
+#define DHCPD_TC_SERVER_PORT    67
+#define DHCPD_TC_CLIENT_PORT    68
+#define DHCPD_TC_START          PP_HTONL(0xC0A8A902UL)
+#define DHCPD_TC_END            PP_HTONL(0xC0A8A902UL + DHCPD_TC_POOL - 1)
+#define DHCPD_TC_CLIENT(i)      PP_HTONL(0xC0A8A902UL + (i))
+/* the options of a request, the reply is written over it */
+#define DHCPD_TC_OPTS_LEN       64
+
+/* the leases the server has room for */
+#if DHCPD_LEASE_MAX < DHCPD_TC_POOL
+#define DHCPD_TC_LEASES         DHCPD_LEASE_MAX
+#else
+#define DHCPD_TC_LEASES         DHCPD_TC_POOL
+#endif
+
+extern err_t dhcp_server_start(struct netif *netif, ip4_addr_t *start, ip4_addr_t *end);
+
+static struct netif tc_if;
+static struct udp_pcb *server_pcb;
+static u8_t reply[DHCP_OPTIONS_OFS + DHCPD_TC_OPTS_LEN];
+static u16_t reply_len;
+/* the address of every client, 0 if it has none */
+static u32_t leases[DHCPD_TC_LEASES + 1];
+static rt_uint32_t seed;
+
+/* the output of the netif, keep the DHCP message of the reply */
+static err_t dhcpd_tc_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    reply_len = pbuf_copy_partial(p, reply, sizeof(reply), IP_HLEN + UDP_HLEN);
+
+    return ERR_OK;
+}
+
+/*
+ * send a request of client i, returns the message type of the reply or 0
+ * if there is none, *yiaddr is the address in the reply
+ */
+static u8_t dhcpd_tc_request(int i, u8_t msg_type, u32_t ciaddr, u32_t *yiaddr)
+{
+    struct pbuf *p;
+    struct dhcp_msg *msg;
+    u8_t *opt;
+    ip_addr_t addr;
+
+    p = pbuf_alloc(PBUF_TRANSPORT, DHCP_OPTIONS_OFS + DHCPD_TC_OPTS_LEN, PBUF_RAM);
+    if (p == RT_NULL)
+    {
+        return 0;
+    }
+    msg = (struct dhcp_msg *)p->payload;
+    rt_memset(msg, 0, p->len);
+    msg->op = DHCP_BOOTREQUEST;
+    msg->htype = 1;
+    msg->hlen = 6;
+    msg->xid = htonl(0x7C000000UL + i);
+    msg->chaddr[0] = 0x02;
+    msg->chaddr[4] = (u8_t)(i >> 8);
+    msg->chaddr[5] = (u8_t)i;
+    msg->cookie = PP_HTONL(DHCP_MAGIC_COOKIE);
+
+    opt = (u8_t *)msg + DHCP_OPTIONS_OFS;
+    *opt++ = DHCP_OPTION_MESSAGE_TYPE;
+    *opt++ = 1;
+    *opt++ = msg_type;
+    if (ciaddr != 0)
+    {
+        *opt++ = DHCP_OPTION_REQUESTED_IP;
+        *opt++ = 4;
+        SMEMCPY(opt, &ciaddr, 4);
+        opt += 4;
+    }
+    *opt++ = DHCP_OPTION_END;
+
+    reply_len = 0;
+    ip_addr_set_any(0, &addr);
+    /* the callback frees the request */
+    server_pcb->recv(server_pcb->recv_arg, server_pcb, p, &addr, DHCPD_TC_CLIENT_PORT);
+
+    msg = (struct dhcp_msg *)reply;
+    if (reply_len < DHCP_OPTIONS_OFS + 3 || msg->op != DHCP_BOOTREPLY ||
+        msg->xid != htonl(0x7C000000UL + i) || msg->chaddr[5] != (u8_t)i ||
+        reply[DHCP_OPTIONS_OFS] != DHCP_OPTION_MESSAGE_TYPE)
+    {
+        return 0;
+    }
+    SMEMCPY(yiaddr, &msg->yiaddr, 4);
+
+    return reply[DHCP_OPTIONS_OFS + 2];
+}
+
+/* DISCOVER and REQUEST of client i, returns its address or 0 */
+static u32_t dhcpd_tc_lease(int i)
+{
+    u32_t offered, acked;
+
+    if (dhcpd_tc_request(i, DHCP_DISCOVER, 0, &offered) != DHCP_OFFER ||
+        dhcpd_tc_request(i, DHCP_REQUEST, offered, &acked) != DHCP_ACK ||
+        acked != offered)
+    {
+        return 0;
+    }
+
+    return acked;
+}
+
+/* check that the leases are distinct addresses of the pool */
+static int dhcpd_tc_distinct(void)
+{
+    rt_uint8_t used[DHCPD_TC_POOL];
+    u32_t offset;
+    int i, bad = 0;
+
+    rt_memset(used, 0, sizeof(used));
+    for (i = 0; i < DHCPD_TC_LEASES + 1; i++)
+    {
+        if (leases[i] == 0)
+        {
+            continue;
+        }
+        offset = ntohl(leases[i]) - ntohl(DHCPD_TC_START);
+        if (offset >= DHCPD_TC_POOL || used[offset])
+        {
+            bad ++;
+            continue;
+        }
+        used[offset] = 1;
+    }
+
+    return bad;
+}
+
+static rt_err_t dhcpd_tc_init(void)
+{
+    ip4_addr_t start, end;
+    struct udp_pcb *pcb;
+    err_t err;
+
+    IP_ADDR4(&tc_if.ip_addr, 192, 168, 169, 1);
+    IP_ADDR4(&tc_if.netmask, 255, 255, 255, 0);
+    tc_if.name[0] = 't';
+    tc_if.name[1] = 'c';
+    tc_if.output = dhcpd_tc_output;
+    ip4_addr_set_u32(&start, DHCPD_TC_START);
+    ip4_addr_set_u32(&end, DHCPD_TC_END);
+    rt_memset(leases, 0, sizeof(leases));
+    seed = 1;
+
+    LOCK_TCPIP_CORE();
+    /* the server of the netif stays, a different pool drops its leases */
+    err = dhcp_server_start(&tc_if, &start, &start);
+    if (err == ERR_OK)
+    {
+        err = dhcp_server_start(&tc_if, &start, &end);
+    }
+    server_pcb = RT_NULL;
+    for (pcb = udp_pcbs; pcb != RT_NULL; pcb = pcb->next)
+    {
+        if (pcb->local_port == DHCPD_TC_SERVER_PORT && pcb->recv != RT_NULL)
+        {
+            server_pcb = pcb;
+            break;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    if (err != ERR_OK || server_pcb == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t dhcpd_tc_full_init(void)
+{
+    int i, bad = 0;
+
+    if (dhcpd_tc_init() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    LOCK_TCPIP_CORE();
+    for (i = 0; i < DHCPD_TC_LEASES; i++)
+    {
+        leases[i] = dhcpd_tc_lease(i);
+        if (leases[i] == 0)
+        {
+            bad ++;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    return bad == 0 ? RT_EOK : -RT_ERROR;
+}
+
+static void dhcpd_leases(void)
+{
+    u32_t addr;
+    int i, bad = 0;
+
+    LOCK_TCPIP_CORE();
+    for (i = 0; i < DHCPD_TC_LEASES; i++)
+    {
+        leases[i] = dhcpd_tc_lease(i);
+        if (leases[i] == 0)
+        {
+            bad ++;
+        }
+    }
+    uassert_int_equal(bad, 0);
+    uassert_int_equal(dhcpd_tc_distinct(), 0);
+
+    /* a client asking again keeps its address */
+    for (i = 0; i < DHCPD_TC_LEASES; i++)
+    {
+        if (dhcpd_tc_request(i, DHCP_DISCOVER, 0, &addr) != DHCP_OFFER || addr != leases[i])
+        {
+            bad ++;
+        }
+    }
+    uassert_int_equal(bad, 0);
+
+    /* no room for one more, and an address out of the pool is refused */
+    uassert_int_equal(dhcpd_tc_request(DHCPD_TC_LEASES, DHCP_DISCOVER, 0, &addr), 0);
+    uassert_int_equal(dhcpd_tc_request(DHCPD_TC_LEASES, DHCP_REQUEST, DHCPD_TC_CLIENT(DHCPD_TC_POOL), &addr), DHCP_NAK);
+    UNLOCK_TCPIP_CORE();
+}
+
+static void dhcpd_release(void)
+{
+    u32_t addr;
+    int i, bad = 0;
+
+    LOCK_TCPIP_CORE();
+    /* every other client leaves, the holes are in the middle of the probes */
+    for (i = 0; i < DHCPD_TC_LEASES; i += 2)
+    {
+        dhcpd_tc_request(i, DHCP_RELEASE, 0, &addr);
+    }
+
+    for (i = 0; i < DHCPD_TC_LEASES; i++)
+    {
+        if (i % 2 == 1)
+        {
+            if (dhcpd_tc_request(i, DHCP_REQUEST, 0, &addr) != DHCP_ACK || addr != leases[i])
+            {
+                bad ++;
+            }
+        }
+        else
+        {
+            if (dhcpd_tc_request(i, DHCP_REQUEST, leases[i], &addr) != DHCP_NAK)
+            {
+                bad ++;
+            }
+            leases[i] = 0;
+        }
+    }
+    uassert_int_equal(bad, 0);
+
+    /* the released addresses are given out to new clients */
+    leases[DHCPD_TC_LEASES] = dhcpd_tc_lease(DHCPD_TC_LEASES);
+    uassert_true(leases[DHCPD_TC_LEASES] != 0);
+    for (i = 2; i < DHCPD_TC_LEASES; i += 2)
+    {
+        leases[i] = dhcpd_tc_lease(i);
+        if (leases[i] == 0)
+        {
+            bad ++;
+        }
+    }
+    uassert_int_equal(bad, 0);
+    uassert_int_equal(dhcpd_tc_distinct(), 0);
+    UNLOCK_TCPIP_CORE();
+}
+
+static void dhcpd_lookup(void)
+{
+    u32_t addr;
+    int i, n, bad = 0;
+
+    LOCK_TCPIP_CORE();
+    for (i = 0; i < DHCPD_TC_LOOKUPS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        n = (seed >> 8) % DHCPD_TC_LEASES;
+        if (dhcpd_tc_request(n, DHCP_REQUEST, leases[n], &addr) != DHCP_ACK || addr != leases[n])
+        {
+            bad ++;
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase_lease(void)
+{
+    UTEST_UNIT_RUN(dhcpd_leases);
+    UTEST_UNIT_RUN(dhcpd_release);
+}
+UTEST_TC_EXPORT(testcase_lease, "testcases.net.dhcpd.lease", dhcpd_tc_init, RT_NULL, 10);
+
+static void testcase_lookup(void)
+{
+    UTEST_UNIT_RUN(dhcpd_lookup);
+}
+UTEST_TC_EXPORT(testcase_lookup, "testcases.net.dhcpd.lookup", dhcpd_tc_full_init, RT_NULL, 10);
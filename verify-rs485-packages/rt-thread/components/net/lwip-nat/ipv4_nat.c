@@ -31,12 +31,11 @@
  * Date           Author       Notes
  * 2015-01-26     Hichard      porting to RT-Thread
  * 2015-01-27     Bernard      code cleanup for lwIP in RT-Thread
+ * 2026-10-17     RT-Thread    hash the TCP/UDP state tables, expire them on a timing wheel
  */
 
 /*
  * TODOS:
- *  - we should decide if we want to use static tables for NAT or a linked
- *    list.
  *  - we should allocate icmp ping id if multiple clients are sending
  *    ping requests.
  *  - maybe we could hash the identifiers for TCP, ICMP and UDP and use
@@ -96,13 +95,40 @@
 #define LWIP_NAT_DEFAULT_TTL_SECONDS             (128)
 #define LWIP_NAT_FORWARD_HEADER_SIZE_MIN         (sizeof(struct eth_hdr))
 
+/** Number of state entries per protocol, can be set in rtconfig.h */
+#ifndef LWIP_NAT_DEFAULT_STATE_TABLES_ICMP
 #define LWIP_NAT_DEFAULT_STATE_TABLES_ICMP       (4)
+#endif
+#ifndef LWIP_NAT_DEFAULT_STATE_TABLES_TCP
 #define LWIP_NAT_DEFAULT_STATE_TABLES_TCP        (32)
+#endif
+#ifndef LWIP_NAT_DEFAULT_STATE_TABLES_UDP
 #define LWIP_NAT_DEFAULT_STATE_TABLES_UDP        (32)
+#endif
+
+/** Number of outgoing hash buckets per protocol */
+#ifndef LWIP_NAT_HASH_BUCKETS_TCP
+#define LWIP_NAT_HASH_BUCKETS_TCP                LWIP_NAT_DEFAULT_STATE_TABLES_TCP
+#endif
+#ifndef LWIP_NAT_HASH_BUCKETS_UDP
+#define LWIP_NAT_HASH_BUCKETS_UDP                LWIP_NAT_DEFAULT_STATE_TABLES_UDP
+#endif
 
 #define LWIP_NAT_DEFAULT_TCP_SOURCE_PORT         (40000)
 #define LWIP_NAT_DEFAULT_UDP_SOURCE_PORT         (40000)
 
+/* entry i is translated to port SOURCE_PORT + i, so incoming packets index the table directly */
+#if (LWIP_NAT_DEFAULT_TCP_SOURCE_PORT + LWIP_NAT_DEFAULT_STATE_TABLES_TCP > 0xFFFF) || \
+    (LWIP_NAT_DEFAULT_UDP_SOURCE_PORT + LWIP_NAT_DEFAULT_STATE_TABLES_UDP > 0xFFFF)
+#error "NAT state tables do not fit in the translated port range"
+#endif
+
+/** TCP/UDP entries expire on a wheel turned by ip_nat_tmr(), one slot per call */
+#define LWIP_NAT_TTL_TICKS       ((LWIP_NAT_DEFAULT_TTL_SECONDS + LWIP_NAT_TMR_INTERVAL_SEC - 1) / LWIP_NAT_TMR_INTERVAL_SEC)
+#define LWIP_NAT_WHEEL_SLOTS     (LWIP_NAT_TTL_TICKS + 1)
+
+#define IPNAT_NONE               (0xFFFF)
+
 #define IPNAT_ENTRY_RESET(x) do { \
   (x)->ttl = 0; \
 } while(0)
@@ -128,21 +154,33 @@ typedef struct ip_nat_entries_icmp
   u16_t                 seqno;
 } ip_nat_entries_icmp_t;
 
-typedef struct ip_nat_entries_tcp
+typedef struct ip_nat_entries_port
 {
   ip_nat_entry_common_t common;
   u16_t                 nport;
   u16_t                 sport;
   u16_t                 dport;
-} ip_nat_entries_tcp_t;
-
-typedef struct ip_nat_entries_udp
+  u16_t                 hnext;  /* next entry in the outgoing hash bucket or in the free list */
+  u16_t                 wnext;  /* timing wheel slot links */
+  u16_t                 wprev;
+  u16_t                 wslot;  /* wheel slot the entry is queued at, IPNAT_NONE if none */
+  u32_t                 expire; /* wheel tick at which the entry times out */
+} ip_nat_entries_port_t;
+
+typedef ip_nat_entries_port_t ip_nat_entries_tcp_t;
+typedef ip_nat_entries_port_t ip_nat_entries_udp_t;
+
+/** State table shared by TCP and UDP */
+typedef struct ip_nat_port_table
 {
-  ip_nat_entry_common_t common;
-  u16_t                 nport;
-  u16_t                 sport;
-  u16_t                 dport;
-} ip_nat_entries_udp_t;
+  ip_nat_entries_port_t *entries;
+  u16_t                 *bucket;
+  u16_t                  size;
+  u16_t                  nbucket;
+  u16_t                  base_port;
+  u16_t                  free;
+  u16_t                  wheel[LWIP_NAT_WHEEL_SLOTS];
+} ip_nat_port_table_t;
 
 typedef union u_nat_entry
 {
@@ -156,6 +194,11 @@ static ip_nat_conf_t *ip_nat_cfg = NULL;
 static ip_nat_entries_icmp_t ip_nat_icmp_table[LWIP_NAT_DEFAULT_STATE_TABLES_ICMP];
 static ip_nat_entries_tcp_t ip_nat_tcp_table[LWIP_NAT_DEFAULT_STATE_TABLES_TCP];
 static ip_nat_entries_udp_t ip_nat_udp_table[LWIP_NAT_DEFAULT_STATE_TABLES_UDP];
+static u16_t ip_nat_tcp_hash[LWIP_NAT_HASH_BUCKETS_TCP];
+static u16_t ip_nat_udp_hash[LWIP_NAT_HASH_BUCKETS_UDP];
+static ip_nat_port_table_t ip_nat_tcp_state;
+static ip_nat_port_table_t ip_nat_udp_state;
+static u32_t ip_nat_now;
 
 /* ----------------------- Static functions (COMMON) --------------------*/
 static void     ip_nat_chksum_adjust(u8_t *chksum, const u8_t *optr, s16_t olen, const u8_t *nptr, s16_t nlen);
@@ -183,6 +226,17 @@ static void     ip_nat_dbg_dump_remove(ip_nat_conf_t *cur);
 #define ip_nat_dbg_dump_remove(cur)
 #endif /* defined(LWIP_DEBUG) && (LWIP_NAT_DEBUG & LWIP_DBG_ON) */
 
+/* ----------------------- Static functions (TCP/UDP) -------------------*/
+static void     ip_nat_port_init(ip_nat_port_table_t *t, ip_nat_entries_port_t *entries, u16_t size,
+                                 u16_t *bucket, u16_t nbucket, u16_t base_port);
+static ip_nat_entries_port_t *ip_nat_port_lookup_incoming(ip_nat_port_table_t *t, const struct ip_hdr *iphdr,
+                                                           u16_t src, u16_t dest);
+static ip_nat_entries_port_t *ip_nat_port_lookup_outgoing(ip_nat_port_table_t *t, ip_nat_conf_t *nat_config,
+                                                           const struct ip_hdr *iphdr, u16_t src, u16_t dest,
+                                                           u8_t allocate);
+static void     ip_nat_port_free(ip_nat_port_table_t *t, ip_nat_entries_port_t *e);
+static void     ip_nat_port_tmr(ip_nat_port_table_t *t);
+
 /* ----------------------- Static functions (TCP) -----------------------*/
 static ip_nat_entries_tcp_t *ip_nat_tcp_lookup_incoming(const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr);
 static ip_nat_entries_tcp_t *ip_nat_tcp_lookup_outgoing(ip_nat_conf_t *nat_config,
@@ -222,12 +276,10 @@ ip_nat_init(void)
   for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
     IPNAT_ENTRY_RESET(&ip_nat_icmp_table[i].common);
   }
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    IPNAT_ENTRY_RESET(&ip_nat_tcp_table[i].common);
-  }
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    IPNAT_ENTRY_RESET(&ip_nat_udp_table[i].common);
-  }
+  ip_nat_port_init(&ip_nat_tcp_state, ip_nat_tcp_table, LWIP_NAT_DEFAULT_STATE_TABLES_TCP,
+                   ip_nat_tcp_hash, LWIP_NAT_HASH_BUCKETS_TCP, LWIP_NAT_DEFAULT_TCP_SOURCE_PORT);
+  ip_nat_port_init(&ip_nat_udp_state, ip_nat_udp_table, LWIP_NAT_DEFAULT_STATE_TABLES_UDP,
+                   ip_nat_udp_hash, LWIP_NAT_HASH_BUCKETS_UDP, LWIP_NAT_DEFAULT_UDP_SOURCE_PORT);
 
   /* we must lock scheduler to protect following code */
   rt_enter_critical();
@@ -340,21 +392,20 @@ ip_nat_reset_state(ip_nat_conf_t *cfg)
 {
   int i;
 
-  /* @todo: optimize this!!!
-     why do we search for it anyway, if we have the pointer??? */
+  /* only called when a NAT config is removed, a full scan is fine here */
   for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
     if(ip_nat_icmp_table[i].common.cfg == cfg) {
       IPNAT_ENTRY_RESET(&ip_nat_icmp_table[i].common);
     }
   }
   for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    if(ip_nat_tcp_table[i].common.cfg == cfg) {
-      IPNAT_ENTRY_RESET(&ip_nat_tcp_table[i].common);
+    if(ip_nat_tcp_table[i].common.ttl && ip_nat_tcp_table[i].common.cfg == cfg) {
+      ip_nat_port_free(&ip_nat_tcp_state, &ip_nat_tcp_table[i]);
     }
   }
   for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    if(ip_nat_udp_table[i].common.cfg == cfg) {
-      IPNAT_ENTRY_RESET(&ip_nat_udp_table[i].common);
+    if(ip_nat_udp_table[i].common.ttl && ip_nat_udp_table[i].common.cfg == cfg) {
+      ip_nat_port_free(&ip_nat_udp_state, &ip_nat_udp_table[i]);
     }
   }
 }
@@ -439,7 +490,7 @@ ip_nat_input(struct pbuf *p)
         nat_entry.tcp = ip_nat_tcp_lookup_incoming(iphdr, tcphdr);
         if (nat_entry.tcp != NULL) {
           /* Refresh TCP entry */
-          nat_entry.tcp->common.ttl = LWIP_NAT_DEFAULT_TTL_SECONDS;
+          nat_entry.tcp->expire = ip_nat_now + LWIP_NAT_TTL_TICKS;
           tcphdr->dest = nat_entry.tcp->sport;
           /* Adjust TCP checksum for changed destination port */
           ip_nat_chksum_adjust((u8_t *)&(tcphdr->chksum),
@@ -464,15 +515,18 @@ ip_nat_input(struct pbuf *p)
         nat_entry.udp = ip_nat_udp_lookup_incoming(iphdr, udphdr);
         if (nat_entry.udp != NULL) {
           /* Refresh UDP entry */
-          nat_entry.udp->common.ttl = LWIP_NAT_DEFAULT_TTL_SECONDS;
+          nat_entry.udp->expire = ip_nat_now + LWIP_NAT_TTL_TICKS;
           udphdr->dest = nat_entry.udp->sport;
-          /* Adjust UDP checksum for changed destination port */
-          ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-            (u8_t *)&(nat_entry.udp->nport), 2, (u8_t *)&(udphdr->dest), 2);
-          /* Adjust UDP checksum for changing dest IP address */
-          ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-            (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4,
-            (u8_t *)&(nat_entry.cmn->source.addr), 4);
+          /* a zero UDP checksum means none was computed, leave it alone */
+          if (udphdr->chksum != 0) {
+            /* Adjust UDP checksum for changed destination port */
+            ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
+              (u8_t *)&(nat_entry.udp->nport), 2, (u8_t *)&(udphdr->dest), 2);
+            /* Adjust UDP checksum for changing dest IP address */
+            ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
+              (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4,
+              (u8_t *)&(nat_entry.cmn->source.addr), 4);
+          }
 
           consumed = 1;
         }
@@ -592,12 +646,10 @@ ip_nat_tmr(void)
   for(i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_ICMP; i++) {
     ip_nat_check_timeout((ip_nat_entry_common_t *) & ip_nat_icmp_table[i]);
   }
-  for(i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    ip_nat_check_timeout((ip_nat_entry_common_t *) & ip_nat_tcp_table[i]);
-  }
-  for(i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    ip_nat_check_timeout((ip_nat_entry_common_t *) & ip_nat_udp_table[i]);
-  }
+
+  ip_nat_now++;
+  ip_nat_port_tmr(&ip_nat_tcp_state);
+  ip_nat_port_tmr(&ip_nat_udp_state);
 }
 
 /** Check if we want to perform NAT with this packet. If so, send it out on
@@ -660,14 +712,16 @@ ip_nat_out(struct pbuf *p)
         } else {
           nat_entry.udp = ip_nat_udp_lookup_outgoing(nat_config, iphdr, udphdr, 1);
           if (nat_entry.udp != NULL) {
-            /* Adjust UDP checksum for changing source port */
             udphdr->src = nat_entry.udp->nport;
-            ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-              (u8_t *)&(nat_entry.udp->sport), 2, (u8_t *) & (udphdr->src), 2);
-            /* Adjust UDP checksum for changing source IP address */
-            ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
-              (u8_t *)&(nat_entry.cmn->source.addr), 4,
-              (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4);
+            if (udphdr->chksum != 0) {
+              /* Adjust UDP checksum for changing source port */
+              ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
+                (u8_t *)&(nat_entry.udp->sport), 2, (u8_t *) & (udphdr->src), 2);
+              /* Adjust UDP checksum for changing source IP address */
+              ip_nat_chksum_adjust((u8_t *)&(udphdr->chksum),
+                (u8_t *)&(nat_entry.cmn->source.addr), 4,
+                (u8_t *)&(nat_entry.cmn->cfg->entry.out_if->ip_addr.addr), 4);
+            }
           }
         }
         break;
@@ -748,6 +802,205 @@ ip_nat_cmn_init(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr, ip_nat_en
   nat_entry->ttl = LWIP_NAT_DEFAULT_TTL_SECONDS;
 }
 
+/** Hash the outgoing 4-tuple of a TCP/UDP packet, the protocol selects the table */
+static u16_t
+ip_nat_port_hash(const ip_nat_port_table_t *t, u32_t src, u32_t dest, u16_t sport, u16_t dport)
+{
+  u32_t h;
+
+  h = src ^ (dest * 2654435761UL) ^ ((u32_t)sport << 16 | dport);
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return (u16_t)(h % t->nbucket);
+}
+
+/** Initialize a TCP/UDP state table, all entries go to the free list */
+static void
+ip_nat_port_init(ip_nat_port_table_t *t, ip_nat_entries_port_t *entries, u16_t size,
+                 u16_t *bucket, u16_t nbucket, u16_t base_port)
+{
+  u16_t i;
+
+  t->entries = entries;
+  t->size = size;
+  t->bucket = bucket;
+  t->nbucket = nbucket;
+  t->base_port = base_port;
+
+  for (i = 0; i < nbucket; i++) {
+    bucket[i] = IPNAT_NONE;
+  }
+  for (i = 0; i < LWIP_NAT_WHEEL_SLOTS; i++) {
+    t->wheel[i] = IPNAT_NONE;
+  }
+  for (i = 0; i < size; i++) {
+    IPNAT_ENTRY_RESET(&entries[i].common);
+    entries[i].nport = htons((u16_t)(base_port + i));
+    entries[i].wslot = IPNAT_NONE;
+    entries[i].hnext = (u16_t)(i + 1 < size ? i + 1 : IPNAT_NONE);
+  }
+  t->free = size ? 0 : IPNAT_NONE;
+}
+
+/** Put an entry in the wheel slot of its expiry tick */
+static void
+ip_nat_port_wheel_add(ip_nat_port_table_t *t, ip_nat_entries_port_t *e)
+{
+  u16_t idx = (u16_t)(e - t->entries);
+
+  e->wslot = (u16_t)(e->expire % LWIP_NAT_WHEEL_SLOTS);
+  e->wprev = IPNAT_NONE;
+  e->wnext = t->wheel[e->wslot];
+  if (e->wnext != IPNAT_NONE) {
+    t->entries[e->wnext].wprev = idx;
+  }
+  t->wheel[e->wslot] = idx;
+}
+
+/** Take an entry off its wheel slot */
+static void
+ip_nat_port_wheel_remove(ip_nat_port_table_t *t, ip_nat_entries_port_t *e)
+{
+  if (e->wslot == IPNAT_NONE) {
+    return;
+  }
+  if (e->wprev != IPNAT_NONE) {
+    t->entries[e->wprev].wnext = e->wnext;
+  } else {
+    t->wheel[e->wslot] = e->wnext;
+  }
+  if (e->wnext != IPNAT_NONE) {
+    t->entries[e->wnext].wprev = e->wprev;
+  }
+  e->wslot = IPNAT_NONE;
+}
+
+/** Unlink an entry from its hash bucket and the wheel, and return it to the free list */
+static void
+ip_nat_port_free(ip_nat_port_table_t *t, ip_nat_entries_port_t *e)
+{
+  u16_t idx = (u16_t)(e - t->entries);
+  u16_t *link;
+
+  link = &t->bucket[ip_nat_port_hash(t, e->common.source.addr, e->common.dest.addr, e->sport, e->dport)];
+  while (*link != IPNAT_NONE && *link != idx) {
+    link = &t->entries[*link].hnext;
+  }
+  if (*link == idx) {
+    *link = e->hnext;
+  }
+  ip_nat_port_wheel_remove(t, e);
+
+  IPNAT_ENTRY_RESET(&e->common);
+  e->hnext = t->free;
+  t->free = idx;
+}
+
+/** Turn the wheel by one slot: expire the entries due now, requeue the ones refreshed meanwhile.
+ * Refreshing an entry only moves its expiry tick, so the per packet cost stays O(1).
+ */
+static void
+ip_nat_port_tmr(ip_nat_port_table_t *t)
+{
+  u16_t *slot = &t->wheel[ip_nat_now % LWIP_NAT_WHEEL_SLOTS];
+  u16_t idx = *slot;
+  ip_nat_entries_port_t *e;
+
+  *slot = IPNAT_NONE;
+  while (idx != IPNAT_NONE) {
+    e = &t->entries[idx];
+    idx = e->wnext;
+    e->wslot = IPNAT_NONE;
+
+    if ((s32_t)(e->expire - ip_nat_now) > 0) {
+      ip_nat_port_wheel_add(t, e);
+    } else {
+      LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_tmr: removing port %" U16_F "\n", ntohs(e->nport)));
+      ip_nat_port_free(t, e);
+    }
+  }
+}
+
+/**
+ * This function checks for incoming packets if we already have a NAT entry.
+ * The destination port selects the entry, so no search is needed.
+ *
+ * @param t The state table.
+ * @param iphdr The IP header.
+ * @param src The TCP/UDP source port.
+ * @param dest The TCP/UDP destination port.
+ * @return A pointer to an existing NAT entry or NULL if none is found.
+ */
+static ip_nat_entries_port_t *
+ip_nat_port_lookup_incoming(ip_nat_port_table_t *t, const struct ip_hdr *iphdr, u16_t src, u16_t dest)
+{
+  u16_t idx = (u16_t)(ntohs(dest) - t->base_port);
+  ip_nat_entries_port_t *e;
+
+  if (idx >= t->size) {
+    return NULL;
+  }
+  e = &t->entries[idx];
+  if (e->common.ttl && (iphdr->src.addr == e->common.dest.addr) && (src == e->dport)) {
+    return e;
+  }
+  return NULL;
+}
+
+/**
+ * This function checks if we already have a NAT entry for this connection.
+ * If yes the a pointer to this NAT entry is returned.
+ *
+ * @param t The state table.
+ * @param nat_config NAT config entry
+ * @param iphdr The IP header.
+ * @param src The TCP/UDP source port.
+ * @param dest The TCP/UDP destination port.
+ * @param allocate If no existing NAT entry is found and this flag is true
+ *        a NAT entry is allocated.
+ */
+static ip_nat_entries_port_t *
+ip_nat_port_lookup_outgoing(ip_nat_port_table_t *t, ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr,
+                            u16_t src, u16_t dest, u8_t allocate)
+{
+  u16_t b = ip_nat_port_hash(t, iphdr->src.addr, iphdr->dest.addr, src, dest);
+  u16_t idx;
+  ip_nat_entries_port_t *e;
+
+  for (idx = t->bucket[b]; idx != IPNAT_NONE; idx = e->hnext) {
+    e = &t->entries[idx];
+    if ((iphdr->src.addr == e->common.source.addr) &&
+        (iphdr->dest.addr == e->common.dest.addr) &&
+        (src == e->sport) && (dest == e->dport)) {
+      e->expire = ip_nat_now + LWIP_NAT_TTL_TICKS;
+      return e;
+    }
+  }
+
+  if (!allocate || t->free == IPNAT_NONE) {
+    if (allocate) {
+      LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_port_lookup_outgoing: no more NAT entries available\n"));
+    }
+    return NULL;
+  }
+
+  idx = t->free;
+  e = &t->entries[idx];
+  t->free = e->hnext;
+
+  e->sport = src;
+  e->dport = dest;
+  ip_nat_cmn_init(nat_config, iphdr, &e->common);
+  e->expire = ip_nat_now + LWIP_NAT_TTL_TICKS;
+
+  e->hnext = t->bucket[b];
+  t->bucket[b] = idx;
+  ip_nat_port_wheel_add(t, e);
+
+  return e;
+}
+
 /**
  * This function checks for incoming packets if we already have a NAT entry.
  * If yes a pointer to the NAT entry is returned. Otherwise NULL.
@@ -760,20 +1013,12 @@ ip_nat_cmn_init(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr, ip_nat_en
 static ip_nat_entries_udp_t *
 ip_nat_udp_lookup_incoming(const struct ip_hdr *iphdr, const struct udp_hdr *udphdr)
 {
-  int i;
-  ip_nat_entries_udp_t *nat_entry = NULL;
+  ip_nat_entries_udp_t *nat_entry;
 
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    if (ip_nat_udp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_udp_table[i].common.dest.addr) &&
-          (udphdr->src == ip_nat_udp_table[i].dport) &&
-          (udphdr->dest == ip_nat_udp_table[i].nport)) {
-        nat_entry = &ip_nat_udp_table[i];
-        ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_incoming: found existing nat entry: ",
-                                      nat_entry);
-        break;
-      }
-    }
+  nat_entry = ip_nat_port_lookup_incoming(&ip_nat_udp_state, iphdr, udphdr->src, udphdr->dest);
+  if (nat_entry != NULL) {
+    ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_incoming: found existing nat entry: ",
+                                  nat_entry);
   }
   return nat_entry;
 }
@@ -792,45 +1037,14 @@ static ip_nat_entries_udp_t *
 ip_nat_udp_lookup_outgoing(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr,
                            const struct udp_hdr *udphdr, u8_t allocate)
 {
-  int i;
-  nat_entry_t nat_entry;
-  int last_free = -1;
+  ip_nat_entries_udp_t *nat_entry;
 
-  nat_entry.cmn = NULL;
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_UDP; i++) {
-    if (ip_nat_udp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_udp_table[i].common.source.addr) &&
-          (iphdr->dest.addr == ip_nat_udp_table[i].common.dest.addr) &&
-          (udphdr->src == ip_nat_udp_table[i].sport) &&
-          (udphdr->dest == ip_nat_udp_table[i].dport)) {
-        nat_entry.udp = &ip_nat_udp_table[i];
-
-        ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_outgoing: found existing nat entry: ",
-                                      nat_entry.udp);
-        break;
-      }
-    } else {
-        last_free = i;
-    }
+  nat_entry = ip_nat_port_lookup_outgoing(&ip_nat_udp_state, nat_config, iphdr,
+                                          udphdr->src, udphdr->dest, allocate);
+  if (nat_entry != NULL) {
+    ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_outgoing: nat entry: ", nat_entry);
   }
-  if (nat_entry.cmn == NULL) {
-    if (allocate) {
-      if (last_free != -1) {
-        nat_entry.udp = &ip_nat_udp_table[last_free];
-        nat_entry.udp->nport = htons((u16_t) (LWIP_NAT_DEFAULT_UDP_SOURCE_PORT + i));
-        nat_entry.udp->sport = udphdr->src;
-        nat_entry.udp->dport = udphdr->dest;
-        ip_nat_cmn_init(nat_config, iphdr, nat_entry.cmn);
-
-        ip_nat_dbg_dump_udp_nat_entry("ip_nat_udp_lookup_outgoing: created new nat entry: ",
-                                      nat_entry.udp);
-      } else {
-        LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_udp_lookup_outgoing: no more NAT entries available\n"));
-        // rt_kprintf("ip_nat_udp_lookup_outgoing: no more NAT entries available\n");
-      }
-    }
-  }
-  return nat_entry.udp;
+  return nat_entry;
 }
 
 /**
@@ -844,21 +1058,12 @@ ip_nat_udp_lookup_outgoing(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr
 static ip_nat_entries_tcp_t *
 ip_nat_tcp_lookup_incoming(const struct ip_hdr *iphdr, const struct tcp_hdr *tcphdr)
 {
-  int i;
-  ip_nat_entries_tcp_t *nat_entry = NULL;
+  ip_nat_entries_tcp_t *nat_entry;
 
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    if (ip_nat_tcp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_tcp_table[i].common.dest.addr) &&
-          (tcphdr->src == ip_nat_tcp_table[i].dport) &&
-          (tcphdr->dest == ip_nat_tcp_table[i].nport)) {
-        nat_entry = &ip_nat_tcp_table[i];
-
-        ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_incoming: found existing nat entry: ",
-                                      nat_entry);
-        break;
-      }
-    }
+  nat_entry = ip_nat_port_lookup_incoming(&ip_nat_tcp_state, iphdr, tcphdr->src, tcphdr->dest);
+  if (nat_entry != NULL) {
+    ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_incoming: found existing nat entry: ",
+                                  nat_entry);
   }
   return nat_entry;
 }
@@ -877,45 +1082,14 @@ static ip_nat_entries_tcp_t *
 ip_nat_tcp_lookup_outgoing(ip_nat_conf_t *nat_config, const struct ip_hdr *iphdr,
                            const struct tcp_hdr *tcphdr, u8_t allocate)
 {
-  int i;
-  nat_entry_t nat_entry;
-  int last_free = -1;
+  ip_nat_entries_tcp_t *nat_entry;
 
-  nat_entry.cmn = NULL;
-  for (i = 0; i < LWIP_NAT_DEFAULT_STATE_TABLES_TCP; i++) {
-    if (ip_nat_tcp_table[i].common.ttl) {
-      if ((iphdr->src.addr == ip_nat_tcp_table[i].common.source.addr) &&
-          (iphdr->dest.addr == ip_nat_tcp_table[i].common.dest.addr) &&
-          (tcphdr->src == ip_nat_tcp_table[i].sport) &&
-          (tcphdr->dest == ip_nat_tcp_table[i].dport)) {
-        nat_entry.tcp = &ip_nat_tcp_table[i];
-
-        ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_outgoing: found existing nat entry: ",
-                                      nat_entry.tcp);
-        break;
-      }
-    } else {
-        last_free = i;
-    }
+  nat_entry = ip_nat_port_lookup_outgoing(&ip_nat_tcp_state, nat_config, iphdr,
+                                          tcphdr->src, tcphdr->dest, allocate);
+  if (nat_entry != NULL) {
+    ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_outgoing: nat entry: ", nat_entry);
   }
-  if (nat_entry.cmn == NULL) {
-    if (allocate) {
-      if (last_free != -1) {
-        nat_entry.tcp = &ip_nat_tcp_table[last_free];
-        nat_entry.tcp->nport = htons((u16_t) (LWIP_NAT_DEFAULT_TCP_SOURCE_PORT + i));
-        nat_entry.tcp->sport = tcphdr->src;
-        nat_entry.tcp->dport = tcphdr->dest;
-        ip_nat_cmn_init(nat_config, iphdr, nat_entry.cmn);
-
-        ip_nat_dbg_dump_tcp_nat_entry("ip_nat_tcp_lookup_outgoing: created new nat entry: ",
-                                      nat_entry.tcp);
-      } else {
-        LWIP_DEBUGF(LWIP_NAT_DEBUG, ("ip_nat_udp_lookup_outgoing: no more NAT entries available\n"));
-        // rt_kprintf("ip_nat_udp_lookup_outgoing: no more NAT entries available\n");
-      }
-    }
-  }
-  return nat_entry.tcp;
+  return nat_entry;
 }
 
 /** Adjusts the checksum of a NAT'ed packet without having to completely recalculate it
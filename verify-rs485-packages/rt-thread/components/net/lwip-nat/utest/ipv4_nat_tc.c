@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "lwip/ip.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcpip.h"
+#include "lwip/udp.h"
+#include "ipv4_nat.h"
+#include "utest.h"
+
+/*
+ * NAT forwarding rate between two loopback netifs that only catch what
+ * the NAT sends out. Every run passes NAT_TC_ROUNDS rounds of one UDP
+ * request and its reply for each of NAT_TC_FLOWS flows through
+ * ip_nat_out() and ip_nat_input(), so the first round creates the table
+ * entries and the others look them up. The addresses are taken from the
+ * 198.18.0.0/15 benchmark range. The expire testcase turns the timer
+ * wheel with ip_nat_tmr() while one flow keeps sending and another is
+ * idle. Call ip_nat_init() before and time it with:
+ *
+ *     utest_bench -n 50 testcases.net.lwip_nat.*
+ */
+
+#ifndef NAT_TC_FLOWS
+#define NAT_TC_FLOWS        32
+#endif
+#define NAT_TC_ROUNDS       8
+#define NAT_TC_PORT         502
+/* ip_nat_tmr() calls, several times the default time to live */
+#define NAT_TC_TICKS        32
+
+#define NAT_TC_SERVER       PP_HTONL(0xC6130002UL)
+#define NAT_TC_HOST(i)      PP_HTONL(0xC6120000UL + 2 + (i) % 250)
+
+static struct netif in_if, out_if;
+static ip_nat_entry_t nat_entry;
+static struct pbuf *caught;
+static int bad;
+
+/* the output of both netifs, keep the packet to check it */
+static err_t nat_tc_output(struct netif *netif, struct pbuf *p, ip_addr_t *ipaddr)
+{
+    LWIP_UNUSED_ARG(netif);
+    LWIP_UNUSED_ARG(ipaddr);
+
+    if (caught != RT_NULL)
+    {
+        return ERR_BUF;
+    }
+    pbuf_ref(p);
+    caught = p;
+
+    return ERR_OK;
+}
+
+static struct pbuf *nat_tc_packet(u32_t src, u16_t sport, u32_t dest, u16_t dport)
+{
+    struct pbuf *p;
+    struct ip_hdr *iphdr;
+    struct udp_hdr *udphdr;
+
+    p = pbuf_alloc(PBUF_IP, sizeof(struct udp_hdr), PBUF_RAM);
+    if (p == RT_NULL)
+    {
+        return RT_NULL;
+    }
+    udphdr = (struct udp_hdr *)p->payload;
+    udphdr->src = htons(sport);
+    udphdr->dest = htons(dport);
+    udphdr->len = htons(sizeof(struct udp_hdr));
+    udphdr->chksum = htons(0x1234);
+
+    pbuf_header(p, IP_HLEN);
+    iphdr = (struct ip_hdr *)p->payload;
+    IPH_VHL_SET(iphdr, 4, IP_HLEN / 4);
+    IPH_TOS_SET(iphdr, 0);
+    IPH_LEN_SET(iphdr, htons(p->tot_len));
+    IPH_ID_SET(iphdr, 0);
+    IPH_OFFSET_SET(iphdr, 0);
+    IPH_TTL_SET(iphdr, 64);
+    IPH_PROTO_SET(iphdr, IP_PROTO_UDP);
+    iphdr->src.addr = src;
+    iphdr->dest.addr = dest;
+    IPH_CHKSUM_SET(iphdr, 0);
+    IPH_CHKSUM_SET(iphdr, inet_chksum(iphdr, IP_HLEN));
+
+    return p;
+}
+
+/* take the packet a netif caught, check its IP checksum and addresses */
+static struct udp_hdr *nat_tc_caught(u32_t src, u32_t dest)
+{
+    struct ip_hdr *iphdr;
+
+    if (caught == RT_NULL)
+    {
+        return RT_NULL;
+    }
+
+    iphdr = (struct ip_hdr *)caught->payload;
+    if (inet_chksum(iphdr, IP_HLEN) != 0 || iphdr->src.addr != src || iphdr->dest.addr != dest)
+    {
+        return RT_NULL;
+    }
+
+    return (struct udp_hdr *)((u8_t *)iphdr + IP_HLEN);
+}
+
+static void nat_tc_release(void)
+{
+    if (caught != RT_NULL)
+    {
+        pbuf_free(caught);
+        caught = RT_NULL;
+    }
+}
+
+static rt_err_t nat_tc_init(void)
+{
+    IP4_ADDR(&in_if.ip_addr, 198, 18, 0, 1);
+    IP4_ADDR(&in_if.netmask, 255, 255, 0, 0);
+    in_if.output = nat_tc_output;
+    IP4_ADDR(&out_if.ip_addr, 198, 19, 0, 1);
+    IP4_ADDR(&out_if.netmask, 255, 255, 0, 0);
+    out_if.output = nat_tc_output;
+
+    IP4_ADDR(&nat_entry.source_net, 198, 18, 0, 0);
+    IP4_ADDR(&nat_entry.source_netmask, 255, 255, 0, 0);
+    IP4_ADDR(&nat_entry.dest_net, 198, 19, 0, 0);
+    IP4_ADDR(&nat_entry.dest_netmask, 255, 255, 0, 0);
+    nat_entry.in_if = &in_if;
+    nat_entry.out_if = &out_if;
+    caught = RT_NULL;
+
+    LOCK_TCPIP_CORE();
+    if (ip_nat_add(&nat_entry) != ERR_OK)
+    {
+        UNLOCK_TCPIP_CORE();
+        return -RT_ENOMEM;
+    }
+    UNLOCK_TCPIP_CORE();
+
+    return RT_EOK;
+}
+
+static rt_err_t nat_tc_cleanup(void)
+{
+    LOCK_TCPIP_CORE();
+    /* the entries of the flows are reset with the configuration */
+    ip_nat_remove(&nat_entry);
+    UNLOCK_TCPIP_CORE();
+
+    return RT_EOK;
+}
+
+/* a request of flow i through the NAT, returns the translated port or 0 */
+static u16_t nat_tc_request(int i)
+{
+    struct pbuf *p;
+    struct udp_hdr *udphdr;
+    u16_t nport = 0;
+
+    /* request from host i, leaves on out_if with the address of out_if */
+    p = nat_tc_packet(NAT_TC_HOST(i), 1024 + i, NAT_TC_SERVER, NAT_TC_PORT);
+    if (p == RT_NULL)
+    {
+        return 0;
+    }
+    if (ip_nat_out(p) != 0 &&
+        (udphdr = nat_tc_caught(out_if.ip_addr.addr, NAT_TC_SERVER)) != RT_NULL &&
+        udphdr->dest == htons(NAT_TC_PORT))
+    {
+        nport = ntohs(udphdr->src);
+    }
+    pbuf_free(p);
+    nat_tc_release();
+
+    return nport;
+}
+
+/* the reply to the translated port of flow i, returns 1 if it went back to host i */
+static int nat_tc_reply(int i, u16_t nport)
+{
+    struct pbuf *p;
+    struct udp_hdr *udphdr;
+    int back = 0;
+
+    p = nat_tc_packet(NAT_TC_SERVER, NAT_TC_PORT, out_if.ip_addr.addr, nport);
+    if (p == RT_NULL)
+    {
+        return 0;
+    }
+    /* ip_nat_input() frees a packet it took */
+    if (ip_nat_input(p) == 0)
+    {
+        pbuf_free(p);
+    }
+    else if ((udphdr = nat_tc_caught(NAT_TC_SERVER, NAT_TC_HOST(i))) != RT_NULL &&
+             udphdr->dest == htons(1024 + i))
+    {
+        back = 1;
+    }
+    nat_tc_release();
+
+    return back;
+}
+
+static void nat_forward(void)
+{
+    u16_t nport;
+    int round, i;
+
+    bad = 0;
+
+    LOCK_TCPIP_CORE();
+    for (round = 0; round < NAT_TC_ROUNDS; round++)
+    {
+        for (i = 0; i < NAT_TC_FLOWS; i++)
+        {
+            nport = nat_tc_request(i);
+            if (nport == 0 || !nat_tc_reply(i, nport))
+            {
+                bad ++;
+            }
+        }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    uassert_int_equal(bad, 0);
+}
+
+/* an idle flow times out, one that keeps sending stays across turns of the wheel */
+static void nat_expire(void)
+{
+    u16_t nport_a, nport_b;
+    int tick;
+
+    bad = 0;
+
+    LOCK_TCPIP_CORE();
+    nport_a = nat_tc_request(0);
+    nport_b = nat_tc_request(1);
+    uassert_true(nport_a != 0 && nport_b != 0 && nport_a != nport_b);
+
+    for (tick = 0; tick < NAT_TC_TICKS; tick++)
+    {
+        ip_nat_tmr();
+        if (nat_tc_request(0) != nport_a)
+        {
+            bad ++;
+        }
+    }
+
+    uassert_int_equal(nat_tc_reply(1, nport_b), 0);
+    uassert_int_equal(nat_tc_reply(0, nport_a), 1);
+
+    /* the entry of the idle flow is given out again */
+    nport_b = nat_tc_request(1);
+    uassert_true(nport_b != 0 && nport_b != nport_a);
+    uassert_int_equal(nat_tc_reply(1, nport_b), 1);
+    UNLOCK_TCPIP_CORE();
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(nat_forward);
+}
+UTEST_TC_EXPORT(testcase, "testcases.net.lwip_nat.udp_forward", nat_tc_init, nat_tc_cleanup, 10);
+
+static void testcase_expire(void)
+{
+    UTEST_UNIT_RUN(nat_expire);
+}
+UTEST_TC_EXPORT(testcase_expire, "testcases.net.lwip_nat.udp_expire", nat_tc_init, nat_tc_cleanup, 10);
@@ -7,6 +7,8 @@
  * Date           Author       Notes
  * 2021-01-07     ChenYong     first version
  * 2021-12-20     armink       add multi-instance version
+ * 2026-10-17     RT-Thread    write blocks in a dedicated thread, optional LZ4 compression
+ * 2026-10-17     RT-Thread    keep the current file on a failed rotation, report lost bytes
  */
 
 #include <rtthread.h>
@@ -18,16 +20,23 @@
 
 #ifdef ULOG_BACKEND_USING_FILE
 
-#if defined(ULOG_ASYNC_OUTPUT_THREAD_STACK) && (ULOG_ASYNC_OUTPUT_THREAD_STACK < 2048)
+#if !defined(ULOG_BACKEND_FILE_USING_WRITER) && defined(ULOG_ASYNC_OUTPUT_THREAD_STACK) && (ULOG_ASYNC_OUTPUT_THREAD_STACK < 2048)
 #error "The value of ULOG_ASYNC_OUTPUT_THREAD_STACK must be greater than 2048."
 #endif
 
+#ifndef ULOG_BACKEND_FILE_WRITER_STACK
+#define ULOG_BACKEND_FILE_WRITER_STACK      2048
+#endif
+#ifndef ULOG_BACKEND_FILE_WRITER_PRIORITY
+#define ULOG_BACKEND_FILE_WRITER_PRIORITY   (RT_THREAD_PRIORITY_MAX - 2)
+#endif
+
 /* rotate the log file xxx_n-1.log => xxx_n.log, and xxx.log => xxx_0.log */
 static rt_bool_t ulog_file_rotate(struct ulog_file_be *be)
 {
 #define SUFFIX_LEN          10
     /* mv xxx_n-1.log => xxx_n.log, and xxx.log => xxx_0.log */
-    static char old_path[ULOG_FILE_PATH_LEN], new_path[ULOG_FILE_PATH_LEN];
+    char old_path[ULOG_FILE_PATH_LEN], new_path[ULOG_FILE_PATH_LEN];
     int index = 0, err = 0, file_fd = 0;
     rt_bool_t result = RT_FALSE;
     size_t base_len = 0;
@@ -43,8 +52,8 @@ static rt_bool_t ulog_file_rotate(struct ulog_file_be *be)
 
     for (index = be->file_max_num - 2; index >= 0; --index)
     {
-        rt_snprintf(old_path + base_len, SUFFIX_LEN, index ? "_%d.log" : ".log", index - 1);
-        rt_snprintf(new_path + base_len, SUFFIX_LEN, "_%d.log", index);
+        rt_snprintf(old_path + base_len, SUFFIX_LEN, index ? "_%d" ULOG_FILE_SUFFIX : ULOG_FILE_SUFFIX, index - 1);
+        rt_snprintf(new_path + base_len, SUFFIX_LEN, "_%d" ULOG_FILE_SUFFIX, index);
         /* remove the old file */
         if ((file_fd = open(new_path, O_RDONLY)) >= 0)
         {
@@ -68,12 +77,51 @@ static rt_bool_t ulog_file_rotate(struct ulog_file_be *be)
     }
 
 __exit:
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    if (result && be->next_ready)
+    {
+        /* the writer created the next file while it was idle, after a failed rotation
+           it would replace the current file, so it is kept for the next try */
+        rt_snprintf(old_path + base_len, SUFFIX_LEN, ".nxt");
+        dfs_file_rename(old_path, be->cur_log_file_path);
+        be->next_ready = RT_FALSE;
+    }
+#endif
     /* reopen the file */
     be->cur_log_file_fd = open(be->cur_log_file_path, O_CREAT | O_RDWR | O_APPEND);
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    be->cur_file_size = (be->cur_log_file_fd >= 0) ? lseek(be->cur_log_file_fd, 0, SEEK_END) : 0;
+#endif
 
     return result;
 }
 
+static rt_bool_t ulog_file_open(struct ulog_file_be *be)
+{
+    if (be->cur_log_file_fd >= 0)
+    {
+        return RT_TRUE;
+    }
+    /* check log file directory  */
+    if (access(be->cur_log_dir_path, F_OK) < 0)
+    {
+        mkdir(be->cur_log_dir_path, 0);
+    }
+    /* open file */
+    rt_snprintf(be->cur_log_file_path, ULOG_FILE_PATH_LEN, "%s/%s" ULOG_FILE_SUFFIX, be->cur_log_dir_path, be->parent.name);
+    be->cur_log_file_fd = open(be->cur_log_file_path, O_CREAT | O_RDWR | O_APPEND);
+    if (be->cur_log_file_fd < 0)
+    {
+        rt_kprintf("ulog file(%s) open failed.", be->cur_log_file_path);
+        return RT_FALSE;
+    }
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    be->cur_file_size = lseek(be->cur_log_file_fd, 0, SEEK_END);
+#endif
+    return RT_TRUE;
+}
+
+#ifndef ULOG_BACKEND_FILE_USING_WRITER
 static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
 {
     struct ulog_file_be *be = (struct ulog_file_be *) backend;
@@ -83,21 +131,9 @@ static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
     {
         return;
     }
-    if (be->cur_log_file_fd < 0)
+    if (!ulog_file_open(be))
     {
-        /* check log file directory  */
-        if (access(be->cur_log_dir_path, F_OK) < 0)
-        {
-            mkdir(be->cur_log_dir_path, 0);
-        }
-        /* open file */
-        rt_snprintf(be->cur_log_file_path, ULOG_FILE_PATH_LEN, "%s/%s.log", be->cur_log_dir_path, be->parent.name);
-        be->cur_log_file_fd = open(be->cur_log_file_path, O_CREAT | O_RDWR | O_APPEND);
-        if (be->cur_log_file_fd < 0)
-        {
-            rt_kprintf("ulog file(%s) open failed.", be->cur_log_file_path);
-            return;
-        }
+        return;
     }
 
     file_size = lseek(be->cur_log_file_fd, 0, SEEK_END);
@@ -163,11 +199,336 @@ static void ulog_file_backend_output_with_buf(struct ulog_backend *backend, rt_u
     }
 }
 
+#else
+
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+#define LZ4_HASH_BITS       10
+#define LZ4_MIN_MATCH       4
+#define LZ4_LAST_LITERALS   5
+#define LZ4_MFLIMIT         12
+
+rt_inline rt_uint32_t lz4_read32(const rt_uint8_t *p)
+{
+    rt_uint32_t v;
+
+    rt_memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+rt_inline rt_uint32_t lz4_hash(rt_uint32_t v)
+{
+    return (v * 2654435761U) >> (32 - LZ4_HASH_BITS);
+}
+
+rt_inline rt_uint8_t *lz4_put_len(rt_uint8_t *op, rt_size_t len)
+{
+    for (; len >= 255; len -= 255)
+    {
+        *op++ = 255;
+    }
+    *op++ = (rt_uint8_t)len;
+    return op;
+}
+
+/* emit one sequence, mlen is 0 for the trailing literals */
+static rt_uint8_t *lz4_put_seq(rt_uint8_t *op, rt_uint8_t *oend, const rt_uint8_t *lit, rt_size_t llen,
+                               rt_size_t offset, rt_size_t mlen)
+{
+    rt_uint8_t *token = op++;
+
+    if (op + llen + llen / 255 + 1 + 2 + mlen / 255 + 1 > oend)
+    {
+        return RT_NULL;
+    }
+
+    if (llen >= 15)
+    {
+        *token = 15 << 4;
+        op = lz4_put_len(op, llen - 15);
+    }
+    else
+    {
+        *token = (rt_uint8_t)(llen << 4);
+    }
+    rt_memcpy(op, lit, llen);
+    op += llen;
+
+    if (mlen)
+    {
+        *op++ = (rt_uint8_t)offset;
+        *op++ = (rt_uint8_t)(offset >> 8);
+        mlen -= LZ4_MIN_MATCH;
+        if (mlen >= 15)
+        {
+            *token |= 15;
+            op = lz4_put_len(op, mlen - 15);
+        }
+        else
+        {
+            *token |= (rt_uint8_t)mlen;
+        }
+    }
+    return op;
+}
+
+/* LZ4 block format, returns the compressed length or 0 if it does not fit in cap */
+static rt_size_t ulog_lz4_compress(const rt_uint8_t *src, rt_size_t len, rt_uint8_t *dst, rt_size_t cap,
+                                   rt_uint32_t *table)
+{
+    rt_uint8_t *op = dst, *oend = dst + cap;
+    rt_size_t ip = 0, anchor = 0, ref, mlen;
+    rt_uint32_t seq, h;
+
+    rt_memset(table, 0, sizeof(rt_uint32_t) << LZ4_HASH_BITS);
+
+    if (len > LZ4_MFLIMIT)
+    {
+        while (ip < len - LZ4_MFLIMIT)
+        {
+            seq = lz4_read32(src + ip);
+            h = lz4_hash(seq);
+            ref = table[h];
+            table[h] = (rt_uint32_t)ip;
+
+            if (ref >= ip || ip - ref > 0xFFFF || lz4_read32(src + ref) != seq)
+            {
+                ip++;
+                continue;
+            }
+
+            mlen = LZ4_MIN_MATCH;
+            while (ip + mlen < len - LZ4_LAST_LITERALS && src[ref + mlen] == src[ip + mlen])
+            {
+                mlen++;
+            }
+
+            op = lz4_put_seq(op, oend, src + anchor, ip - anchor, ip - ref, mlen);
+            if (op == RT_NULL)
+            {
+                return 0;
+            }
+            ip += mlen;
+            anchor = ip;
+        }
+    }
+
+    op = lz4_put_seq(op, oend, src + anchor, len - anchor, 0, 0);
+    if (op == RT_NULL)
+    {
+        return 0;
+    }
+    return op - dst;
+}
+#endif /* ULOG_BACKEND_FILE_USING_LZ4 */
+
+/* hand the block being filled to the writer, called with be->lock held */
+static rt_bool_t ulog_file_submit(struct ulog_file_be *be)
+{
+    rt_uint8_t *base = be->file_buf + be->fill * be->buf_size;
+    rt_uint8_t other = be->fill ^ 1;
+
+    if (be->buf_ptr_now == base)
+    {
+        return RT_FALSE;
+    }
+    if (be->pending & (1 << other))
+    {
+        /* the writer is still saving the other block, let it pick this one up when done */
+        be->flush_req = RT_TRUE;
+        return RT_FALSE;
+    }
+
+    be->blk_len[be->fill] = be->buf_ptr_now - base;
+    be->pending |= 1 << be->fill;
+    be->fill = other;
+    be->buf_ptr_now = be->file_buf + other * be->buf_size;
+
+    return RT_TRUE;
+}
+
+static void ulog_file_write_block(struct ulog_file_be *be, const rt_uint8_t *blk, rt_size_t len)
+{
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+    struct ulog_file_lz4_head *head = (struct ulog_file_lz4_head *)be->zbuf;
+    rt_size_t zlen;
+
+    /* data_len == raw_len means stored, a compressed block must be shorter */
+    zlen = ulog_lz4_compress(blk, len, be->zbuf + sizeof(*head), len - 1, be->ztab);
+    if (zlen == 0)
+    {
+        /* incompressible, store it */
+        rt_memcpy(be->zbuf + sizeof(*head), blk, len);
+        zlen = len;
+    }
+    rt_memcpy(head->magic, ULOG_FILE_LZ4_MAGIC, sizeof(head->magic));
+    head->raw_len = len;
+    head->data_len = zlen;
+    blk = be->zbuf;
+    len = sizeof(*head) + zlen;
+#endif
+
+    if (!ulog_file_open(be))
+    {
+        return;
+    }
+    if (be->cur_file_size + len > be->file_max_size)
+    {
+        if (!ulog_file_rotate(be) || be->cur_log_file_fd < 0)
+        {
+            return;
+        }
+    }
+
+    if (write(be->cur_log_file_fd, blk, len) != len)
+    {
+        return;
+    }
+    fsync(be->cur_log_file_fd);
+    be->cur_file_size += len;
+
+    if (!be->next_ready && be->file_max_num > 1 && be->cur_file_size >= be->file_max_size / 2)
+    {
+        /* create the next file now, so the rotation only renames */
+        char next_path[ULOG_FILE_PATH_LEN];
+        int fd;
+
+        rt_snprintf(next_path, ULOG_FILE_PATH_LEN, "%s/%s.nxt", be->cur_log_dir_path, be->parent.name);
+        fd = open(next_path, O_CREAT | O_RDWR | O_TRUNC);
+        if (fd >= 0)
+        {
+            close(fd);
+            be->next_ready = RT_TRUE;
+        }
+    }
+}
+
+static void ulog_file_writer_entry(void *param)
+{
+    struct ulog_file_be *be = (struct ulog_file_be *)param;
+    rt_base_t level;
+    rt_uint8_t idx;
+
+    while (1)
+    {
+        rt_sem_take(&be->notice, RT_WAITING_FOREVER);
+
+        while (1)
+        {
+            level = rt_spin_lock_irqsave(&be->lock);
+            if (be->pending == 0 && be->flush_req)
+            {
+                be->flush_req = RT_FALSE;
+                ulog_file_submit(be);
+            }
+            if (be->pending == 0)
+            {
+                rt_spin_unlock_irqrestore(&be->lock, level);
+                break;
+            }
+            idx = (be->pending & 1) ? 0 : 1;
+            rt_spin_unlock_irqrestore(&be->lock, level);
+
+            ulog_file_write_block(be, be->file_buf + idx * be->buf_size, be->blk_len[idx]);
+
+            level = rt_spin_lock_irqsave(&be->lock);
+            be->pending &= ~(1 << idx);
+            rt_spin_unlock_irqrestore(&be->lock, level);
+        }
+
+        if (be->lost != be->lost_reported)
+        {
+            rt_kprintf("ulog file backend %s lost %d bytes\n", be->parent.name, be->lost - be->lost_reported);
+            be->lost_reported = be->lost;
+        }
+
+        if (!be->running)
+        {
+            break;
+        }
+    }
+
+    rt_completion_done(&be->exit);
+}
+
+static void ulog_file_backend_flush_with_buf(struct ulog_backend *backend)
+{
+    struct ulog_file_be *be = (struct ulog_file_be *)backend;
+    rt_base_t level;
+    rt_bool_t submitted;
+
+    if (be->enable == RT_FALSE)
+    {
+        return;
+    }
+
+    level = rt_spin_lock_irqsave(&be->lock);
+    submitted = ulog_file_submit(be);
+    rt_spin_unlock_irqrestore(&be->lock, level);
+
+    if (submitted)
+    {
+        rt_sem_release(&be->notice);
+    }
+}
+
+/* only copies into the block being filled, the file I/O happens in the writer thread */
+static void ulog_file_backend_output_with_buf(struct ulog_backend *backend, rt_uint32_t level,
+            const char *tag, rt_bool_t is_raw, const char *log, rt_size_t len)
+{
+    struct ulog_file_be *be = (struct ulog_file_be *)backend;
+    rt_size_t copy_len = 0;
+    const rt_uint8_t *buf_ptr_end;
+    rt_bool_t submitted = RT_FALSE;
+    rt_base_t lock_level;
+
+    if (be->enable == RT_FALSE)
+    {
+        return;
+    }
+
+    lock_level = rt_spin_lock_irqsave(&be->lock);
+    while (len)
+    {
+        buf_ptr_end = be->file_buf + (be->fill + 1) * be->buf_size;
+        copy_len = buf_ptr_end - be->buf_ptr_now;
+        if (copy_len > len)
+        {
+            copy_len = len;
+        }
+        rt_memcpy(be->buf_ptr_now, log, copy_len);
+        be->buf_ptr_now += copy_len;
+        len -= copy_len;
+        log += copy_len;
+
+        if (be->buf_ptr_now == buf_ptr_end)
+        {
+            if (!ulog_file_submit(be))
+            {
+                /* both blocks are busy, drop the rest instead of blocking the caller */
+                be->lost += len;
+                break;
+            }
+            submitted = RT_TRUE;
+        }
+    }
+    rt_spin_unlock_irqrestore(&be->lock, lock_level);
+
+    if (submitted)
+    {
+        rt_sem_release(&be->notice);
+    }
+}
+#endif /* ULOG_BACKEND_FILE_USING_WRITER */
+
 /* initialize the ulog file backend */
 int ulog_file_backend_init(struct ulog_file_be *be, const char *name, const char *dir_path, rt_size_t max_num,
         rt_size_t max_size, rt_size_t buf_size)
 {
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    be->file_buf = rt_calloc(2, buf_size);
+#else
     be->file_buf = rt_calloc(1, buf_size);
+#endif
     if (!be->file_buf)
     {
         rt_kprintf("Warning: NO MEMORY for %s file backend\n", name);
@@ -186,14 +547,84 @@ int ulog_file_backend_init(struct ulog_file_be *be, const char *name, const char
 
     be->parent.output = ulog_file_backend_output_with_buf;
     be->parent.flush = ulog_file_backend_flush_with_buf;
+
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    rt_spin_lock_init(&be->lock);
+    be->fill = 0;
+    be->pending = 0;
+    be->flush_req = RT_FALSE;
+    be->lost = 0;
+    be->lost_reported = 0;
+    be->cur_file_size = 0;
+    be->next_ready = RT_FALSE;
+    /* the backend name is needed by the thread, it is set by the register below */
+    rt_strncpy(be->parent.name, name, RT_NAME_MAX);
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+    be->zbuf = rt_malloc(sizeof(struct ulog_file_lz4_head) + buf_size);
+    be->ztab = rt_malloc(sizeof(rt_uint32_t) << LZ4_HASH_BITS);
+    if (!be->zbuf || !be->ztab)
+    {
+        rt_kprintf("Warning: NO MEMORY for %s file backend\n", name);
+        goto __nomem;
+    }
+#endif
+    rt_sem_init(&be->notice, name, 0, RT_IPC_FLAG_FIFO);
+    rt_completion_init(&be->exit);
+    be->running = RT_TRUE;
+    be->writer = rt_thread_create(name, ulog_file_writer_entry, be,
+            ULOG_BACKEND_FILE_WRITER_STACK, ULOG_BACKEND_FILE_WRITER_PRIORITY, 10);
+    if (!be->writer)
+    {
+        rt_kprintf("Warning: %s file backend writer create failed\n", name);
+        rt_sem_detach(&be->notice);
+        goto __nomem;
+    }
+    rt_thread_startup(be->writer);
+#endif
+
     ulog_backend_register((ulog_backend_t) be, name, RT_FALSE);
 
     return 0;
+
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+__nomem:
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+    rt_free(be->zbuf);
+    rt_free(be->ztab);
+#endif
+    rt_free(be->file_buf);
+    be->file_buf = RT_NULL;
+    return -RT_ENOMEM;
+#endif
 }
 
 /* uninitialize the ulog file backend */
 int ulog_file_backend_deinit(struct ulog_file_be *be)
 {
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    ulog_backend_unregister((ulog_backend_t)be);
+
+    /* let the writer save what is left, then stop it */
+    ulog_file_backend_flush_with_buf((ulog_backend_t)be);
+    be->running = RT_FALSE;
+    rt_sem_release(&be->notice);
+    rt_completion_wait(&be->exit, RT_WAITING_FOREVER);
+    rt_sem_detach(&be->notice);
+
+    if (be->cur_log_file_fd >= 0)
+    {
+        close(be->cur_log_file_fd);
+        be->cur_log_file_fd = -1;
+    }
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+    rt_free(be->zbuf);
+    rt_free(be->ztab);
+#endif
+    rt_free(be->file_buf);
+    be->file_buf = RT_NULL;
+
+    return 0;
+#else
     if (be->cur_log_file_fd >= 0)
     {
         /* flush log to file */
@@ -203,7 +634,7 @@ int ulog_file_backend_deinit(struct ulog_file_be *be)
         be->cur_log_file_fd = -1;
     }
 
-    if (!be->file_buf)
+    if (be->file_buf)
     {
         rt_free(be->file_buf);
         be->file_buf = RT_NULL;
@@ -211,8 +642,24 @@ int ulog_file_backend_deinit(struct ulog_file_be *be)
 
     ulog_backend_unregister((ulog_backend_t)be);
     return 0;
+#endif
 }
 
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+/* bytes dropped so far because the writer could not keep up */
+rt_size_t ulog_file_backend_lost(struct ulog_file_be *be)
+{
+    rt_base_t level;
+    rt_size_t lost;
+
+    level = rt_spin_lock_irqsave(&be->lock);
+    lost = be->lost;
+    rt_spin_unlock_irqrestore(&be->lock, level);
+
+    return lost;
+}
+#endif
+
 void ulog_file_backend_enable(struct ulog_file_be *be)
 {
     be->enable = RT_TRUE;
@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-01-07     ChenYong     first version
  * 2021-12-20     armink       add multi-instance version
+ * 2026-10-17     RT-Thread    add the writer thread and LZ4 block compression
  */
 
 #ifndef _ULOG_BE_H_
@@ -18,6 +19,25 @@
 #define ULOG_FILE_PATH_LEN   128
 #endif
 
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+#include <ipc/completion.h>
+#endif
+
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+/* every block in the file starts with this header, data_len == raw_len means stored */
+#define ULOG_FILE_LZ4_MAGIC  "ULZ4"
+#define ULOG_FILE_SUFFIX     ".ulz"
+
+struct ulog_file_lz4_head
+{
+    char magic[4];
+    rt_uint32_t raw_len;
+    rt_uint32_t data_len;
+};
+#else
+#define ULOG_FILE_SUFFIX     ".log"
+#endif
+
 struct ulog_file_be
 {
     struct ulog_backend parent;
@@ -32,6 +52,28 @@ struct ulog_file_be
 
     char cur_log_file_path[ULOG_FILE_PATH_LEN];
     char cur_log_dir_path[ULOG_FILE_PATH_LEN];
+
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+    /* file_buf holds two blocks, one is filled by the callers while the writer saves the other */
+    struct rt_spinlock lock;
+    rt_uint8_t fill;                /* index of the block being filled */
+    rt_uint8_t pending;             /* bitmask of blocks handed to the writer */
+    rt_bool_t flush_req;            /* submit the filled block once the writer is free */
+    rt_size_t blk_len[2];
+    rt_size_t lost;                 /* bytes dropped because both blocks were busy */
+    rt_size_t lost_reported;        /* lost bytes the writer has reported already */
+
+    rt_thread_t writer;
+    rt_bool_t running;
+    struct rt_semaphore notice;
+    struct rt_completion exit;
+    rt_size_t cur_file_size;
+    rt_bool_t next_ready;           /* the next log file has been created already */
+#ifdef ULOG_BACKEND_FILE_USING_LZ4
+    rt_uint8_t *zbuf;
+    rt_uint32_t *ztab;
+#endif
+#endif /* ULOG_BACKEND_FILE_USING_WRITER */
 };
 
 /* ulog file backend api */
@@ -40,5 +82,8 @@ int ulog_file_backend_init(struct ulog_file_be *be, const char *name, const char
 int ulog_file_backend_deinit(struct ulog_file_be *be);
 void ulog_file_backend_enable(struct ulog_file_be *be);
 void ulog_file_backend_disable(struct ulog_file_be *be);
+#ifdef ULOG_BACKEND_FILE_USING_WRITER
+rt_size_t ulog_file_backend_lost(struct ulog_file_be *be);
+#endif
 
 #endif /* _ULOG_BE_H_ */
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <unistd.h>
+#include <ulog_be.h>
+#include <drivers/cputime.h>
+#include "utest.h"
+
+/*
+ * The worst case time of a log call on the file backend. The caller only
+ * copies into a block, the writer thread saves the blocks, so no call may
+ * wait for the file system even while the files rotate. Every run makes
+ * ULOG_FILE_TC_CALLS calls on a backend writing into ULOG_FILE_TC_DIR,
+ * fails if one took more than ULOG_FILE_TC_MAX_US and logs the worst one
+ * and the bytes the writer could not keep up with. Time it with:
+ *
+ *     utest_bench -n 20 testcases.utilities.ulog.file_latency
+ */
+
+#ifndef ULOG_FILE_TC_DIR
+#define ULOG_FILE_TC_DIR        "/ulog_tc"
+#endif
+#ifndef ULOG_FILE_TC_MAX_US
+#define ULOG_FILE_TC_MAX_US     1000
+#endif
+#define ULOG_FILE_TC_NAME       "ulogtc"
+#define ULOG_FILE_TC_CALLS      256
+#define ULOG_FILE_TC_LINE       64
+#define ULOG_FILE_TC_BUF_SIZE   1024
+#define ULOG_FILE_TC_FILE_SIZE  (16 * 1024)
+
+static struct ulog_file_be be;
+static char line[ULOG_FILE_TC_LINE];
+
+static rt_err_t ulog_file_tc_init(void)
+{
+    rt_memset(line, 'u', sizeof(line) - 1);
+    line[sizeof(line) - 1] = '\n';
+
+    /* small files, so the runs rotate them */
+    if (ulog_file_backend_init(&be, ULOG_FILE_TC_NAME, ULOG_FILE_TC_DIR, 2,
+                               ULOG_FILE_TC_FILE_SIZE, ULOG_FILE_TC_BUF_SIZE) != 0)
+    {
+        return -RT_ERROR;
+    }
+    ulog_file_backend_enable(&be);
+
+    return RT_EOK;
+}
+
+static rt_err_t ulog_file_tc_cleanup(void)
+{
+    ulog_file_backend_disable(&be);
+    ulog_file_backend_deinit(&be);
+
+    unlink(ULOG_FILE_TC_DIR "/" ULOG_FILE_TC_NAME ULOG_FILE_SUFFIX);
+    unlink(ULOG_FILE_TC_DIR "/" ULOG_FILE_TC_NAME "_0" ULOG_FILE_SUFFIX);
+    unlink(ULOG_FILE_TC_DIR "/" ULOG_FILE_TC_NAME ".nxt");
+    rmdir(ULOG_FILE_TC_DIR);
+
+    return RT_EOK;
+}
+
+static void ulog_file_latency(void)
+{
+    rt_uint64_t start, cost, worst = 0;
+    int i;
+
+    for (i = 0; i < ULOG_FILE_TC_CALLS; i++)
+    {
+        start = clock_cpu_gettime();
+        be.parent.output(&be.parent, LOG_LVL_INFO, "tc", RT_FALSE, line, sizeof(line));
+        cost = clock_cpu_gettime() - start;
+        if (cost > worst)
+        {
+            worst = cost;
+        }
+    }
+    be.parent.flush(&be.parent);
+
+    LOG_I("worst log call %d us, %d bytes lost so far", (int)clock_cpu_microsecond(worst),
+          (int)ulog_file_backend_lost(&be));
+    uassert_true(clock_cpu_microsecond(worst) <= ULOG_FILE_TC_MAX_US);
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(ulog_file_latency);
+}
+UTEST_TC_EXPORT(testcase, "testcases.utilities.ulog.file_latency", ulog_file_tc_init, ulog_file_tc_cleanup, 30);
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-11-19     MurphyZhao   the first version
+ * 2026-10-17     RT-Thread    add parallel run, benchmark mode and baseline compare
+ * 2026-10-17     RT-Thread    count the asserts of threads the testcases create in a parallel run
  */
 
 #include <rtthread.h>
@@ -15,6 +17,14 @@
 #include "utest.h"
 #include <utest_log.h>
 
+#ifdef RT_USING_CPUTIME
+#include <drivers/cputime.h>
+#endif
+#ifdef DFS_USING_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #undef DBG_TAG
 #undef DBG_LVL
 
@@ -42,6 +52,16 @@
 #define UTEST_THREAD_PRIORITY   FINSH_THREAD_PRIORITY
 #endif
 
+#ifndef UTEST_WORKERS_MAX
+#define UTEST_WORKERS_MAX       8
+#endif
+
+/* utest_bench defaults */
+#define UTEST_BENCH_ITERS       100
+#define UTEST_BENCH_WARMUP      10
+#define UTEST_BENCH_THRESHOLD   10      /* regression threshold in percent */
+#define UTEST_BENCH_LINE_SIZE   (UTEST_NAME_MAX_LEN + 64)
+
 static rt_uint8_t utest_log_lv = UTEST_LOG_ALL;
 static utest_tc_export_t tc_table = RT_NULL;
 static rt_size_t tc_num;
@@ -49,6 +69,19 @@ static rt_uint32_t tc_loop;
 static rt_uint8_t *tc_fail_list;
 static struct utest local_utest = {UTEST_PASSED, 0, 0};
 
+/*
+ * worker threads of a parallel run, each one has its own utest result. The
+ * result is found by the calling thread, so the asserts of the threads a
+ * testcase creates go to local_utest and fail the whole run instead.
+ */
+struct utest_worker
+{
+    rt_thread_t tid;
+    struct utest utest;
+};
+static struct utest_worker *utest_workers;
+static int utest_workers_num;
+
 #if defined(__ICCARM__) || defined(__ICCRX__)         /* for IAR compiler */
 #pragma section="UtestTcTab"
 #elif defined(_MSC_VER)
@@ -185,10 +218,92 @@ static int utest_help(void)
     rt_kprintf("            support '*' wildcard. Run all test cases starting with 'test'.\n");
     rt_kprintf("         8. utest_run -help\n");
     rt_kprintf("            Show utest help information\n");
+    rt_kprintf("         9. utest_run -j 4 test*\n");
+    rt_kprintf("            Run the test cases starting with 'test' on 4 worker threads.\n");
+    rt_kprintf("            The test cases must not depend on each other. An assert failed in a\n");
+    rt_kprintf("            thread a test case creates fails the run, not the test case.\n");
+    rt_kprintf("\n");
+    rt_kprintf("Command: utest_bench\n");
+    rt_kprintf("   info: Benchmark test cases, time of each run of the test case function.\n");
+    rt_kprintf(" format: utest_bench [-n iterations] [-w warm-up] [-f text|json|csv]\n");
+    rt_kprintf("                     [-o result.csv] [-b baseline.csv] [-t percent] [testcase name]\n");
+    rt_kprintf("  usage:\n");
+    rt_kprintf("         1. utest_bench -n 1000 -f csv testcaseA\n");
+    rt_kprintf("            Run 'testcaseA' 1000 times after %d warm-up runs, print min/median/p99 in ns.\n", UTEST_BENCH_WARMUP);
+    rt_kprintf("         2. utest_bench -o /base.csv test*\n");
+    rt_kprintf("            Also save the results in CSV to '/base.csv'.\n");
+    rt_kprintf("         3. utest_bench -b /base.csv -t 5 test*\n");
+    rt_kprintf("            Flag the medians more than 5%% slower than the ones in '/base.csv'.\n");
     rt_kprintf("\n");
     return 0;
 }
 
+static rt_bool_t utest_name_match(const char *name, const char *utest_name)
+{
+    int len;
+
+    if (utest_name == RT_NULL)
+    {
+        return RT_TRUE;
+    }
+
+    len = strlen(utest_name);
+    if (utest_name[len - 1] == '*')
+    {
+        len -= 1;
+    }
+
+    return rt_memcmp(name, utest_name, len) == 0;
+}
+
+/* run one testcase, return RT_TRUE if it failed */
+static rt_bool_t utest_tc_run(utest_tc_export_t tc)
+{
+    rt_bool_t failed = RT_FALSE;
+
+    LOG_I("[----------] [ testcase ] (%s) started", tc->name);
+    if (tc->init != RT_NULL)
+    {
+        if (tc->init() != RT_EOK)
+        {
+            LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc->name);
+            goto __tc_continue;
+        }
+    }
+
+    if (tc->tc != RT_NULL)
+    {
+        tc->tc();
+        if (utest_handle_get()->failed_num == 0)
+        {
+            LOG_I("[  PASSED  ] [ result   ] testcase (%s)", tc->name);
+        }
+        else
+        {
+            failed = RT_TRUE;
+            LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc->name);
+        }
+    }
+    else
+    {
+        LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc->name);
+    }
+
+    if (tc->cleanup != RT_NULL)
+    {
+        if (tc->cleanup() != RT_EOK)
+        {
+            LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc->name);
+            goto __tc_continue;
+        }
+    }
+
+__tc_continue:
+    LOG_I("[----------] [ testcase ] (%s) finished", tc->name);
+
+    return failed;
+}
+
 static void utest_run(const char *utest_name)
 {
     rt_size_t i;
@@ -215,62 +330,19 @@ static void utest_run(const char *utest_name)
         LOG_I("[==========] [ utest    ] started");
         while(i < tc_num)
         {
-            if (utest_name)
+            if (!utest_name_match(tc_table[i].name, utest_name))
             {
-                int len = strlen(utest_name);
-                if (utest_name[len - 1] == '*')
-                {
-                    len -= 1;
-                }
-                if (rt_memcmp(tc_table[i].name, utest_name, len) != 0)
-                {
-                    i++;
-                    continue;
-                }
+                i++;
+                continue;
             }
             is_find = RT_TRUE;
 
-            LOG_I("[----------] [ testcase ] (%s) started", tc_table[i].name);
-            if (tc_table[i].init != RT_NULL)
+            if (utest_tc_run(&tc_table[i]))
             {
-                if (tc_table[i].init() != RT_EOK)
-                {
-                    LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc_table[i].name);
-                    goto __tc_continue;
-                }
+                TC_FAIL_LIST_MARK_FAILED(i);
+                tc_fail_num ++;
             }
 
-            if (tc_table[i].tc != RT_NULL)
-            {
-                tc_table[i].tc();
-                if (local_utest.failed_num == 0)
-                {
-                    LOG_I("[  PASSED  ] [ result   ] testcase (%s)", tc_table[i].name);
-                }
-                else
-                {
-                    TC_FAIL_LIST_MARK_FAILED(i);
-                    tc_fail_num ++;
-                    LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc_table[i].name);
-                }
-            }
-            else
-            {
-                LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc_table[i].name);
-            }
-
-            if (tc_table[i].cleanup != RT_NULL)
-            {
-                if (tc_table[i].cleanup() != RT_EOK)
-                {
-                    LOG_E("[  FAILED  ] [ result   ] testcase (%s)", tc_table[i].name);
-                    goto __tc_continue;
-                }
-            }
-
-    __tc_continue:
-            LOG_I("[----------] [ testcase ] (%s) finished", tc_table[i].name);
-
             tc_run_num ++;
             i++;
         }
@@ -300,6 +372,534 @@ static void utest_run(const char *utest_name)
     }
 }
 
+static struct rt_spinlock utest_par_lock;
+static struct rt_semaphore utest_par_done;
+static const char *utest_par_name;
+static rt_size_t utest_par_next;
+static rt_uint32_t utest_par_run_num;
+static rt_uint32_t utest_par_fail_num;
+
+static void utest_worker_entry(void *param)
+{
+    rt_base_t level;
+    rt_size_t i;
+    rt_bool_t failed;
+
+    for (;;)
+    {
+        /* take the next testcase */
+        level = rt_spin_lock_irqsave(&utest_par_lock);
+        while (utest_par_next < tc_num &&
+               !utest_name_match(tc_table[utest_par_next].name, utest_par_name))
+        {
+            utest_par_next ++;
+        }
+        i = utest_par_next;
+        if (i < tc_num)
+        {
+            utest_par_next ++;
+        }
+        rt_spin_unlock_irqrestore(&utest_par_lock, level);
+
+        if (i >= tc_num)
+        {
+            break;
+        }
+
+        failed = utest_tc_run(&tc_table[i]);
+
+        level = rt_spin_lock_irqsave(&utest_par_lock);
+        utest_par_run_num ++;
+        if (failed)
+        {
+            if (tc_fail_list)
+            {
+                TC_FAIL_LIST_MARK_FAILED(i);
+            }
+            utest_par_fail_num ++;
+        }
+        rt_spin_unlock_irqrestore(&utest_par_lock, level);
+    }
+
+    rt_sem_release(&utest_par_done);
+}
+
+/* run the testcases on worker threads, they must not depend on each other */
+static void utest_run_parallel(const char *utest_name, int jobs)
+{
+    struct utest_worker *workers;
+    char name[RT_NAME_MAX];
+    rt_size_t i;
+    int n;
+
+    if (utest_workers_num > 0)
+    {
+        LOG_E("[  error   ] a parallel run is in progress.");
+        return;
+    }
+
+    if (jobs < 1)
+    {
+        jobs = 1;
+    }
+    if (jobs > UTEST_WORKERS_MAX)
+    {
+        jobs = UTEST_WORKERS_MAX;
+    }
+
+    workers = (struct utest_worker *)rt_calloc(jobs, sizeof(struct utest_worker));
+    if (workers == RT_NULL)
+    {
+        LOG_E("[  error   ] no memory for %d workers.", jobs);
+        return;
+    }
+
+    rt_spin_lock_init(&utest_par_lock);
+    rt_sem_init(&utest_par_done, "utestpar", 0, RT_IPC_FLAG_PRIO);
+    utest_par_name = utest_name;
+    utest_par_next = 0;
+    utest_par_run_num = 0;
+    utest_par_fail_num = 0;
+    local_utest.failed_num = 0;
+    if (tc_fail_list)
+    {
+        rt_memset(tc_fail_list, 0, TC_FAIL_LIST_SIZE);
+    }
+
+    for (n = 0; n < jobs; n++)
+    {
+        rt_snprintf(name, sizeof(name), "utest%d", n);
+        workers[n].tid = rt_thread_create(name, utest_worker_entry, RT_NULL,
+                                          UTEST_THREAD_STACK_SIZE, UTEST_THREAD_PRIORITY, 10);
+        if (workers[n].tid == RT_NULL)
+        {
+            break;
+        }
+#ifdef RT_USING_SMP
+        rt_thread_control(workers[n].tid, RT_THREAD_CTRL_BIND_CPU, (void *)(rt_ubase_t)(n % RT_CPUS_NR));
+#endif
+    }
+    if (n == 0)
+    {
+        LOG_E("[  error   ] create the worker threads failed.");
+        rt_sem_detach(&utest_par_done);
+        rt_free(workers);
+        return;
+    }
+
+    /* the workers find their utest in it */
+    utest_workers = workers;
+    utest_workers_num = n;
+
+    LOG_I("[==========] [ utest    ] started on %d workers", n);
+    for (i = 0; i < n; i++)
+    {
+        rt_thread_startup(workers[i].tid);
+    }
+    for (i = 0; i < n; i++)
+    {
+        rt_sem_take(&utest_par_done, RT_WAITING_FOREVER);
+    }
+
+    utest_workers_num = 0;
+    utest_workers = RT_NULL;
+    rt_free(workers);
+    rt_sem_detach(&utest_par_done);
+
+    if (utest_par_run_num == 0 && utest_name != RT_NULL)
+    {
+        LOG_I("[==========] [ utest    ] Not find (%s)", utest_name);
+    }
+    LOG_I("[==========] [ utest    ] finished");
+    LOG_I("[==========] [ utest    ] %d tests from %d testcase ran.", utest_par_run_num, tc_num);
+    LOG_I("[  PASSED  ] [ result   ] %d tests.", utest_par_run_num - utest_par_fail_num);
+
+    if (tc_fail_list && (utest_par_fail_num > 0))
+    {
+        LOG_E("[  FAILED  ] [ result   ] %d tests, listed below:", utest_par_fail_num);
+        for (i = 0; i < tc_num; i ++)
+        {
+            if (TC_FAIL_LIST_IS_FAILED(i))
+            {
+                LOG_E("[  FAILED  ] [ result   ] %s", tc_table[i].name);
+            }
+        }
+    }
+    /* not known which testcase they belong to */
+    if (local_utest.failed_num > 0)
+    {
+        LOG_E("[  FAILED  ] [ result   ] %d asserts in threads of the test cases, run them without -j.",
+              local_utest.failed_num);
+    }
+}
+
+/* result of a benchmarked testcase, iters is 0 if it failed */
+struct utest_bench_result
+{
+    const char *name;
+    rt_uint32_t iters;
+    rt_uint32_t min_ns;
+    rt_uint32_t median_ns;
+    rt_uint32_t p99_ns;
+};
+
+static rt_uint64_t utest_bench_now(void)
+{
+#ifdef RT_USING_CPUTIME
+    return clock_cpu_gettime();
+#else
+    return rt_tick_get();
+#endif
+}
+
+/* elapsed time in ns, saturated to 32 bits */
+static rt_uint32_t utest_bench_ns(rt_uint64_t elapsed)
+{
+#ifdef RT_USING_CPUTIME
+    elapsed = elapsed * clock_cpu_getres() / 1000000;
+#else
+    elapsed = elapsed * (1000000000UL / RT_TICK_PER_SECOND);
+#endif
+
+    return elapsed > 0xFFFFFFFFUL ? 0xFFFFFFFFUL : (rt_uint32_t)elapsed;
+}
+
+static int utest_bench_cmp(const void *a, const void *b)
+{
+    rt_uint32_t x = *(const rt_uint32_t *)a;
+    rt_uint32_t y = *(const rt_uint32_t *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+/* run the testcase function warmup + iters times and time the last iters runs */
+static rt_err_t utest_bench_tc(utest_tc_export_t tc, rt_uint32_t iters, rt_uint32_t warmup,
+                               rt_uint32_t *samples, struct utest_bench_result *result)
+{
+    rt_uint64_t start;
+    rt_uint32_t k;
+    rt_err_t err = RT_EOK;
+
+    result->name = tc->name;
+    result->iters = 0;
+
+    if (tc->tc == RT_NULL)
+    {
+        return -RT_ERROR;
+    }
+    if (tc->init != RT_NULL && tc->init() != RT_EOK)
+    {
+        return -RT_ERROR;
+    }
+
+    utest_handle_get()->failed_num = 0;
+    for (k = 0; k < warmup + iters; k++)
+    {
+        start = utest_bench_now();
+        tc->tc();
+        if (k >= warmup)
+        {
+            samples[k - warmup] = utest_bench_ns(utest_bench_now() - start);
+        }
+        if (utest_handle_get()->failed_num != 0)
+        {
+            err = -RT_ERROR;
+            break;
+        }
+    }
+
+    if (tc->cleanup != RT_NULL && tc->cleanup() != RT_EOK)
+    {
+        err = -RT_ERROR;
+    }
+    if (err != RT_EOK)
+    {
+        return err;
+    }
+
+    qsort(samples, iters, sizeof(rt_uint32_t), utest_bench_cmp);
+    result->iters = iters;
+    result->min_ns = samples[0];
+    result->median_ns = samples[(iters - 1) / 2];
+    result->p99_ns = samples[(iters * 99 + 99) / 100 - 1];
+
+    return RT_EOK;
+}
+
+static void utest_bench_print(const struct utest_bench_result *results, rt_size_t num, const char *format)
+{
+    const struct utest_bench_result *r;
+    rt_size_t i;
+    int first = 1;
+
+    if (rt_strcmp(format, "csv") == 0)
+    {
+        rt_kprintf("name,iterations,min_ns,median_ns,p99_ns\n");
+    }
+    else if (rt_strcmp(format, "json") == 0)
+    {
+        rt_kprintf("[");
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        r = &results[i];
+        if (rt_strcmp(format, "csv") == 0)
+        {
+            if (r->iters > 0)
+            {
+                rt_kprintf("%s,%u,%u,%u,%u\n", r->name, r->iters, r->min_ns, r->median_ns, r->p99_ns);
+            }
+        }
+        else if (rt_strcmp(format, "json") == 0)
+        {
+            rt_kprintf("%s\n  {\"name\": \"%s\", \"passed\": %s, \"iterations\": %u, "
+                       "\"min_ns\": %u, \"median_ns\": %u, \"p99_ns\": %u}",
+                       first ? "" : ",", r->name, r->iters > 0 ? "true" : "false",
+                       r->iters, r->min_ns, r->median_ns, r->p99_ns);
+            first = 0;
+        }
+        else if (r->iters > 0)
+        {
+            LOG_I("[  BENCH   ] [ result   ] %s: %u runs, min %u ns, median %u ns, p99 %u ns",
+                  r->name, r->iters, r->min_ns, r->median_ns, r->p99_ns);
+        }
+        else
+        {
+            LOG_E("[  FAILED  ] [ result   ] testcase (%s)", r->name);
+        }
+    }
+
+    if (rt_strcmp(format, "json") == 0)
+    {
+        rt_kprintf("\n]\n");
+    }
+}
+
+#ifdef DFS_USING_POSIX
+/* save the results in the csv format of utest_bench -f csv */
+static void utest_bench_save(const char *path, const struct utest_bench_result *results, rt_size_t num)
+{
+    char line[UTEST_BENCH_LINE_SIZE];
+    rt_size_t i;
+    int fd, len;
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0);
+    if (fd < 0)
+    {
+        LOG_E("[  error   ] open %s failed.", path);
+        return;
+    }
+
+    len = rt_snprintf(line, sizeof(line), "name,iterations,min_ns,median_ns,p99_ns\n");
+    write(fd, line, len);
+    for (i = 0; i < num; i++)
+    {
+        if (results[i].iters > 0)
+        {
+            len = rt_snprintf(line, sizeof(line), "%s,%u,%u,%u,%u\n", results[i].name, results[i].iters,
+                              results[i].min_ns, results[i].median_ns, results[i].p99_ns);
+            write(fd, line, len);
+        }
+    }
+    close(fd);
+
+    LOG_I("[  BENCH   ] [ utest    ] results saved to %s", path);
+}
+
+/* flag the medians slower than the baseline ones by more than threshold percent */
+static void utest_bench_compare(const char *path, const struct utest_bench_result *results, rt_size_t num,
+                                rt_uint32_t threshold)
+{
+    char *buf, *line, *next, *field;
+    rt_uint32_t base, percent, regress_num = 0;
+    rt_size_t i;
+    off_t size;
+    int fd;
+
+    fd = open(path, O_RDONLY, 0);
+    if (fd < 0)
+    {
+        LOG_E("[  error   ] open %s failed.", path);
+        return;
+    }
+    size = lseek(fd, 0, SEEK_END);
+    lseek(fd, 0, SEEK_SET);
+    buf = (size > 0) ? (char *)rt_malloc(size + 1) : RT_NULL;
+    if (buf == RT_NULL || read(fd, buf, size) != size)
+    {
+        LOG_E("[  error   ] read %s failed.", path);
+        rt_free(buf);
+        close(fd);
+        return;
+    }
+    buf[size] = '\0';
+    close(fd);
+
+    for (line = buf; line != RT_NULL && *line != '\0'; line = next)
+    {
+        next = strchr(line, '\n');
+        if (next != RT_NULL)
+        {
+            *next++ = '\0';
+        }
+
+        /* name,iterations,min_ns,median_ns,p99_ns */
+        field = strchr(line, ',');
+        if (field == RT_NULL)
+        {
+            continue;
+        }
+        *field++ = '\0';
+        field = strchr(field, ',');
+        field = field ? strchr(field + 1, ',') : RT_NULL;
+        if (field == RT_NULL)
+        {
+            continue;
+        }
+        base = strtoul(field + 1, RT_NULL, 10);
+
+        for (i = 0; i < num; i++)
+        {
+            if (results[i].iters > 0 && rt_strcmp(results[i].name, line) == 0)
+            {
+                break;
+            }
+        }
+        if (i == num || base == 0)
+        {
+            continue;
+        }
+
+        percent = (rt_uint32_t)(((rt_uint64_t)results[i].median_ns * 100) / base);
+        if (results[i].median_ns > base && percent - 100 > threshold)
+        {
+            regress_num ++;
+            LOG_E("[ REGRESS  ] [ result   ] %s: median %u ns, baseline %u ns, +%u%%",
+                  results[i].name, results[i].median_ns, base, percent - 100);
+        }
+        else
+        {
+            LOG_I("[    OK    ] [ result   ] %s: median %u ns, baseline %u ns",
+                  results[i].name, results[i].median_ns, base);
+        }
+    }
+    rt_free(buf);
+
+    if (regress_num > 0)
+    {
+        LOG_E("[ REGRESS  ] [ result   ] %d tests slower than %s by more than %d%%.", regress_num, path, threshold);
+    }
+    else
+    {
+        LOG_I("[  PASSED  ] [ result   ] no regression against %s.", path);
+    }
+}
+#endif /* DFS_USING_POSIX */
+
+static void utest_bench(int argc, char **argv)
+{
+    rt_uint32_t iters = UTEST_BENCH_ITERS;
+    rt_uint32_t warmup = UTEST_BENCH_WARMUP;
+    rt_uint32_t threshold = UTEST_BENCH_THRESHOLD;
+    const char *format = "text";
+    const char *save_path = RT_NULL;
+    const char *base_path = RT_NULL;
+    const char *utest_name = RT_NULL;
+    struct utest_bench_result *results;
+    rt_uint32_t *samples;
+    rt_uint8_t log_lv = utest_log_lv;
+    rt_size_t i, num = 0;
+    int arg;
+
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (argv[arg][0] != '-')
+        {
+            utest_name = argv[arg];
+            continue;
+        }
+        if (arg + 1 == argc || argv[arg][2] != '\0')
+        {
+            utest_help();
+            return;
+        }
+        switch (argv[arg][1])
+        {
+        case 'n': iters = atoi(argv[++arg]); break;
+        case 'w': warmup = atoi(argv[++arg]); break;
+        case 'f': format = argv[++arg]; break;
+        case 'o': save_path = argv[++arg]; break;
+        case 'b': base_path = argv[++arg]; break;
+        case 't': threshold = atoi(argv[++arg]); break;
+        default:
+            utest_help();
+            return;
+        }
+    }
+    if (iters == 0)
+    {
+        LOG_E("[  error   ] at least one iteration.");
+        return;
+    }
+#ifndef DFS_USING_POSIX
+    if (save_path != RT_NULL || base_path != RT_NULL)
+    {
+        LOG_E("[  error   ] -o and -b need DFS_USING_POSIX.");
+        return;
+    }
+#endif
+
+    results = (struct utest_bench_result *)rt_calloc(tc_num, sizeof(struct utest_bench_result));
+    samples = (rt_uint32_t *)rt_malloc(iters * sizeof(rt_uint32_t));
+    if (results == RT_NULL || samples == RT_NULL)
+    {
+        LOG_E("[  error   ] no memory for %d iterations.", iters);
+        rt_free(results);
+        rt_free(samples);
+        return;
+    }
+
+#ifndef RT_USING_CPUTIME
+    LOG_W("[  BENCH   ] [ utest    ] no RT_USING_CPUTIME, the resolution is one tick.");
+#endif
+
+    /* the log of every passed assert would be timed too */
+    utest_log_lv = UTEST_LOG_ASSERT;
+    for (i = 0; i < tc_num; i++)
+    {
+        if (utest_name_match(tc_table[i].name, utest_name))
+        {
+            utest_bench_tc(&tc_table[i], iters, warmup, samples, &results[num++]);
+        }
+    }
+    utest_log_lv = log_lv;
+    rt_free(samples);
+
+    if (num == 0 && utest_name != RT_NULL)
+    {
+        LOG_I("[==========] [ utest    ] Not find (%s)", utest_name);
+    }
+    else
+    {
+        utest_bench_print(results, num, format);
+    }
+
+#ifdef DFS_USING_POSIX
+    if (save_path != RT_NULL)
+    {
+        utest_bench_save(save_path, results, num);
+    }
+    if (base_path != RT_NULL)
+    {
+        utest_bench_compare(base_path, results, num, threshold);
+    }
+#endif
+
+    rt_free(results);
+}
+MSH_CMD_EXPORT_ALIAS(utest_bench, utest_bench, utest_bench [-n iters] [-w warmup] [-f text|json|csv] [-o file] [-b file] [-t percent] [testcase name]);
+
 static void utest_testcase_run(int argc, char** argv)
 {
     void *thr_param = RT_NULL;
@@ -338,6 +938,14 @@ static void utest_testcase_run(int argc, char** argv)
         {
             utest_help();
         }
+        else if (rt_strcmp(argv[1], "-j") == 0 && argc >= 3)
+        {
+            if (argc == 4)
+            {
+                rt_strncpy(utest_name, argv[3], sizeof(utest_name) -1);
+            }
+            utest_run_parallel(argc == 4 ? utest_name : RT_NULL, atoi(argv[2]));
+        }
         else
         {
             rt_strncpy(utest_name, argv[1], sizeof(utest_name) -1);
@@ -351,19 +959,36 @@ static void utest_testcase_run(int argc, char** argv)
         utest_help();
     }
 }
-MSH_CMD_EXPORT_ALIAS(utest_testcase_run, utest_run, utest_run [-thread or -help] [testcase name] [loop num]);
+MSH_CMD_EXPORT_ALIAS(utest_testcase_run, utest_run, utest_run [-thread or -j jobs or -help] [testcase name] [loop num]);
 
 utest_t utest_handle_get(void)
 {
+    rt_thread_t self;
+    int i;
+
+    if (utest_workers_num > 0)
+    {
+        self = rt_thread_self();
+        for (i = 0; i < utest_workers_num; i++)
+        {
+            if (utest_workers[i].tid == self)
+            {
+                return &utest_workers[i].utest;
+            }
+        }
+    }
+
     return (utest_t)&local_utest;
 }
 
 void utest_unit_run(test_unit_func func, const char *unit_func_name)
 {
+    utest_t utest = utest_handle_get();
+
     // LOG_I("[==========] utest unit name: (%s)", unit_func_name);
-    local_utest.error = UTEST_PASSED;
-    local_utest.passed_num = 0;
-    local_utest.failed_num = 0;
+    utest->error = UTEST_PASSED;
+    utest->passed_num = 0;
+    utest->failed_num = 0;
 
     if (func != RT_NULL)
     {
@@ -373,10 +998,12 @@ void utest_unit_run(test_unit_func func, const char *unit_func_name)
 
 void utest_assert(int value, const char *file, int line, const char *func, const char *msg)
 {
+    utest_t utest = utest_handle_get();
+
     if (!(value))
     {
-        local_utest.error = UTEST_FAILED;
-        local_utest.failed_num ++;
+        utest->error = UTEST_FAILED;
+        utest->failed_num ++;
         LOG_E("[  ASSERT  ] [ unit     ] at (%s); func: (%s:%d); msg: (%s)", file_basename(file), func, line, msg);
     }
     else
@@ -385,8 +1012,8 @@ void utest_assert(int value, const char *file, int line, const char *func, const
         {
             LOG_D("[    OK    ] [ unit     ] (%s:%d) is passed", func, line);
         }
-        local_utest.error = UTEST_PASSED;
-        local_utest.passed_num ++;
+        utest->error = UTEST_PASSED;
+        utest->passed_num ++;
     }
 }
 
@@ -6,6 +6,8 @@
  * Change Logs:
  * Date           Author       Notes
  * 2018-11-19     MurphyZhao   the first version
+ * 2026-10-17     RT-Thread    name the export after the testcase function
+ * 2026-10-17     RT-Thread    document the handle of a parallel run
  */
 
 #ifndef __UTEST_H__
@@ -104,7 +106,9 @@ void utest_unit_run(test_unit_func func, const char *unit_func_name);
  * utest_handle_get
  *
  * @brief Get the utest data structure handle.
- *        No need for the user to call this function directly
+ *        No need for the user to call this function directly.
+ *        In a parallel run it is the one of the calling worker thread,
+ *        the threads a testcase creates share the one of the whole run.
  *
  * @param void
  *
@@ -127,7 +131,7 @@ utest_t utest_handle_get(void);
  * @brief Export testcase function to `UtestTcTab` section in flash.
  *        Used in application layer.
  *
- * @param testcase The testcase function.
+ * @param testcase The testcase function, one file may export several testcases.
  * @param name     The testcase name.
  * @param init     The initialization function of the test case.
  * @param cleanup  The cleanup function of the test case.
@@ -140,7 +144,7 @@ utest_t utest_handle_get(void);
 #pragma section("UtestTcTab$f",read)
 #define UTEST_TC_EXPORT(testcase, name, init, cleanup, timeout)                \
     __declspec(allocate("UtestTcTab$f"))                                       \
-    static const struct utest_tc_export _utest_testcase =                      \
+    static const struct utest_tc_export _utest_tc_##testcase =                 \
     {                                                                          \
         name,                                                                  \
         timeout,                                                               \
@@ -151,7 +155,7 @@ utest_t utest_handle_get(void);
 #pragma comment(linker, "/merge:UtestTcTab=tctext")
 #else
 #define UTEST_TC_EXPORT(testcase, name, init, cleanup, timeout)                \
-    rt_used static const struct utest_tc_export _utest_testcase                \
+    rt_used static const struct utest_tc_export _utest_tc_##testcase           \
     rt_section("UtestTcTab") =                                                 \
     {                                                                          \
         name,                                                                  \
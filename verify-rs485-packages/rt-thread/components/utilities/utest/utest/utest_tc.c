@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "utest.h"
+
+/*
+ * The result the asserts are counted in. The asserts of a testcase go to
+ * the same result for the whole testcase, the asserts of a thread the
+ * testcase creates go to the one that thread finds: the same one in a
+ * serial run, the one shared by the whole run with utest_run -j. Run it
+ * both ways:
+ *
+ *     utest_run testcases.utilities.utest.runner
+ *     utest_run -j 4 testcases.utilities.utest.*
+ */
+
+#define UTEST_TC_ASSERTS        8
+#define UTEST_TC_STACK_SIZE     2048
+
+static struct rt_semaphore child_done;
+static utest_t child_handle;
+static rt_uint32_t child_passed;
+static rt_uint32_t child_failed;
+
+static rt_err_t utest_tc_init(void)
+{
+    return rt_sem_init(&child_done, "utest_tc", 0, RT_IPC_FLAG_PRIO);
+}
+
+static rt_err_t utest_tc_cleanup(void)
+{
+    return rt_sem_detach(&child_done);
+}
+
+static void runner_handle(void)
+{
+    utest_t utest = utest_handle_get();
+    rt_uint32_t passed = utest->passed_num;
+    int i;
+
+    for (i = 0; i < UTEST_TC_ASSERTS; i++)
+    {
+        uassert_true(RT_TRUE);
+    }
+
+    uassert_true(utest_handle_get() == utest);
+    uassert_int_equal(utest->passed_num - passed, UTEST_TC_ASSERTS + 1);
+    uassert_int_equal(utest->failed_num, 0);
+}
+
+static void runner_child_entry(void *param)
+{
+    rt_uint32_t passed, failed;
+
+    child_handle = utest_handle_get();
+    passed = child_handle->passed_num;
+    failed = child_handle->failed_num;
+    uassert_true(RT_TRUE);
+    child_passed = child_handle->passed_num - passed;
+    child_failed = child_handle->failed_num - failed;
+
+    rt_sem_release(&child_done);
+}
+
+static void runner_thread(void)
+{
+    utest_t utest = utest_handle_get();
+    rt_uint32_t passed = utest->passed_num;
+    rt_thread_t tid;
+    rt_err_t err;
+
+    child_handle = RT_NULL;
+    tid = rt_thread_create("utest_tc", runner_child_entry, RT_NULL, UTEST_TC_STACK_SIZE,
+                           RT_THREAD_PRIORITY_MAX - 2, 10);
+    uassert_not_null(tid);
+    if (tid == RT_NULL)
+    {
+        return;
+    }
+    rt_thread_startup(tid);
+    err = rt_sem_take(&child_done, RT_TICK_PER_SECOND);
+    /* the assert on tid and the one of the child if it shares the result */
+    passed = utest->passed_num - passed;
+    uassert_int_equal(err, RT_EOK);
+
+    /* the assert of the child is in the result it found */
+    uassert_not_null(child_handle);
+    uassert_int_equal(child_passed, 1);
+    uassert_int_equal(child_failed, 0);
+    if (child_handle == utest)
+    {
+        uassert_int_equal(passed, 2);
+    }
+    else
+    {
+        /* a worker of a parallel run */
+        uassert_int_equal(passed, 1);
+    }
+}
+
+static void testcase(void)
+{
+    UTEST_UNIT_RUN(runner_handle);
+    UTEST_UNIT_RUN(runner_thread);
+}
+UTEST_TC_EXPORT(testcase, "testcases.utilities.utest.runner", utest_tc_init, utest_tc_cleanup, 10);
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include <var_export.h>
+#include "utest.h"
+
+/*
+ * Lookups of the VE_TC_VARS values this file exports into module ve_tc,
+ * named idGK with the value G * 10 + K. The index testcase checks that
+ * every one is found by var_export_find() and through ve_module_init(),
+ * and that a missing one is not. Every run of the find testcase looks up
+ * VE_TC_LOOKUPS pseudo random names with var_export_find(), the module
+ * testcase looks up the module by ve_module_init() as often. Time them
+ * with:
+ *
+ *     utest_bench -n 20 testcases.utilities.var_export.*
+ */
+
+#define VE_TC_GROUPS        8
+#define VE_TC_VARS          (VE_TC_GROUPS * 8)
+#define VE_TC_LOOKUPS       1024
+
+#define VE_TC_EXPORT8(g)                \
+    VAR_EXPORT(ve_tc, id##g##0, g##0);  \
+    VAR_EXPORT(ve_tc, id##g##1, g##1);  \
+    VAR_EXPORT(ve_tc, id##g##2, g##2);  \
+    VAR_EXPORT(ve_tc, id##g##3, g##3);  \
+    VAR_EXPORT(ve_tc, id##g##4, g##4);  \
+    VAR_EXPORT(ve_tc, id##g##5, g##5);  \
+    VAR_EXPORT(ve_tc, id##g##6, g##6);  \
+    VAR_EXPORT(ve_tc, id##g##7, g##7)
+
+/* a leading 0 makes group 0 octal, the same values */
+VE_TC_EXPORT8(0);
+VE_TC_EXPORT8(1);
+VE_TC_EXPORT8(2);
+VE_TC_EXPORT8(3);
+VE_TC_EXPORT8(4);
+VE_TC_EXPORT8(5);
+VE_TC_EXPORT8(6);
+VE_TC_EXPORT8(7);
+
+static char names[VE_TC_VARS][8];
+static rt_uint32_t seed;
+
+static rt_err_t ve_tc_init(void)
+{
+    int i;
+
+    for (i = 0; i < VE_TC_VARS; i++)
+    {
+        rt_snprintf(names[i], sizeof(names[i]), "id%d%d", i / 8, i % 8);
+    }
+    seed = 1;
+
+    return RT_EOK;
+}
+
+static void ve_index(void)
+{
+    const ve_exporter_t *exporter;
+    ve_module_t mod;
+    int i, bad = 0;
+
+    uassert_int_equal(ve_module_init(&mod, "ve_tc"), RT_EOK);
+    uassert_true(ve_value_count(&mod) >= VE_TC_VARS);
+
+    for (i = 0; i < VE_TC_VARS; i++)
+    {
+        exporter = var_export_find("ve_tc", names[i]);
+        if (exporter == RT_NULL || exporter->value != (i / 8) * 10 + i % 8)
+        {
+            bad ++;
+        }
+        if (ve_value_get(&mod, names[i]) != (i / 8) * 10 + i % 8)
+        {
+            bad ++;
+        }
+    }
+    uassert_int_equal(bad, 0);
+
+    uassert_null(var_export_find("ve_tc", "id80"));
+    uassert_null(var_export_find("ve_tc_none", "id00"));
+    uassert_int_equal(ve_module_init(&mod, "ve_tc_none"), -RT_ERROR);
+}
+
+static void ve_find(void)
+{
+    const ve_exporter_t *exporter;
+    int i, n, bad = 0;
+
+    for (i = 0; i < VE_TC_LOOKUPS; i++)
+    {
+        seed = seed * 1103515245 + 12345;
+        n = (seed >> 8) % VE_TC_VARS;
+        exporter = var_export_find("ve_tc", names[n]);
+        if (exporter == RT_NULL || exporter->value != (n / 8) * 10 + n % 8)
+        {
+            bad ++;
+        }
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void ve_module(void)
+{
+    ve_module_t mod;
+    int i, bad = 0;
+
+    for (i = 0; i < VE_TC_LOOKUPS; i++)
+    {
+        if (ve_module_init(&mod, "ve_tc") != RT_EOK)
+        {
+            bad ++;
+        }
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase_index(void)
+{
+    UTEST_UNIT_RUN(ve_index);
+}
+UTEST_TC_EXPORT(testcase_index, "testcases.utilities.var_export.index", ve_tc_init, RT_NULL, 10);
+
+static void testcase_find(void)
+{
+    UTEST_UNIT_RUN(ve_find);
+}
+UTEST_TC_EXPORT(testcase_find, "testcases.utilities.var_export.find", ve_tc_init, RT_NULL, 10);
+
+static void testcase_module(void)
+{
+    UTEST_UNIT_RUN(ve_module);
+}
+UTEST_TC_EXPORT(testcase_module, "testcases.utilities.var_export.module", ve_tc_init, RT_NULL, 10);
@@ -7,6 +7,8 @@
  * Date           Author       Notes
  * 2021-06-04     WillianChan  first version
  * 2021-06-08     WillianChan  support to MS VC++ compiler
+ * 2026-10-17     RT-Thread    heap sort without rt_snprintf, hash index for lookups
+ * 2026-10-17     RT-Thread    scan the table in link order unless it was sorted
  */
 
 #include <var_export.h>
@@ -14,6 +16,55 @@
 static const ve_exporter_t *ve_exporter_table = RT_NULL;
 static rt_size_t ve_exporter_num = 0;
 
+/* open addressing index of the table, slot holds index + 1, 0 is empty */
+static rt_uint16_t *ve_hash_table = RT_NULL;
+static rt_size_t ve_hash_mask = 0;
+
+/* order of the table: module, then identifier */
+static int ve_exporter_cmp(const ve_exporter_t *a, const ve_exporter_t *b)
+{
+    int result = rt_strcmp(a->module, b->module);
+
+    return result ? result : rt_strcmp(a->identifier, b->identifier);
+}
+
+static rt_uint32_t ve_hash(const char *module, const char *identifier)
+{
+    rt_uint32_t hash = 2166136261u;     /* FNV-1a */
+
+    while (*module)
+        hash = (hash ^ (rt_uint8_t)*module++) * 16777619u;
+    hash = (hash ^ '.') * 16777619u;
+    while (*identifier)
+        hash = (hash ^ (rt_uint8_t)*identifier++) * 16777619u;
+
+    return hash;
+}
+
+static void ve_hash_init(void)
+{
+    rt_size_t size, index, slot;
+
+    if (ve_exporter_num == 0 || ve_exporter_num >= 0xFFFF)
+        return;
+
+    /* at most half full */
+    for (size = 4; size < ve_exporter_num * 2; size <<= 1);
+
+    ve_hash_table = (rt_uint16_t *)rt_calloc(size, sizeof(rt_uint16_t));
+    if (ve_hash_table == RT_NULL)
+        return;     /* lookups fall back to the binary search */
+    ve_hash_mask = size - 1;
+
+    for (index = 0; index < ve_exporter_num; index++)
+    {
+        slot = ve_hash(ve_exporter_table[index].module, ve_exporter_table[index].identifier) & ve_hash_mask;
+        while (ve_hash_table[slot] != 0)
+            slot = (slot + 1) & ve_hash_mask;
+        ve_hash_table[slot] = (rt_uint16_t)(index + 1);
+    }
+}
+
 /* for IAR compiler */
 #if defined(__ICCARM__) || defined(__ICCRX__)
 #pragma section="VarExpTab"
@@ -80,10 +131,8 @@ int var_export_init(void)
     unsigned int *ptr_begin = (unsigned int *)&__ve_table_start;
     unsigned int *ptr_end = (unsigned int *)&__ve_table_end;
     static ve_exporter_t ve_exporter_tab[2048];
-    static char __vexp_strbuf1[1024];
-    static char __vexp_strbuf2[1024];
     ve_exporter_t ve_exporter_temp;
-    rt_size_t index_i, index_j;
+    rt_size_t index_i, root, child, count;
 
     /* past the three members in first ptr_begin */
     ptr_begin += (sizeof(struct ve_exporter) / sizeof(unsigned int));
@@ -96,34 +145,42 @@ int var_export_init(void)
     /* check if the ve_exporter_num is out of bounds */
     RT_ASSERT(ve_exporter_num < (sizeof(ve_exporter_tab) / sizeof(ve_exporter_t)));
 
-    /* bubble sort algorithms */
-    for (index_i = 0; index_i < (ve_exporter_num - 1); index_i++)
+    /* heap sort algorithms, the other compilers keep the table in link order */
+    for (index_i = ve_exporter_num + ve_exporter_num / 2; index_i > 0; index_i--)
     {
-        for (index_j = 0; index_j < ((ve_exporter_num - 1) - index_i); index_j++)
+        /* build the heap for the first half of the rounds, then pop it */
+        if (index_i > ve_exporter_num)
         {
-            /* splice ve_exporter's module and ve_exporter's identifier into a complete string */
-            rt_snprintf(__vexp_strbuf1,
-                        sizeof(__vexp_strbuf1),
-                        "%s%s",
-                        ve_exporter_tab[index_j].module,
-                        ve_exporter_tab[index_j].identifier);
-            rt_snprintf(__vexp_strbuf2,
-                        sizeof(__vexp_strbuf2),
-                        "%s%s",
-                        ve_exporter_tab[index_j + 1].module,
-                        ve_exporter_tab[index_j + 1].identifier);
-            if (rt_strcmp(__vexp_strbuf1, __vexp_strbuf2) > 0)
-            {
-                ve_exporter_temp = ve_exporter_tab[index_j];
-                ve_exporter_tab[index_j] = ve_exporter_tab[index_j + 1];
-                ve_exporter_tab[index_j + 1] = ve_exporter_temp;
-            }
+            root = index_i - ve_exporter_num - 1;
+            count = ve_exporter_num;
         }
+        else
+        {
+            count = index_i - 1;
+            ve_exporter_temp = ve_exporter_tab[0];
+            ve_exporter_tab[0] = ve_exporter_tab[count];
+            ve_exporter_tab[count] = ve_exporter_temp;
+            root = 0;
+        }
+
+        ve_exporter_temp = ve_exporter_tab[root];
+        while ((child = root * 2 + 1) < count)
+        {
+            if (child + 1 < count && ve_exporter_cmp(&ve_exporter_tab[child + 1], &ve_exporter_tab[child]) > 0)
+                child++;
+            if (ve_exporter_cmp(&ve_exporter_tab[child], &ve_exporter_temp) <= 0)
+                break;
+            ve_exporter_tab[root] = ve_exporter_tab[child];
+            root = child;
+        }
+        ve_exporter_tab[root] = ve_exporter_temp;
     }
 
     ve_exporter_table = ve_exporter_tab;
 #endif /* __ARMCC_VERSION */
 
+    ve_hash_init();
+
     return ve_exporter_num;
 }
 INIT_BOARD_EXPORT(var_export_init);
@@ -131,10 +188,43 @@ INIT_BOARD_EXPORT(var_export_init);
 /* initialize module */
 int ve_module_init(ve_module_t *mod, const char *module)
 {
+#if defined(_MSC_VER)
+    rt_size_t low, high, mid;
+
+    /* the first exporter of the module */
+    low = 0;
+    high = ve_exporter_num;
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (rt_strcmp(ve_exporter_table[mid].module, module) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    if (low == ve_exporter_num || rt_strcmp(ve_exporter_table[low].module, module))
+    {
+        return -RT_ERROR;
+    }
+    mod->begin = &ve_exporter_table[low];
+
+    /* the last one */
+    high = ve_exporter_num;
+    while (low < high)
+    {
+        mid = (low + high) / 2;
+        if (rt_strcmp(ve_exporter_table[mid].module, module) <= 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    mod->end = &ve_exporter_table[low - 1];
+#else
     const ve_exporter_t *exporter = ve_exporter_table;
     rt_bool_t first_exist = RT_FALSE;
     rt_size_t found_index;
 
+    /* the table is in link order, not sorted */
     for (found_index = 0; found_index < ve_exporter_num; found_index++)
     {
         if (!rt_strcmp(exporter->module, module))
@@ -153,10 +243,63 @@ int ve_module_init(ve_module_t *mod, const char *module)
     {
         return -RT_ERROR;
     }
+#endif /* _MSC_VER */
 
     return RT_EOK;
 }
 
+/* find an exporter by module and identifier */
+const ve_exporter_t *var_export_find(const char *module, const char *identifier)
+{
+    const ve_exporter_t *exporter;
+    ve_module_t mod;
+    rt_size_t slot;
+
+    if (ve_hash_table == RT_NULL)
+    {
+        if (ve_module_init(&mod, module) != RT_EOK)
+            return RT_NULL;
+#if defined(_MSC_VER)
+        return ve_binary_search(&mod, identifier);
+#else
+        for (exporter = mod.begin; exporter <= mod.end; exporter++)
+        {
+            if (!rt_strcmp(exporter->identifier, identifier) && !rt_strcmp(exporter->module, module))
+                return exporter;
+        }
+        return RT_NULL;
+#endif
+    }
+
+    slot = ve_hash(module, identifier) & ve_hash_mask;
+    while (ve_hash_table[slot] != 0)
+    {
+        exporter = &ve_exporter_table[ve_hash_table[slot] - 1];
+        if (!rt_strcmp(exporter->identifier, identifier) && !rt_strcmp(exporter->module, module))
+        {
+            return exporter;
+        }
+        slot = (slot + 1) & ve_hash_mask;
+    }
+
+    return RT_NULL;
+}
+
+/* get the value by module and identifier, resolve it only once into *cache */
+rt_base_t ve_value_get_cached(const ve_exporter_t **cache, const char *module, const char *identifier)
+{
+    if (*cache == RT_NULL)
+    {
+        *cache = var_export_find(module, identifier);
+        if (*cache == RT_NULL)
+        {
+            return VE_NOT_FOUND;
+        }
+    }
+
+    return (*cache)->value;
+}
+
 /* initialize iterator */
 void ve_iter_init(ve_module_t *mod, ve_iterator_t *iter)
 {
@@ -213,7 +356,7 @@ const ve_exporter_t *ve_binary_search(ve_module_t *mod, const char *identifier)
 /* get the value by identifier */
 rt_base_t ve_value_get(ve_module_t *mod, const char *identifier)
 {
-    const ve_exporter_t *exporter = ve_binary_search(mod, identifier);
+    const ve_exporter_t *exporter = var_export_find(mod->begin->module, identifier);
 
     if (exporter)
     {
@@ -228,7 +371,7 @@ rt_base_t ve_value_get(ve_module_t *mod, const char *identifier)
 /* check if this value exists in the module*/
 rt_bool_t ve_value_exist(ve_module_t *mod, const char *identifier)
 {
-    if (ve_binary_search(mod, identifier))
+    if (var_export_find(mod->begin->module, identifier))
     {
         return RT_TRUE;
     }
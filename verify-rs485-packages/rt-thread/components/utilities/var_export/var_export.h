@@ -7,6 +7,7 @@
  * Date           Author       Notes
  * 2021-06-04     WillianChan  first version
  * 2021-06-08     WillianChan  support to MS VC++ compiler
+ * 2026-10-17     RT-Thread    add var_export_find and ve_value_get_cached
  */
 
 #ifndef _VAR_EXPORT_H__
@@ -92,5 +93,9 @@ rt_base_t ve_value_get(ve_module_t *mod, const char *identifier);
 rt_bool_t ve_value_exist(ve_module_t *mod, const char *identifier);
 rt_size_t ve_value_count(ve_module_t *mod);
 const ve_exporter_t *ve_binary_search(ve_module_t *mod, const char *identifier);
+/* find an exporter by module and identifier */
+const ve_exporter_t *var_export_find(const char *module, const char *identifier);
+/* get the value by module and identifier, *cache (a static pointer at the call site) keeps the exporter */
+rt_base_t ve_value_get_cached(const ve_exporter_t **cache, const char *module, const char *identifier);
 
 #endif /* _VAR_EXPORT_H__ */
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+#ifndef __VBUS_HW_H__
+#define __VBUS_HW_H__
+
+#include <rtthread.h>
+
+/* VBus hardware layer of the posix simulator, the rings are in a POSIX shared
+ * memory object shared by two simulator processes. */
+
+#ifndef RT_VBUS_GUEST_VIRQ
+#define RT_VBUS_GUEST_VIRQ  0
+#endif
+#ifndef RT_VBUS_HOST_VIRQ
+#define RT_VBUS_HOST_VIRQ   0
+#endif
+
+/* Map the shared memory and start VBus on it. */
+int rt_vbus_sim_init(void);
+
+/* Ring the doorbell of the other process. */
+void rt_vbus_sim_notify(void);
+
+rt_inline void rt_vbus_tick(unsigned int target_cpu, unsigned int irqnr)
+{
+    rt_vbus_sim_notify();
+}
+
+/* Read memory barrier. */
+rt_inline void rt_vbus_smp_rmb(void)
+{
+    __sync_synchronize();
+}
+
+/* Write memory barrier. */
+rt_inline void rt_vbus_smp_wmb(void)
+{
+    __sync_synchronize();
+}
+
+/* General memory barrier. */
+rt_inline void rt_vbus_smp_mb(void)
+{
+    __sync_synchronize();
+}
+
+#endif /* end of include guard: __VBUS_HW_H__ */
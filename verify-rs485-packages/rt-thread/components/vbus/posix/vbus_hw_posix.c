@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2006-2023, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+/*
+ * VBus hardware layer of the posix simulator. Two simulator processes share
+ * the rings through the POSIX shared memory object RT_VBUS_SIM_SHM_NAME, the
+ * first one started is side 0, the other one side 1. The out ring of one side
+ * is the in ring of the other.
+ *
+ * The interrupt from the other side is a process shared semaphore, waited by a
+ * native thread which runs rt_vbus_isr. Like an eventfd, the doorbell is only
+ * posted once until the waiting side takes it.
+ *
+ * The object is removed when both sides exit. After a crash remove it from
+ * /dev/shm by hand.
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "vbus.h"
+#include "vbus_hw.h"
+
+#ifndef RT_VBUS_SIM_SHM_NAME
+#define RT_VBUS_SIM_SHM_NAME    "/rtvbus"
+#endif
+
+#define VBUS_SIM_MAGIC          0x56425553  /* "VBUS" */
+
+struct vbus_sim_shm
+{
+    volatile unsigned int magic;
+    /* processes attached */
+    volatile unsigned int users;
+    /* processes done with rt_vbus_init */
+    volatile unsigned int ready;
+    /* doorbell of each side rung and not taken yet */
+    volatile unsigned int pending[2];
+    sem_t bell[2];
+    struct rt_vbus_ring ring[2];
+};
+
+static struct vbus_sim_shm *_shm;
+static int _side;
+static pthread_t _irq_thread;
+
+void rt_vbus_sim_notify(void)
+{
+    if (__sync_lock_test_and_set(&_shm->pending[!_side], 1) == 0)
+        sem_post(&_shm->bell[!_side]);
+}
+
+int rt_vbus_hw_eoi(int irqnr, void *param)
+{
+    return 0;
+}
+
+/* stands in for the interrupt from the other side */
+static void *_vbus_sim_irq_entry(void *param)
+{
+    sigset_t sigmask;
+
+    /* the signals are for the simulator threads */
+    sigfillset(&sigmask);
+    pthread_sigmask(SIG_BLOCK, &sigmask, RT_NULL);
+
+    for (;;)
+    {
+        if (sem_wait(&_shm->bell[_side]) != 0)
+            continue;
+
+        /* a doorbell rung from now on needs another run */
+        __sync_lock_release(&_shm->pending[_side]);
+
+        rt_interrupt_enter();
+        rt_vbus_isr(RT_VBUS_HOST_VIRQ, RT_NULL);
+        rt_interrupt_leave();
+    }
+
+    return RT_NULL;
+}
+
+int rt_vbus_hw_init(void)
+{
+    /* rt_vbus_init resets both rings, no side posts before the other one
+     * has done it */
+    __sync_fetch_and_add(&_shm->ready, 1);
+    while (_shm->ready < 2)
+        rt_thread_mdelay(10);
+
+    if (pthread_create(&_irq_thread, RT_NULL, _vbus_sim_irq_entry, RT_NULL) != 0)
+    {
+        rt_kprintf("vbus: create the interrupt thread failed\n");
+        return -RT_ERROR;
+    }
+
+    return 0;
+}
+
+static void _vbus_sim_detach(void)
+{
+    if (__sync_sub_and_fetch(&_shm->users, 1) == 0)
+        shm_unlink(RT_VBUS_SIM_SHM_NAME);
+}
+
+int rt_vbus_sim_init(void)
+{
+    struct stat st;
+    void *addr;
+    int fd, created = 1;
+
+    fd = shm_open(RT_VBUS_SIM_SHM_NAME, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0)
+    {
+        created = 0;
+        fd = shm_open(RT_VBUS_SIM_SHM_NAME, O_RDWR, 0600);
+    }
+    if (fd < 0)
+    {
+        rt_kprintf("vbus: open %s failed\n", RT_VBUS_SIM_SHM_NAME);
+        return -RT_ERROR;
+    }
+
+    if (created)
+    {
+        if (ftruncate(fd, sizeof(struct vbus_sim_shm)) != 0)
+        {
+            rt_kprintf("vbus: resize %s failed\n", RT_VBUS_SIM_SHM_NAME);
+            close(fd);
+            shm_unlink(RT_VBUS_SIM_SHM_NAME);
+            return -RT_ERROR;
+        }
+    }
+    else
+    {
+        /* the creator is still resizing it */
+        while (fstat(fd, &st) == 0 && st.st_size < (off_t)sizeof(struct vbus_sim_shm))
+            rt_thread_mdelay(1);
+    }
+
+    addr = mmap(RT_NULL, sizeof(struct vbus_sim_shm), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        rt_kprintf("vbus: map %s failed\n", RT_VBUS_SIM_SHM_NAME);
+        if (created)
+            shm_unlink(RT_VBUS_SIM_SHM_NAME);
+        return -RT_ERROR;
+    }
+    _shm = (struct vbus_sim_shm *)addr;
+
+    if (created)
+    {
+        sem_init(&_shm->bell[0], 1, 0);
+        sem_init(&_shm->bell[1], 1, 0);
+        _shm->users = 1;
+        __sync_synchronize();
+        _shm->magic = VBUS_SIM_MAGIC;
+        _side = 0;
+    }
+    else
+    {
+        while (_shm->magic != VBUS_SIM_MAGIC)
+            rt_thread_mdelay(1);
+
+        if (__sync_fetch_and_add(&_shm->users, 1) != 1)
+        {
+            rt_kprintf("vbus: %s is in use or stale\n", RT_VBUS_SIM_SHM_NAME);
+            munmap(addr, sizeof(struct vbus_sim_shm));
+            _shm = RT_NULL;
+            return -RT_EBUSY;
+        }
+        _side = 1;
+    }
+    atexit(_vbus_sim_detach);
+
+    rt_kprintf("vbus: side %d of %s, waiting for the other side\n",
+               _side, RT_VBUS_SIM_SHM_NAME);
+
+    return rt_vbus_init(&_shm->ring[_side], &_shm->ring[!_side]);
+}
+INIT_COMPONENT_EXPORT(rt_vbus_sim_init);
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2006-2026, RT-Thread Development Team
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Change Logs:
+ * Date           Author       Notes
+ * 2026-10-17     RT-Thread    the first version
+ */
+
+#include <rtthread.h>
+#include "vbus.h"
+#include "utest.h"
+
+/*
+ * VBus between two simulator processes over the shared memory transport.
+ * Start the echo service in one of them with the vbus_tc_echo command, it
+ * sends back whatever arrives on channel VBUS_TC_NAME. The testcases run
+ * in the other one:
+ *
+ *   - tput_hi and tput_lo post VBUS_TC_BYTES in VBUS_TC_POST byte posts at
+ *     a high and a low priority and check every byte of the echo.
+ *   - latency makes VBUS_TC_PINGS round trips of VBUS_TC_PING bytes.
+ *
+ * Time them with:
+ *
+ *     utest_bench -n 20 testcases.vbus.sim.*
+ */
+
+#define VBUS_TC_NAME        "vbtc"
+#define VBUS_TC_BYTES       (64 * 1024)
+#define VBUS_TC_POST        4096
+#define VBUS_TC_PINGS       256
+#define VBUS_TC_PING        64
+#define VBUS_TC_PRIO_HI     1
+#define VBUS_TC_PRIO_LO     30
+#define VBUS_TC_ECHO_PRIO   1
+#define VBUS_TC_STACK_SIZE  2048
+
+static struct rt_vbus_request client_req =
+{
+    VBUS_TC_PRIO_HI, VBUS_TC_NAME, 0, {32, 64}, {32, 64},
+};
+static int chnr = -1;
+static rt_uint8_t pattern[VBUS_TC_POST];
+
+/* the echo service */
+
+static struct rt_vbus_request echo_req =
+{
+    VBUS_TC_ECHO_PRIO, VBUS_TC_NAME, 1, {32, 64}, {32, 64},
+};
+static struct rt_semaphore echo_tx_sem;
+static rt_thread_t echo_tid;
+
+static void vbus_tc_echo_tx(void *ctx)
+{
+    rt_sem_release(&echo_tx_sem);
+}
+
+static void vbus_tc_echo_entry(void *param)
+{
+    struct rt_vbus_data *act;
+    int echo_chnr;
+
+    while (1)
+    {
+        echo_chnr = rt_vbus_request_chn(&echo_req, RT_WAITING_FOREVER);
+        if (echo_chnr < 0)
+        {
+            rt_thread_mdelay(100);
+            continue;
+        }
+        rt_vbus_register_listener(echo_chnr, RT_VBUS_EVENT_ID_TX, vbus_tc_echo_tx, RT_NULL);
+
+        /* until the other side closes the channel */
+        while (rt_vbus_listen_on(echo_chnr, RT_WAITING_FOREVER) == RT_EOK)
+        {
+            while ((act = rt_vbus_data_pop(echo_chnr)) != RT_NULL)
+            {
+                /* the data must stay until it is written into the ring */
+                if (rt_vbus_post(echo_chnr, VBUS_TC_ECHO_PRIO, act + 1, act->size, RT_WAITING_FOREVER) == RT_EOK)
+                    rt_sem_take(&echo_tx_sem, RT_WAITING_FOREVER);
+                rt_free(act);
+            }
+        }
+        rt_vbus_close_chn(echo_chnr);
+    }
+}
+
+static int vbus_tc_echo(int argc, char **argv)
+{
+    if (echo_tid != RT_NULL)
+    {
+        rt_kprintf("vbus_tc_echo: already running\n");
+        return 0;
+    }
+
+    rt_sem_init(&echo_tx_sem, "vbtc_tx", 0, RT_IPC_FLAG_FIFO);
+    echo_tid = rt_thread_create("vbtc_echo", vbus_tc_echo_entry, RT_NULL, VBUS_TC_STACK_SIZE,
+                                RT_THREAD_PRIORITY_MAX / 2, 10);
+    if (echo_tid == RT_NULL)
+    {
+        rt_sem_detach(&echo_tx_sem);
+        return -RT_ENOMEM;
+    }
+    rt_thread_startup(echo_tid);
+
+    return 0;
+}
+MSH_CMD_EXPORT(vbus_tc_echo, start the echo service of the vbus testcases);
+
+/* the testcases */
+
+static rt_err_t vbus_tc_init(void)
+{
+    rt_size_t i;
+
+    for (i = 0; i < VBUS_TC_POST; i++)
+    {
+        pattern[i] = (rt_uint8_t)(i * 7 + 1);
+    }
+
+    /* there is no echo service if nobody answers in a second */
+    chnr = rt_vbus_request_chn(&client_req, RT_TICK_PER_SECOND);
+    if (chnr < 0)
+    {
+        LOG_E("no answer on %s, start vbus_tc_echo on the other side", VBUS_TC_NAME);
+        return -RT_ERROR;
+    }
+
+    return RT_EOK;
+}
+
+static rt_err_t vbus_tc_cleanup(void)
+{
+    rt_vbus_close_chn(chnr);
+    chnr = -1;
+
+    return RT_EOK;
+}
+
+/* receive size bytes of the echo, return the bytes that are not the pattern */
+static int vbus_tc_recv(rt_size_t size)
+{
+    struct rt_vbus_data *act;
+    rt_uint8_t *data;
+    rt_size_t got = 0, i;
+    int bad = 0;
+
+    while (got < size)
+    {
+        act = rt_vbus_data_pop(chnr);
+        if (act == RT_NULL)
+        {
+            if (rt_vbus_listen_on(chnr, RT_TICK_PER_SECOND) != RT_EOK)
+                return bad + (int)(size - got);
+            continue;
+        }
+
+        data = (rt_uint8_t *)(act + 1);
+        for (i = 0; i < act->size; i++)
+        {
+            if (data[i] != pattern[(got + i) % VBUS_TC_POST])
+                bad ++;
+        }
+        got += act->size;
+        rt_free(act);
+    }
+
+    return got == size ? bad : bad + 1;
+}
+
+static void vbus_tput(rt_uint8_t prio)
+{
+    rt_size_t sent;
+    int bad = 0;
+
+    /* the pattern never changes, no need to wait for the posts */
+    for (sent = 0; sent < VBUS_TC_BYTES; sent += VBUS_TC_POST)
+    {
+        if (rt_vbus_post(chnr, prio, pattern, VBUS_TC_POST, RT_WAITING_FOREVER) != RT_EOK)
+            bad ++;
+    }
+    uassert_int_equal(bad, 0);
+
+    uassert_int_equal(vbus_tc_recv(VBUS_TC_BYTES), 0);
+}
+
+static void vbus_tput_hi(void)
+{
+    vbus_tput(VBUS_TC_PRIO_HI);
+}
+
+static void vbus_tput_lo(void)
+{
+    vbus_tput(VBUS_TC_PRIO_LO);
+}
+
+static void vbus_latency(void)
+{
+    int i, bad = 0;
+
+    for (i = 0; i < VBUS_TC_PINGS; i++)
+    {
+        if (rt_vbus_post(chnr, VBUS_TC_PRIO_HI, pattern, VBUS_TC_PING, RT_WAITING_FOREVER) != RT_EOK)
+        {
+            bad ++;
+            continue;
+        }
+        bad += vbus_tc_recv(VBUS_TC_PING);
+    }
+
+    uassert_int_equal(bad, 0);
+}
+
+static void testcase_tput_hi(void)
+{
+    UTEST_UNIT_RUN(vbus_tput_hi);
+}
+UTEST_TC_EXPORT(testcase_tput_hi, "testcases.vbus.sim.tput_hi", vbus_tc_init, vbus_tc_cleanup, 30);
+
+static void testcase_tput_lo(void)
+{
+    UTEST_UNIT_RUN(vbus_tput_lo);
+}
+UTEST_TC_EXPORT(testcase_tput_lo, "testcases.vbus.sim.tput_lo", vbus_tc_init, vbus_tc_cleanup, 30);
+
+static void testcase_latency(void)
+{
+    UTEST_UNIT_RUN(vbus_latency);
+}
+UTEST_TC_EXPORT(testcase_latency, "testcases.vbus.sim.latency", vbus_tc_init, vbus_tc_cleanup, 30);
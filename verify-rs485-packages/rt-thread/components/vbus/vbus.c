@@ -6,6 +6,7 @@
  * Change Logs:
  * Date           Author       Notes
  * 2013-11-04     Grissiom     add comment
+ * 2026-10-17     RT-Thread    write the queued packages in a burst, one tick per burst
  */
 
 #include <rthw.h>
@@ -185,103 +186,120 @@ static struct rt_thread _bus_out_thread;
 static rt_uint8_t _bus_out_thread_stack[_BUS_OUT_THRD_STACK_SZ];
 struct rt_prio_queue *_bus_out_que;
 
-static void _bus_out_entry(void *param)
+/* write one package into the out ring, @sp is the known free blocks */
+static void _bus_out_put(const struct rt_vbus_pkg *dpkg, int *sp)
 {
-    struct rt_vbus_pkg dpkg;
+    rt_uint32_t nxtidx;
+    const int dnr = LEN2BNR(dpkg->len);
 
-    _bus_out_que = rt_prio_queue_create("vbus",
-                                        _BUS_OUT_PKG_NR,
-                                        sizeof(struct rt_vbus_pkg));
+    vbus_debug("vmm bus out"
+               "(data: %p, len: %d, prio: %d, id: %d)\n",
+               dpkg->data, dpkg->len, dpkg->prio, dpkg->id);
 
-    if (!_bus_out_que)
-    {
-        rt_kprintf("could not create vmm bus queue\n");
-        return;
-    }
+    /* the space only grows behind our back, refresh it when short */
+    if (*sp < dnr)
+        *sp = _bus_ring_space_nr(RT_VBUS_OUT_RING);
 
-    while (rt_prio_queue_pop(_bus_out_que, &dpkg,
-                             RT_WAITING_FOREVER) == RT_EOK)
+    /* wait for enough space */
+    while (*sp < dnr)
     {
-        int sp;
-        rt_uint32_t nxtidx;
-        const int dnr = LEN2BNR(dpkg.len);
+        rt_base_t level = rt_hw_interrupt_disable();
 
-#ifdef RT_VBUS_USING_FLOW_CONTROL
-        rt_wm_que_dec(&_chn_wm_que[dpkg.id]);
-#endif
+        RT_VBUS_OUT_RING->blocked = 1;
+        rt_vbus_smp_wmb();
 
-        if (!_chn_connected(dpkg.id))
-            continue;
+        /* kick the guest, hoping this could force it do the work */
+        rt_vbus_tick(0, RT_VBUS_GUEST_VIRQ);
 
-        sp = _bus_ring_space_nr(RT_VBUS_OUT_RING);
+        rt_thread_suspend(rt_thread_self());
+        rt_schedule();
 
-        vbus_debug("vmm bus out"
-                   "(data: %p, len: %d, prio: %d, id: %d)\n",
-                   dpkg.data, dpkg.len, dpkg.prio, dpkg.id);
+        RT_VBUS_OUT_RING->blocked = 0;
 
-        /* wait for enough space */
-        while (sp < dnr)
-        {
-            rt_base_t level = rt_hw_interrupt_disable();
+        rt_hw_interrupt_enable(level);
 
-            RT_VBUS_OUT_RING->blocked = 1;
-            rt_vbus_smp_wmb();
+        *sp = _bus_ring_space_nr(RT_VBUS_OUT_RING);
+    }
+    *sp -= dnr;
 
-            /* kick the guest, hoping this could force it do the work */
-            rt_vbus_tick(0, RT_VBUS_GUEST_VIRQ);
+    nxtidx = RT_VBUS_OUT_RING->put_idx + dnr;
 
-            rt_thread_suspend(rt_thread_self());
-            rt_schedule();
+    RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].id  = dpkg->id;
+    RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].qos = dpkg->prio;
+    RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].len = dpkg->len;
 
-            RT_VBUS_OUT_RING->blocked = 0;
+    if (nxtidx >= RT_VMM_RB_BLK_NR)
+    {
+        unsigned int tailsz;
 
-            rt_hw_interrupt_enable(level);
+        tailsz = (RT_VMM_RB_BLK_NR - RT_VBUS_OUT_RING->put_idx)
+            * sizeof(RT_VBUS_OUT_RING->blks[0]) - RT_VBUS_BLK_HEAD_SZ;
 
-            sp = _bus_ring_space_nr(RT_VBUS_OUT_RING);
-        }
+        /* the remaining block is sufficient for the data */
+        if (tailsz > dpkg->len)
+            tailsz = dpkg->len;
 
-        nxtidx = RT_VBUS_OUT_RING->put_idx + dnr;
+        rt_memcpy(&RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].data,
+                  dpkg->data, tailsz);
+        rt_memcpy(&RT_VBUS_OUT_RING->blks[0],
+                  ((char*)dpkg->data)+tailsz,
+                  dpkg->len - tailsz);
 
-        RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].id  = dpkg.id;
-        RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].qos = dpkg.prio;
-        RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].len = dpkg.len;
+        rt_vbus_smp_wmb();
+        RT_VBUS_OUT_RING->put_idx = nxtidx - RT_VMM_RB_BLK_NR;
+    }
+    else
+    {
+        rt_memcpy(&RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].data,
+                  dpkg->data, dpkg->len);
 
-        if (nxtidx >= RT_VMM_RB_BLK_NR)
-        {
-            unsigned int tailsz;
+        rt_vbus_smp_wmb();
+        RT_VBUS_OUT_RING->put_idx = nxtidx;
+    }
+}
+
+static void _bus_out_entry(void *param)
+{
+    struct rt_vbus_pkg dpkg;
+    int sp;
 
-            tailsz = (RT_VMM_RB_BLK_NR - RT_VBUS_OUT_RING->put_idx)
-                * sizeof(RT_VBUS_OUT_RING->blks[0]) - RT_VBUS_BLK_HEAD_SZ;
+    _bus_out_que = rt_prio_queue_create("vbus",
+                                        _BUS_OUT_PKG_NR,
+                                        sizeof(struct rt_vbus_pkg));
 
-            /* the remaining block is sufficient for the data */
-            if (tailsz > dpkg.len)
-                tailsz = dpkg.len;
+    if (!_bus_out_que)
+    {
+        rt_kprintf("could not create vmm bus queue\n");
+        return;
+    }
 
-            rt_memcpy(&RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].data,
-                      dpkg.data, tailsz);
-            rt_memcpy(&RT_VBUS_OUT_RING->blks[0],
-                      ((char*)dpkg.data)+tailsz,
-                      dpkg.len - tailsz);
+    while (rt_prio_queue_pop(_bus_out_que, &dpkg,
+                             RT_WAITING_FOREVER) == RT_EOK)
+    {
+        sp = 0;
 
-            rt_vbus_smp_wmb();
-            RT_VBUS_OUT_RING->put_idx = nxtidx - RT_VMM_RB_BLK_NR;
-        }
-        else
+        /* Write all the queued packages(the blocks of a large post are
+         * queued together), highest priority first, then tick the other
+         * side once for the whole burst. */
+        do
         {
-            rt_memcpy(&RT_VBUS_OUT_RING->blks[RT_VBUS_OUT_RING->put_idx].data,
-                      dpkg.data, dpkg.len);
+#ifdef RT_VBUS_USING_FLOW_CONTROL
+            rt_wm_que_dec(&_chn_wm_que[dpkg.id]);
+#endif
 
-            rt_vbus_smp_wmb();
-            RT_VBUS_OUT_RING->put_idx = nxtidx;
-        }
+            if (!_chn_connected(dpkg.id))
+                continue;
+
+            _bus_out_put(&dpkg, &sp);
+
+            if (dpkg.finished)
+            {
+                _vbus_indicate(RT_VBUS_EVENT_ID_TX, dpkg.id);
+            }
+        } while (rt_prio_queue_pop(_bus_out_que, &dpkg, 0) == RT_EOK);
 
         rt_vbus_smp_wmb();
         rt_vbus_tick(0, RT_VBUS_GUEST_VIRQ);
-
-        if (dpkg.finished)
-        {
-            _vbus_indicate(RT_VBUS_EVENT_ID_TX, dpkg.id);
-        }
     }
     RT_ASSERT(0);
 }
@@ -358,6 +376,10 @@ rt_err_t rt_vbus_post(rt_uint8_t id,
     dp       = data;
     pkg.id   = id;
     pkg.prio = prio;
+
+    /* Queue all the blocks before the out thread runs so it writes them in
+     * one burst. The scheduler is only unlocked to wait for space. */
+    rt_enter_critical();
     for (putsz = 0; size; size -= putsz)
     {
         pkg.data = dp;
@@ -377,7 +399,13 @@ rt_err_t rt_vbus_post(rt_uint8_t id,
         dp += putsz;
 
 #ifdef RT_VBUS_USING_FLOW_CONTROL
-        err = rt_wm_que_inc(&_chn_wm_que[id], timeout);
+        err = rt_wm_que_inc(&_chn_wm_que[id], 0);
+        if (err != RT_EOK && timeout != 0)
+        {
+            rt_exit_critical();
+            err = rt_wm_que_inc(&_chn_wm_que[id], timeout);
+            rt_enter_critical();
+        }
         if (err != RT_EOK)
             break;
 #endif
@@ -386,10 +414,17 @@ rt_err_t rt_vbus_post(rt_uint8_t id,
                    pkg.data, ((unsigned char*)pkg.data)[0],
                    pkg.len, pkg.finished, timeout);
 
-        err = rt_prio_queue_push(_bus_out_que, prio, &pkg, timeout);
+        err = rt_prio_queue_push(_bus_out_que, prio, &pkg, 0);
+        if (err != RT_EOK && timeout != 0)
+        {
+            rt_exit_critical();
+            err = rt_prio_queue_push(_bus_out_que, prio, &pkg, timeout);
+            rt_enter_critical();
+        }
         if (err != RT_EOK)
             break;
     }
+    rt_exit_critical();
 
     return err;
 }